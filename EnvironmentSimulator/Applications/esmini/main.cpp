@@ -61,19 +61,28 @@ static int execute_scenario(int argc, char* argv[])
 	}
 
 
-	while (!player->IsQuitRequested() && !quit)
+	try
 	{
-		double dt;
-		if (player->GetFixedTimestep() > SMALL_NUMBER)
-		{
-			dt = player->GetFixedTimestep();
-		}
-		else
+		while (!player->IsQuitRequested() && !quit)
 		{
-			dt = SE_getSimTimeStep(time_stamp, player->minStepSize, player->maxStepSize);
+			double dt;
+			if (player->GetFixedTimestep() > SMALL_NUMBER)
+			{
+				dt = player->GetFixedTimestep();
+			}
+			else
+			{
+				dt = SE_getSimTimeStep(time_stamp, player->minStepSize, player->maxStepSize);
+			}
+
+			player->Frame(dt);
 		}
-
-		player->Frame(dt);
+	}
+	catch (const std::exception& e)
+	{
+		// e.g. LOG_AND_QUIT, player is deleted on return which writes any buffered log and recording data
+		LOG(std::string("Exception: ").append(e.what()).c_str());
+		return -1;
 	}
 
 	if (player->opt.IsOptionArgumentSet("param_permutation"))
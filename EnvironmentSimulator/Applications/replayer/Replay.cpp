@@ -12,115 +12,95 @@
 
 #include "Replay.hpp"
 #include "ScenarioGateway.hpp"
+#include "DatFile.hpp"
 #include "CommonMini.hpp"
 #include "dirent.h"
+#include <algorithm>
+#include <climits>
 
 using namespace scenarioengine;
 
 
-Replay::Replay(std::string filename, bool clean) : time_(0.0), index_(0), repeat_(false), clean_(clean)
+typedef struct
 {
-	file_.open(filename, std::ofstream::binary);
-	if (file_.fail())
-	{
-		LOG("Cannot open file: %s", filename.c_str());
-		throw std::invalid_argument(std::string("Cannot open file: ") + filename);
-	}
+	char magic[4];
+	int version;
+	int clean;
+	int dat_version;
+	unsigned long long dat_size;
+	long long dat_mtime;
+	unsigned int n_entries;  // 0 if all records are used
+	unsigned int n_frames;
+} ReplayIndexHeader;
+
+Replay::Replay(std::string filename, bool clean, IndexFile index_file) : records_(nullptr), n_records_(0),
+	frames_sorted_(true), slot_table_index_(UINT_MAX), time_(0.0), index_(0), repeat_(false), clean_(clean)
+{
+	Open(filename);
 
-	file_.read((char*)&header_, sizeof(header_));
-	LOG("Recording %s opened. dat version: %d odr: %s model: %s", FileNameOf(filename).c_str(), header_.version,
-		FileNameOf(header_.odr_filename).c_str(), FileNameOf(header_.model_filename).c_str());
+	std::string index_filename = filename + REPLAY_INDEX_FILE_EXT;
+	bool use_index_file = index_file == IndexFile::READ_OR_CREATE;
 
-	if (header_.version != DAT_FILE_FORMAT_VERSION)
+	if (use_index_file && LoadIndexFile(index_filename) == 0)
 	{
-		LOG_AND_QUIT("Version mismatch. %s is version %d while supported version is %d. Please re-create dat file.",
-			filename.c_str(), header_.version, DAT_FILE_FORMAT_VERSION);
+		LOG("Loaded frame index %s", FileNameOf(index_filename).c_str());
 	}
-
-	if (header_.version != DAT_FILE_FORMAT_VERSION)
-	{
-		LOG_AND_QUIT("Version mismatch. %s is version %d while supported version is %d. Please re-create dat file.",
-			filename.c_str(), header_.version, DAT_FILE_FORMAT_VERSION);
-	}
-
-	while (!file_.eof())
+	else
 	{
-		ReplayEntry data;
+		if (clean_)
+		{
+			CleanEntries();
+		}
 
-		file_.read((char*)&data.state, sizeof(data.state));
+		BuildFrameIndex();
 
-		if (!file_.eof())
+		if (use_index_file && SaveIndexFile(index_filename) != 0)
 		{
-			data_.push_back(data);
+			LOG("Failed to save frame index %s", index_filename.c_str());
 		}
 	}
 
-	if (clean_)
-	{
-		CleanEntries(data_);
-	}
-
-	if (data_.size() > 0)
-	{
-		// Register first entry timestamp as starting time
-		time_ = data_[0].state.info.timeStamp;
-		startTime_ = time_;
-		startIndex_ = 0;
-
-		// Register last entry timestamp as stop time
-		stopTime_ = data_.back().state.info.timeStamp;
-		stopIndex_ = FindIndexAtTimestamp(stopTime_);
-	}
+	InitTimeSpan();
 }
 
-Replay::Replay(const std::string directory, const std::string scenario, std::string create_datfile) : time_(0.0), index_(0), repeat_(false), create_datfile_(create_datfile)
+Replay::Replay(const std::string directory, const std::string scenario, std::string create_datfile) : records_(nullptr),
+	n_records_(0), frames_sorted_(true), slot_table_index_(UINT_MAX), time_(0.0), index_(0), repeat_(false), clean_(true),
+	create_datfile_(create_datfile)
 {
 	GetReplaysFromDirectory(directory, scenario);
-	std::vector<std::pair<std::string, std::vector<ReplayEntry>>> scenarioData;
+	std::vector<std::pair<std::string, Replay*>> scenarioData;
 
 	for (size_t i = 0; i < scenarios_.size(); i++)
 	{
-		file_.open(scenarios_[i], std::ofstream::binary);
-		if (file_.fail())
-		{
-			LOG("Cannot open file: %s", scenarios_[i].c_str());
-			throw std::invalid_argument(std::string("Cannot open file: ") + scenarios_[i]);
-		}
-		file_.read((char*)&header_, sizeof(header_));
-		LOG("Recording %s opened. dat version: %d odr: %s model: %s", FileNameOf(scenarios_[i]).c_str(), header_.version,
-			FileNameOf(header_.odr_filename).c_str(), FileNameOf(header_.model_filename).c_str());
+		// Each recording is mapped and cleaned in place. Ensure increasing timestamps, skip any other entries.
+		Replay* replay = new Replay(scenarios_[i], true);
 
-		if (header_.version != DAT_FILE_FORMAT_VERSION)
+		if (replay->GetNumberOfEntries() == 0)
 		{
-			LOG_AND_QUIT("Version mismatch. %s is version %d while supported version is %d. Please re-create dat file.",
-				scenarios_[i].c_str(), header_.version, DAT_FILE_FORMAT_VERSION);
+			LOG("Skipping empty recording %s", scenarios_[i].c_str());
+			delete replay;
+			continue;
 		}
-		while (!file_.eof())
-		{
-			ReplayEntry entry;
 
-			file_.read((char*)&entry.state, sizeof(entry.state));
+		header_ = replay->header_;
 
-			if (!file_.eof())
-			{
-				data_.push_back(entry);
-			}
-		}
 		// pair <scenario name, scenario data>
-		scenarioData.push_back(std::make_pair(scenarios_[i], data_));
-		data_ = {};
-		file_.close();
+		scenarioData.push_back(std::make_pair(scenarios_[i], replay));
 	}
 
 	if (scenarioData.size() < 2)
 	{
+		for (auto& sce : scenarioData)
+		{
+			delete sce.second;
+		}
 		LOG_AND_QUIT("Too few scenarios loaded, use single replay feature instead\n");
 	}
 
 	// Scenario with smallest start time first
 	std::sort(scenarioData.begin(), scenarioData.end(), [](const auto& sce1, const auto& sce2)
 	{
-		return sce1.second[0].state.info.timeStamp < sce2.second[0].state.info.timeStamp;
+		return sce1.second->GetFirstTimestamp() < sce2.second->GetFirstTimestamp();
 	});
 
 	// Log which scenario belongs to what ID-group (0, 100, 200 etc.)
@@ -130,32 +110,133 @@ Replay::Replay(const std::string directory, const std::string scenario, std::str
 		LOG("Scenarios corresponding to IDs (%d:%d): %s", i * 100, (i+1) * 100 - 1, FileNameOf(scenario_tmp.c_str()).c_str());
 	}
 
+	// Build remaining data in order.
+	BuildData(scenarioData);
 
-	// Ensure increasing timestamps. Remove any other entries.
 	for (auto& sce : scenarioData)
 	{
-		CleanEntries(sce.second);
+		delete sce.second;
 	}
 
-	// Build remaining data in order.
-	BuildData(scenarioData);
+	records_ = buffer_.data();
+	n_records_ = buffer_.size();
+
+	BuildFrameIndex();
+	InitTimeSpan();
 
-	if (data_.size() > 0)
+	if (!create_datfile_.empty())
+	{
+		CreateMergedDatfile(create_datfile_);
+	}
+}
+
+void Replay::Open(std::string filename)
+{
+	if (file_.Open(filename) != 0 || file_.GetSize() < sizeof(DatHeader))
+	{
+		LOG("Cannot open file: %s", filename.c_str());
+		throw std::invalid_argument(std::string("Cannot open file: ") + filename);
+	}
+
+	memcpy(&header_, file_.GetData(), sizeof(header_));
+	LOG("Recording %s opened. dat version: %d odr: %s model: %s", FileNameOf(filename).c_str(), header_.version,
+		FileNameOf(header_.odr_filename).c_str(), FileNameOf(header_.model_filename).c_str());
+
+	if (header_.version == DAT_FILE_FORMAT_VERSION_V2)
+	{
+		// Use records in place, any trailing incomplete record is ignored
+		records_ = reinterpret_cast<ObjectStateStructDat*>(file_.GetData() + sizeof(DatHeader));
+		n_records_ = (file_.GetSize() - sizeof(DatHeader)) / sizeof(ObjectStateStructDat);
+	}
+	else if (header_.version == DAT_FILE_FORMAT_VERSION)
+	{
+		// Index chunks of frames together with the decoder state at the start of each. Records are then
+		// decoded from the mapping on demand, keeping memory usage bounded also for large recordings.
+		const char* data = file_.GetData() + sizeof(DatHeader);
+		size_t size = file_.GetSize() - sizeof(DatHeader);
+		size_t pos = 0;
+		DatDecoder decoder;
+		std::vector<ObjectStateStructDat> states;
+
+		while (pos < size)
+		{
+			ReplayChunk chunk = { pos, n_records_, 0, decoder.GetObjects() };
+
+			states.clear();
+			if (decoder.Decode(data, size, pos, states, REPLAY_CHUNK_SIZE) != 0)
+			{
+				LOG_AND_QUIT("Failed to decode %s", filename.c_str());
+			}
+
+			if (states.empty())
+			{
+				break;  // no more complete frames
+			}
+
+			chunk.n_records = states.size();
+			n_records_ += states.size();
+			chunks_.push_back(std::move(chunk));
+		}
+		records_ = nullptr;
+	}
+	else
+	{
+		LOG_AND_QUIT("Version mismatch. %s is version %d while supported versions are %d and %d. Please re-create dat file.",
+			filename.c_str(), header_.version, DAT_FILE_FORMAT_VERSION_V2, DAT_FILE_FORMAT_VERSION);
+	}
+}
+
+ObjectStateStructDat* Replay::DecodeRecord(size_t record)
+{
+	for (int i = 0; i < 2; i++)
+	{
+		int slot = (chunk_recent_ + i) % 2;
+		if (chunk_slot_[slot] != SIZE_MAX)
+		{
+			const ReplayChunk& chunk = chunks_[chunk_slot_[slot]];
+			if (record >= chunk.first && record < chunk.first + chunk.n_records)
+			{
+				chunk_recent_ = slot;
+				return &chunk_states_[slot][record - chunk.first];
+			}
+		}
+	}
+
+	// Decode chunk into the least recently used slot. Pointers into the other slot stay valid.
+	auto it = std::upper_bound(chunks_.begin(), chunks_.end(), record,
+		[](size_t r, const ReplayChunk& c) { return r < c.first; });
+	size_t index = static_cast<size_t>(it - chunks_.begin()) - 1;
+	const ReplayChunk& chunk = chunks_[index];
+	int slot = 1 - chunk_recent_;
+	size_t pos = chunk.pos;
+	DatDecoder decoder;
+
+	decoder.SetObjects(chunk.objects);
+	chunk_states_[slot].clear();
+	if (decoder.Decode(file_.GetData() + sizeof(DatHeader), file_.GetSize() - sizeof(DatHeader), pos,
+		chunk_states_[slot], chunk.n_records) != 0 || chunk_states_[slot].size() != chunk.n_records)
+	{
+		LOG_AND_QUIT("Failed to decode recording at record %d", static_cast<int>(record));
+	}
+	chunk_slot_[slot] = index;
+	chunk_recent_ = slot;
+
+	return &chunk_states_[slot][record - chunk.first];
+}
+
+void Replay::InitTimeSpan()
+{
+	if (GetNumberOfEntries() > 0)
 	{
 		// Register first entry timestamp as starting time
-		time_ = data_[0].state.info.timeStamp;
+		time_ = TimeStampAt(0);
 		startTime_ = time_;
 		startIndex_ = 0;
 
 		// Register last entry timestamp as stop time
-		stopTime_ = data_.back().state.info.timeStamp;
+		stopTime_ = TimeStampAt(GetNumberOfEntries() - 1);
 		stopIndex_ = FindIndexAtTimestamp(stopTime_);
 	}
-
-	if (!create_datfile_.empty())
-	{
-		CreateMergedDatfile(create_datfile_);
-	}
 }
 
 // Browse through replay-folder and appends strings of absolute path to matching scenario
@@ -187,7 +268,7 @@ void Replay::GetReplaysFromDirectory(const std::string dir, const std::string sc
 			{
 				std::string nested_filename = nested_file->d_name;
 
-				if (nested_filename != "." && nested_filename != ".." && nested_filename.find(sce) != std::string::npos && nested_filename.find(".dat") != std::string::npos)
+				if (nested_filename != "." && nested_filename != ".." && nested_filename.find(sce) != std::string::npos && FileNameExtOf(nested_filename) == ".dat")
 				{
 					scenarios_.emplace_back(CombineDirectoryPathAndFilepath(dir+filename, nested_filename));
 				}
@@ -195,7 +276,7 @@ void Replay::GetReplaysFromDirectory(const std::string dir, const std::string sc
 			closedir(nested_dir);
 		}
 
-		if (filename != "." && filename != ".." && filename.find(sce) != std::string::npos && filename.find(".dat") != std::string::npos)
+		if (filename != "." && filename != ".." && filename.find(sce) != std::string::npos && FileNameExtOf(filename) == ".dat")
 		{
 			scenarios_.emplace_back(CombineDirectoryPathAndFilepath(dir, filename));
 		}
@@ -218,7 +299,7 @@ size_t Replay::GetNumberOfScenarios()
 
 Replay::~Replay()
 {
-	data_.clear();
+	file_.Close();
 }
 
 void Replay::GoToStart()
@@ -266,10 +347,10 @@ void Replay::GoToTime(double time, bool stop_at_next_frame)
 		if (time > time_)
 		{
 			next_index = FindNextTimestamp();
-			if (next_index > (int)index_ && time > data_[next_index].state.info.timeStamp && data_[next_index].state.info.timeStamp <= GetStopTime())
+			if (next_index > (int)index_ && time > TimeStampAt(next_index) && TimeStampAt(next_index) <= GetStopTime())
 			{
 				index_ = next_index;
-				time_ = data_[index_].state.info.timeStamp;
+				time_ = TimeStampAt(index_);
 			}
 			else
 			{
@@ -286,10 +367,10 @@ void Replay::GoToTime(double time, bool stop_at_next_frame)
 		else if (time < time_)
 		{
 			next_index = FindPreviousTimestamp();
-			if (next_index < (int)index_ && time < data_[next_index].state.info.timeStamp)
+			if (next_index < (int)index_ && time < TimeStampAt(next_index))
 			{
 				index_ = next_index;
-				time_ = data_[index_].state.info.timeStamp;
+				time_ = TimeStampAt(index_);
 			}
 			else
 			{
@@ -313,30 +394,53 @@ void Replay::GoToDeltaTime(double dt, bool stop_at_next_frame)
 
 int Replay::GoToNextFrame()
 {
-	double ctime = data_[index_].state.info.timeStamp;
-	for (size_t i = index_+1; i < data_.size(); i++)
+	int frame = FindNextFrame(index_);
+
+	if (frame < 0)
 	{
-		if (data_[i].state.info.timeStamp > ctime)
-		{
-			GoToTime(data_[i].state.info.timeStamp);
-			return static_cast<int>(i);
-		}
+		return -1;
 	}
-	return -1;
+
+	GoToTime(frames_[frame].timestamp);
+
+	return static_cast<int>(frames_[frame].first);
 }
 
 void Replay::GoToPreviousFrame()
 {
 	if (index_ > 0)
 	{
-		GoToTime(data_[index_ -1].state.info.timeStamp);
+		GoToTime(TimeStampAt(index_ -1));
 	}
 }
 
-int Replay::FindIndexAtTimestamp(double timestamp, int startSearchIndex)
+int Replay::FrameOfEntry(unsigned int index)
 {
-	int i = 0;
+	// frames are ordered by first entry, find last frame starting at or before given entry
+	auto it = std::upper_bound(frames_.begin(), frames_.end(), index,
+		[](unsigned int i, const ReplayFrame& frame) { return i < frame.first; });
 
+	return static_cast<int>(it - frames_.begin()) - 1;
+}
+
+int Replay::FindNextFrame(unsigned int index)
+{
+	float timestamp = TimeStampAt(index);
+
+	for (size_t i = FrameOfEntry(index) + 1; i < frames_.size(); i++)
+	{
+		// normally next frame, unless recording has not been cleaned and time goes backwards
+		if (frames_[i].timestamp > timestamp)
+		{
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
+int Replay::FindIndexAtTimestamp(double timestamp, int startSearchIndex)
+{
 	if (timestamp > stopTime_)
 	{
 		GoToEnd();
@@ -353,29 +457,42 @@ int Replay::FindIndexAtTimestamp(double timestamp, int startSearchIndex)
 		startSearchIndex = 0;
 	}
 
-	for (i = startSearchIndex; i < (int)data_.size(); i++)
+	if (startSearchIndex >= static_cast<int>(GetNumberOfEntries()))
 	{
-		if (data_[i].state.info.timeStamp >= timestamp)
-		{
-			break;
-		}
+		return static_cast<int>(GetNumberOfEntries()) - 1;
 	}
 
-	return MIN(i, (int)data_.size() - 1);
+	int frame = FrameOfEntry(startSearchIndex);
+	if (frames_[frame].timestamp >= timestamp)
+	{
+		return startSearchIndex;
+	}
+
+	std::vector<ReplayFrame>::iterator it;
+	if (frames_sorted_)
+	{
+		it = std::lower_bound(frames_.begin() + frame + 1, frames_.end(), timestamp,
+			[](const ReplayFrame& f, double t) { return f.timestamp < t; });
+	}
+	else
+	{
+		it = std::find_if(frames_.begin() + frame + 1, frames_.end(),
+			[timestamp](const ReplayFrame& f) { return f.timestamp >= timestamp; });
+	}
+
+	if (it == frames_.end())
+	{
+		return static_cast<int>(GetNumberOfEntries()) - 1;
+	}
+
+	return static_cast<int>(it->first);
 }
 
 int Replay::FindNextTimestamp(bool wrap)
 {
-	int index = index_ + 1;
-	for (; index < data_.size(); index++)
-	{
-		if (data_[index].state.info.timeStamp > data_[index_].state.info.timeStamp)
-		{
-			break;
-		}
-	}
+	int frame = FindNextFrame(index_);
 
-	if (index >= data_.size())
+	if (frame < 0)
 	{
 		if (wrap)
 		{
@@ -387,7 +504,7 @@ int Replay::FindNextTimestamp(bool wrap)
 		}
 	}
 
-	return index;
+	return static_cast<int>(frames_[frame].first);
 }
 
 int Replay::FindPreviousTimestamp(bool wrap)
@@ -398,7 +515,7 @@ int Replay::FindPreviousTimestamp(bool wrap)
 	{
 		if (wrap)
 		{
-			index = (int)(data_.size() - 1);
+			index = (int)(GetNumberOfEntries() - 1);
 		}
 		else
 		{
@@ -406,42 +523,77 @@ int Replay::FindPreviousTimestamp(bool wrap)
 		}
 	}
 
-	for (int i = index - 1; i >= 0; i--)
+	// go backwards until we identify the first entry with same timestamp
+	int frame = FrameOfEntry(index);
+	while (frame > 0 && !(frames_[frame - 1].timestamp < frames_[frame].timestamp))
 	{
-		// go backwards until we identify the first entry with same timestamp
-		if (data_[i].state.info.timeStamp < data_[index].state.info.timeStamp)
-		{
-			break;
-		}
-		index = i;
+		frame--;
+	}
+
+	return static_cast<int>(frames_[frame].first);
+}
+
+int Replay::GetEntryIndex(int id)
+{
+	if (index_ >= GetNumberOfEntries())
+	{
+		return -1;
+	}
+
+	if (index_ != slot_table_index_)
+	{
+		// Moved to another frame, map objects of the current one
+		UpdateSlotTable();
+	}
+
+	auto it = object_slot_.find(id);
+	if (it == object_slot_.end())
+	{
+		return -1;
 	}
 
-	return index;
+	return slot_table_[it->second];
 }
 
-ReplayEntry* Replay::GetEntry(int id)
+void Replay::UpdateSlotTable()
 {
-	// Read all vehicles at current timestamp
-	float timestamp = data_[index_].state.info.timeStamp;
-	int i = 0;
-	while (index_ + i < data_.size() && !(data_[index_ + i].state.info.timeStamp > timestamp))
+	ReplayFrame* frame = &frames_[FrameOfEntry(index_)];
+
+	std::fill(slot_table_.begin(), slot_table_.end(), -1);
+
+	for (unsigned int i = index_; i < frame->first + frame->n_entries; i++)
 	{
-		if (data_[index_ + i].state.info.id == id)
+		int id = GetStateByIndex(i)->info.id;
+		auto it = object_slot_.find(id);
+		size_t slot;
+
+		if (it == object_slot_.end())
 		{
-			return &data_[index_ + i];
+			// first appearance of this object, assign a new slot
+			slot = slot_table_.size();
+			object_slot_[id] = slot;
+			slot_table_.push_back(-1);
+		}
+		else
+		{
+			slot = it->second;
+		}
+
+		if (slot_table_[slot] < 0)
+		{
+			slot_table_[slot] = static_cast<int>(i);
 		}
-		i++;
 	}
 
-	return nullptr;
+	slot_table_index_ = index_;
 }
 
 ObjectStateStructDat* Replay::GetState(int id)
 {
-	ReplayEntry* entry = GetEntry(id);
-	if (entry != nullptr)
+	int index = GetEntryIndex(id);
+	if (index >= 0)
 	{
-		return &entry->state;
+		return GetStateByIndex(index);
 	}
 	else
 	{
@@ -449,6 +601,15 @@ ObjectStateStructDat* Replay::GetState(int id)
 	}
 }
 
+void Replay::SetOdometerByIndex(size_t index, double odometer)
+{
+	if (odometer_.size() < GetNumberOfEntries())
+	{
+		odometer_.resize(GetNumberOfEntries(), 0.0);
+	}
+	odometer_[index] = odometer;
+}
+
 void Replay::SetStartTime(double time)
 {
 	startTime_ = time;
@@ -471,76 +632,210 @@ void Replay::SetStopTime(double time)
 	stopIndex_ = FindIndexAtTimestamp(stopTime_);
 }
 
-void Replay::CleanEntries(std::vector<ReplayEntry>& entries)
+void Replay::CleanEntries()
 {
-	for (size_t i = 0; i < entries.size() - 1; i++)
+	// Ensure increasing timestamps and keep only the latest instance of an object within a frame.
+	// Records are left untouched, only the list of entries to use is updated.
+	std::vector<unsigned int> entries;
+	std::map<int, size_t> frame_ids;  // position in entries list per object id, within current frame
+	float frame_timestamp = 0.0f;
+	float last_timestamp = 0.0f;
+	bool skipped = false;
+
+	entries.reserve(n_records_);
+
+	for (unsigned int i = 0; i < n_records_; i++)
 	{
-		if (entries[i + 1].state.info.timeStamp < entries[i].state.info.timeStamp)
-		{
-			entries.erase(entries.begin() + i + 1);
-			i--;
-		}
+		ObjectStateStructDat* state = GetRecord(i);
 
-		for (int j = 1; (i + j < entries.size()) && NEAR_NUMBERS(entries[i + j].state.info.timeStamp, entries[i].state.info.timeStamp); j++)
+		if (!entries.empty())
 		{
-			// Keep the latest instance of entries with same timestamp
-			if (entries[i + j].state.info.id == entries[i].state.info.id)
+			if (state->info.timeStamp < last_timestamp)
+			{
+				skipped = true;
+				continue;
+			}
+
+			if (!NEAR_NUMBERS(state->info.timeStamp, frame_timestamp))
 			{
-				entries.erase(entries.begin() + i);
-				i--;
-				break;
+				frame_ids.clear();
 			}
 		}
+
+		if (frame_ids.empty())
+		{
+			frame_timestamp = state->info.timeStamp;
+		}
+
+		auto it = frame_ids.find(state->info.id);
+		if (it != frame_ids.end())
+		{
+			// Keep the latest instance of entries with same timestamp, mark earlier one for removal
+			entries[it->second] = UINT_MAX;
+			skipped = true;
+		}
+
+		frame_ids[state->info.id] = entries.size();
+		entries.push_back(i);
+		last_timestamp = state->info.timeStamp;
+	}
+
+	if (skipped)
+	{
+		entries.erase(std::remove(entries.begin(), entries.end(), UINT_MAX), entries.end());
+		entries.shrink_to_fit();
+		entries_.swap(entries);
+	}
+	else
+	{
+		entries_.clear();  // all records used as is
+	}
+}
+
+void Replay::BuildFrameIndex()
+{
+	frames_.clear();
+
+	for (size_t i = 0; i < GetNumberOfEntries(); i++)
+	{
+		float timestamp = TimeStampAt(i);
+
+		if (frames_.empty() || timestamp != frames_.back().timestamp)
+		{
+			ReplayFrame frame = { timestamp, static_cast<unsigned int>(i), 0 };
+			frames_.push_back(frame);
+		}
+		frames_.back().n_entries++;
 	}
+
+	UpdateFrameOrder();
 }
 
-void Replay::BuildData(std::vector<std::pair<std::string, std::vector<ReplayEntry>>>& scenarios)
+void Replay::UpdateFrameOrder()
 {
-	// Keep track of current index of each scenario
-	std::vector<int> cur_idx;
-	std::vector<int> next_idx;
+	// Binary search on time is possible unless recording has not been cleaned and time goes backwards
+	frames_sorted_ = std::is_sorted(frames_.begin(), frames_.end(),
+		[](const ReplayFrame& a, const ReplayFrame& b) { return a.timestamp < b.timestamp; });
+}
+
+int Replay::LoadIndexFile(std::string filename)
+{
+	std::ifstream file(filename, std::ifstream::binary);
+	if (!file.is_open())
+	{
+		return -1;
+	}
+
+	ReplayIndexHeader header;
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (file.fail() ||
+		strncmp(header.magic, "EIDX", sizeof(header.magic)) != 0 ||
+		header.version != REPLAY_INDEX_FILE_VERSION ||
+		header.clean != (clean_ ? 1 : 0) ||
+		header.dat_version != header_.version ||
+		header.dat_size != file_.GetSize() ||
+		header.dat_mtime != file_.GetModificationTime())
+	{
+		LOG("Frame index %s outdated or not matching, ignoring it", FileNameOf(filename).c_str());
+		return -1;
+	}
+
+	std::vector<unsigned int> entries(header.n_entries);
+	std::vector<ReplayFrame> frames(header.n_frames);
+
+	file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(unsigned int)));
+	file.read(reinterpret_cast<char*>(frames.data()), static_cast<std::streamsize>(frames.size() * sizeof(ReplayFrame)));
+	if (file.fail())
+	{
+		LOG("Failed to read frame index %s", FileNameOf(filename).c_str());
+		return -1;
+	}
 
-	for (size_t j = 0; j < scenarios.size(); j++)
+	for (size_t i = 0; i < entries.size(); i++)
 	{
-		cur_idx.push_back(0);
-		next_idx.push_back(0);
+		if (entries[i] >= n_records_)
+		{
+			LOG("Corrupt frame index %s", FileNameOf(filename).c_str());
+			return -1;
+		}
 	}
 
-	// Set scenario ID-group (0, 100, 200 etc.)
-	for (size_t j = 0; j < scenarios.size(); j++)
+	size_t n_entries = entries.empty() ? n_records_ : entries.size();
+	for (size_t i = 0; i < frames.size(); i++)
 	{
-		for (size_t k = 0; k < scenarios[j].second.size(); k++)
+		if (frames[i].n_entries == 0 || frames[i].first >= n_entries || frames[i].n_entries > n_entries - frames[i].first)
 		{
-			// Set scenario ID-group (0, 100, 200 etc.)
-			scenarios[j].second[k].state.info.id += static_cast<int>(j) * 100;
+			LOG("Corrupt frame index %s", FileNameOf(filename).c_str());
+			return -1;
 		}
 	}
 
-	// Populate data_ based on first (with lowest timestamp) scenario
-	float cur_timestamp = scenarios[0].second[0].state.info.timeStamp;
+	entries_.swap(entries);
+	frames_.swap(frames);
+	UpdateFrameOrder();
+
+	return 0;
+}
+
+int Replay::SaveIndexFile(std::string filename)
+{
+	std::ofstream file(filename, std::ofstream::binary);
+	if (!file.is_open())
+	{
+		return -1;
+	}
+
+	ReplayIndexHeader header;
+	memcpy(header.magic, "EIDX", sizeof(header.magic));
+	header.version = REPLAY_INDEX_FILE_VERSION;
+	header.clean = clean_ ? 1 : 0;
+	header.dat_version = header_.version;
+	header.dat_size = file_.GetSize();
+	header.dat_mtime = file_.GetModificationTime();
+	header.n_entries = static_cast<unsigned int>(entries_.size());
+	header.n_frames = static_cast<unsigned int>(frames_.size());
+
+	file.write(reinterpret_cast<char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<char*>(entries_.data()), static_cast<std::streamsize>(entries_.size() * sizeof(unsigned int)));
+	file.write(reinterpret_cast<char*>(frames_.data()), static_cast<std::streamsize>(frames_.size() * sizeof(ReplayFrame)));
+
+	return file.fail() ? -1 : 0;
+}
+
+void Replay::BuildData(std::vector<std::pair<std::string, Replay*>>& scenarios)
+{
+	// Keep track of current index of each scenario
+	std::vector<int> cur_idx(scenarios.size(), 0);
+	std::vector<int> next_idx(scenarios.size(), 0);
+
+	// Populate buffer based on first (with lowest timestamp) scenario
+	float cur_timestamp = scenarios[0].second->TimeStampAt(0);
 	while (cur_timestamp < LARGE_NUMBER - SMALL_NUMBER)
 	{
 		// populate entries if all scenarios at current time step
 		float min_time_stamp = LARGE_NUMBER;
 		for (size_t j = 0; j < scenarios.size(); j++)
 		{
+			Replay* sce = scenarios[j].second;
+
 			if (next_idx[j] != -1)
 			{
 				int k = cur_idx[j];
-				for (; k < scenarios[j].second.size() &&
-					scenarios[j].second[k].state.info.timeStamp < cur_timestamp + SMALL_NUMBER; k++)
+				for (; k < static_cast<int>(sce->GetNumberOfEntries()) && sce->TimeStampAt(k) < cur_timestamp + SMALL_NUMBER; k++)
 				{
-					// push entry with modified timestamp
-					scenarios[j].second[k].state.info.timeStamp = cur_timestamp;
-					data_.push_back(scenarios[j].second[k]);
+					// push entry with modified timestamp and scenario ID-group (0, 100, 200 etc.)
+					buffer_.push_back(*sce->GetStateByIndex(k));
+					buffer_.back().info.timeStamp = cur_timestamp;
+					buffer_.back().info.id += static_cast<int>(j) * 100;
 				}
 
-				if (k < scenarios[j].second.size())
+				if (k < static_cast<int>(sce->GetNumberOfEntries()))
 				{
 					next_idx[j] = k;
-					if (scenarios[j].second[k].state.info.timeStamp < min_time_stamp)
+					if (sce->TimeStampAt(k) < min_time_stamp)
 					{
-						min_time_stamp = scenarios[j].second[k].state.info.timeStamp;
+						min_time_stamp = sce->TimeStampAt(k);
 					}
 				}
 				else
@@ -554,7 +849,7 @@ void Replay::BuildData(std::vector<std::pair<std::string, std::vector<ReplayEntr
 		{
 			for (size_t j = 0; j < scenarios.size(); j++)
 			{
-				if (next_idx[j] > 0 && scenarios[j].second[next_idx[j]].state.info.timeStamp < min_time_stamp + SMALL_NUMBER)
+				if (next_idx[j] > 0 && scenarios[j].second->TimeStampAt(next_idx[j]) < min_time_stamp + SMALL_NUMBER)
 				{
 					// time has reached next entry, step this scenario
 					cur_idx[j] = next_idx[j];
@@ -566,24 +861,43 @@ void Replay::BuildData(std::vector<std::pair<std::string, std::vector<ReplayEntr
 	}
 }
 
-void Replay::CreateMergedDatfile(const std::string filename)
+int Replay::SaveDatfile(const std::string filename)
 {
-	std::ofstream data_file_;
-	data_file_.open(filename, std::ofstream::binary);
-	if (data_file_.fail())
+	std::ofstream file;
+	file.open(filename, std::ofstream::binary);
+	if (file.fail())
 	{
 		LOG("Cannot open file: %s", filename.c_str());
-		exit(-1);
+		return -1;
 	}
 
-	data_file_.write((char*)&header_, sizeof(header_));
+	DatHeader header = header_;
+	header.version = DAT_FILE_FORMAT_VERSION;
+	file.write((char*)&header, sizeof(header));
 
-	if (data_file_.is_open())
+	// Encode frame by frame, entries of a frame are not necessarily consecutive records
+	DatEncoder encoder;
+	std::vector<ObjectStateStructDat> states;
+	std::vector<char> buf;
+	for (size_t i = 0; i < frames_.size(); i++)
 	{
-		// Write status to file - for later replay
-		for (size_t i = 0; i < data_.size(); i++)
+		states.clear();
+		for (unsigned int j = 0; j < frames_[i].n_entries; j++)
 		{
-			data_file_.write((char*)(&data_[i].state), sizeof(data_[i].state));
+			states.push_back(*GetStateByIndex(frames_[i].first + j));
 		}
+		buf.clear();
+		encoder.Encode(states.data(), states.size(), buf);
+		file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+	}
+
+	return file.fail() ? -1 : 0;
+}
+
+void Replay::CreateMergedDatfile(const std::string filename)
+{
+	if (SaveDatfile(filename) != 0)
+	{
+		exit(-1);
 	}
-}
\ No newline at end of file
+}
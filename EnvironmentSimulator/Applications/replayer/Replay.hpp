@@ -14,25 +14,53 @@
 
 #include <string>
 #include <fstream>
+#include <unordered_map>
 #include "CommonMini.hpp"
 #include "ScenarioGateway.hpp"
+#include "DatFile.hpp"
+
+#define REPLAY_INDEX_FILE_VERSION 1
+#define REPLAY_INDEX_FILE_EXT ".idx"
+#define REPLAY_CHUNK_SIZE 4096  // number of records decoded at a time from delta encoded recordings
 
 namespace scenarioengine
 {
+	// All entries sharing the same timestamp
+	typedef struct
+	{
+		float timestamp;
+		unsigned int first;  // index of first entry of the frame
+		unsigned int n_entries;
+	} ReplayFrame;
+
+	// Consecutive frames of a delta encoded recording, decoded on demand
 	typedef struct
 	{
-		ObjectStateStructDat state;
-		double odometer;
-	} ReplayEntry;
+		size_t pos;  // position of first packet in data following the DatHeader
+		size_t first;  // index of first record
+		size_t n_records;
+		std::unordered_map<int, DatObjectCache> objects;  // decoder state at start of chunk
+	} ReplayChunk;
 
 	class Replay
 	{
 	public:
 		DatHeader header_;
-		std::vector<ReplayEntry> data_;
 
-		Replay(std::string filename, bool clean);
-		// Replay(const std::string directory, const std::string scenario, bool clean);
+		enum class IndexFile
+		{
+			NONE,
+			READ_OR_CREATE  // read frame index from <filename>.idx, create it if missing or outdated
+		};
+
+		/**
+			Open a recording. Files are memory mapped. Version 2 records are used in place, while
+			delta encoded files (version 3) are decoded on demand, a chunk of frames at a time.
+			@param filename Recording (.dat) file
+			@param clean If true, skip entries going back in time and duplicate object entries within a frame
+			@param index_file Whether to make use of a frame index file, see IndexFile
+		*/
+		Replay(std::string filename, bool clean, IndexFile index_file = IndexFile::NONE);
 		Replay(const std::string directory, const std::string scenario, std::string create_datfile);
 		~Replay();
 
@@ -51,8 +79,41 @@ namespace scenarioengine
 		void GoToPreviousFrame();
 		int FindNextTimestamp(bool wrap = false);
 		int FindPreviousTimestamp(bool wrap = false);
-		ReplayEntry* GetEntry(int id);
+
+		/**
+			Get index of entry for specified object at current frame
+			@param id Object id
+			@return entry index, -1 if object not present in current frame
+		*/
+		int GetEntryIndex(int id);
+
+		/**
+			Get state of specified object at current frame
+			@param id Object id
+			@return pointer to state, nullptr if object not present in current frame. For delta encoded recordings
+			the state lives in a cache of two decoded chunks and is overwritten once entries of two other chunks
+			have been looked up. Copy the state to keep it across further lookups.
+		*/
 		ObjectStateStructDat* GetState(int id);
+		size_t GetNumberOfEntries() { return entries_.empty() ? n_records_ : entries_.size(); }
+
+		/**
+			Get state of specified entry, same pointer lifetime as for GetState()
+			@param index Entry index
+			@return pointer to state
+		*/
+		ObjectStateStructDat* GetStateByIndex(size_t index) { return GetRecord(entries_.empty() ? index : entries_[index]); }
+		size_t GetNumberOfFrames() { return frames_.size(); }
+		ReplayFrame* GetFrame(size_t index) { return &frames_[index]; }
+		double GetFirstTimestamp() { return frames_.empty() ? 0.0 : frames_.front().timestamp; }
+		double GetLastTimestamp() { return frames_.empty() ? 0.0 : frames_.back().timestamp; }
+
+		/**
+			Odometer values are not part of the recording, applications calculate and store them per entry
+		*/
+		void SetOdometerByIndex(size_t index, double odometer);
+		double GetOdometerByIndex(size_t index) { return index < odometer_.size() ? odometer_[index] : 0.0; }
+
 		void SetStartTime(double time);
 		void SetStopTime(double time);
 		double GetStartTime() { return startTime_; }
@@ -60,12 +121,31 @@ namespace scenarioengine
 		double GetTime() { return time_; }
 		int GetIndex() { return index_; }
 		void SetRepeat(bool repeat) { repeat_ = repeat; }
-		void CleanEntries(std::vector<ReplayEntry>& entries);
-		void BuildData(std::vector<std::pair<std::string, std::vector<ReplayEntry>>>& scenarios);
 		void CreateMergedDatfile(const std::string filename);
 
+		/**
+			Save entries in current .dat format (DAT_FILE_FORMAT_VERSION), e.g. to convert older recordings
+			@param filename Name of file to create
+			@return 0 on success, -1 on failure
+		*/
+		int SaveDatfile(const std::string filename);
+
 private:
-		std::ifstream file_;
+		SE_MappedFile file_;
+		ObjectStateStructDat* records_;  // points into file mapping or buffer_, nullptr for delta encoded recordings
+		size_t n_records_;
+		std::vector<ObjectStateStructDat> buffer_;  // records owned in memory, merged from multiple recordings
+		std::vector<ReplayChunk> chunks_;  // index of delta encoded recording
+		std::vector<ObjectStateStructDat> chunk_states_[2];  // two most recently decoded chunks
+		size_t chunk_slot_[2] = { SIZE_MAX, SIZE_MAX };  // chunk index per slot
+		int chunk_recent_ = 0;  // slot used most recently
+		std::vector<unsigned int> entries_;  // record index per entry when some records are skipped, empty means all records used
+		std::vector<ReplayFrame> frames_;
+		bool frames_sorted_;  // frames in increasing time order
+		std::unordered_map<int, size_t> object_slot_;  // slot per object id
+		std::vector<int> slot_table_;  // entry index per object slot for current frame, -1 if object not present
+		unsigned int slot_table_index_;  // entry index the slot table was built for
+		std::vector<double> odometer_;
 		std::vector<std::string> scenarios_;
 		double time_;
 		double startTime_;
@@ -77,7 +157,21 @@ private:
 		bool clean_;
 		std::string create_datfile_;
 
+		ObjectStateStructDat* GetRecord(size_t record) { return records_ != nullptr ? &records_[record] : DecodeRecord(record); }
+		ObjectStateStructDat* DecodeRecord(size_t record);  // into chunk_states_, valid until two other chunks decoded
+		float TimeStampAt(size_t index) { return GetStateByIndex(index)->info.timeStamp; }
 		int FindIndexAtTimestamp(double timestamp, int startSearchIndex = 0);
+		int FrameOfEntry(unsigned int index);
+		int FindNextFrame(unsigned int index);
+		void UpdateSlotTable();
+		void UpdateFrameOrder();
+		void Open(std::string filename);
+		void CleanEntries();
+		void BuildFrameIndex();
+		int LoadIndexFile(std::string filename);
+		int SaveIndexFile(std::string filename);
+		void BuildData(std::vector<std::pair<std::string, Replay*>>& scenarios);
+		void InitTimeSpan();
 	};
 
-}
\ No newline at end of file
+}
@@ -11,80 +11,317 @@
  */
 
  /*
-  * This application uses the Replay class to read and binary recordings and print content in ascii format to stdout
+  * This application reads binary recordings and prints content in ascii format to csv files
+  *
+  * The recording is streamed in chunks of entries, which are formatted in parallel and written in order.
+  * Given a directory, all .dat files in it are converted concurrently.
   */
 
 #include <clocale>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
-#include "Replay.hpp"
+#include "ScenarioGateway.hpp"
+#include "DatFile.hpp"
 #include "CommonMini.hpp"
+#include "dirent.h"
 
 using namespace scenarioengine;
 
 #define MAX_LINE_LEN 2048
+#define ENTRIES_PER_CHUNK 16384
 
-int main(int argc, char** argv)
+static char* FormatInt(char* dst, long long value)
 {
-	Replay* player;
-	static char line[MAX_LINE_LEN];
+	char digits[24];
+	int n = 0;
+	unsigned long long u = value < 0 ? 0ull - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
 
-	std::setlocale(LC_ALL, "C.UTF-8");
+	do
+	{
+		digits[n++] = static_cast<char>('0' + u % 10);
+		u /= 10;
+	} while (u > 0);
 
-	if (argc < 2)
+	if (value < 0)
 	{
-		printf("Usage: %s <filename>\n", argv[0]);
-		return -1;
+		*dst++ = '-';
+	}
+	while (n > 0)
+	{
+		*dst++ = digits[--n];
+	}
+
+	return dst;
+}
+
+// Same result as printf "%.3f". value * 1000 is exact in double precision for any float, so rounding the product
+// to nearest (ties to even, as printf) gives correctly rounded output without going through the printf machinery.
+static char* FormatFloat3(char* dst, float value)
+{
+	double scaled = static_cast<double>(value) * 1000.0;
+
+	if (!std::isfinite(scaled) || fabs(scaled) > 1e15)
+	{
+		return dst + snprintf(dst, 64, "%.3f", static_cast<double>(value));
+	}
+
+	long long q = static_cast<long long>(std::nearbyint(fabs(scaled)));
+
+	if (std::signbit(value))
+	{
+		*dst++ = '-';
+	}
+	dst = FormatInt(dst, q / 1000);
+	*dst++ = '.';
+	*dst++ = static_cast<char>('0' + (q / 100) % 10);
+	*dst++ = static_cast<char>('0' + (q / 10) % 10);
+	*dst++ = static_cast<char>('0' + q % 10);
+
+	return dst;
+}
+
+static char* Separator(char* dst)
+{
+	*dst++ = ',';
+	*dst++ = ' ';
+	return dst;
+}
+
+static void FormatEntries(const ObjectStateStructDat* states, size_t n, std::string* out)
+{
+	char line[MAX_LINE_LEN];
+
+	out->clear();
+	out->reserve(n * 128);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		const ObjectStateStructDat* state = &states[i];
+		char* p = line;
+
+		p = Separator(FormatFloat3(p, state->info.timeStamp));
+		p = Separator(FormatInt(p, state->info.id));
+		size_t name_len = strnlen(state->info.name, NAME_LEN);
+		memcpy(p, state->info.name, name_len);
+		p = Separator(p + name_len);
+		p = Separator(FormatFloat3(p, state->pos.x));
+		p = Separator(FormatFloat3(p, state->pos.y));
+		p = Separator(FormatFloat3(p, state->pos.z));
+		p = Separator(FormatFloat3(p, state->pos.h));
+		p = Separator(FormatFloat3(p, state->pos.p));
+		p = Separator(FormatFloat3(p, state->pos.r));
+		p = Separator(FormatFloat3(p, state->info.speed));
+		p = Separator(FormatFloat3(p, state->info.wheel_angle));
+		p = FormatFloat3(p, state->info.wheel_rot);
+		*p++ = '\n';
+
+		out->append(line, static_cast<size_t>(p - line));
 	}
+}
+
+/**
+	Convert one recording into csv file
+	@param filename Recording (.dat) file
+	@param csv_filename File to create
+	@param n_threads Number of threads formatting entries
+	@return 0 on success, -1 on failure
+*/
+static int ConvertFile(std::string filename, std::string csv_filename, unsigned int n_threads)
+{
+	SE_MappedFile file;
+	DatHeader header;
+	SE_SystemTime timer;
 
-	std::string filename = FileNameWithoutExtOf(argv[1]) + ".csv";
-	std::ofstream file;
-	file.open(filename);
-	if (!file.is_open())
+	if (file.Open(filename) != 0 || file.GetSize() < sizeof(DatHeader))
 	{
-		printf("Failed to create file %s\n", filename.c_str());
+		printf("Cannot open file: %s\n", filename.c_str());
 		return -1;
 	}
 
-	// Create replayer object for parsing the binary data file
-	try
+	memcpy(&header, file.GetData(), sizeof(header));
+	if (header.version != DAT_FILE_FORMAT_VERSION && header.version != DAT_FILE_FORMAT_VERSION_V2)
 	{
-		player = new Replay(argv[1], false);
+		printf("Version mismatch. %s is version %d while supported versions are %d and %d. Please re-create dat file.\n",
+			filename.c_str(), header.version, DAT_FILE_FORMAT_VERSION_V2, DAT_FILE_FORMAT_VERSION);
+		return -1;
 	}
-	catch (const std::exception& e)
+
+	SE_AsyncFileWriter out;
+	if (out.Open(csv_filename, false) != 0)
 	{
-		printf("%s", e.what());
+		printf("Failed to create file %s\n", csv_filename.c_str());
 		return -1;
 	}
 
 	// First output header and CSV labels
-	snprintf(line, MAX_LINE_LEN, "Version: %d, OpenDRIVE: %s, 3DModel: %s\n", player->header_.version, player->header_.odr_filename, player->header_.model_filename);
-	file << line;
+	char line[MAX_LINE_LEN];
+	header.odr_filename[DAT_FILENAME_SIZE - 1] = 0;
+	header.model_filename[DAT_FILENAME_SIZE - 1] = 0;
+	snprintf(line, MAX_LINE_LEN, "Version: %d, OpenDRIVE: %s, 3DModel: %s\n", header.version, header.odr_filename, header.model_filename);
+	out.Write(line);
 	snprintf(line, MAX_LINE_LEN, "time, id, name, x, y, z, h, p, r, speed, wheel_angle, wheel_rot\n");
-	file << line;
+	out.Write(line);
 
-	// Then output all entries with comma separated values
-	for (size_t i = 0; i < player->data_.size(); i++)
+	// Then output all entries with comma separated values, a batch of chunks at a time
+	const char* data = file.GetData() + sizeof(DatHeader);
+	size_t size = file.GetSize() - sizeof(DatHeader);
+	size_t pos = 0;
+	size_t n_entries = 0;
+	DatDecoder decoder;
+	std::vector<std::vector<ObjectStateStructDat>> decoded(n_threads);
+	std::vector<const ObjectStateStructDat*> chunk(n_threads);
+	std::vector<size_t> chunk_size(n_threads);
+	std::vector<std::string> text(n_threads);
+	std::vector<std::thread> workers;
+
+	while (pos < size)
 	{
-		ObjectStateStructDat *state = &player->data_[i].state;
+		unsigned int n_chunks = 0;
+
+		for (; n_chunks < n_threads && pos < size; n_chunks++)
+		{
+			if (header.version == DAT_FILE_FORMAT_VERSION_V2)
+			{
+				// Use records in place, any trailing incomplete record is ignored
+				size_t n = std::min(static_cast<size_t>(ENTRIES_PER_CHUNK), (size - pos) / sizeof(ObjectStateStructDat));
+				chunk[n_chunks] = reinterpret_cast<const ObjectStateStructDat*>(data + pos);
+				chunk_size[n_chunks] = n;
+				pos = n > 0 ? pos + n * sizeof(ObjectStateStructDat) : size;
+			}
+			else
+			{
+				decoded[n_chunks].clear();
+				if (decoder.Decode(data, size, pos, decoded[n_chunks], ENTRIES_PER_CHUNK) != 0)
+				{
+					printf("Failed to decode %s\n", filename.c_str());
+					return -1;
+				}
+				chunk[n_chunks] = decoded[n_chunks].data();
+				chunk_size[n_chunks] = decoded[n_chunks].size();
+			}
+		}
 
-		snprintf(line, MAX_LINE_LEN, "%.3f, %d, %s, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f, %.3f\n",
-			state->info.timeStamp,
-			state->info.id,
-			state->info.name,
-			state->pos.x,
-			state->pos.y,
-			state->pos.z,
-			state->pos.h,
-			state->pos.p,
-			state->pos.r,
-			state->info.speed,
-			state->info.wheel_angle,
-			state->info.wheel_rot);
+		// Format first chunk on this thread, the others in parallel
+		workers.clear();
+		for (unsigned int i = 1; i < n_chunks; i++)
+		{
+			workers.emplace_back(FormatEntries, chunk[i], chunk_size[i], &text[i]);
+		}
+		FormatEntries(chunk[0], chunk_size[0], &text[0]);
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
 
-		file << line;
+		for (unsigned int i = 0; i < n_chunks; i++)
+		{
+			out.Write(text[i]);
+			n_entries += chunk_size[i];
+		}
 	}
 
-	file.close();
+	out.Close();
+
+	double elapsed = timer.GetS();
+	double mbytes = file.GetSize() / 1e6;
+	printf("Created %s (%zu entries) from %.1f MB in %.2f s, %.1f MB/s\n",
+		csv_filename.c_str(), n_entries, mbytes, elapsed, elapsed > SMALL_NUMBER ? mbytes / elapsed : 0.0);
+
+	return 0;
+}
+
+static int ConvertDirectory(std::string dirname, unsigned int n_threads)
+{
+	std::vector<std::string> filenames;
+	DIR* directory = opendir(dirname.c_str());
+
+	if (directory == nullptr)
+	{
+		printf("Couldn't open directory %s\n", dirname.c_str());
+		return -1;
+	}
+
+	struct dirent* file;
+	while ((file = readdir(directory)) != nullptr)
+	{
+		std::string filename = file->d_name;
+		if (file->d_type != DT_DIR && FileNameExtOf(filename) == ".dat")
+		{
+			filenames.push_back(CombineDirectoryPathAndFilepath(dirname, filename));
+		}
+	}
+	closedir(directory);
+
+	// Biggest files first for better load balance
+	std::vector<std::pair<size_t, std::string>> jobs;
+	size_t total_size = 0;
+	for (auto& filename : filenames)
+	{
+		SE_MappedFile f;
+		size_t file_size = f.Open(filename) == 0 ? f.GetSize() : 0;
+		jobs.push_back(std::make_pair(file_size, filename));
+		total_size += file_size;
+	}
+	std::sort(jobs.begin(), jobs.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+	// One file per thread, each formatted sequentially
+	SE_SystemTime timer;
+	std::atomic<size_t> next_job(0);
+	std::atomic<int> n_failed(0);
+	std::vector<std::thread> workers;
+
+	for (unsigned int i = 0; i < std::min(n_threads, static_cast<unsigned int>(jobs.size())); i++)
+	{
+		workers.emplace_back([&]()
+		{
+			for (size_t j = next_job++; j < jobs.size(); j = next_job++)
+			{
+				std::string csv_filename = FileNameWithoutExtOf(jobs[j].second) + ".csv";
+				if (ConvertFile(jobs[j].second, CombineDirectoryPathAndFilepath(dirname, csv_filename), 1) != 0)
+				{
+					n_failed++;
+				}
+			}
+		});
+	}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	double elapsed = timer.GetS();
+	printf("Converted %zu of %zu files, %.1f MB in %.2f s, %.1f MB/s\n", jobs.size() - static_cast<size_t>(n_failed.load()),
+		jobs.size(), total_size / 1e6, elapsed, elapsed > SMALL_NUMBER ? total_size / 1e6 / elapsed : 0.0);
+
+	return n_failed > 0 ? -1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	std::setlocale(LC_ALL, "C.UTF-8");
+
+	if (argc < 2)
+	{
+		printf("Usage: %s <filename or directory> [Number of threads, default=number of cores]\n", argv[0]);
+		return -1;
+	}
+
+	unsigned int n_threads = std::max(1u, std::thread::hardware_concurrency());
+	if (argc > 2)
+	{
+		n_threads = static_cast<unsigned int>(std::max(1, strtoi(argv[2])));
+	}
+
+	std::string path = argv[1];
+	DIR* directory = opendir(path.c_str());
+	if (directory != nullptr)
+	{
+		closedir(directory);
+		return ConvertDirectory(path, n_threads);
+	}
 
-	delete player;
-}
\ No newline at end of file
+	return ConvertFile(path, FileNameWithoutExtOf(path) + ".csv", n_threads);
+}
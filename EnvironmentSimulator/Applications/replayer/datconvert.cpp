@@ -0,0 +1,61 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+ /*
+  * This application uses the Replay class to convert recordings of older format into current, compact, .dat format
+  */
+
+#include "Replay.hpp"
+#include "CommonMini.hpp"
+
+using namespace scenarioengine;
+
+int main(int argc, char** argv)
+{
+	Replay* player;
+
+	if (argc < 3)
+	{
+		printf("Usage: %s <input filename> <output filename>\n", argv[0]);
+		return -1;
+	}
+
+	if (std::string(argv[1]) == std::string(argv[2]))
+	{
+		printf("Input and output must be different files\n");
+		return -1;
+	}
+
+	try
+	{
+		player = new Replay(argv[1], false);
+	}
+	catch (const std::exception& e)
+	{
+		printf("%s", e.what());
+		return -1;
+	}
+
+	int retval = player->SaveDatfile(argv[2]);
+	if (retval == 0)
+	{
+		printf("Converted %s (version %d) into %s (version %d)\n", argv[1], player->header_.version, argv[2], DAT_FILE_FORMAT_VERSION);
+	}
+	else
+	{
+		printf("Failed to create file %s\n", argv[2]);
+	}
+
+	delete player;
+
+	return retval;
+}
@@ -49,6 +49,7 @@ static std::vector<int> removeObjects;
 double deltaSimTime;  // external - used by Viewer::RubberBandCamera
 
 static std::vector<ScenarioEntity> scenarioEntity;
+static std::map<int, size_t> scenarioEntityIndex;  // index in scenarioEntity per object id
 
 
 void log_callback(const char* str)
@@ -74,12 +75,11 @@ void setEntityVisibility(int index, bool visible)
 
 ScenarioEntity *getScenarioEntityById(int id)
 {
-	for (size_t i=0; i<scenarioEntity.size(); i++)
+	auto it = scenarioEntityIndex.find(id);
+
+	if (it != scenarioEntityIndex.end())
 	{
-		if (scenarioEntity[i].id == id)
-		{
-			return &scenarioEntity[i];
-		}
+		return &scenarioEntity[it->second];
 	}
 
 	return 0;
@@ -115,46 +115,45 @@ int ParseEntities(viewer::Viewer* viewer, Replay* player)
 	};
 	std::map<int, OdoInfo> odo_info;  // temporary keep track of entity odometers
 
-	for (int i = 0; i < player->data_.size(); i++)
+	for (size_t i = 0; i < player->GetNumberOfEntries(); i++)
 	{
-		ReplayEntry* entry = &player->data_[i];
-		ObjectStateStructDat* state = &entry->state;
+		ObjectStateStructDat state = *player->GetStateByIndex(i);  // copy, may be overwritten by further lookups
 		OdoInfo odo_entry;
 
-		if (no_ghost && state->info.ctrl_type == GHOST_CTRL_TYPE)
+		if (no_ghost && state.info.ctrl_type == GHOST_CTRL_TYPE)
 		{
 			continue;
 		}
 
-		if (std::find(removeObjects.begin(), removeObjects.end(), state->info.id) != removeObjects.end())
+		if (std::find(removeObjects.begin(), removeObjects.end(), state.info.id) != removeObjects.end())
 		{
 			continue;
 		}
 
-		ScenarioEntity* sc = getScenarioEntityById(state->info.id);
+		ScenarioEntity* sc = getScenarioEntityById(state.info.id);
 
 		// If not available, create it
 		if (sc == 0)
 		{
 			ScenarioEntity new_sc;
 
-			new_sc.id = state->info.id;
+			new_sc.id = state.info.id;
 			new_sc.trajPoints = 0;
 			new_sc.pos = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0, 0, 0.0f, 0.0f };
 			new_sc.trajectory = nullptr;
 			new_sc.wheel_angle = 0.0f;
 			new_sc.wheel_rotation = 0.0f;
-			new_sc.name = state->info.name;
+			new_sc.name = state.info.name;
 			new_sc.visible = true;
 			std::string filename;
-			if (state->info.model_id >= 0)
+			if (state.info.model_id >= 0)
 			{
-				filename = SE_Env::Inst().GetModelFilenameById(state->info.model_id);
+				filename = SE_Env::Inst().GetModelFilenameById(state.info.model_id);
 			}
 
 			if ((new_sc.entityModel = viewer->CreateEntityModel(filename.c_str(), osg::Vec4(0.5, 0.5, 0.5, 1.0),
-				viewer::EntityModel::EntityType::VEHICLE, false, state->info.name, &state->info.boundingbox,
-				static_cast<EntityScaleMode>(state->info.scaleMode))) == 0)
+				viewer::EntityModel::EntityType::VEHICLE, false, state.info.name, &state.info.boundingbox,
+				static_cast<EntityScaleMode>(state.info.scaleMode))) == 0)
 			{
 				return -1;
 			}
@@ -166,20 +165,21 @@ int ParseEntities(viewer::Viewer* viewer, Replay* player)
 				}
 			}
 
-			if (state->info.ctrl_type == GHOST_CTRL_TYPE && no_ghost_model)
+			if (state.info.ctrl_type == GHOST_CTRL_TYPE && no_ghost_model)
 			{
 				new_sc.entityModel->txNode_->setNodeMask(0x0);
 			}
 
-			new_sc.bounding_box = state->info.boundingbox;
+			new_sc.bounding_box = state.info.boundingbox;
 
 			// Add it to the list of scenario cars
 			scenarioEntity.push_back(new_sc);
+			scenarioEntityIndex[new_sc.id] = scenarioEntity.size() - 1;
 
 			sc = &scenarioEntity.back();
 
-			odo_entry.x = state->pos.x;
-			odo_entry.y = state->pos.y;
+			odo_entry.x = state.pos.x;
+			odo_entry.y = state.pos.y;
 			odo_entry.odometer = 0.0;
 
 			odo_info.insert(std::make_pair(new_sc.id, odo_entry));  // Set inital odometer value for the entity
@@ -192,31 +192,31 @@ int ParseEntities(viewer::Viewer* viewer, Replay* player)
 
 		if (sc->trajPoints->size() == 0)
 		{
-			sc->trajPoints->push_back(osg::Vec3d(state->pos.x, state->pos.y, state->pos.z + z_offset));
+			sc->trajPoints->push_back(osg::Vec3d(state.pos.x, state.pos.y, state.pos.z + z_offset));
 		}
 		else
 		{
-			if (sc->trajPoints->size() > 2 && GetLengthOfLine2D(state->pos.x, state->pos.y,
+			if (sc->trajPoints->size() > 2 && GetLengthOfLine2D(state.pos.x, state.pos.y,
 				(*sc->trajPoints)[sc->trajPoints->size()-2][0], (*sc->trajPoints)[sc->trajPoints->size()-2][1]) < minTrajPointDist)
 			{
 				// Replace last point until distance is above threshold
-				sc->trajPoints->back() = osg::Vec3d(state->pos.x, state->pos.y, state->pos.z + z_offset);
+				sc->trajPoints->back() = osg::Vec3d(state.pos.x, state.pos.y, state.pos.z + z_offset);
 			}
 			else
 			{
-				sc->trajPoints->push_back(osg::Vec3d(state->pos.x, state->pos.y, state->pos.z + z_offset));
+				sc->trajPoints->push_back(osg::Vec3d(state.pos.x, state.pos.y, state.pos.z + z_offset));
 			}
 		}
 
 		// calculate odometer
 		odo_entry = odo_info[sc->id];
-		double delta = GetLengthOfLine2D(odo_entry.x, odo_entry.y, state->pos.x, state->pos.y);
-		odo_entry.x = state->pos.x;
-		odo_entry.y = state->pos.y;
+		double delta = GetLengthOfLine2D(odo_entry.x, odo_entry.y, state.pos.x, state.pos.y);
+		odo_entry.x = state.pos.x;
+		odo_entry.y = state.pos.y;
 		odo_entry.odometer += delta;
 		odo_info[sc->id] = odo_entry;  // save updated odo info for next calculation
 
-		entry->odometer = odo_entry.odometer;  // update odometer
+		player->SetOdometerByIndex(i, odo_entry.odometer);  // update odometer
 	}
 
 	for (int i = 0; i < scenarioEntity.size(); i++)
@@ -354,6 +354,7 @@ int main(int argc, char** argv)
 	opt.AddOption("dir", "Directory containing replays to overlay, pair with \"file\" argument, where \"file\" is .dat filename match substring","path");
 	opt.AddOption("disable_off_screen", "Disable esmini off-screen rendering, revert to OSG viewer default handling");
 	opt.AddOption("hide_trajectories", "Hide trajectories from start (toggle with key 'n')");
+	opt.AddOption("index_file", "Read frame index from <file>.idx, create it if missing or outdated (speeds up opening large recordings)");
 	opt.AddOption("info_text", "Show on-screen info text (toggle key 'i') mode 0=None 1=current (default) 2=per_object 3=both", "mode");
 	opt.AddOption("no_ghost", "Remove ghost entities");
 	opt.AddOption("no_ghost_model", "Remove only ghost model, show trajectory (toggle with key 'g')");
@@ -438,7 +439,8 @@ int main(int argc, char** argv)
 				LOG("\"--saved_merged\" works only in combination with \"--dir\" argument, combining multiple dat files");
 				return -1;
 			}
-			player = std::make_unique<Replay>(opt.GetOptionArg("file"), true);
+			player = std::make_unique<Replay>(opt.GetOptionArg("file"), true,
+				opt.GetOptionSet("index_file") ? Replay::IndexFile::READ_OR_CREATE : Replay::IndexFile::NONE);
 		}
 	}
 	catch (const std::exception& e)
@@ -789,15 +791,15 @@ int main(int argc, char** argv)
 		if (!start_time_str.empty())
 		{
 			double startTime = 1E-3 * strtod(start_time_str);
-			if (startTime < player->data_[0].state.info.timeStamp)
+			if (startTime < player->GetFirstTimestamp())
 			{
-				printf("Specified start time (%.2f) < first timestamp (%.2f), adapting.\n", startTime, player->data_[0].state.info.timeStamp);
-				startTime = player->data_[0].state.info.timeStamp;
+				printf("Specified start time (%.2f) < first timestamp (%.2f), adapting.\n", startTime, player->GetFirstTimestamp());
+				startTime = player->GetFirstTimestamp();
 			}
-			else if (startTime > player->data_.back().state.info.timeStamp)
+			else if (startTime > player->GetLastTimestamp())
 			{
-				printf("Specified start time (%.2f) > last timestamp (%.2f), adapting.\n", startTime, player->data_.back().state.info.timeStamp);
-				startTime = player->data_.back().state.info.timeStamp;
+				printf("Specified start time (%.2f) > last timestamp (%.2f), adapting.\n", startTime, player->GetLastTimestamp());
+				startTime = player->GetLastTimestamp();
 			}
 			player->SetStartTime(startTime);
 			player->GoToTime(startTime);
@@ -807,15 +809,15 @@ int main(int argc, char** argv)
 		if (!stop_time_str.empty())
 		{
 			double stopTime = 1E-3 * strtod(stop_time_str);
-			if (stopTime > player->data_.back().state.info.timeStamp)
+			if (stopTime > player->GetLastTimestamp())
 			{
-				printf("Specified stop time (%.2f) > last timestamp (%.2f), adapting.\n", stopTime, player->data_.back().state.info.timeStamp);
-				stopTime = player->data_.back().state.info.timeStamp;
+				printf("Specified stop time (%.2f) > last timestamp (%.2f), adapting.\n", stopTime, player->GetLastTimestamp());
+				stopTime = player->GetLastTimestamp();
 			}
-			else if (stopTime < player->data_[0].state.info.timeStamp)
+			else if (stopTime < player->GetFirstTimestamp())
 			{
-				printf("Specified stop time (%.2f) < first timestamp (%.2f), adapting.\n", simTime, player->data_[0].state.info.timeStamp);
-				stopTime = player->data_[0].state.info.timeStamp;
+				printf("Specified stop time (%.2f) < first timestamp (%.2f), adapting.\n", simTime, player->GetFirstTimestamp());
+				stopTime = player->GetFirstTimestamp();
 			}
 			player->SetStopTime(stopTime);
 		}
@@ -867,16 +869,16 @@ int main(int argc, char** argv)
 				}
 
 				// Fetch states of scenario objects
-				ReplayEntry* entry = nullptr;
+				int entry_index = -1;
 				ObjectStateStructDat* state = nullptr;
 				for (int index = 0; index < scenarioEntity.size(); index++)
 				{
 					ScenarioEntity* sc = &scenarioEntity[index];
 
-					entry = player->GetEntry(sc->id);
-					if (entry)
+					entry_index = player->GetEntryIndex(sc->id);
+					if (entry_index >= 0)
 					{
-						state = &entry->state;
+						state = player->GetStateByIndex(entry_index);
 					}
 					else
 					{
@@ -911,7 +913,7 @@ int main(int argc, char** argv)
 					// on screen text following each entity
 					snprintf(sc->entityModel->on_screen_info_.string_, sizeof(sc->entityModel->on_screen_info_.string_),
 						" %s (%d) %.2fm\n %.2fkm/h road %d lane %d/%.2f s %.2f\n x %.2f y %.2f hdg %.2f\n osi x %.2f y %.2f \n|",
-						state->info.name, state->info.id, entry->odometer,
+						state->info.name, state->info.id, player->GetOdometerByIndex(entry_index),
 						3.6 * state->info.speed, sc->pos.roadId,
 						sc->pos.laneId, fabs(sc->pos.offset) < SMALL_NUMBER ? 0 : sc->pos.offset, sc->pos.s,
 						sc->pos.x, sc->pos.y, sc->pos.h,
@@ -923,7 +925,7 @@ int main(int argc, char** argv)
 					{
 						// Update overlay info text
 						snprintf(info_str_buf, sizeof(info_str_buf), "%.3fs entity[%d]: %s (%d) %.2fs %.2fkm/h %.2fm (%d, %d, %.2f, %.2f)/(%.2f, %.2f %.2f) tScale: %.2f ",
-							simTime, viewer->currentCarInFocus_, state->info.name, state->info.id, state->info.timeStamp, 3.6 * state->info.speed, entry->odometer, sc->pos.roadId,
+							simTime, viewer->currentCarInFocus_, state->info.name, state->info.id, state->info.timeStamp, 3.6 * state->info.speed, player->GetOdometerByIndex(entry_index), sc->pos.roadId,
 							sc->pos.laneId, fabs(sc->pos.offset) < SMALL_NUMBER ? 0 : sc->pos.offset, sc->pos.s, sc->pos.x, sc->pos.y, sc->pos.h, time_scale);
 						viewer->SetInfoText(info_str_buf);
 					}
@@ -957,7 +959,8 @@ int main(int argc, char** argv)
 									{
 										overlap = true;
 										pause = true;
-										double rel_speed = abs((player->GetState(scenarioEntity[0].id))->info.speed - (player->GetState(scenarioEntity[i].id)->info.speed)) * 3.6;
+										double speed = state->info.speed;  // read before next lookup, which may overwrite state
+										double rel_speed = abs(player->GetState(scenarioEntity[0].id)->info.speed - speed) * 3.6;
 										double rel_angle = (scenarioEntity[0].pos.h - scenarioEntity[i].pos.h) * 180 / M_PI;
 										LOG("Collision between %d and %d at time %.2f.\n- Relative speed %.2f km/h\n- Angle %.2f degrees (ego to target)",
 										0, i, simTime, rel_speed, rel_angle);
@@ -235,6 +235,13 @@ public static class ESMiniLib
         [DllImport(LIB_NAME, EntryPoint = "SE_ReportObjectAngularAcc")]
         public static extern int SE_ReportObjectAngularAcc(int id, float timestamp, float h_acc, float p_acc, float r_acc);
 
+        [DllImport(LIB_NAME, EntryPoint = "SE_ReportObjectStatesBatch")]
+        /// <summary>Report state (id, timestamp, position, speed and wheel status) of multiple objects in one call</summary>
+        /// <param name="states">Array of object states</param>
+        /// <param name="nStates">Number of states in the array</param>
+        /// <return>Number of reported objects, -1 on error e.g. scenario not initialized</return>
+        public static extern int SE_ReportObjectStatesBatch([In] ScenarioObjectState[] states, int nStates);
+
         #endregion
         [DllImport(LIB_NAME, EntryPoint = "SE_SetLockOnLane")]
         /// <summary>Controls whether to keep lane ID regardless of lateral position or snap to closest lane (default)</summary>
@@ -254,6 +261,13 @@ public static class ESMiniLib
         /// <return>0 if successful, -1 if not</return>
         public static extern int SE_GetObjectState(int index, ref ScenarioObjectState state);
 
+        [DllImport(LIB_NAME, EntryPoint = "SE_GetAllObjectStates")]
+        /// <summary>Get the state of all objects in one call</summary>
+        /// <param name="states">Array of ScenarioObjectState structs to be filled in</param>
+        /// <param name="capacity">Size of the array</param>
+        /// <return>Number of objects in the scenario, -1 on error e.g. scenario not initialized</return>
+        public static extern int SE_GetAllObjectStates([In, Out] ScenarioObjectState[] states, int capacity);
+
         [DllImport(LIB_NAME, EntryPoint = "SE_GetObjectTypeName")]
         //[return: MarshalAs(UnmanagedType.LPStr)]
         /// <summary>Get the type name of the specifed vehicle-, pedestrian- or misc object</summary>
@@ -879,6 +879,29 @@ extern "C"
 		RegisterParameterDeclarationCallback(nullptr, nullptr);
 	}
 
+	SE_DLL_API int SE_Reset(int permutationIndex)
+	{
+		if (player == nullptr)
+		{
+			return -1;
+		}
+
+		OSCParameterDistribution& dist = OSCParameterDistribution::Inst();
+		if (permutationIndex > -1 && dist.GetNumPermutations() > 0)
+		{
+			if (permutationIndex >= dist.GetNumPermutations())
+			{
+				LOG("Requested permutation %d out of range [%d .. %d]", permutationIndex, 0, dist.GetNumPermutations() - 1);
+				return -1;
+			}
+			dist.SetRequestedIndex(permutationIndex);
+		}
+
+		time_stamp = 0;
+
+		return player->Reset();
+	}
+
 	SE_DLL_API void SE_LogToConsole(bool mode)
 	{
 		logToConsole = mode;
@@ -889,6 +912,33 @@ extern "C"
 		SE_Env::Inst().SetCollisionDetection(mode);
 	}
 
+	SE_DLL_API int SE_OpenSharedMemory(const char *name, int lockstep_timeout)
+	{
+		if (player == nullptr || name == nullptr)
+		{
+			return -1;
+		}
+
+		return player->OpenSharedMemory(name, lockstep_timeout);
+	}
+
+	SE_DLL_API int SE_GetFrameTimingStats(SE_FrameTimingStats *stats)
+	{
+		if (player == nullptr || stats == nullptr || !player->frameScheduler.IsActive())
+		{
+			return -1;
+		}
+
+		const SE_FrameScheduler::Stats& s = player->frameScheduler.GetStats();
+		stats->frames = static_cast<int>(s.frames);
+		stats->overruns = static_cast<int>(s.overruns);
+		stats->skipped = static_cast<int>(s.skipped);
+		stats->jitter_avg = static_cast<float>(s.jitter_avg_us);
+		stats->jitter_max = static_cast<float>(s.jitter_max_us);
+
+		return 0;
+	}
+
 	SE_DLL_API int SE_OpenOSISocket(const char *ipaddr)
 	{
 		if (player == nullptr)
@@ -1244,6 +1294,36 @@ extern "C"
 		return 0;
 	}
 
+	SE_DLL_API int SE_ReportObjectStatesBatch(const SE_ScenarioObjectState *states, int nStates)
+	{
+		if (player == nullptr || states == nullptr)
+		{
+			return -1;
+		}
+
+		int counter = 0;
+		ScenarioGateway* gw = player->scenarioGateway;
+
+		for (int i = 0; i < nStates; i++)
+		{
+			const SE_ScenarioObjectState* state = &states[i];
+
+			if (!gw->isObjectReported(state->id))
+			{
+				LOG("Invalid object_id (%d)", state->id);
+				continue;
+			}
+
+			gw->updateObjectWorldPos(state->id, state->timestamp, state->x, state->y, state->z, state->h, state->p, state->r);
+			gw->updateObjectSpeed(state->id, state->timestamp, state->speed);
+			gw->updateObjectWheelRotation(state->id, state->timestamp, state->wheel_rot);
+			gw->updateObjectWheelAngle(state->id, state->timestamp, state->wheel_angle);
+			counter++;
+		}
+
+		return counter;
+	}
+
 	SE_DLL_API int SE_SetLockOnLane(int id, bool mode)
 	{
 		if (player == nullptr)
@@ -1316,6 +1396,23 @@ extern "C"
 		return -1;
 	}
 
+	SE_DLL_API int SE_GetAllObjectStates(SE_ScenarioObjectState *states, int capacity)
+	{
+		if (player == nullptr)
+		{
+			return -1;
+		}
+
+		int n = player->scenarioGateway->getNumberOfObjects();
+
+		for (int i = 0; states != nullptr && i < n && i < capacity; i++)
+		{
+			copyStateFromScenarioGateway(&states[i], &player->scenarioGateway->getObjectStatePtrByIdx(i)->state_);
+		}
+
+		return n;
+	}
+
 	SE_DLL_API int SE_GetOverrideActionStatus(int object_id, SE_OverrideActionList *list)
 	{
 		Object* obj = nullptr;
@@ -1776,6 +1873,25 @@ extern "C"
 		return -1;
 	}
 
+	SE_DLL_API int SE_SetObjectSensorOcclusion(int sensor_id, bool mode)
+	{
+		if (player == nullptr)
+		{
+			return -1;
+		}
+
+		// check sign before comparing with the unsigned size
+		if (sensor_id < 0 || static_cast<size_t>(sensor_id) >= player->sensor.size())
+		{
+			LOG("Invalid sensor_id (%d specified / %d available)", sensor_id, static_cast<int>(player->sensor.size()));
+			return -1;
+		}
+
+		player->sensor[static_cast<size_t>(sensor_id)]->SetOcclusion(mode);
+
+		return 0;
+	}
+
 	SE_DLL_API int SE_GetRoadInfoAtDistance(int object_id, float lookahead_distance, SE_RoadInfo *data, int lookAheadMode, bool inRoadDrivingDirection)
 	{
 		Object* obj = nullptr;
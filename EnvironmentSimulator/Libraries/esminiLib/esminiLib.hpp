@@ -171,6 +171,15 @@ typedef struct
 	unsigned char* data;
 } SE_Image;  // Should be synked with CommonMini/OffScreenImage
 
+typedef struct
+{
+	int frames;          // number of paced frames
+	int overruns;        // frames started after their deadline
+	int skipped;         // deadlines missed completely
+	float jitter_avg;    // average deviation of frame start from deadline (microseconds)
+	float jitter_max;    // max deviation of frame start from deadline (microseconds)
+} SE_FrameTimingStats;
+
 
 #ifdef __cplusplus
 extern "C"
@@ -368,6 +377,15 @@ extern "C"
 	*/
 	SE_DLL_API void SE_Close();
 
+	/**
+		Restart the scenario from the beginning, much faster than SE_Close + SE_Init. Road network, viewer and OSI
+		reporter are kept while storyboard, entities and controllers are recreated. Any object sensors are removed.
+		Real time pacing, if active, starts over at the first frame, see SE_GetFrameTimingStats.
+		@param permutationIndex Parameter permutation to apply, -1 = next one. Ignored if no parameter distribution is loaded.
+		@return 0 if successful, -1 if not
+	*/
+	SE_DLL_API int SE_Reset(int permutationIndex);
+
 	/**
 		Enable or disable log to stdout/console
 		@param mode true=enable, false=disable
@@ -791,6 +809,16 @@ extern "C"
 	*/
 	SE_DLL_API int SE_ReportObjectWheelStatus(int object_id, float rotation, float angle);
 
+	/**
+		Report state of multiple objects in one call, e.g. all externally controlled objects of a frame.
+		For each state the fields id, timestamp, x, y, z, h, p, r, speed, wheel_angle and wheel_rot are used,
+		corresponding to SE_ReportObjectPos, SE_ReportObjectSpeed and SE_ReportObjectWheelStatus.
+		@param states Array of object states
+		@param nStates Number of states in the array
+		@return Number of reported objects, states of unknown objects are skipped. -1 on error e.g. scenario not initialized
+	*/
+	SE_DLL_API int SE_ReportObjectStatesBatch(const SE_ScenarioObjectState *states, int nStates);
+
 
 	/**
 		Controls whether to keep lane ID regardless of lateral position or snap to closest lane (default)
@@ -827,6 +855,14 @@ extern "C"
 	*/
 	SE_DLL_API int SE_GetObjectState(int object_id, SE_ScenarioObjectState *state);
 
+	/**
+		Get the state of all objects in one call, in same order as SE_GetId
+		@param states Array of SE_ScenarioObjectState structs to be filled in
+		@param capacity Size of the array. If less than number of objects only the first ones are filled in
+		@return Number of objects in the scenario, -1 on error e.g. scenario not initialized
+	*/
+	SE_DLL_API int SE_GetAllObjectStates(SE_ScenarioObjectState *states, int capacity);
+
 	/**
 		Get the overrideActionStatus of specified object
 		@param objectId ID of the object.
@@ -963,6 +999,15 @@ extern "C"
 	*/
 	SE_DLL_API int SE_FetchSensorObjectList(int sensor_id, int *list);
 
+	/**
+		Skip objects completely hidden behind nearer objects, as seen from the sensor in 2D (bird's eye view).
+		Partly hidden objects are still detected. Default is off.
+		@param sensor_id Handle (index) to the sensor
+		@param mode true=enable occlusion, false=disable
+		@return 0 if successful, -1 if not
+	*/
+	SE_DLL_API int SE_SetObjectSensorOcclusion(int sensor_id, bool mode);
+
 	/**
 		Register a function and optional parameter (ref) to be called back from esmini after each frame (update of scenario)
 		The current state of specified entity will be returned.
@@ -1040,6 +1085,24 @@ extern "C"
 	*/
 	SE_DLL_API int SE_GetRoadSignValidityRecord(int road_id, int signIndex, int validityIndex, SE_RoadObjValidity* validity);
 
+	/**
+		Exchange object states with external processes via shared memory, as an alternative to UDP.
+		All object states are published every step, and input from clients is applied at the next step.
+		See SharedMemoryExchange.hpp and scripts/shm_driver.py.
+		@param name Name of the shared memory region, e.g. "esmini"
+		@param lockstep_timeout Max time (ms) to wait each step for clients to respond, 0 = no lockstep
+		@return 0 if successful, -1 if not
+	*/
+	SE_DLL_API int SE_OpenSharedMemory(const char *name, int lockstep_timeout);
+
+	/**
+		Get frame timing statistics of real time pacing, enabled by arguments --fixed_timestep <dt> --pace_realtime
+		Each SE_Step() then waits for its absolute deadline, start time + n * dt.
+		@param stats Pointer/reference to a SE_FrameTimingStats struct to be filled in
+		@return 0 if successful, -1 if not (e.g. pacing not active)
+	*/
+	SE_DLL_API int SE_GetFrameTimingStats(SE_FrameTimingStats *stats);
+
 	// OSI interface
 	//
 
@@ -18,6 +18,7 @@
 #include <sstream>
 #include <locale>
 #include <array>
+#include <unordered_map>
 
 
 // UDP network includes
@@ -27,10 +28,21 @@
 	#include <arpa/inet.h>
 	#include <netdb.h>  /* Needed for getaddrinfo() and freeaddrinfo() */
 	#include <unistd.h> /* Needed for close() */
+	#include <fcntl.h>
+	#include <sys/mman.h>
 #else
+	// Keep min/max macros and rarely used APIs out, e.g. for builds not setting these flags (MinGW)
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
 	#include <winsock2.h>
 	#include <Ws2tcpip.h>
+	#include <windows.h>
 #endif
+#include <sys/stat.h>
 
 #include "CommonMini.hpp"
 
@@ -574,6 +586,7 @@ double strtod(std::string s)
 #if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
 
 	#include <windows.h>
+	#include <mmsystem.h>  // timeGetTime, excluded from windows.h by WIN32_LEAN_AND_MEAN
 	#include <process.h>
 
 	__int64 SE_getSystemTime()
@@ -586,6 +599,36 @@ double strtod(std::string s)
 		Sleep(msec);
 	}
 
+	__int64 SE_getMonotonicTimeNs()
+	{
+		static LARGE_INTEGER frequency = { 0 };
+		LARGE_INTEGER counter;
+
+		if (frequency.QuadPart == 0)
+		{
+			QueryPerformanceFrequency(&frequency);
+		}
+		QueryPerformanceCounter(&counter);
+
+		// split to avoid overflow of counter * 1e9
+		return (counter.QuadPart / frequency.QuadPart) * 1000000000LL +
+			(counter.QuadPart % frequency.QuadPart) * 1000000000LL / frequency.QuadPart;
+	}
+
+	void SE_sleepUntilNs(__int64 deadline_ns)
+	{
+		// Sleep has millisecond granularity at best, so leave a full ms for spinning
+		__int64 remaining_ns = deadline_ns - SE_getMonotonicTimeNs();
+		if (remaining_ns > 1000000 + SE_SPIN_TIME_NS)
+		{
+			Sleep(static_cast<DWORD>((remaining_ns - SE_SPIN_TIME_NS) / 1000000 - 1));
+		}
+
+		while (SE_getMonotonicTimeNs() < deadline_ns)
+		{
+		}
+	}
+
 #else
 
 	#include <chrono>
@@ -602,13 +645,129 @@ double strtod(std::string s)
 		std::this_thread::sleep_for(std::chrono::milliseconds((int)(msec)));
 	}
 
+#ifdef __linux__
+
+	#include <time.h>
+	#include <errno.h>
+
+	__int64 SE_getMonotonicTimeNs()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+
+		return static_cast<__int64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+	}
+
+	void SE_sleepUntilNs(__int64 deadline_ns)
+	{
+		__int64 wakeup_ns = deadline_ns - SE_SPIN_TIME_NS;
+
+		if (wakeup_ns > SE_getMonotonicTimeNs())
+		{
+			struct timespec ts;
+			ts.tv_sec = static_cast<time_t>(wakeup_ns / 1000000000LL);
+			ts.tv_nsec = static_cast<long>(wakeup_ns % 1000000000LL);
+
+			// Absolute time, so an interrupted sleep is simply restarted
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+			{
+			}
+		}
+
+		while (SE_getMonotonicTimeNs() < deadline_ns)
+		{
+		}
+	}
+
+#else
+
+	__int64 SE_getMonotonicTimeNs()
+	{
+		return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	void SE_sleepUntilNs(__int64 deadline_ns)
+	{
+		__int64 wakeup_ns = deadline_ns - SE_SPIN_TIME_NS;
+
+		if (wakeup_ns > SE_getMonotonicTimeNs())
+		{
+			std::this_thread::sleep_until(steady_clock::time_point(duration_cast<steady_clock::duration>(nanoseconds(wakeup_ns))));
+		}
+
+		while (SE_getMonotonicTimeNs() < deadline_ns)
+		{
+		}
+	}
+
 #endif
 
+#endif
+
+void SE_FrameScheduler::Start(double period_s)
+{
+	period_ns_ = static_cast<__int64>(period_s * 1e9 + 0.5);
+	next_deadline_ns_ = 0;  // schedule is anchored at first frame
+	ResetStats();
+}
+
+void SE_FrameScheduler::Restart()
+{
+	next_deadline_ns_ = 0;
+	ResetStats();
+}
+
+void SE_FrameScheduler::ResetStats()
+{
+	memset(&stats_, 0, sizeof(stats_));
+	jitter_sum_us_ = 0.0;
+}
+
+void SE_FrameScheduler::WaitForNextFrame()
+{
+	if (period_ns_ <= 0)
+	{
+		return;
+	}
+
+	__int64 now = SE_getMonotonicTimeNs();
+
+	if (next_deadline_ns_ == 0)
+	{
+		next_deadline_ns_ = now;
+	}
+	else if (now > next_deadline_ns_)
+	{
+		stats_.overruns++;
+		if (now - next_deadline_ns_ >= period_ns_)
+		{
+			// Skip missed deadlines, keeping the phase of the original schedule
+			__int64 missed = (now - next_deadline_ns_) / period_ns_;
+			stats_.skipped += missed;
+			next_deadline_ns_ += missed * period_ns_;
+		}
+	}
+	else
+	{
+		SE_sleepUntilNs(next_deadline_ns_);
+		now = SE_getMonotonicTimeNs();
+	}
+
+	double jitter_us = 1e-3 * static_cast<double>(now - next_deadline_ns_);
+	jitter_sum_us_ += jitter_us;
+	stats_.frames++;
+	stats_.jitter_avg_us = jitter_sum_us_ / static_cast<double>(stats_.frames);
+	stats_.jitter_max_us = MAX(stats_.jitter_max_us, jitter_us);
+
+	next_deadline_ns_ += period_ns_;
+}
+
 double SE_getSimTimeStep(__int64 &time_stamp, double min_time_step, double max_time_step)
 {
 	double dt;
 
-	__int64 now = SE_getSystemTime();
+	// Monotonic clock with sub-millisecond resolution, time_stamp is in nanoseconds
+	__int64 now = SE_getMonotonicTimeNs();
 
 	if (time_stamp == 0)
 	{
@@ -617,7 +776,7 @@ double SE_getSimTimeStep(__int64 &time_stamp, double min_time_step, double max_t
 	}
 	else
 	{
-		dt = (now - time_stamp) * 0.001;  // step size in seconds
+		dt = (now - time_stamp) * 1e-9;  // step size in seconds
 
 		if (dt > max_time_step) // limit step size
 		{
@@ -625,9 +784,9 @@ double SE_getSimTimeStep(__int64 &time_stamp, double min_time_step, double max_t
 		}
 		else if (dt < min_time_step)  // avoid CPU rush, sleep for a while
 		{
-			SE_sleep((int)((min_time_step - dt) * 1000));
-			now = SE_getSystemTime();
-			dt = (now - time_stamp) * 0.001;
+			SE_sleepUntilNs(time_stamp + static_cast<__int64>(min_time_step * 1e9));
+			now = SE_getMonotonicTimeNs();
+			dt = (now - time_stamp) * 1e-9;
 		}
 	}
 	time_stamp = now;
@@ -907,7 +1066,99 @@ std::string SE_Env::GetModelFilenameById(int model_id)
 	return name;
 }
 
-Logger::Logger() : callback_(0), time_(0)
+// Bounded multi-producer queue, see https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// Producers format messages directly into their claimed entry, the writer thread is the only consumer.
+typedef struct
+{
+	std::atomic<size_t> seq;
+	size_t pos;  // queue position the entry was claimed for
+	bool has_time;
+	bool trace;
+	int line;
+	double time;
+	const char* file;
+	const char* func;
+	const char* format;  // call site, part of the key for rate limiting of repeated messages
+	char message[LOG_MESSAGE_SIZE];
+} LogEntry;
+
+class LogQueue
+{
+public:
+	LogQueue() : enqueue_pos_(0), dequeue_pos_(0), written_(0)
+	{
+		for (size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+		{
+			entries_[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Claim next free entry, waiting if queue is full
+	LogEntry* BeginWrite()
+	{
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			LogEntry* entry = &entries_[pos & (LOG_QUEUE_SIZE - 1)];
+			intptr_t diff = static_cast<intptr_t>(entry->seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+			if (diff == 0)
+			{
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					entry->pos = pos;
+					return entry;
+				}
+			}
+			else if (diff < 0)
+			{
+				SE_sleep(0);  // full, wait for writer thread to catch up
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+			else
+			{
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void EndWrite(LogEntry* entry)
+	{
+		entry->seq.store(entry->pos + 1, std::memory_order_release);
+	}
+
+	// Return next complete entry or nullptr if none, only to be called by the single consumer
+	LogEntry* BeginRead()
+	{
+		LogEntry* entry = &entries_[dequeue_pos_ & (LOG_QUEUE_SIZE - 1)];
+		if (entry->seq.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+		{
+			return nullptr;
+		}
+		return entry;
+	}
+
+	void EndRead(LogEntry* entry)
+	{
+		entry->seq.store(dequeue_pos_ + LOG_QUEUE_SIZE, std::memory_order_release);
+		dequeue_pos_++;
+		written_.store(dequeue_pos_, std::memory_order_release);
+	}
+
+	size_t GetEnqueuePos() { return enqueue_pos_.load(); }
+	size_t GetWritten() { return written_.load(); }
+
+private:
+	LogEntry entries_[LOG_QUEUE_SIZE];
+	std::atomic<size_t> enqueue_pos_;
+	size_t dequeue_pos_;
+	std::atomic<size_t> written_;  // number of entries written, for Flush()
+};
+
+// Set for the async writer thread, messages logged by it (from the callback) bypass the queue
+static thread_local bool log_writer_thread = false;
+
+Logger::Logger() : callback_(0), time_(0), level_(LogLevel::LEVEL_INFO), queue_(nullptr), producers_(0),
+	writer_queue_(nullptr), quit_(false), writer_waiting_(false)
 {
 	callback_ = 0;
 	time_ = 0;
@@ -915,6 +1166,7 @@ Logger::Logger() : callback_(0), time_(0)
 
 Logger::~Logger()
 {
+	// Never called, see Inst()
 	if (file_.is_open())
 	{
 		file_.close();
@@ -930,127 +1182,432 @@ bool Logger::IsCallbackSet()
 
 void Logger::Log(bool quit, bool trace, char const* file, char const* func, int line, char const* format, ...)
 {
-	static char complete_entry[2048];
-	static char message[1024];
-
-	mutex_.Lock();  // Protect from simultanous use from different threads
+	va_list args;
+	va_start(args, format);
+	LogV(quit ? LogLevel::LEVEL_ERROR : LogLevel::LEVEL_INFO, quit, trace, file, func, line, format, args);
+	va_end(args);
+}
 
+void Logger::LogDebug(char const* file, char const* func, int line, char const* format, ...)
+{
 	va_list args;
 	va_start(args, format);
-	vsnprintf(message, 1024, format, args);
+	LogV(LogLevel::LEVEL_DEBUG, false, false, file, func, line, format, args);
+	va_end(args);
+}
+
+void Logger::LogV(LogLevel level, bool quit, bool trace, char const* file, char const* func, int line, char const* format, va_list args)
+{
+	if (level < level_)
+	{
+		return;
+	}
 
 #ifdef DEBUG_TRACE
 	// enforce trace
 	trace = true;
 #endif
-	if (time_)
+
+	if (log_writer_thread)
+	{
+		// Logged by the callback. The writer thread already holds the mutex and the queue might be full,
+		// so write to file directly. Skip the callback to avoid recursion.
+		char message[LOG_MESSAGE_SIZE];
+		char entry[LOG_MESSAGE_SIZE + 1024];
+		vsnprintf(message, LOG_MESSAGE_SIZE, format, args);
+		FormatEntry(entry, sizeof(entry), time_, trace, file, func, line, message);
+		if (file_.is_open())
+		{
+			file_ << entry << '\n';
+		}
+		return;
+	}
+
+	if (!quit)
+	{
+		// Register as user of the queue, so that it's not deleted meanwhile by SetAsync(false)
+		producers_++;
+		LogQueue* queue = queue_.load();
+		if (queue != nullptr)
+		{
+			LogEntry* entry = queue->BeginWrite();
+			entry->has_time = time_ != nullptr;
+			entry->time = time_ ? *time_ : 0.0;
+			entry->trace = trace;
+			entry->file = file;
+			entry->func = func;
+			entry->line = line;
+			entry->format = format;
+			vsnprintf(entry->message, LOG_MESSAGE_SIZE, format, args);
+			queue->EndWrite(entry);
+			producers_--;
+			WakeWriter(false);
+			return;
+		}
+		producers_--;
+	}
+	else
+	{
+		// Preserve order, write any queued messages before the final one
+		Flush();
+	}
+
+	char message[LOG_MESSAGE_SIZE];
+	vsnprintf(message, LOG_MESSAGE_SIZE, format, args);
+
+	mutex_.Lock();  // Protect from simultanous use from different threads
+	Write(time_, trace, file, func, line, message, true);
+	std::string entry = complete_entry_;
+	mutex_.Unlock();
+
+	if (quit)
+	{
+		throw std::runtime_error(entry);
+	}
+}
+
+void Logger::FormatEntry(char* buf, size_t size, const double* time, bool trace, char const* file, char const* func,
+	int line, const char* message)
+{
+	if (time)
 	{
 		if (trace)
 		{
-			snprintf(complete_entry, 2048, "%.3f %s / %d / %s(): %s", *time_, file, line, func, message);
+			snprintf(buf, size, "%.3f %s / %d / %s(): %s", *time, file, line, func, message);
 		}
 		else
 		{
-			snprintf(complete_entry, 2048, "%.3f: %s", *time_, message);
+			snprintf(buf, size, "%.3f: %s", *time, message);
 		}
 	}
 	else
 	{
 		if (trace)
 		{
-			snprintf(complete_entry, 2048, "%s / %d / %s(): %s", file, line, func, message);
+			snprintf(buf, size, "%s / %d / %s(): %s", file, line, func, message);
 		}
 		else
 		{
-			strncpy(complete_entry, message, 1024);
+			snprintf(buf, size, "%s", message);
 		}
 	}
+}
+
+void Logger::Write(const double* time, bool trace, char const* file, char const* func, int line, const char* message, bool flush)
+{
+	FormatEntry(complete_entry_, sizeof(complete_entry_), time, trace, file, func, line, message);
 
 	if (file_.is_open())
 	{
-		file_ << complete_entry << std::endl;
-		file_.flush();
+		file_ << complete_entry_ << '\n';
+		if (flush)
+		{
+			file_.flush();
+		}
 	}
 
 	if (callback_)
 	{
-		callback_(complete_entry);
+		callback_(complete_entry_);
 	}
+}
 
-	va_end(args);
-
-	mutex_.Unlock();
-
-	if (quit)
+void Logger::WaitForMessages(LogQueue* queue, __int64 deadline_ns)
+{
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+	(void)queue;
+	(void)deadline_ns;
+	SE_sleep(1);
+#else
+	std::unique_lock<std::mutex> lock(wake_mutex_);
+	writer_waiting_ = true;
+	// Producers check writer_waiting_ after adding their entry, see WakeWriter(). At least one side sees the other.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto ready = [this, queue] { return quit_ || queue->BeginRead() != nullptr; };
+	if (deadline_ns > 0)
+	{
+		wake_cv_.wait_for(lock, std::chrono::nanoseconds(MAX(0, deadline_ns - SE_getMonotonicTimeNs())), ready);
+	}
+	else
 	{
-		throw std::runtime_error(complete_entry);
+		wake_cv_.wait(lock, ready);
 	}
+	writer_waiting_ = false;
+#endif
 }
 
-void Logger::SetCallback(FuncPtr callback)
+void Logger::WakeWriter(bool flushed)
 {
-	callback_ = callback;
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+	(void)flushed;
+#else
+	if (flushed)
+	{
+		// Called by the writer thread after writing messages
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		flushed_cv_.notify_all();
+		return;
+	}
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (writer_waiting_.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		wake_cv_.notify_one();
+	}
+#endif
 }
 
-Logger& Logger::Inst()
+// Identifies repeated messages, same text from same call site. FNV-1a, see http://www.isthe.com/chongo/tech/comp/fnv/
+static unsigned long long LogMessageKey(const char* format, const char* message)
 {
-	static Logger instance_;
-	return instance_;
+	unsigned long long hash = 14695981039346656037ULL ^ static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(format));
+	for (const char* c = message; *c != 0; c++)
+	{
+		hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+	}
+	return hash;
 }
 
-void Logger::OpenLogfile(std::string filename)
+void Logger::WriterThread(void* args)
 {
-#ifndef SUPPRESS_LOG
-	if (!filename.empty())
+	typedef struct
 	{
-		if (file_.is_open())
-		{
-			// Close any open logfile, perhaps user want a new with unique filename
-			file_.close();
-		}
+		__int64 window_start;
+		int count;
+		int suppressed;
+		bool has_time;
+		double time;  // of last suppressed message
+		std::string message;  // copy of suppressed message, for the summary
+	} RateState;
 
-		file_.open(filename.c_str());
-		if (file_.fail())
+	Logger* logger = static_cast<Logger*>(args);
+	LogQueue* queue = logger->writer_queue_;
+	std::unordered_map<unsigned long long, RateState> rate;
+	__int64 next_expiry = 0;  // earliest end of any rate limit window, 0 = none
+	int n_pending = 0;  // number of windows with suppressed messages
+	char summary[LOG_MESSAGE_SIZE];
+
+	log_writer_thread = true;
+
+	for (;;)
+	{
+		int n = 0;
+		LogEntry* entry;
+		__int64 now = SE_getMonotonicTimeNs();
+
+		logger->mutex_.Lock();
+
+		// Report suppressed messages as soon as their window ends, and forget expired windows
+		if (next_expiry > 0 && (now >= next_expiry || logger->quit_))
 		{
-			const char* filename_tmp = std::tmpnam(NULL);
-			printf("Cannot open log file: %s in working directory. Trying system tmp-file: %s\n",
-				SE_Env::Inst().GetLogFilePath().c_str(), filename_tmp);
-			file_.open(filename_tmp);
-			if (file_.fail())
+			next_expiry = 0;
+			for (auto it = rate.begin(); it != rate.end();)
 			{
-				printf("Also failed to open log file: %s. Continue without logfile, still logging to console.\n", filename_tmp);
+				RateState& state = it->second;
+				if (now - state.window_start >= 1000000000LL || logger->quit_)
+				{
+					if (state.suppressed > 0)
+					{
+						snprintf(summary, sizeof(summary), "(%d repeated messages suppressed: %.*s)", state.suppressed,
+							LOG_MESSAGE_SIZE - 64, state.message.c_str());
+						logger->Write(state.has_time ? &state.time : nullptr, false, nullptr, nullptr, 0, summary, false);
+						n_pending--;
+						n++;
+					}
+					it = rate.erase(it);
+				}
+				else
+				{
+					next_expiry = next_expiry == 0 ? state.window_start + 1000000000LL : MIN(next_expiry, state.window_start + 1000000000LL);
+					++it;
+				}
 			}
 		}
-	}
-#endif
-}
 
-void Logger::LogVersion()
-{
-	static char message[1024];
+		while ((entry = queue->BeginRead()) != nullptr)
+		{
+			// Rate limit repeated messages over one second windows
+			RateState& state = rate[LogMessageKey(entry->format, entry->message)];
+			if (state.count == 0)
+			{
+				state.window_start = now;
+				next_expiry = next_expiry == 0 ? now + 1000000000LL : MIN(next_expiry, now + 1000000000LL);
+			}
 
-	snprintf(message, 1024, "esmini GIT REV: %s", esmini_git_rev());
-	if (file_.is_open()) file_ << message << std::endl;
-	if (callback_) callback_(message);
+			if (++state.count <= LOG_RATE_LIMIT)
+			{
+				logger->Write(entry->has_time ? &entry->time : nullptr, entry->trace, entry->file, entry->func, entry->line,
+					entry->message, false);
+			}
+			else
+			{
+				if (state.suppressed++ == 0)
+				{
+					state.message = entry->message;
+					n_pending++;
+				}
+				state.has_time = entry->has_time;
+				state.time = entry->time;
+			}
 
-	snprintf(message, 1024, "esmini GIT TAG: %s", esmini_git_tag());
-	if (file_.is_open()) file_ << message << std::endl;
-	if (callback_) callback_(message);
+			queue->EndRead(entry);
+			n++;
+		}
+		if (n > 0 && logger->file_.is_open())
+		{
+			logger->file_.flush();
+		}
+		bool quit = logger->quit_ && n_pending == 0;
+		logger->mutex_.Unlock();
 
-	snprintf(message, 1024, "esmini GIT BRANCH: %s", esmini_git_branch());
-	if (file_.is_open()) file_ << message << std::endl;
-	if (callback_) callback_(message);
+		if (n > 0)
+		{
+			logger->WakeWriter(true);
+		}
+		else if (quit)
+		{
+			break;
+		}
+		else
+		{
+			// Wake up at end of window only if there are suppressed messages to report
+			logger->WaitForMessages(queue, n_pending > 0 ? next_expiry : 0);
+		}
+	}
 
-	snprintf(message, 1024, "esmini BUILD VERSION: %s", esmini_build_version());
-	if (file_.is_open()) file_ << message << std::endl;
-	if (callback_) callback_(message);
+	log_writer_thread = false;
 }
 
-SE_Env& SE_Env::Inst()
+void Logger::SetAsync(bool async)
 {
-	static SE_Env instance_;
-	return instance_;
-}
+	if (async && queue_.load() == nullptr)
+	{
+		quit_ = false;
+		writer_queue_ = new LogQueue;
+		thread_.Start(WriterThread, this);
+		queue_ = writer_queue_;
+	}
+	else if (!async && queue_.load() != nullptr)
+	{
+		// Detach the queue from producers, then wait for the ones already using it to finish their entry
+		queue_ = nullptr;
+		while (producers_.load() > 0)
+		{
+			SE_sleep(0);
+		}
+
+		// Writer thread drains the queue before quitting
+		quit_ = true;
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+		{
+			std::lock_guard<std::mutex> lock(wake_mutex_);
+			wake_cv_.notify_one();
+		}
+#endif
+		thread_.Wait();
+		delete writer_queue_;
+		writer_queue_ = nullptr;
+	}
+}
+
+void Logger::Flush()
+{
+	if (log_writer_thread)
+	{
+		return;  // called from the callback, messages are written by this thread
+	}
+
+	producers_++;
+	LogQueue* queue = queue_.load();
+	if (queue != nullptr)
+	{
+		size_t target = queue->GetEnqueuePos();
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+		while (queue->GetWritten() < target)
+		{
+			SE_sleep(1);
+		}
+#else
+		std::unique_lock<std::mutex> lock(wake_mutex_);
+		flushed_cv_.wait(lock, [queue, target] { return queue->GetWritten() >= target; });
+#endif
+	}
+	producers_--;
+}
+
+void Logger::SetCallback(FuncPtr callback)
+{
+	Flush();  // queued messages goes to previous callback
+	mutex_.Lock();
+	callback_ = callback;
+	mutex_.Unlock();
+}
+
+Logger& Logger::Inst()
+{
+	// Intentionally never destroyed, see SetAsync()
+	static Logger* instance_ = new Logger;
+	return *instance_;
+}
+
+void Logger::OpenLogfile(std::string filename)
+{
+#ifndef SUPPRESS_LOG
+	if (!filename.empty())
+	{
+		Flush();
+		mutex_.Lock();
+		if (file_.is_open())
+		{
+			// Close any open logfile, perhaps user want a new with unique filename
+			file_.close();
+		}
+
+		file_.open(filename.c_str());
+		if (file_.fail())
+		{
+			const char* filename_tmp = std::tmpnam(NULL);
+			printf("Cannot open log file: %s in working directory. Trying system tmp-file: %s\n",
+				SE_Env::Inst().GetLogFilePath().c_str(), filename_tmp);
+			file_.open(filename_tmp);
+			if (file_.fail())
+			{
+				printf("Also failed to open log file: %s. Continue without logfile, still logging to console.\n", filename_tmp);
+			}
+		}
+		mutex_.Unlock();
+	}
+#endif
+}
+
+void Logger::LogVersion()
+{
+	static char message[1024];
+
+	snprintf(message, 1024, "esmini GIT REV: %s", esmini_git_rev());
+	if (file_.is_open()) file_ << message << std::endl;
+	if (callback_) callback_(message);
+
+	snprintf(message, 1024, "esmini GIT TAG: %s", esmini_git_tag());
+	if (file_.is_open()) file_ << message << std::endl;
+	if (callback_) callback_(message);
+
+	snprintf(message, 1024, "esmini GIT BRANCH: %s", esmini_git_branch());
+	if (file_.is_open()) file_ << message << std::endl;
+	if (callback_) callback_(message);
+
+	snprintf(message, 1024, "esmini BUILD VERSION: %s", esmini_build_version());
+	if (file_.is_open()) file_ << message << std::endl;
+	if (callback_) callback_(message);
+}
+
+SE_Env& SE_Env::Inst()
+{
+	static SE_Env instance_;
+	return instance_;
+}
 
 void SE_Env::SetLogFilePath(std::string logFilePath)
 {
@@ -1079,65 +1636,261 @@ void SE_Env::SetDatFilePath(std::string datFilePath)
  * in columnar format, with time running from top to bottom and
  * vehicles running from left to right, starting with the Ego vehicle
  */
-CSV_Logger::CSV_Logger() : data_index_(0), callback_(nullptr)
+
+// Binary format columns, in order of CSV_VehicleData
+static const struct
+{
+	CSV_BinaryColumnType type;
+	const char* name;
+} csv_binary_columns[] =
+{
+	{ CSV_BINARY_INT32, "Index [-]" },
+	{ CSV_BINARY_FLOAT64, "TimeStamp [s]" },
+	{ CSV_BINARY_INT32, "Entitity_ID [-]" },
+	{ CSV_BINARY_FLOAT64, "Current_Speed [m/s]" },
+	{ CSV_BINARY_FLOAT64, "Wheel_Angle [deg]" },
+	{ CSV_BINARY_FLOAT64, "Wheel_Rotation [-]" },
+	{ CSV_BINARY_FLOAT64, "World_Position_X [m]" },
+	{ CSV_BINARY_FLOAT64, "World_Position_Y [m]" },
+	{ CSV_BINARY_FLOAT64, "World_Position_Z [m]" },
+	{ CSV_BINARY_FLOAT64, "Vel_X [m/s]" },
+	{ CSV_BINARY_FLOAT64, "Vel_Y [m/s]" },
+	{ CSV_BINARY_FLOAT64, "Vel_Z [m/s]" },
+	{ CSV_BINARY_FLOAT64, "Acc_X [m/s2]" },
+	{ CSV_BINARY_FLOAT64, "Acc_Y [m/s2]" },
+	{ CSV_BINARY_FLOAT64, "Acc_Z [m/s2]" },
+	{ CSV_BINARY_FLOAT64, "Distance_Travelled_Along_Road_Segment [m]" },
+	{ CSV_BINARY_FLOAT64, "Lateral_Distance_Lanem [m]" },
+	{ CSV_BINARY_FLOAT64, "World_Heading_Angle [rad]" },
+	{ CSV_BINARY_FLOAT64, "Heading_Angle_Rate [rad/s]" },
+	{ CSV_BINARY_FLOAT64, "Relative_Heading_Angle [rad]" },
+	{ CSV_BINARY_FLOAT64, "Relative_Heading_Angle_Drive_Direction [rad]" },
+	{ CSV_BINARY_FLOAT64, "World_Pitch_Angle [rad]" },
+	{ CSV_BINARY_FLOAT64, "Road_Curvature [1/m]" },
+	{ CSV_BINARY_INT32, "Number_Of_Collisions [-]" },
+};
+
+static void AppendInt(std::string& str, long long value)
 {
+	char buf[24];
+	int n = 0;
+	unsigned long long v = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+
+	do
+	{
+		buf[n++] = static_cast<char>('0' + v % 10);
+		v /= 10;
+	} while (v > 0);
 
+	if (value < 0)
+	{
+		str.push_back('-');
+	}
+	while (n > 0)
+	{
+		str.push_back(buf[--n]);
+	}
 }
 
-CSV_Logger::~CSV_Logger()
+// Append value in printf "%f" format, i.e. six decimals, without the cost of snprintf for common values
+static void AppendFloat6(std::string& str, double value)
 {
-	if (file_.is_open())
+	double scaled = fabs(value) * 1e6;
+
+	// Fall back to snprintf for large and non finite values, and when rounding is too close to call
+	if (!(scaled < 1e15) || fabs(scaled - floor(scaled) - 0.5) < 1e-15 * scaled + 1e-9)
 	{
-		file_.close();
+		char buf[512];
+		snprintf(buf, sizeof(buf), "%f", value);
+		str.append(buf);
+		return;
 	}
 
+	long long rounded = static_cast<long long>(floor(scaled + 0.5));
+	if (std::signbit(value))
+	{
+		str.push_back('-');
+	}
+	AppendInt(str, rounded / 1000000);
+	str.push_back('.');
+
+	char frac[6];
+	long long f = rounded % 1000000;
+	for (int i = 5; i >= 0; i--)
+	{
+		frac[i] = static_cast<char>('0' + f % 10);
+		f /= 10;
+	}
+	str.append(frac, 6);
+}
+
+/*
+ * Logger for all vehicles contained in the Entities vector.
+ *
+ * Builds a header based on the number of vehicles then prints data
+ * in columnar format, with time running from top to bottom and
+ * vehicles running from left to right, starting with the Ego vehicle
+ */
+CSV_Logger::CSV_Logger() : data_index_(0), callback_(nullptr), binary_(false)
+{
+
+}
+
+CSV_Logger::~CSV_Logger()
+{
 	callback_ = 0;
 }
 
-void CSV_Logger::LogVehicleData(bool isendline, double timestamp, char const* name, int id, double speed,
-	double wheel_angle, double wheel_rot, double posX, double posY, double posZ, double velX, double velY,
-	double velZ, double accX, double accY, double accZ, double distance_road, double distance_lanem, double heading,
-	double heading_rate, double heading_angle, double heading_angle_driving_direction, double pitch, double curvature,
-	const char* collisions, ...)
+void CSV_Logger::Close()
 {
-	static char data_entry[max_csv_entry_length];
+	if (binary_ && file_.IsOpen())
+	{
+		WriteBinaryBlock();
+	}
+	file_.Close();
+}
+
+void CSV_Logger::LogVehicleData(bool isendline, double timestamp, const CSV_VehicleData& data)
+{
+	if (binary_)
+	{
+		if (!file_.IsOpen())
+		{
+			return;
+		}
+
+		std::map<int, std::string>::iterator it = names_.find(data.id);
+		if (it == names_.end() || it->second != data.name)
+		{
+			// Name block goes before the data block holding the row
+			WriteBinaryBlock();
+			names_[data.id] = data.name;
+
+			CSV_BinaryBlockHeader header = { CSV_BINARY_BLOCK_NAME, static_cast<int>(sizeof(int) + strlen(data.name)) };
+			file_.Write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file_.Write(reinterpret_cast<const char*>(&data.id), sizeof(int));
+			file_.Write(data.name, strlen(data.name));
+		}
+
+		const double values[CSV_N_VALUES] =
+		{
+			data.speed, data.wheel_angle, data.wheel_rot, data.x, data.y, data.z, data.vel_x, data.vel_y, data.vel_z,
+			data.acc_x, data.acc_y, data.acc_z, data.s, data.t, data.h, data.h_rate, data.h_relative,
+			data.h_relative_drive_direction, data.p, data.curvature
+		};
+
+		index_.push_back(data_index_);
+		time_.push_back(timestamp);
+		id_.push_back(data.id);
+		values_.insert(values_.end(), values, values + CSV_N_VALUES);
+		n_collisions_.push_back(data.n_collisions);
+		collision_ids_.insert(collision_ids_.end(), data.collision_ids, data.collision_ids + data.n_collisions);
+
+		if (isendline)
+		{
+			data_index_++;
+		}
+
+		if (index_.size() >= CSV_BINARY_CHUNK_ROWS)
+		{
+			WriteBinaryBlock();
+		}
+
+		return;
+	}
 
 	//If this data is for Ego (position 0 in the Entities vector) print using the first format
 	//Otherwise use the second format
-	if (id == 0)
-		snprintf(data_entry, max_csv_entry_length,
-			"%d, %f, %s, %d, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %s, ",
-			data_index_, timestamp, name, id, speed, wheel_angle, wheel_rot, posX, posY, posZ, velX,
-			velY, velZ, accX, accY, accZ, distance_road, distance_lanem, heading, heading_rate,
-			heading_angle, heading_angle_driving_direction, pitch, curvature, collisions);
-	else
-		snprintf(data_entry, max_csv_entry_length,
-			"%s, %d, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %s, ",
-			name, id, speed, wheel_angle, wheel_rot, posX, posY, posZ, velX, velY, velZ, accX, accY, accZ,
-			distance_road, distance_lanem, heading, heading_rate, heading_angle, heading_angle_driving_direction,
-			pitch, curvature, collisions);
+	entry_.clear();
+	if (data.id == 0)
+	{
+		AppendInt(entry_, data_index_);
+		entry_.append(", ");
+		AppendFloat6(entry_, timestamp);
+		entry_.append(", ");
+	}
+	entry_.append(data.name);
+	entry_.append(", ");
+	AppendInt(entry_, data.id);
+	for (double value : { data.speed, data.wheel_angle, data.wheel_rot, data.x, data.y, data.z, data.vel_x, data.vel_y,
+		data.vel_z, data.acc_x, data.acc_y, data.acc_z, data.s, data.t, data.h, data.h_rate, data.h_relative,
+		data.h_relative_drive_direction, data.p, data.curvature })
+	{
+		entry_.append(", ");
+		AppendFloat6(entry_, value);
+	}
+	entry_.append(", ");
+	for (int i = 0; i < data.n_collisions; i++)
+	{
+		AppendInt(entry_, data.collision_ids[i]);
+		entry_.push_back(' ');
+	}
+	entry_.append(", ");
 
 	//Add lines horizontally until the endline is reached
 	if (isendline == false)
 	{
-		file_ << data_entry;
+		file_.Write(entry_);
 	}
-	else if (file_.is_open())
+	else if (file_.IsOpen())
 	{
-
-		file_ << data_entry << std::endl;
-		file_.flush();
+		file_.Write(entry_);
+		file_.Write("\n");
 
 		data_index_++;
 	}
 
-
 	if (callback_)
 	{
-		callback_(data_entry);
+		callback_(entry_.c_str());
 	}
 }
 
+void CSV_Logger::WriteBinaryBlock()
+{
+	int n = static_cast<int>(index_.size());
+	if (n == 0)
+	{
+		return;
+	}
+
+	// Transpose rows into columns
+	size_t size = sizeof(int) + n * (3 * sizeof(int) + (1 + CSV_N_VALUES) * sizeof(double)) + collision_ids_.size() * sizeof(int);
+	CSV_BinaryBlockHeader header = { CSV_BINARY_BLOCK_DATA, static_cast<int>(size) };
+	block_.resize(sizeof(header) + size);
+	char* dst = block_.data();
+
+	auto append = [&dst](const void* src, size_t bytes)
+	{
+		memcpy(dst, src, bytes);
+		dst += bytes;
+	};
+
+	append(&header, sizeof(header));
+	append(&n, sizeof(int));
+	append(index_.data(), n * sizeof(int));
+	append(time_.data(), n * sizeof(double));
+	append(id_.data(), n * sizeof(int));
+	for (int i = 0; i < CSV_N_VALUES; i++)
+	{
+		for (int j = 0; j < n; j++)
+		{
+			append(&values_[j * CSV_N_VALUES + i], sizeof(double));
+		}
+	}
+	append(n_collisions_.data(), n * sizeof(int));
+	append(collision_ids_.data(), collision_ids_.size() * sizeof(int));
+
+	file_.Write(block_.data(), block_.size());
+
+	index_.clear();
+	time_.clear();
+	id_.clear();
+	values_.clear();
+	n_collisions_.clear();
+	collision_ids_.clear();
+}
+
 void CSV_Logger::SetCallback(FuncPtr callback)
 {
 	callback_ = callback;
@@ -1156,35 +1909,67 @@ void CSV_Logger::SetCallback(FuncPtr callback)
 
 //instantiator
 //Filename and vehicle number are used for dynamic header creation
-void CSV_Logger::Open(std::string scenario_filename, int numvehicles, std::string csv_filename)
+void CSV_Logger::Open(std::string scenario_filename, int numvehicles, std::string csv_filename, bool binary)
 {
-	if (file_.is_open())
-	{
-		file_.close();
-	}
+	Close();
 
-	file_.open(csv_filename);
-	if (file_.fail())
+	if (file_.Open(csv_filename, binary) != 0)
 	{
 		throw std::iostream::failure(std::string("Cannot open file: ") + csv_filename);
 	}
 
 	data_index_ = 0;
+	binary_ = binary;
+	names_.clear();
 
 	//Standard ESMINI log header, appended with Scenario file name and vehicle count
+	std::vector<std::string> info;
 	static char message[max_csv_entry_length];
 	snprintf(message, max_csv_entry_length, "esmini GIT REV: %s", esmini_git_rev());
-	file_ << message << std::endl;
+	info.push_back(message);
 	snprintf(message, max_csv_entry_length, "esmini GIT TAG: %s", esmini_git_tag());
-	file_ << message << std::endl;
+	info.push_back(message);
 	snprintf(message, max_csv_entry_length, "esmini GIT BRANCH: %s", esmini_git_branch());
-	file_ << message << std::endl;
+	info.push_back(message);
 	snprintf(message, max_csv_entry_length, "esmini BUILD VERSION: %s", esmini_build_version());
-	file_ << message << std::endl;
+	info.push_back(message);
 	snprintf(message, max_csv_entry_length, "Scenario File Name: %s", scenario_filename.c_str());
-	file_ << message << std::endl;
+	info.push_back(message);
 	snprintf(message, max_csv_entry_length, "Number of Vehicles: %d", numvehicles);
-	file_ << message << std::endl;
+	info.push_back(message);
+
+	if (binary_)
+	{
+		int n_columns = static_cast<int>(sizeof(csv_binary_columns) / sizeof(csv_binary_columns[0]));
+		CSV_BinaryHeader header = { CSV_BINARY_MAGIC, CSV_BINARY_VERSION, static_cast<int>(info.size()), n_columns };
+		file_.Write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		for (size_t i = 0; i < info.size(); i++)
+		{
+			int length = static_cast<int>(info[i].size());
+			file_.Write(reinterpret_cast<const char*>(&length), sizeof(int));
+			file_.Write(info[i]);
+		}
+
+		for (int i = 0; i < n_columns; i++)
+		{
+			int type = csv_binary_columns[i].type;
+			int length = static_cast<int>(strlen(csv_binary_columns[i].name));
+			file_.Write(reinterpret_cast<const char*>(&type), sizeof(int));
+			file_.Write(reinterpret_cast<const char*>(&length), sizeof(int));
+			file_.Write(csv_binary_columns[i].name, length);
+		}
+
+		callback_ = 0;
+
+		return;
+	}
+
+	for (size_t i = 0; i < info.size(); i++)
+	{
+		file_.Write(info[i]);
+		file_.Write("\n");
+	}
 
 	//Ego vehicle is always present, at least one set of vehicle data values should be stored
 	//Index and TimeStamp are included in this first set of columns
@@ -1197,7 +1982,7 @@ void CSV_Logger::Open(std::string scenario_filename, int numvehicles, std::strin
 		"#1 Lateral_Distance_Lanem [m] , #1 World_Heading_Angle [rad] , #1 Heading_Angle_Rate [rad/s] , "
 		"#1 Relative_Heading_Angle [rad] , #1 Relative_Heading_Angle_Drive_Direction [rad] , "
 		"#1 World_Pitch_Angle [rad] , #1 Road_Curvature [1/m] , #1 collision_ids , ");
-	file_ << message;
+	file_.Write(message);
 
 	//Based on number of vehicels in the Entities vector, extend the header accordingly
 	for (int i = 2; i <= numvehicles; i++)
@@ -1212,19 +1997,18 @@ void CSV_Logger::Open(std::string scenario_filename, int numvehicles, std::strin
 			"#%d Relative_Heading_Angle_Drive_Direction [rad] , #%d World_Pitch_Angle [rad] , "
 			"#%d Road_Curvature [1/m] , #%d collision_ids , "
 			, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i);
-		file_ << message;
+		file_.Write(message);
 	}
-	file_ << std::endl;
-
-	file_.flush();
+	file_.Write("\n");
 
 	callback_ = 0;
 }
 
 CSV_Logger& CSV_Logger::Inst()
 {
-	static CSV_Logger instance_;
-	return instance_;
+	// Intentionally never destroyed, see Close()
+	static CSV_Logger* instance_ = new CSV_Logger;
+	return *instance_;
 }
 
 SE_Thread::~SE_Thread()
@@ -1292,6 +2076,144 @@ void SE_Mutex::Unlock()
 }
 
 
+int SE_AsyncFileWriter::Open(std::string filename, bool binary)
+{
+	Close();
+
+	file_ = fopen(filename.c_str(), binary ? "wb" : "w");
+	if (file_ == nullptr)
+	{
+		return -1;
+	}
+
+	// Data is written in large chunks anyway, skip the extra copy into the stdio buffer
+	setvbuf(file_, nullptr, _IONBF, 0);
+
+	buffer_[0].reserve(SE_ASYNC_FILE_WRITER_CHUNK_SIZE);
+	buffer_[1].reserve(SE_ASYNC_FILE_WRITER_CHUNK_SIZE);
+	front_ = 0;
+	pending_ = false;
+	quit_ = false;
+
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	thread_ = std::thread(&SE_AsyncFileWriter::WriterLoop, this);
+#endif
+
+	return 0;
+}
+
+void SE_AsyncFileWriter::Write(const char* data, size_t size)
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	if (buffer_[front_].empty())
+	{
+		front_time_ = SE_getMonotonicTimeNs();
+	}
+
+	buffer_[front_].insert(buffer_[front_].end(), data, data + size);
+
+	if (buffer_[front_].size() >= SE_ASYNC_FILE_WRITER_CHUNK_SIZE ||
+		SE_getMonotonicTimeNs() - front_time_ > SE_ASYNC_FILE_WRITER_MAX_AGE_NS)
+	{
+		HandOver();
+	}
+}
+
+void SE_AsyncFileWriter::HandOver()
+{
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+	fwrite(buffer_[front_].data(), 1, buffer_[front_].size(), file_);
+	buffer_[front_].clear();
+#else
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	// Wait for previous chunk to be written, only happens if the disk can't keep up
+	cv_.wait(lock, [this] { return !pending_; });
+
+	front_ = 1 - front_;
+	pending_ = true;
+	cv_.notify_all();
+#endif
+}
+
+void SE_AsyncFileWriter::WriterLoop()
+{
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	while (true)
+	{
+		cv_.wait(lock, [this] { return pending_ || quit_; });
+
+		if (pending_)
+		{
+			// Write back buffer without holding the lock, the simulation thread keeps filling the front buffer
+			std::vector<char>& back = buffer_[1 - front_];
+			lock.unlock();
+			fwrite(back.data(), 1, back.size(), file_);
+			back.clear();
+			lock.lock();
+			pending_ = false;
+			cv_.notify_all();
+		}
+		else if (quit_)
+		{
+			break;
+		}
+	}
+#endif
+}
+
+void SE_AsyncFileWriter::Flush()
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	if (!buffer_[front_].empty())
+	{
+		HandOver();
+	}
+
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	std::unique_lock<std::mutex> lock(mutex_);
+	cv_.wait(lock, [this] { return !pending_; });
+#endif
+
+	fflush(file_);
+}
+
+void SE_AsyncFileWriter::Close()
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	Flush();
+
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		quit_ = true;
+		cv_.notify_all();
+	}
+	thread_.join();
+#endif
+
+	fclose(file_);
+	file_ = nullptr;
+}
+
 void SE_Option::Usage()
 {
 	if (!default_value_.empty())
@@ -1646,6 +2568,260 @@ int SE_WriteTGA(const char* filename, int width, int height, const unsigned char
 	return 0;
 }
 
+SE_MappedFile::SE_MappedFile() : data_(nullptr), size_(0), mtime_(0)
+#ifdef _WIN32
+	, file_handle_(nullptr), map_handle_(nullptr)
+#endif
+{
+}
+
+SE_MappedFile::~SE_MappedFile()
+{
+	Close();
+}
+
+int SE_MappedFile::Open(std::string filename)
+{
+	Close();
+
+	struct stat file_stat;
+	if (stat(filename.c_str(), &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		return -1;
+	}
+	size_ = static_cast<size_t>(file_stat.st_size);
+	mtime_ = static_cast<__int64>(file_stat.st_mtime);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		size_ = 0;
+		return -1;
+	}
+
+	HANDLE map = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (map == NULL)
+	{
+		CloseHandle(file);
+		size_ = 0;
+		return -1;
+	}
+
+	data_ = static_cast<char*>(MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0));
+	if (data_ == nullptr)
+	{
+		CloseHandle(map);
+		CloseHandle(file);
+		size_ = 0;
+		return -1;
+	}
+	file_handle_ = file;
+	map_handle_ = map;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		size_ = 0;
+		return -1;
+	}
+
+	void* addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);  // the mapping keeps its own reference to the file
+
+	if (addr == MAP_FAILED)
+	{
+		size_ = 0;
+		return -1;
+	}
+	data_ = static_cast<char*>(addr);
+#endif
+
+	return 0;
+}
+
+void SE_MappedFile::Close()
+{
+	if (data_ != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+		CloseHandle(map_handle_);
+		CloseHandle(file_handle_);
+		map_handle_ = nullptr;
+		file_handle_ = nullptr;
+#else
+		munmap(data_, size_);
+#endif
+	}
+	data_ = nullptr;
+	size_ = 0;
+	mtime_ = 0;
+}
+
+SE_SharedMemory::SE_SharedMemory() : data_(nullptr), size_(0), owner_(false)
+#ifdef _WIN32
+	, map_handle_(nullptr)
+#endif
+{
+}
+
+SE_SharedMemory::~SE_SharedMemory()
+{
+	Close();
+}
+
+#ifndef _WIN32
+static std::string SharedMemoryName(std::string name)
+{
+	// POSIX requires names on the form "/name"
+	return name[0] == '/' ? name : "/" + name;
+}
+#endif
+
+int SE_SharedMemory::Create(std::string name, size_t size)
+{
+	Close();
+
+	if (name.empty() || size == 0)
+	{
+		return -1;
+	}
+
+#ifdef _WIN32
+	HANDLE map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+		static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32), static_cast<DWORD>(size & 0xffffffff), name.c_str());
+	if (map == NULL)
+	{
+		return -1;
+	}
+
+	data_ = static_cast<char*>(MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (data_ == nullptr)
+	{
+		CloseHandle(map);
+		return -1;
+	}
+	memset(data_, 0, size);  // an existing mapping might be reused
+	map_handle_ = map;
+#else
+	std::string shm_name = SharedMemoryName(name);
+
+	shm_unlink(shm_name.c_str());  // remove any stale region from a previous run
+	int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+	{
+		close(fd);
+		shm_unlink(shm_name.c_str());
+		return -1;
+	}
+
+	void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (addr == MAP_FAILED)
+	{
+		shm_unlink(shm_name.c_str());
+		return -1;
+	}
+	data_ = static_cast<char*>(addr);
+#endif
+
+	size_ = size;
+	name_ = name;
+	owner_ = true;
+
+	return 0;
+}
+
+int SE_SharedMemory::Open(std::string name)
+{
+	Close();
+
+	if (name.empty())
+	{
+		return -1;
+	}
+
+#ifdef _WIN32
+	HANDLE map = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (map == NULL)
+	{
+		return -1;
+	}
+
+	data_ = static_cast<char*>(MapViewOfFile(map, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+	MEMORY_BASIC_INFORMATION info;
+	if (data_ == nullptr || VirtualQuery(data_, &info, sizeof(info)) == 0)
+	{
+		if (data_ != nullptr)
+		{
+			UnmapViewOfFile(data_);
+			data_ = nullptr;
+		}
+		CloseHandle(map);
+		return -1;
+	}
+	size_ = static_cast<size_t>(info.RegionSize);
+	map_handle_ = map;
+#else
+	int fd = shm_open(SharedMemoryName(name).c_str(), O_RDWR, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+
+	struct stat shm_stat;
+	if (fstat(fd, &shm_stat) != 0 || shm_stat.st_size == 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	void* addr = mmap(nullptr, static_cast<size_t>(shm_stat.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (addr == MAP_FAILED)
+	{
+		return -1;
+	}
+	data_ = static_cast<char*>(addr);
+	size_ = static_cast<size_t>(shm_stat.st_size);
+#endif
+
+	name_ = name;
+	owner_ = false;
+
+	return 0;
+}
+
+void SE_SharedMemory::Close()
+{
+	if (data_ != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(data_);
+		CloseHandle(map_handle_);
+		map_handle_ = nullptr;
+#else
+		munmap(data_, size_);
+		if (owner_)
+		{
+			shm_unlink(SharedMemoryName(name_).c_str());
+		}
+#endif
+	}
+	data_ = nullptr;
+	size_ = 0;
+	owner_ = false;
+	name_.clear();
+}
+
 int SE_ReadCSVFile(const char* filename, std::vector<std::vector<std::string>>& content, int skip_lines)
 {
 	// Cred: https://java2blog.com/read-csv-file-in-cpp/
@@ -22,6 +22,7 @@
 #include <condition_variable>
 #include <cstring>
 #include <map>
+#include <atomic>
 
 #ifndef _WIN32
 	#include <inttypes.h>
@@ -62,6 +63,7 @@
 
 #define LOG(Format_, ...)  Logger::Inst().Log(false, false, __FILENAME__, __FUNCTION__, __LINE__, Format_, ##__VA_ARGS__)
 #define LOG_TRACE(Format_, ...)  Logger::Inst().Log(false, true, __FILENAME__, __FUNCTION__, __LINE__, Format_, ##__VA_ARGS__)
+#define LOG_DEBUG(Format_, ...)  Logger::Inst().LogDebug(__FILENAME__, __FUNCTION__, __LINE__, Format_, ##__VA_ARGS__)
 #define LOG_ONCE(Format_, ...)  { \
 		static bool firstTime = true; \
 		if (firstTime) \
@@ -87,6 +89,20 @@ __int64 SE_getSystemTime();
 void SE_sleep(unsigned int msec);
 double SE_getSimTimeStep(__int64& time_stamp, double min_time_step, double max_time_step);
 
+#define SE_SPIN_TIME_NS 100000  // last part of a precise wait is spent polling the clock, covering OS wakeup latency
+
+/**
+	Monotonic time, not affected by system clock adjustments. Only differences are meaningful.
+	@return Time in nanoseconds
+*/
+__int64 SE_getMonotonicTimeNs();
+
+/**
+	Sleep until an absolute point in time, then spin the final SE_SPIN_TIME_NS for precision
+	@param deadline_ns Monotonic time, as returned by SE_getMonotonicTimeNs(), to return at
+*/
+void SE_sleepUntilNs(__int64 deadline_ns);
+
 // Useful types
 enum class KeyType // copy key enums from OSG GUIEventAdapter
 {
@@ -581,6 +597,56 @@ private:
 	bool flag;
 };
 
+#define SE_ASYNC_FILE_WRITER_CHUNK_SIZE (1 << 20)  // bytes collected before handed over to the writer thread
+#define SE_ASYNC_FILE_WRITER_MAX_AGE_NS 1000000000LL  // max time data is collected, bounds loss if never closed
+
+/**
+	File writer moving disk I/O off the calling thread. Data is collected in one buffer while the other one is
+	written to file by a background thread, then they swap. Hence each file write is a full chunk, or the data
+	collected during SE_ASYNC_FILE_WRITER_MAX_AGE_NS. Any remaining data is written on Flush(), Close() and
+	destruction. Close() joins the writer thread, so owners with static storage duration must call it before
+	exit instead of relying on the destructor.
+	Platforms lacking std::thread support (Win7, MinGW) write synchronously through the same interface.
+*/
+class SE_AsyncFileWriter
+{
+public:
+	SE_AsyncFileWriter() : file_(nullptr), front_(0), front_time_(0), pending_(false), quit_(false) {}
+	~SE_AsyncFileWriter() { Close(); }
+
+	/**
+		Create file and start writer thread
+		@param filename Name of file to create, any existing file is overwritten
+		@param binary Open in binary mode, else text mode
+		@return 0 on success, -1 on failure
+	*/
+	int Open(std::string filename, bool binary = true);
+	void Write(const char* data, size_t size);
+	void Write(const std::string& str) { Write(str.c_str(), str.size()); }
+
+	// Block until all data so far has been written to file
+	void Flush();
+	void Close();
+	bool IsOpen() { return file_ != nullptr; }
+
+private:
+	FILE* file_;
+	std::vector<char> buffer_[2];
+	int front_;  // index of buffer being filled, the other one is owned by writer thread while pending_
+	__int64 front_time_;  // when first data was added to the front buffer
+	bool pending_;
+	bool quit_;
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	std::thread thread_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+#endif
+
+	void HandOver();
+	void WriterLoop();
+};
+
 std::vector<std::string> SplitString(const std::string& s, char separator);
 std::string DirNameOf(const std::string& fname);
 std::string FileNameOf(const std::string& fname);
@@ -594,6 +660,19 @@ int strtoi(std::string s);
 double strtod(std::string s);
 
 // Global Logger class
+#define LOG_MESSAGE_SIZE 1024
+#define LOG_QUEUE_SIZE 1024  // entries, power of 2
+#define LOG_RATE_LIMIT 20  // max number of repeated messages per second, same text from same call site, in async mode
+
+enum class LogLevel
+{
+	LEVEL_DEBUG = 0,  // LOG_DEBUG
+	LEVEL_INFO = 1,  // LOG, LOG_TRACE, LOG_ONCE
+	LEVEL_ERROR = 2  // LOG_AND_QUIT, always logged
+};
+
+class LogQueue;
+
 class Logger
 {
 public:
@@ -601,6 +680,7 @@ public:
 
 	static Logger& Inst();
 	void Log(bool quit, bool trace, char const* func, char const* file, int line, char const* format, ...);
+	void LogDebug(char const* file, char const* func, int line, char const* format, ...);
 	void SetCallback(FuncPtr callback);
 	bool IsCallbackSet();
 	void SetTimePtr(double* timePtr) { time_ = timePtr; }
@@ -608,16 +688,136 @@ public:
 	void LogVersion();
 	bool IsFileOpen() { return file_.is_open(); }
 
+	/**
+		Messages below given level are dropped before being formatted. Default is LEVEL_INFO.
+	*/
+	void SetLevel(LogLevel level) { level_ = level; }
+	LogLevel GetLevel() { return level_; }
+
+	/**
+		In async mode the calling thread only formats the message into a lock-free queue. A background thread
+		adds the prefix and writes to file and callback, so the callback is called from that thread. Messages
+		logged by the callback bypass the queue and are written to file only. Repeated messages, same text from
+		the same call site, exceeding LOG_RATE_LIMIT per second are suppressed. Their number is reported when the
+		one second window ends.
+		Async mode must be left before exit, the logger is never destroyed since joining the writer thread
+		from a static destructor may deadlock, e.g. on DLL unload.
+		@param async true to enable, false to flush any queued messages and return to synchronous mode
+	*/
+	void SetAsync(bool async);
+	bool IsAsync() { return queue_.load() != nullptr; }
+
+	// Block until all messages logged so far have been written
+	void Flush();
+
 private:
 	Logger();
 	~Logger();
 
+	void LogV(LogLevel level, bool quit, bool trace, char const* file, char const* func, int line, char const* format, va_list args);
+	static void FormatEntry(char* buf, size_t size, const double* time, bool trace, char const* file, char const* func,
+		int line, const char* message);
+	void Write(const double* time, bool trace, char const* file, char const* func, int line, const char* message, bool flush);
+	static void WriterThread(void* args);
+	void WaitForMessages(LogQueue* queue, __int64 deadline_ns);
+	void WakeWriter(bool flushed);
+
 	SE_Mutex mutex_;
 	FuncPtr callback_;
 	std::ofstream file_;
 	double* time_; // seconds
+	LogLevel level_;
+	std::atomic<LogQueue*> queue_;  // queue used by producers, nullptr in synchronous mode
+	std::atomic<int> producers_;  // number of threads currently using queue_
+	LogQueue* writer_queue_;  // queue owned by the writer thread
+	SE_Thread thread_;
+	std::atomic<bool> quit_;
+	std::atomic<bool> writer_waiting_;
+#if (defined WINVER && WINVER == _WIN32_WINNT_WIN7 || __MINGW32__)
+#else
+	std::mutex wake_mutex_;
+	std::condition_variable wake_cv_;  // new messages or quit, for the writer thread
+	std::condition_variable flushed_cv_;  // messages written, for Flush()
+#endif
+	char complete_entry_[LOG_MESSAGE_SIZE + 1024];
 };
 
+// Vehicle data of one entity, as logged by CSV_Logger
+typedef struct
+{
+	const char* name;
+	int id;
+	double speed;
+	double wheel_angle;
+	double wheel_rot;
+	double x;
+	double y;
+	double z;
+	double vel_x;
+	double vel_y;
+	double vel_z;
+	double acc_x;
+	double acc_y;
+	double acc_z;
+	double s;
+	double t;
+	double h;
+	double h_rate;
+	double h_relative;
+	double h_relative_drive_direction;
+	double p;
+	double curvature;
+	const int* collision_ids;  // ids of objects in collision with this one
+	int n_collisions;
+} CSV_VehicleData;
+
+/*
+ * Binary csv format, selected by Open(..., binary = true)
+ *
+ * Instead of one text line per frame, rows of one entity per frame are collected and written column by column
+ * in blocks of up to CSV_BINARY_CHUNK_ROWS rows. All values are little endian (native).
+ *
+ * CSV_BinaryHeader
+ * n_info_lines x { int length, char text[length] }   text header lines, e.g. git revision and scenario
+ * n_columns x { int type, int length, char name[length] }   column schema, type is CSV_BinaryColumnType
+ * blocks, each starting with CSV_BinaryBlockHeader:
+ *   CSV_BINARY_BLOCK_NAME: int id, char name[size - 4]   (re)defines name of entity, precedes its first row
+ *   CSV_BINARY_BLOCK_DATA: int n_rows, then for each column n_rows values. The last column is the number
+ *     of collisions per row, it is followed by all collision ids of the block as int32.
+ *
+ * For a reader and conversion to text csv, see scripts/csvb.py and scripts/csvb2csv.py
+ */
+#define CSV_BINARY_MAGIC 0x42565343  // "CSVB"
+#define CSV_BINARY_VERSION 1
+#define CSV_BINARY_CHUNK_ROWS 1024
+#define CSV_N_VALUES 20  // number of double values per row, speed to curvature
+
+typedef enum
+{
+	CSV_BINARY_INT32 = 1,
+	CSV_BINARY_FLOAT64 = 2
+} CSV_BinaryColumnType;
+
+typedef enum
+{
+	CSV_BINARY_BLOCK_NAME = 1,
+	CSV_BINARY_BLOCK_DATA = 2
+} CSV_BinaryBlockType;
+
+typedef struct
+{
+	unsigned int magic;
+	int version;
+	int n_info_lines;
+	int n_columns;
+} CSV_BinaryHeader;
+
+typedef struct
+{
+	int type;  // CSV_BinaryBlockType
+	int size;  // bytes following this header
+} CSV_BinaryBlockHeader;
+
 // Global Vehicle Data Logger
 class CSV_Logger
 {
@@ -627,15 +827,22 @@ public:
 	//Instantiator
 	static CSV_Logger& Inst();
 
-	//Logging function called by VehicleLogger object using pass by value
-	void LogVehicleData(bool isendline, double timestamp, char const* name, int id, double speed,
-		double wheel_angle, double wheel_rot, double posX, double posY, double posZ, double velX, double velY,
-		double velZ, double accX, double accY, double accZ, double distance_road, double distance_lanem, double heading,
-		double heading_rate, double heading_angle, double heading_angle_driving_direction, double pitch, double curvature,
-		char const* collisions, ...);
+	/**
+		Log data of one entity. Entities of a frame are logged in sequence, the last one with isendline set.
+		@param isendline Last entity of the frame
+		@param timestamp Simulation time
+		@param data Vehicle data
+	*/
+	void LogVehicleData(bool isendline, double timestamp, const CSV_VehicleData& data);
 
 	void SetCallback(FuncPtr callback);
-	void Open(std::string scenario_filename, int numvehicles, std::string csv_filename);
+	void Open(std::string scenario_filename, int numvehicles, std::string csv_filename, bool binary = false);
+
+	/**
+		Write any buffered data and close file. Must be called before exit, the instance is never destroyed
+		since joining the writer thread from a static destructor may deadlock, e.g. on DLL unload.
+	*/
+	void Close();
 
 private:
 	//Constructor to be called by instantiator
@@ -644,16 +851,31 @@ private:
 	//Destructor
 	~CSV_Logger();
 
+	void WriteBinaryBlock();
+
 	//Counter for indexing each log entry
 	int data_index_;
 
-	//File output stream
-	std::ofstream file_;
+	//File output, written by background thread
+	SE_AsyncFileWriter file_;
 
 	//Callback function pointer for error logging
 	FuncPtr callback_;
-};
 
+	//Text mode entry, reused to avoid allocations
+	std::string entry_;
+
+	//Binary mode column buffers for current block
+	bool binary_;
+	std::vector<int> index_;
+	std::vector<double> time_;
+	std::vector<int> id_;
+	std::vector<double> values_;  // row by row, transposed when block is written
+	std::vector<int> n_collisions_;
+	std::vector<int> collision_ids_;
+	std::map<int, std::string> names_;  // latest name written per entity id
+	std::vector<char> block_;
+};
 
 // Argument parser
 
@@ -708,34 +930,34 @@ private:
 class SE_SystemTime
 {
 public:
-	__int64 start_time_;
+	__int64 start_time_;  // monotonic, nanoseconds
 
-	SE_SystemTime() : start_time_(SE_getSystemTime()) {}
-	void Reset() { start_time_ = SE_getSystemTime(); }
-	double GetS() { return 1E-3 * (SE_getSystemTime() - start_time_); }
+	SE_SystemTime() : start_time_(SE_getMonotonicTimeNs()) {}
+	void Reset() { start_time_ = SE_getMonotonicTimeNs(); }
+	double GetS() { return 1E-9 * (SE_getMonotonicTimeNs() - start_time_); }
 };
 
 class SE_SystemTimer
 {
 public:
-	__int64 start_time_;
+	__int64 start_time_;  // monotonic, nanoseconds
 	double duration_;
 
 	SE_SystemTimer() : start_time_(0), duration_(0) {}
 	void Start()
 	{
-		start_time_ = SE_getSystemTime();
+		start_time_ = SE_getMonotonicTimeNs();
 	}
 	void Start(double duration)
 	{
-		start_time_ = SE_getSystemTime();
+		start_time_ = SE_getMonotonicTimeNs();
 		duration_ = duration;
 	}
 
 	void Reset() { start_time_ = 0; }
 	bool Started() { return start_time_ > 0 ? true : false; }
 	void SetDuration(double duration) { duration_ = duration; }
-	double Elapsed() { return 1E-3 * (SE_getSystemTime() - start_time_); }
+	double Elapsed() { return 1E-9 * (SE_getMonotonicTimeNs() - start_time_); }
 	double Remaining()
 	{
 		if (Expired())
@@ -751,6 +973,54 @@ public:
 };
 
 
+/*
+ * Paces a loop to a fixed period using absolute deadlines, start + n * period, so that errors do not
+ * accumulate into drift. A frame that starts late (overrun) is not compensated by shorter periods, but
+ * deadlines missed completely are skipped to avoid a burst of frames catching up.
+ */
+class SE_FrameScheduler
+{
+public:
+	typedef struct
+	{
+		long long frames;
+		long long overruns;  // frames started after their deadline
+		long long skipped;  // deadlines missed completely
+		double jitter_avg_us;  // deviation of frame start from deadline
+		double jitter_max_us;
+	} Stats;
+
+	SE_FrameScheduler() : period_ns_(0), next_deadline_ns_(0), jitter_sum_us_(0.0) { ResetStats(); }
+
+	/**
+		Start pacing, the first frame is due immediately when waited for and defines the schedule
+		@param period_s Frame period in seconds, 0 to stop
+	*/
+	void Start(double period_s);
+	void Stop() { period_ns_ = 0; }
+	bool IsActive() { return period_ns_ > 0; }
+
+	/**
+		Start over with same period, e.g. when the scenario is restarted. The schedule is anchored at next frame,
+		so time passed since last frame is neither counted as overrun nor skipped. Stats are reset.
+	*/
+	void Restart();
+
+	/**
+		Wait until the next frame is due
+	*/
+	void WaitForNextFrame();
+
+	const Stats& GetStats() { return stats_; }
+	void ResetStats();
+
+private:
+	__int64 period_ns_;
+	__int64 next_deadline_ns_;
+	double jitter_sum_us_;
+	Stats stats_;
+};
+
 class SE_SimulationTimer
 {
 public:
@@ -928,6 +1198,82 @@ private:
 	std::map<int, std::string> entity_model_map;
 };
 
+/**
+	Memory mapped view of a file. The file is mapped copy-on-write, meaning content can be
+	read in place without loading it into RAM and any modifications stay in process memory
+	without affecting the file on disk.
+*/
+class SE_MappedFile
+{
+public:
+	SE_MappedFile();
+	~SE_MappedFile();
+
+	/**
+		Map a file into memory
+		@param filename Path to the file
+		@return 0 if OK, -1 if file could not be opened or mapped
+	*/
+	int Open(std::string filename);
+	void Close();
+	bool IsOpen() { return data_ != nullptr; }
+	char* GetData() { return data_; }
+	size_t GetSize() { return size_; }
+
+	/**
+		Modification time of the mapped file, in seconds since epoch
+	*/
+	__int64 GetModificationTime() { return mtime_; }
+
+private:
+	char* data_;
+	size_t size_;
+	__int64 mtime_;
+#ifdef _WIN32
+	void* file_handle_;
+	void* map_handle_;
+#endif
+};
+
+/**
+	Named memory region shared between processes. POSIX shared memory (shm_open) or, on Windows, a named file mapping.
+*/
+class SE_SharedMemory
+{
+public:
+	SE_SharedMemory();
+	~SE_SharedMemory();
+
+	/**
+		Create a zero initialized shared memory region. Any existing region with same name is replaced.
+		The name is removed when the region is closed.
+		@param name Name of the region, e.g. "esmini"
+		@param size Size in bytes
+		@return 0 if OK, -1 if region could not be created or mapped
+	*/
+	int Create(std::string name, size_t size);
+
+	/**
+		Open an existing shared memory region, e.g. created by another process
+		@param name Name of the region
+		@return 0 if OK, -1 if region does not exist or could not be mapped
+	*/
+	int Open(std::string name);
+	void Close();
+	bool IsOpen() { return data_ != nullptr; }
+	char* GetData() { return data_; }
+	size_t GetSize() { return size_; }
+
+private:
+	char* data_;
+	size_t size_;
+	std::string name_;
+	bool owner_;  // created the region
+#ifdef _WIN32
+	void* map_handle_;
+#endif
+};
+
 /**
 	Store RGB (3*8 bits color values) image data as a PPM image file
 	PPM info: http://paulbourke.net/dataformats/ppm/
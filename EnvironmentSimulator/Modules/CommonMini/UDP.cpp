@@ -11,9 +11,11 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #ifndef _WIN32
 	#include <sys/time.h>
+	#include <sys/select.h>
 #endif
 
 #include "UDP.hpp"
@@ -112,6 +114,87 @@ int UDPServer::Receive(char* buf, unsigned int size)
 	return recvfrom(sock_, buf, size, 0, (struct sockaddr*)&sender_addr_, &sender_addr_size_);
 }
 
+// Wait for socket to become readable, returns 1 if readable, 0 on timeout, -1 on error
+static int WaitReadable(int sock, unsigned int timeoutMs)
+{
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+
+	struct timeval tv;
+	tv.tv_sec = static_cast<long>(timeoutMs / 1000);
+	tv.tv_usec = static_cast<long>((timeoutMs % 1000) * 1000);
+
+	return select(sock + 1, &fds, NULL, NULL, &tv);
+}
+
+int UDPServer::ReceiveBatch(char* buf, unsigned int size, unsigned int max_n, int* sizes, unsigned int timeoutMs)
+{
+	max_n = MIN(max_n, UDP_MAX_BATCH_SIZE);
+
+	int retval = WaitReadable(sock_, timeoutMs);
+	if (retval <= 0 || max_n == 0)
+	{
+		return retval;
+	}
+
+#ifdef __linux__
+	struct mmsghdr msgs[UDP_MAX_BATCH_SIZE];
+	struct iovec iovecs[UDP_MAX_BATCH_SIZE];
+
+	memset(msgs, 0, max_n * sizeof(struct mmsghdr));
+	for (unsigned int i = 0; i < max_n; i++)
+	{
+		iovecs[i].iov_base = buf + i * size;
+		iovecs[i].iov_len = size;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int n = recvmmsg(sock_, msgs, max_n, MSG_DONTWAIT, nullptr);
+	for (int i = 0; i < n; i++)
+	{
+		sizes[i] = static_cast<int>(msgs[i].msg_len);
+	}
+
+	return n;
+#else
+	// Receive one datagram at a time as long as more are queued
+	int n = 0;
+	do
+	{
+		sizes[n] = recvfrom(sock_, buf + n * size, size, 0, (struct sockaddr*)&sender_addr_, &sender_addr_size_);
+		if (sizes[n] < 0)
+		{
+			break;
+		}
+		n++;
+	} while (n < static_cast<int>(max_n) && WaitReadable(sock_, 0) > 0);
+
+	return n > 0 ? n : -1;
+#endif
+}
+
+int UDPServer::ReceiveFrom(char* buf, unsigned int size, struct sockaddr_in& addr, unsigned int timeoutMs)
+{
+	int retval = WaitReadable(sock_, timeoutMs);
+	if (retval <= 0)
+	{
+		return retval;
+	}
+
+	socklen_t addr_size = sizeof(addr);
+	retval = recvfrom(sock_, buf, size, 0, (struct sockaddr*)&addr, &addr_size);
+
+	// A zero size datagram is not a timeout, but carries no information either
+	return retval == 0 ? -1 : retval;
+}
+
+int UDPServer::SendTo(const char* buf, unsigned int size, const struct sockaddr_in& addr)
+{
+	return sendto(sock_, buf, size, 0, (const struct sockaddr*)&addr, sizeof(addr));
+}
+
 UDPClient::UDPClient(unsigned short int port, std::string ipAddress) :
 	ipAddress_(ipAddress), UDPBase(port)
 {
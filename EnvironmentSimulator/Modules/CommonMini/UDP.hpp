@@ -27,6 +27,7 @@
 #endif
 
 #define ESMINI_DEFAULT_INPORT 48199
+#define UDP_MAX_BATCH_SIZE 64
 
 class UDPBase
 {
@@ -50,6 +51,36 @@ public:
 	UDPServer(unsigned short int port, unsigned int timeoutMs = 500);
 	~UDPServer() {}
 	int Receive(char* buf, unsigned int size);
+
+	/**
+		Receive any queued datagrams with as few system calls as possible (recvmmsg on Linux)
+		@param buf Buffer for max_n messages, each of size bytes
+		@param size Max size of each message, longer datagrams are truncated
+		@param max_n Max number of messages to receive, limited to UDP_MAX_BATCH_SIZE
+		@param sizes Filled in with received number of bytes per message
+		@param timeoutMs Max time to wait for the first message
+		@return Number of received messages, 0 on timeout, -1 on error
+	*/
+	int ReceiveBatch(char* buf, unsigned int size, unsigned int max_n, int* sizes, unsigned int timeoutMs);
+
+	/**
+		Receive one datagram, waiting at most given time, and tell where it came from
+		@param buf Buffer for the message
+		@param size Size of buffer, longer datagrams are truncated
+		@param addr Filled in with the address of the sender
+		@param timeoutMs Max time to wait for a message
+		@return Received number of bytes, 0 on timeout, -1 on error
+	*/
+	int ReceiveFrom(char* buf, unsigned int size, struct sockaddr_in& addr, unsigned int timeoutMs);
+
+	/**
+		Send a datagram from the server socket, e.g. a reply to a sender
+		@param buf Message
+		@param size Size of message
+		@param addr Address of the receiver
+		@return Sent number of bytes, -1 on error
+	*/
+	int SendTo(const char* buf, unsigned int size, const struct sockaddr_in& addr);
 	unsigned short GetPort() { return port_; }
 	unsigned int GetTimeout() { return timeoutMs_; }
 
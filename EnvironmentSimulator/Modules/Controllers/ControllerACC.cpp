@@ -75,6 +75,8 @@ void ControllerACC::Step(double timeStep)
 	// Lookahead distance is at least 50m or twice the distance required to stop
 	// https://www.symbolab.com/solver/equation-calculator/s%5Cleft(t%5Cright)%3D2%5Cleft(m%2Bvt%2B%5Cfrac%7B1%7D%7B2%7Dat%5E%7B2%7D%5Cright)%2C%20t%3D%5Cfrac%7B-v%7D%7Ba%7D
 	double lookaheadDist = MAX(50.0, 2 * minDist - pow(currentSpeed_, 2) / -object_->GetMaxDeceleration());  // (m)
+	double ownRadius = GetLengthOfVector2D(object_->boundingbox_.dimensions_.length_ / 2.0, object_->boundingbox_.dimensions_.width_ / 2.0) +
+		GetLengthOfVector2D(object_->boundingbox_.center_.x_, object_->boundingbox_.center_.y_);
 	for (size_t i = 0; i < entities_->object_.size(); i++)
 	{
 		Object* pivot_obj = entities_->object_[i];
@@ -83,6 +85,18 @@ void ControllerACC::Step(double timeStep)
 			continue;
 		}
 
+		// Skip entities clearly out of reach before any costly distance measurement. Distance along the road is never
+		// shorter than straight distance between reference points, and bounding boxes are within their radius from it.
+		// Radius of the other entity is overestimated, avoiding square roots in this loop over all entities.
+		OSCBoundingBox& bb = pivot_obj->boundingbox_;
+		double radius = ownRadius + 0.5 * (bb.dimensions_.length_ + bb.dimensions_.width_) + fabs(bb.center_.x_) + fabs(bb.center_.y_);
+		double closeDist = 1.0 + pivot_obj->boundingbox_.dimensions_.length_ + 0.5 * MAX(0.0, currentSpeed_ - pivot_obj->GetSpeed());
+		double dist2 = PointSquareDistance2D(object_->pos_.GetX(), object_->pos_.GetY(), pivot_obj->pos_.GetX(), pivot_obj->pos_.GetY());
+		if (dist2 > pow(lookaheadDist + radius, 2))
+		{
+			continue;
+		}
+
 		// Measure longitudinal distance to all vehicles, don't utilize costly freespace option, instead measure ref point to ref point
 		roadmanager::PositionDiff diff;
 		if (object_->pos_.Delta(&pivot_obj->pos_, diff, false, lookaheadDist) == true)   // look only double timeGap ahead
@@ -115,7 +129,7 @@ void ControllerACC::Step(double timeStep)
 		}
 
 		// Also check for really close entities in front
-		if (minObjIndex != i)
+		if (minObjIndex != i && dist2 < pow(closeDist + radius, 2))
 		{
 			double x_local, y_local;
 			object_->FreeSpaceDistance(pivot_obj, &y_local, &x_local);
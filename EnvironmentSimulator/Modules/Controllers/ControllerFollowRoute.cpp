@@ -188,7 +188,10 @@ void ControllerFollowRoute::UpdateWaypoints(roadmanager::Position vehiclePos, ro
 
 void ControllerFollowRoute::CalculateWaypoints()
 {
-	roadmanager::LaneIndependentRouter router(odr_);
+	if (router_ == nullptr)
+	{
+		router_ = std::make_unique<roadmanager::LaneIndependentRouter>(odr_);
+	}
 
 	roadmanager::Position startPos = object_->pos_;
 	roadmanager::Position targetPos = object_->pos_.GetRoute()->scenario_waypoints_[scenarioWaypointIndex_];
@@ -206,7 +209,7 @@ void ControllerFollowRoute::CalculateWaypoints()
 		targetPos = object_->pos_.GetRoute()->scenario_waypoints_[scenarioWaypointIndex_];
 	}
 
-	std::vector<roadmanager::Node> pathToGoal = router.CalculatePath(startPos, targetPos);
+	std::vector<roadmanager::Node> pathToGoal = router_->CalculatePath(startPos, targetPos);
 	if (pathToGoal.empty())
 	{
 		LOG("Error: Path not found, deactivating controller");
@@ -214,7 +217,7 @@ void ControllerFollowRoute::CalculateWaypoints()
 	}
 	else
 	{
-		waypoints_ = router.GetWaypoints(pathToGoal, startPos, targetPos);
+		waypoints_ = router_->GetWaypoints(pathToGoal, startPos, targetPos);
 
 		object_->pos_.GetRoute()->minimal_waypoints_.clear();
 		object_->pos_.GetRoute()->minimal_waypoints_ = {waypoints_[0], waypoints_[1]};
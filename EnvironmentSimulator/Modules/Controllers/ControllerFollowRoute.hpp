@@ -18,7 +18,9 @@
 #include "Parameters.hpp"
 #include "Entities.hpp"
 #include "vehicle.hpp"
+#include "LaneIndependentRouter.hpp"
 #include <queue>
+#include <memory>
 
 // Enable test mode, which stops the vehicle when reaching a target
 // or in case of path not found
@@ -128,6 +130,7 @@ namespace scenarioengine
 		vehicle::Vehicle vehicle_;
 		OSCPrivateAction *laneChangeAction_;
 		roadmanager::OpenDrive *odr_;
+		std::unique_ptr<roadmanager::LaneIndependentRouter> router_;  // kept to reuse its search buffers
 		std::vector<roadmanager::Position> waypoints_;
 		int currentWaypointIndex_;
 		int scenarioWaypointIndex_;
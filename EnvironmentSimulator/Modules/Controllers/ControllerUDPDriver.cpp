@@ -22,11 +22,15 @@
 #include "ScenarioGateway.hpp"
 
 #include <random>
+#include <map>
 
 using namespace scenarioengine;
 
 int ControllerUDPDriver::basePort_ = DEFAULT_UDP_DRIVER_PORT;
 
+static std::map<unsigned short, std::weak_ptr<UDPDriverIngest>> ingestRegistry;
+static SE_Mutex ingestRegistryMutex;
+
 Controller* scenarioengine::InstantiateControllerUDPDriver(void* args)
 {
 	Controller::InitArgs* initArgs = (Controller::InitArgs*)args;
@@ -35,7 +39,8 @@ Controller* scenarioengine::InstantiateControllerUDPDriver(void* args)
 }
 
 ControllerUDPDriver::ControllerUDPDriver(InitArgs* args) :
-	inputMode_(InputMode::DRIVER_INPUT), udpServer_(nullptr), port_(0), execMode_(ExecMode::EXEC_MODE_ASYNCHRONOUS), Controller(args)
+	inputMode_(InputMode::DRIVER_INPUT), udpServer_(nullptr), port_(0), sharedPort_(0), ingestSlot_(nullptr), ingestSeq_(0),
+	execMode_(ExecMode::EXEC_MODE_ASYNCHRONOUS), Controller(args)
 {
 	if (args && args->properties && args->properties->ValueExists("inputMode"))
 	{
@@ -85,6 +90,19 @@ ControllerUDPDriver::ControllerUDPDriver(InitArgs* args) :
 		}
 	}
 
+	if (args && args->properties && args->properties->ValueExists("sharedPort"))
+	{
+		int sharedPortTmp = strtoi(args->properties->GetValueStr("sharedPort"));
+		if (sharedPortTmp < 0 || sharedPortTmp > 65535)
+		{
+			LOG_AND_QUIT("Invalid driver model sharedPort: %d (valid range is [0, 65535]", sharedPortTmp);
+		}
+		else
+		{
+			sharedPort_ = sharedPortTmp;
+		}
+	}
+
 	if (args && args->properties && args->properties->ValueExists("execMode"))
 	{
 		if (args->properties->GetValueStr("execMode") == "asynchronous")
@@ -175,7 +193,11 @@ void ControllerUDPDriver::Step(double timeStep)
 	int retval = 0;
 	int receivedNrOfBytes = 0;
 
-	if (execMode_ == ExecMode::EXEC_MODE_ASYNCHRONOUS)
+	if (ingestSlot_ != nullptr)
+	{
+		receivedNrOfBytes = retval = ReceiveFromIngest();
+	}
+	else if (execMode_ == ExecMode::EXEC_MODE_ASYNCHRONOUS)
 	{
 		// Pick all queued messages - store only the last/latest
 		while (retval >= 0)
@@ -334,12 +356,26 @@ void ControllerUDPDriver::Activate(ControlDomains domainMask)
 {
 	if (object_)
 	{
-		if (port_ == 0)   // port not specified, assign default
+		if (sharedPort_ > 0)
+		{
+			if (ingest_ == nullptr || ingest_->GetPort() != sharedPort_)
+			{
+				ingest_ = UDPDriverIngest::Get(static_cast<unsigned short>(sharedPort_));
+				LOG("ExternalDriverModel object %d using shared port %d execMode: %s", object_->GetId(), sharedPort_, ExecMode2Str(execMode_).c_str());
+			}
+			ingestSlot_ = ingest_->GetSlot(object_->GetId());
+			ingestSeq_ = ingestSlot_->seq.load();  // skip any message received before activation
+		}
+		else if (port_ == 0)   // port not specified, assign default
 		{
 			port_ = basePort_ + object_->GetId();
 		}
 
-		if (udpServer_ == nullptr ||  // not created yet
+		if (sharedPort_ > 0)
+		{
+			// messages received by shared ingest service, no own socket needed
+		}
+		else if (udpServer_ == nullptr ||  // not created yet
 			(udpServer_ != nullptr && udpServer_->GetPort() != port_)) // port nr changed. Need to recreate the socket.
 		{
 			// Close socket in case the controller is assigned again with different port
@@ -375,3 +411,148 @@ void ControllerUDPDriver::Activate(ControlDomains domainMask)
 void ControllerUDPDriver::ReportKeyEvent(int key, bool down)
 {
 }
+
+int ControllerUDPDriver::ReceiveFromIngest()
+{
+	if (UDPDriverIngest::Read(ingestSlot_, msg, ingestSeq_))
+	{
+		return static_cast<int>(sizeof(msg));
+	}
+
+	if (execMode_ == ExecMode::EXEC_MODE_SYNCHRONOUS)
+	{
+		// Wait for next message, spinning shortly before yielding the CPU
+		__int64 startTime = SE_getMonotonicTimeNs();
+		for (__int64 elapsed = 0; elapsed < UDP_SYNCHRONOUS_MODE_TIMEOUT_MS * 1000000LL; elapsed = SE_getMonotonicTimeNs() - startTime)
+		{
+			SE_sleep(elapsed < 2000000LL ? 0 : 1);
+			if (UDPDriverIngest::Read(ingestSlot_, msg, ingestSeq_))
+			{
+				return static_cast<int>(sizeof(msg));
+			}
+		}
+	}
+
+	return 0;
+}
+
+UDPDriverIngest::UDPDriverIngest(unsigned short port) : port_(port), quit_(false), n_messages_(0), n_unknown_(0)
+{
+	udpServer_ = new UDPServer(port, UDP_INGEST_POLL_TIMEOUT_MS);
+	thread_.Start(ReceiverThread, this);
+	LOG("UDPDriverIngest listening on port %d", port_);
+}
+
+UDPDriverIngest::~UDPDriverIngest()
+{
+	quit_ = true;
+	thread_.Wait();
+	delete udpServer_;
+
+	if (n_unknown_ > 0)
+	{
+		LOG("UDPDriverIngest port %d: %llu of %llu messages ignored due to unknown object id",
+			port_, n_unknown_.load(), n_messages_.load());
+	}
+}
+
+std::shared_ptr<UDPDriverIngest> UDPDriverIngest::Get(unsigned short port)
+{
+	ingestRegistryMutex.Lock();
+
+	std::shared_ptr<UDPDriverIngest> ingest = ingestRegistry[port].lock();
+	if (ingest == nullptr)
+	{
+		ingest = std::shared_ptr<UDPDriverIngest>(new UDPDriverIngest(port));
+		ingestRegistry[port] = ingest;
+	}
+
+	ingestRegistryMutex.Unlock();
+
+	return ingest;
+}
+
+UDPDriverIngestSlot* UDPDriverIngest::GetSlot(int objectId)
+{
+	mutex_.Lock();
+
+	std::unique_ptr<UDPDriverIngestSlot>& slot = slots_[objectId];
+	if (slot == nullptr)
+	{
+		slot.reset(new UDPDriverIngestSlot);
+		slot->seq.store(0);
+		memset((void*)&slot->msg, 0, sizeof(slot->msg));
+	}
+	UDPDriverIngestSlot* result = slot.get();
+
+	mutex_.Unlock();
+
+	return result;
+}
+
+bool UDPDriverIngest::Read(UDPDriverIngestSlot* slot, ControllerUDPDriver::DMMessage& msg, unsigned int& seq)
+{
+	for (;;)
+	{
+		unsigned int s = slot->seq.load(std::memory_order_acquire);
+		if (s == seq)
+		{
+			return false;  // nothing new
+		}
+		if (s & 1)
+		{
+			continue;  // writer busy
+		}
+		memcpy((void*)&msg, (const void*)&slot->msg, sizeof(msg));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot->seq.load(std::memory_order_relaxed) == s)
+		{
+			seq = s;
+			return true;
+		}
+	}
+}
+
+void UDPDriverIngest::ReceiverThread(void* args)
+{
+	UDPDriverIngest* ingest = static_cast<UDPDriverIngest*>(args);
+	ControllerUDPDriver::DMMessage buf[UDP_MAX_BATCH_SIZE];
+	int sizes[UDP_MAX_BATCH_SIZE];
+
+	while (!ingest->quit_)
+	{
+		int n = ingest->udpServer_->ReceiveBatch((char*)buf, sizeof(ControllerUDPDriver::DMMessage), UDP_MAX_BATCH_SIZE, sizes,
+			UDP_INGEST_POLL_TIMEOUT_MS);
+
+		if (n <= 0)
+		{
+			continue;
+		}
+
+		// Messages are demultiplexed by object id, later ones in the batch overwriting earlier ones
+		ingest->mutex_.Lock();
+		for (int i = 0; i < n; i++)
+		{
+			if (sizes[i] < static_cast<int>(sizeof(ControllerUDPDriver::DMHeader)))
+			{
+				continue;
+			}
+
+			ingest->n_messages_++;
+			auto it = ingest->slots_.find(static_cast<int>(buf[i].header.objectId));
+			if (it == ingest->slots_.end())
+			{
+				ingest->n_unknown_++;
+				continue;
+			}
+
+			UDPDriverIngestSlot* slot = it->second.get();
+			unsigned int s = slot->seq.load(std::memory_order_relaxed);
+			slot->seq.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			memcpy((void*)&slot->msg, (const void*)&buf[i], sizeof(ControllerUDPDriver::DMMessage));
+			slot->seq.store(s + 2, std::memory_order_release);
+		}
+		ingest->mutex_.Unlock();
+	}
+}
@@ -13,6 +13,9 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 #include "Controller.hpp"
 #include "Parameters.hpp"
 #include "vehicle.hpp"
@@ -24,9 +27,13 @@
 #define UDP_DRIVER_MESSAGE_VERSION 1
 #define DEFAULT_UDP_DRIVER_PORT 49950
 #define UDP_SYNCHRONOUS_MODE_TIMEOUT_MS 500
+#define UDP_INGEST_POLL_TIMEOUT_MS 100  // how often the receiver thread checks for quit request
 
 namespace scenarioengine
 {
+	class UDPDriverIngest;
+	struct UDPDriverIngestSlot;
+
 	// base class for controllers
 	class ControllerUDPDriver: public Controller
 	{
@@ -128,9 +135,73 @@ namespace scenarioengine
 		UDPServer *udpServer_;
 		int port_;
 		static int basePort_;
+		int sharedPort_;  // > 0: receive via shared ingest on this port instead of own socket
+		std::shared_ptr<UDPDriverIngest> ingest_;
+		UDPDriverIngestSlot* ingestSlot_;
+		unsigned int ingestSeq_;  // sequence number of last message read from the slot
 		ExecMode execMode_;
 		DMMessage msg;
 		DMMessage lastMsg;
+
+		int ReceiveFromIngest();
+	};
+
+	// Latest message for one object
+	struct UDPDriverIngestSlot
+	{
+		std::atomic<unsigned int> seq;  // odd while being written
+		ControllerUDPDriver::DMMessage msg;
+	};
+
+	/*
+	 * Receives driver messages for any number of objects on one single port. A background thread drains the
+	 * socket in batches and stores the latest message per object (header.objectId) in a slot, which the
+	 * controllers read without locking. One instance per port is shared by all controllers using it.
+	 */
+	class UDPDriverIngest
+	{
+	public:
+		~UDPDriverIngest();
+
+		/**
+			Get the ingest service for a port, started on first request
+			@param port UDP port to listen on
+			@return Shared instance, stopped when last reference is released
+		*/
+		static std::shared_ptr<UDPDriverIngest> Get(unsigned short port);
+
+		/**
+			Get slot for messages of an object, created on first request
+			@param objectId Object id, matching header.objectId of messages
+			@return Slot pointer, valid for the lifetime of the ingest service
+		*/
+		UDPDriverIngestSlot* GetSlot(int objectId);
+
+		/**
+			Read message from slot if updated since last read
+			@param slot Slot to read from
+			@param msg Message to fill in
+			@param seq Sequence number of last read message, updated on new message
+			@return true if a new message was read, else false
+		*/
+		static bool Read(UDPDriverIngestSlot* slot, ControllerUDPDriver::DMMessage& msg, unsigned int& seq);
+
+		unsigned short GetPort() { return port_; }
+		unsigned long long GetNumberOfMessages() { return n_messages_.load(); }
+		unsigned long long GetNumberOfUnknown() { return n_unknown_.load(); }
+
+	private:
+		UDPDriverIngest(unsigned short port);
+		static void ReceiverThread(void* args);
+
+		unsigned short port_;
+		UDPServer* udpServer_;
+		SE_Thread thread_;
+		SE_Mutex mutex_;  // guards slots_ container
+		std::unordered_map<int, std::unique_ptr<UDPDriverIngestSlot>> slots_;
+		std::atomic<bool> quit_;
+		std::atomic<unsigned long long> n_messages_;
+		std::atomic<unsigned long long> n_unknown_;  // messages for objects without slot
 	};
 
 	Controller* InstantiateControllerUDPDriver(void* args);
@@ -53,6 +53,8 @@ ScenarioPlayer::ScenarioPlayer(int argc, char* argv[]) :
 	osi_receiver_addr = "";
 	osi_freq_ = 1;
 	CSV_Log = NULL;
+	shmExchange = nullptr;
+	udpLockstep = nullptr;
 	osiReporter = NULL;
 	disable_controllers_ = false;
 	frame_counter_ = 0;
@@ -88,6 +90,29 @@ ScenarioPlayer::~ScenarioPlayer()
 	}
 #endif  // _USE_OSG
 	Logger::Inst().SetTimePtr(0);
+	if (frameScheduler.IsActive() && frameScheduler.GetStats().frames > 0)
+	{
+		const SE_FrameScheduler::Stats& stats = frameScheduler.GetStats();
+		LOG("Frame timing: %lld frames, %lld overruns, %lld skipped, jitter avg %.1f max %.1f us",
+			stats.frames, stats.overruns, stats.skipped, stats.jitter_avg_us, stats.jitter_max_us);
+	}
+	// Stop any log writer thread and write queued messages, the logger instance is never destroyed
+	Logger::Inst().SetAsync(false);
+	if (CSV_Log)
+	{
+		// Write any buffered data, don't wait for the static logger instance to be destroyed
+		CSV_Log->Close();
+	}
+	if (shmExchange)
+	{
+		delete shmExchange;
+		shmExchange = nullptr;
+	}
+	if (udpLockstep)
+	{
+		delete udpLockstep;
+		udpLockstep = nullptr;
+	}
 	if (scenarioEngine)
 	{
 		delete scenarioEngine;
@@ -147,6 +172,11 @@ void ScenarioPlayer::Frame(double timestep_s)
 	int retval = 0;
 	double ghost_solo_dt = 0.05;
 
+	if (frameScheduler.IsActive())
+	{
+		frameScheduler.WaitForNextFrame();
+	}
+
 	if (!IsPaused())
 	{
 		retval = ScenarioFrame(timestep_s, true);
@@ -201,6 +231,23 @@ int ScenarioPlayer::ScenarioFrame(double timestep_s, bool keyframe)
 	int retval = 0;
 	mutex.Lock();
 
+	if (shmExchange && keyframe)
+	{
+		// Fetch external input, in lockstep mode waiting for clients to respond to previous frame
+		shmExchange->ApplyInputs(scenarioGateway);
+	}
+
+	if (udpLockstep && keyframe)
+	{
+		// Wait for all participants to respond to previous frame
+		udpLockstep->ApplyInputs(scenarioGateway);
+	}
+
+	if (scenarioEngine->GetLODRadius() > SMALL_NUMBER)
+	{
+		UpdateLODFocus();
+	}
+
 	if ((retval = scenarioEngine->step(timestep_s)) == 0)
 	{
 		if (keyframe)
@@ -231,7 +278,18 @@ int ScenarioPlayer::ScenarioFrame(double timestep_s, bool keyframe)
 			}
 		}
 
-		if (keyframe) frame_counter_++;
+		if (keyframe)
+		{
+			frame_counter_++;
+			if (shmExchange)
+			{
+				shmExchange->Publish(scenarioGateway, frame_counter_, scenarioEngine->getSimulationTime());
+			}
+			if (udpLockstep)
+			{
+				udpLockstep->Publish(scenarioGateway, frame_counter_, scenarioEngine->getSimulationTime());
+			}
+		}
 	}
 
 	scenarioEngine->UpdateGhostMode();
@@ -243,14 +301,41 @@ int ScenarioPlayer::ScenarioFrame(double timestep_s, bool keyframe)
 	return retval;
 }
 
+void ScenarioPlayer::UpdateLODFocus()
+{
+	scenarioEngine->ClearLODFocus();
+
+	if (scenarioEngine->entities_.object_.size() > 0)
+	{
+		scenarioEngine->AddLODFocus(scenarioEngine->entities_.object_[0]);
+	}
+
+	for (size_t i = 0; i < sensor.size(); i++)
+	{
+		scenarioEngine->AddLODFocus(sensor[i]->host_);
+	}
+
+#ifdef _USE_OSG
+	if (viewer_ && viewer_->currentCarInFocus_ >= 0 && viewer_->currentCarInFocus_ < static_cast<int>(scenarioEngine->entities_.object_.size()))
+	{
+		scenarioEngine->AddLODFocus(scenarioEngine->entities_.object_[viewer_->currentCarInFocus_]);
+	}
+#endif
+}
+
 void ScenarioPlayer::ScenarioPostFrame()
 {
 	mutex.Lock();
 
 
-	for (size_t i = 0; i < sensor.size(); i++)
+	if (sensor.size() > 0)
 	{
-		sensor[i]->Update();
+		// One spatial index shared by all sensors
+		sensorGrid.Update(&scenarioEngine->entities_);
+		for (size_t i = 0; i < sensor.size(); i++)
+		{
+			sensor[i]->Update(&sensorGrid);
+		}
 	}
 #ifdef _USE_OSI
 	if (NEAR_NUMBERS(scenarioEngine->getSimulationTime(), scenarioEngine->GetTrueTime()))
@@ -394,19 +479,17 @@ void ScenarioPlayer::ViewerFrame(bool init)
 				}
 			}
 
-			if (entity->trail_->pline_vertex_data_->size() > obj->trail_.GetNumberOfVertices())
+			if (entity->trail_revision_ != obj->trail_.revision_ ||
+				entity->trail_->pline_vertex_data_->size() > obj->trail_.GetNumberOfVertices())
 			{
-				// Reset the trail, probably there has been a ghost restart
+				// Vertices have been removed, e.g. ghost restart, trimmed or decimated trail. Start over.
 				entity->trail_->Reset();
-				for (size_t j = 0; j < obj->trail_.GetNumberOfVertices(); j++)
-				{
-					entity->trail_->AddPoint(osg::Vec3(obj->trail_.vertex_[j].x, obj->trail_.vertex_[j].y, obj->trail_.vertex_[j].z + (obj->GetId() + 1) * TRAIL_Z_OFFSET));
-				}
+				entity->trail_revision_ = obj->trail_.revision_;
 			}
 
-			if (obj->trail_.GetNumberOfVertices() > entity->trail_->pline_vertex_data_->size())
+			for (size_t j = entity->trail_->pline_vertex_data_->size(); j < obj->trail_.GetNumberOfVertices(); j++)
 			{
-				entity->trail_->AddPoint(osg::Vec3(obj->pos_.GetX(), obj->pos_.GetY(), obj->pos_.GetZ() + (obj->GetId() + 1) * TRAIL_Z_OFFSET));
+				entity->trail_->AddPoint(osg::Vec3(obj->trail_.vertex_[j].x, obj->trail_.vertex_[j].y, obj->trail_.vertex_[j].z + (obj->GetId() + 1) * TRAIL_Z_OFFSET));
 			}
 
 			// on screen text following each entity
@@ -861,6 +944,23 @@ int ScenarioPlayer::InitViewer()
 		viewer_->SetNodeMaskBits(viewer::NodeMask::NODE_MASK_ENTITY_BB);
 	}
 
+	if (CreateEntityModels() != 0)
+	{
+		CloseViewer();
+		return -1;
+	}
+
+	// Decorate window border with application name and arguments
+	viewer_->SetWindowTitleFromArgs(opt.GetOriginalArgs());
+	viewer_->RegisterKeyEventCallback(ReportKeyEvent, this);
+
+	viewerState_ = ViewerState::VIEWER_STATE_STARTED;
+
+	return 0;
+}
+
+int ScenarioPlayer::CreateEntityModels()
+{
 	//  Create visual models
 	for (size_t i = 0; i < scenarioEngine->entities_.object_.size(); i++)
 	{
@@ -899,7 +999,6 @@ int ScenarioPlayer::InitViewer()
 			Object::Type::PEDESTRIAN ? viewer::EntityModel::EntityType::MOVING : viewer::EntityModel::EntityType::ENTITY,
 			road_sensor, obj->name_, &obj->boundingbox_, obj->scaleMode_)) != 0)
 		{
-			CloseViewer();
 			return -1;
 		}
 
@@ -931,12 +1030,6 @@ int ScenarioPlayer::InitViewer()
 		}
 	}
 
-	// Decorate window border with application name and arguments
-	viewer_->SetWindowTitleFromArgs(opt.GetOriginalArgs());
-	viewer_->RegisterKeyEventCallback(ReportKeyEvent, this);
-
-	viewerState_ = ViewerState::VIEWER_STATE_STARTED;
-
 	return 0;
 }
 
@@ -1075,6 +1168,7 @@ int ScenarioPlayer::Init()
 	opt.AddOption("bounding_boxes", "Show entities as bounding boxes (toggle modes on key ',') ");
 	opt.AddOption("capture_screen", "Continuous screen capture. Warning: Many jpeg files will be created");
 	opt.AddOption("camera_mode", "Initial camera mode (\"orbit\" (default), \"fixed\", \"flex\", \"flex-orbit\", \"top\", \"driver\", \"custom\") (swith with key 'k') ", "mode");
+	opt.AddOption("csv_binary", "Write csv_logger data in columnar binary format, convert with scripts/csvb2csv.py");
 	opt.AddOption("csv_logger", "Log data for each vehicle in ASCII csv format", "csv_filename");
 	opt.AddOption("collision", "Enable global collision detection, potentially reducing performance");
 	opt.AddOption("custom_camera", "Additional custom fixed camera position <x,y,z,h,p> (multiple occurrences supported)", "position");
@@ -1088,12 +1182,18 @@ int ScenarioPlayer::Init()
 	opt.AddOption("enforce_generate_model", "Generate road 3D model even if SceneGraphFile is specified");
 	opt.AddOption("fixed_timestep", "Run simulation decoupled from realtime, with specified timesteps", "timestep");
 	opt.AddOption("generate_no_road_objects", "Do not generate any OpenDRIVE road objects (e.g. when part of referred 3D model)");
+	opt.AddOption("ghost_trail", "Keep ghost trails within headstart time plus margin (s), removing older vertices", "margin");
+	opt.AddOption("ghost_trail_tolerance", "Drop ghost trail vertices as long as the trail deviates less than tolerance (m)", "tolerance", "0.05");
 	opt.AddOption("ground_plane", "Add a large flat ground surface");
 	opt.AddOption("headless", "Run without viewer window");
 	opt.AddOption("help", "Show this help message");
 	opt.AddOption("hide_route_waypoints", "Disable route waypoint visualization (toggle with key 'R')");
 	opt.AddOption("hide_trajectories", "Hide trajectories from start (toggle with key 'n')");
 	opt.AddOption("info_text", "Show on-screen info text (toggle key 'i') mode 0=None 1=current (default) 2=per_object 3=both", "mode");
+	opt.AddOption("log_async", "Write log messages from a background thread, similar messages exceeding 20/s are suppressed");
+	opt.AddOption("lod_interval", "Number of frames between updates of entities outside lod_radius", "frames", "10");
+	opt.AddOption("lod_radius", "Simulate entities farther than radius from Ego, sensors and camera target at reduced level of detail", "radius");
+	opt.AddOption("log_level", "Skip messages below level: debug, info (default), error", "level");
 	opt.AddOption("logfile_path", "logfile path/filename, e.g. \"../esmini.log\" (default: log.txt)", "path");
 	opt.AddOption("osc_str", "OpenSCENARIO XML string", "string");
 #ifdef _USE_OSI
@@ -1103,6 +1203,7 @@ int ScenarioPlayer::Init()
 	opt.AddOption("osi_points", "Show OSI road pointss (toggle during simulation by press 'y') ");
 	opt.AddOption("osi_receiver_ip", "IP address where to send OSI UDP packages", "IP address");
 #endif
+	opt.AddOption("pace_realtime", "Step in real time with fixed_timestep, at precise absolute deadlines (see also frame timing stats in log)");
 	opt.AddOption("param_dist", "Run variations of the scenario according to specified parameter distribution file", "filename");
 	opt.AddOption("param_permutation", "Run specific permutation of parameter distribution", "index (0 .. NumberOfPermutations-1)");
 	opt.AddOption("path", "Search path prefix for assets, e.g. OpenDRIVE files (multiple occurrences supported)", "path");
@@ -1114,8 +1215,12 @@ int ScenarioPlayer::Init()
 	opt.AddOption("seed", "Specify seed number for random generator", "number");
 	opt.AddOption("sensors", "Show sensor frustums (toggle during simulation by press 'r') ");
 	opt.AddOption("server", "Launch server to receive state of external Ego simulator");
+	opt.AddOption("shm", "Exchange object states with external processes via shared memory", "name", SHM_EXCHANGE_DEFAULT_NAME);
+	opt.AddOption("shm_lockstep", "Wait each frame for shared memory clients to respond, max timeout ms", "timeout", std::to_string(SHM_EXCHANGE_DEFAULT_TIMEOUT));
 	opt.AddOption("threads", "Run viewer in a separate thread, parallel to scenario engine");
 	opt.AddOption("trail_mode", "Show trail lines and/or dots (toggle key 'j') mode 0=None 1=lines 2=dots 3=both", "mode");
+	opt.AddOption("udp_lockstep", "Run in lockstep with external participants over UDP, see UDPLockstepExchange.hpp", "port", std::to_string(UDP_LOCKSTEP_DEFAULT_PORT));
+	opt.AddOption("udp_lockstep_timeout", "Max time to wait each frame for UDP lockstep participants to respond", "ms", std::to_string(UDP_LOCKSTEP_DEFAULT_TIMEOUT));
 	opt.AddOption("version", "Show version and quit");
 
 	exe_path_ = argv_[0];
@@ -1144,6 +1249,32 @@ int ScenarioPlayer::Init()
 		Logger::Inst().SetCallback(0);
 	}
 
+	if ((arg_str = opt.GetOptionArg("log_level")) != "")
+	{
+		if (arg_str == "debug")
+		{
+			Logger::Inst().SetLevel(LogLevel::LEVEL_DEBUG);
+		}
+		else if (arg_str == "info")
+		{
+			Logger::Inst().SetLevel(LogLevel::LEVEL_INFO);
+		}
+		else if (arg_str == "error")
+		{
+			Logger::Inst().SetLevel(LogLevel::LEVEL_ERROR);
+		}
+		else
+		{
+			LOG("Unsupported log level: %s", arg_str.c_str());
+			return -1;
+		}
+	}
+
+	if (opt.GetOptionSet("log_async"))
+	{
+		Logger::Inst().SetAsync(true);
+	}
+
 	OSCParameterDistribution& dist = OSCParameterDistribution::Inst();
 
 	if (dist.GetNumPermutations() > 0)
@@ -1276,6 +1407,19 @@ int ScenarioPlayer::Init()
 		LOG("Run simulation decoupled from realtime, with fixed timestep: %.2f", GetFixedTimestep());
 	}
 
+	if (opt.GetOptionSet("pace_realtime"))
+	{
+		if (GetFixedTimestep() > SMALL_NUMBER)
+		{
+			frameScheduler.Start(GetFixedTimestep());
+			LOG("Pace frames in real time, period %.3f ms", 1e3 * GetFixedTimestep());
+		}
+		else
+		{
+			LOG("pace_realtime requires fixed_timestep, ignored");
+		}
+	}
+
 	if (opt.GetOptionArg("path") != "")
 	{
 		int counter = 0;
@@ -1368,6 +1512,20 @@ int ScenarioPlayer::Init()
 		}
 	}
 
+	if ((arg_str = opt.GetOptionArg("lod_radius")) != "")
+	{
+		int interval = opt.GetOptionSet("lod_interval") ? strtoi(opt.GetOptionArg("lod_interval")) : 10;
+		scenarioEngine->SetLOD(strtod(arg_str), interval);
+		LOG("Level of detail reduced beyond %.1f m, updating every %d frames", scenarioEngine->GetLODRadius(), scenarioEngine->GetLODInterval());
+	}
+
+	if ((arg_str = opt.GetOptionArg("ghost_trail")) != "")
+	{
+		double tolerance = opt.GetOptionSet("ghost_trail_tolerance") ? strtod(opt.GetOptionArg("ghost_trail_tolerance")) : 0.0;
+		scenarioEngine->SetGhostTrailBound(strtod(arg_str), tolerance);
+		LOG("Ghost trails bounded to headstart time + %.1f s, tolerance %.2f m", scenarioEngine->GetGhostTrailMargin(), scenarioEngine->GetGhostTrailTolerance());
+	}
+
 	// Fetch scenario gateway and OpenDRIVE manager objects
 	scenarioGateway = scenarioEngine->getScenarioGateway();
 	odr_manager = scenarioEngine->getRoadManager();
@@ -1418,8 +1576,8 @@ int ScenarioPlayer::Init()
 			}
 
 			CSV_Log->Open(scenarioEngine->getScenarioFilename(),
-				(int)scenarioEngine->entities_.object_.size(), filename);
-			LOG("Log all vehicle data in csv file");
+				(int)scenarioEngine->entities_.object_.size(), filename, opt.GetOptionSet("csv_binary"));
+			LOG("Log all vehicle data in csv file%s", opt.GetOptionSet("csv_binary") ? " (binary)" : "");
 		}
 		else
 		{
@@ -1463,6 +1621,24 @@ int ScenarioPlayer::Init()
 		StartServer(scenarioEngine);
 	}
 
+	if (opt.GetOptionSet("shm"))
+	{
+		int lockstep_timeout = opt.GetOptionSet("shm_lockstep") ? strtoi(opt.GetOptionArg("shm_lockstep")) : 0;
+		if (OpenSharedMemory(opt.GetOptionArg("shm"), lockstep_timeout) != 0)
+		{
+			return -1;
+		}
+	}
+
+	if (opt.GetOptionSet("udp_lockstep"))
+	{
+		int timeout = opt.GetOptionSet("udp_lockstep_timeout") ? strtoi(opt.GetOptionArg("udp_lockstep_timeout")) : UDP_LOCKSTEP_DEFAULT_TIMEOUT;
+		if (OpenUDPLockstep(static_cast<unsigned short>(strtoi(opt.GetOptionArg("udp_lockstep"))), timeout) != 0)
+		{
+			return -1;
+		}
+	}
+
 	player_init_semaphore.Set();
 
 	if (opt.IsInOriginalArgs("--window") || opt.IsInOriginalArgs("--borderless-window"))
@@ -1525,6 +1701,120 @@ int ScenarioPlayer::Init()
 	return 0;
 }
 
+int ScenarioPlayer::Reset()
+{
+	if (scenarioEngine == nullptr)
+	{
+		return -1;
+	}
+
+	if (threads && viewer_)
+	{
+		LOG("Reset not supported with viewer in separate thread");
+		return -1;
+	}
+
+	OSCParameterDistribution& dist = OSCParameterDistribution::Inst();
+
+	if (dist.GetNumPermutations() > 0)
+	{
+		if (dist.GetRequestedIndex() > -1)  // Requested via lib API
+		{
+			if (dist.SetIndex(dist.GetRequestedIndex()) != 0)
+			{
+				return -1;
+			}
+		}
+		else if (dist.IncrementIndex() < 0)
+		{
+			return -1;
+		}
+	}
+
+	// Sensors refer to the entities, remove them before the entities are deleted
+	for (size_t i = 0; i < sensor.size(); i++)
+	{
+		delete sensor[i];
+	}
+	sensor.clear();
+
+#ifdef _USE_OSG
+	if (viewer_)
+	{
+		for (size_t i = 0; i < sensorFrustum.size(); i++)
+		{
+			delete sensorFrustum[i];
+		}
+		sensorFrustum.clear();
+
+		if (OSISensorDetection)
+		{
+			delete OSISensorDetection;
+			OSISensorDetection = nullptr;
+		}
+
+		while (viewer_->entities_.size() > 0)
+		{
+			viewer_->RemoveCar(static_cast<int>(viewer_->entities_.size()) - 1);
+		}
+	}
+#endif
+
+	if (scenarioEngine->Reset() != 0)
+	{
+		LOG("Failed to reset scenario");
+		return -1;
+	}
+
+	if (CSV_Log)
+	{
+		std::string filename = opt.GetOptionArg("csv_logger");
+
+		if (dist.GetNumPermutations() > 0)
+		{
+			filename = dist.AddInfoToFilename(filename);
+		}
+
+		CSV_Log->Open(scenarioEngine->getScenarioFilename(),
+			(int)scenarioEngine->entities_.object_.size(), filename, opt.GetOptionSet("csv_binary"));
+	}
+
+	std::string arg_str;
+	if ((arg_str = opt.GetOptionArg("record")) != "")
+	{
+		std::string filename = IsDirectoryName(arg_str) ?
+			arg_str + FileNameWithoutExtOf(scenarioEngine->getScenarioFilename()) + ".dat" : arg_str;
+
+		if (dist.GetNumPermutations() > 0)
+		{
+			filename = dist.AddInfoToFilename(filename);
+		}
+
+		LOG("Recording data to file %s", filename.c_str());
+		scenarioGateway->RecordToFile(filename, scenarioEngine->getOdrFilename(), scenarioEngine->getSceneGraphFilename());
+	}
+
+#ifdef _USE_OSG
+	if (viewer_ && CreateEntityModels() != 0)
+	{
+		return -1;
+	}
+#endif
+
+	quit_request = false;
+	frame_counter_ = 0;
+
+	if (frameScheduler.IsActive())
+	{
+		// Anchor pacing at the first frame of the new run
+		frameScheduler.Restart();
+	}
+
+	Frame(0.0);
+
+	return 0;
+}
+
 void ScenarioPlayer::RegisterObjCallback(int id, ObjCallbackFunc func, void *data)
 {
 	ObjCallback cb;
@@ -1538,6 +1828,7 @@ void ScenarioPlayer::UpdateCSV_Log()
 {
 	//Flag for signalling end of data line, all vehicles reported
 	bool isendline = false;
+	CSV_VehicleData data;
 
 	//For each vehicle (entitity) stored in the ScenarioPlayer
 	for (size_t i = 0; i < scenarioEngine->entities_.object_.size(); i++)
@@ -1545,11 +1836,8 @@ void ScenarioPlayer::UpdateCSV_Log()
 		//Create a pointer to the object at position i in the entities vector
 		Object* obj = scenarioEngine->entities_.object_[i];
 
-		//Create a Position object for extracting this vehicles XYZ coordinates
-		roadmanager::Position pos = obj->pos_;
-
-		//Extract the String name of the object and store in a compatable const char array
-		const char* name_ = &(*obj->name_.c_str());
+		//Create a reference to the Position object for extracting this vehicles XYZ coordinates
+		roadmanager::Position& pos = obj->pos_;
 
 		if ((i + 1) == scenarioEngine->entities_.object_.size())
 		{
@@ -1557,19 +1845,41 @@ void ScenarioPlayer::UpdateCSV_Log()
 		}
 
 		// Log the extracted data of ego vehicle and additonal scenario vehicles
-		std::string collision_ids;
+		csvCollisionIds.clear();
 		if (SE_Env::Inst().GetCollisionDetection())
 		{
 			for (size_t j = 0; j < obj->collisions_.size(); j++)
 			{
-				collision_ids += std::to_string(obj->collisions_[j]->GetId()) + " ";
+				csvCollisionIds.push_back(obj->collisions_[j]->GetId());
 			}
 		}
-		CSV_Log->LogVehicleData(isendline, scenarioEngine->getSimulationTime(), name_,
-			obj->id_, obj->speed_, obj->wheel_angle_, obj->wheel_rot_,
-			pos.GetX(), pos.GetY(), pos.GetZ(), pos.GetVelX(), pos.GetVelY(), pos.GetVelZ(), pos.GetAccX(), pos.GetAccY(), pos.GetAccZ(),
-			pos.GetS(), pos.GetT(), pos.GetH(), pos.GetHRate(), pos.GetHRelative(), pos.GetHRelativeDrivingDirection(),
-			pos.GetP(), pos.GetCurvature(), collision_ids.c_str());
+
+		data.name = obj->name_.c_str();
+		data.id = obj->id_;
+		data.speed = obj->speed_;
+		data.wheel_angle = obj->wheel_angle_;
+		data.wheel_rot = obj->wheel_rot_;
+		data.x = pos.GetX();
+		data.y = pos.GetY();
+		data.z = pos.GetZ();
+		data.vel_x = pos.GetVelX();
+		data.vel_y = pos.GetVelY();
+		data.vel_z = pos.GetVelZ();
+		data.acc_x = pos.GetAccX();
+		data.acc_y = pos.GetAccY();
+		data.acc_z = pos.GetAccZ();
+		data.s = pos.GetS();
+		data.t = pos.GetT();
+		data.h = pos.GetH();
+		data.h_rate = pos.GetHRate();
+		data.h_relative = pos.GetHRelative();
+		data.h_relative_drive_direction = pos.GetHRelativeDrivingDirection();
+		data.p = pos.GetP();
+		data.curvature = pos.GetCurvature();
+		data.collision_ids = csvCollisionIds.data();
+		data.n_collisions = static_cast<int>(csvCollisionIds.size());
+
+		CSV_Log->LogVehicleData(isendline, scenarioEngine->getSimulationTime(), data);
 	}
 }
 
@@ -1633,6 +1943,46 @@ int ScenarioPlayer::SetParameterValue(const char* name, bool value)
 	return scenarioEngine->scenarioReader->parameters.setParameterValue(name, value);
 }
 
+int ScenarioPlayer::OpenSharedMemory(std::string name, int lockstep_timeout)
+{
+	if (shmExchange == nullptr)
+	{
+		shmExchange = new SharedMemoryExchange();
+	}
+
+	if (shmExchange->Create(name, lockstep_timeout) != 0)
+	{
+		delete shmExchange;
+		shmExchange = nullptr;
+		return -1;
+	}
+
+	// Make initial state available to clients before first step
+	shmExchange->Publish(scenarioGateway, frame_counter_, scenarioEngine->getSimulationTime());
+
+	return 0;
+}
+
+int ScenarioPlayer::OpenUDPLockstep(unsigned short port, int timeout)
+{
+	if (udpLockstep == nullptr)
+	{
+		udpLockstep = new UDPLockstepExchange();
+	}
+
+	if (udpLockstep->Create(port, timeout) != 0)
+	{
+		delete udpLockstep;
+		udpLockstep = nullptr;
+		return -1;
+	}
+
+	// Make initial state available to participants registering before first step
+	udpLockstep->Publish(scenarioGateway, frame_counter_, scenarioEngine->getSimulationTime());
+
+	return 0;
+}
+
 int ScenarioPlayer::LoadParameterDistribution(std::string filename)
 {
 	OSCParameterDistribution& dist = OSCParameterDistribution::Inst();
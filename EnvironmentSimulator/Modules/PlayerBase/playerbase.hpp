@@ -18,6 +18,8 @@
 #include "RoadManager.hpp"
 #include "CommonMini.hpp"
 #include "Server.hpp"
+#include "SharedMemoryExchange.hpp"
+#include "UDPLockstepExchange.hpp"
 #include "IdealSensor.hpp"
 #ifdef _USE_OSI
 #include "OSIReporter.hpp"
@@ -81,6 +83,14 @@ public:
 	ScenarioPlayer(int argc, char* argv[]);
 	~ScenarioPlayer();
 	int Init();
+
+	/**
+		Restart the scenario without reloading road network or recreating viewer and OSI reporter. Storyboard,
+		entities and controllers are recreated, with parameter values of next (or requested) permutation if a
+		parameter distribution is loaded. Sensors are removed, since the entities they are attached to are.
+		@return 0 on success, -1 on failure
+	*/
+	int Reset();
 	void PrintUsage();
 	bool IsQuitRequested() { return quit_request; }
 	void SetOSIFileStatus(bool is_on, const char *filename = 0);
@@ -88,6 +98,7 @@ public:
 	void Draw();
 	void Frame(double timestep_s);
 	void ScenarioPostFrame();
+	void UpdateLODFocus();
 	int ScenarioFrame(double timestep_s, bool keyframe);
 	void ShowObjectSensors(bool mode);
 	void AddObjectSensor(int object_index, double pos_x, double pos_y, double pos_z, double heading,
@@ -132,6 +143,22 @@ public:
 	int GetCounter() { return frame_counter_; }
 	int LoadParameterDistribution(std::string filename);
 
+	/**
+		Exchange object states with external processes via shared memory, see SharedMemoryExchange.hpp
+		@param name Name of the shared memory region
+		@param lockstep_timeout Max time (ms) to wait for client input each frame, 0 = no lockstep
+		@return 0 on success, -1 on failure
+	*/
+	int OpenSharedMemory(std::string name, int lockstep_timeout);
+
+	/**
+		Run in lockstep with external participants over UDP, see UDPLockstepExchange.hpp
+		@param port UDP port to listen on for participants
+		@param timeout Max time (ms) to wait for participant input each frame
+		@return 0 on success, -1 on failure
+	*/
+	int OpenUDPLockstep(unsigned short port, int timeout);
+
 	//TODO
 	//int GetNumberOfVehicleProperties(){return 4;};
 	int GetNumberOfProperties(int index);
@@ -140,6 +167,10 @@ public:
 	roadmanager::OpenDrive *GetODRManager() { return odr_manager; }
 
 	CSV_Logger *CSV_Log;
+	std::vector<int> csvCollisionIds;  // reused by UpdateCSV_Log
+	SharedMemoryExchange *shmExchange;
+	SE_FrameScheduler frameScheduler;  // real time pacing of fixed timesteps, when active
+	UDPLockstepExchange *udpLockstep;
 	ScenarioEngine *scenarioEngine;
 	ScenarioGateway *scenarioGateway;
 #ifdef _USE_OSI
@@ -154,6 +185,7 @@ public:
 	viewer::OSISensorDetection* OSISensorDetection;
 	ViewerState viewerState_;
 	int InitViewer();
+	int CreateEntityModels();
 	void CloseViewer();
 	void ViewerFrame(bool init = false);
 
@@ -171,6 +203,7 @@ public:
 #endif
 	roadmanager::OpenDrive *odr_manager;
 	std::vector<ObjectSensor *> sensor;
+	SensorGrid sensorGrid;
 	const double maxStepSize;
 	const double minStepSize;
 	SE_Options opt;
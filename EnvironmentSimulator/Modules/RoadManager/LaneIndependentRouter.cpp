@@ -1,72 +1,216 @@
 #include <algorithm>
+#include <functional>
 #include "CommonMini.hpp"
 #include "pugixml.hpp"
 #include "LaneIndependentRouter.hpp"
 
 using namespace roadmanager;
 
-LaneIndependentRouter::LaneIndependentRouter(OpenDrive *odr) : odr_(odr), roadCalculations_(RoadCalculations())
+RoadGraph::RoadGraph(OpenDrive *odr) : odr_(odr), roadCalculations_(RoadCalculations()), built_(false), distanceScale_(0.0),
+	maxGap_(0.0), maxSpeed_(0.0), cacheCapacity_(ROUTE_CACHE_SIZE), cacheHits_(0)
 {
+	for (int i = 0; i < odr_->GetNumOfRoads(); i++)
+	{
+		Road *road = odr_->GetRoadByIdx(i);
+		roadIdx_[road] = i;
+		roadById_[road->GetId()] = road;
+	}
+	vertices_.resize(4 * roadIdx_.size(), {false, nullptr, nullptr, {}});
 }
 
-LaneIndependentRouter::~LaneIndependentRouter(){
-	clearQueue(unvisited_);
-	clearVector(visited_);
+Road *RoadGraph::GetRoadById(int id)
+{
+	auto it = roadById_.find(id);
+	return it != roadById_.end() ? it->second : nullptr;
 }
 
-// Gets the next pathnode for the nextroad based on current srcnode
-std::vector<Node *> LaneIndependentRouter::GetNextNodes(Road *nextRoad, Road *targetRoad, Node *currentNode)
+int RoadGraph::GetVertexIndex(Road *road, RoadLink *link, int laneId)
 {
-	std::vector<std::pair<int, int>> connectingLaneIds = GetConnectingLanes(currentNode, nextRoad);
-	if (connectingLaneIds.empty())
+	auto it = roadIdx_.find(road);
+	if (it == roadIdx_.end() || link == nullptr)
 	{
-		return {};
+		return -1;
 	}
 
-	std::vector<Node *> nextNodes;
-	int targetLaneId = targetWaypoint_.GetLaneId();
-	;
-	for (std::pair<int, int> lanePair : connectingLaneIds)
+	return 4 * it->second + (link->GetType() == LinkType::SUCCESSOR ? 2 : 0) + (laneId > 0 ? 1 : 0);
+}
+
+const std::vector<RoadGraph::Edge> &RoadGraph::GetEdges(Road *road, RoadLink *link, int laneId)
+{
+	static const std::vector<Edge> noEdges;
+
+	int idx = GetVertexIndex(road, link, laneId);
+	if (idx < 0)
+	{
+		return noEdges;
+	}
+
+	Vertex &vertex = vertices_[idx];
+	if (!vertex.created)
 	{
-		Node *pNode = nullptr;
-		if (nextRoad == targetRoad && lanePair.second == targetLaneId)
+		CreateVertex(road, link, laneId, vertex);
+	}
+
+	return vertex.edges;
+}
+
+const RoadGraph::Vertex &RoadGraph::GetVertex(int idx)
+{
+	Vertex &vertex = vertices_[idx];
+	if (!vertex.created)
+	{
+		Road *road = odr_->GetRoadByIdx(idx / 4);
+		RoadLink *link = road->GetLink((idx / 2) % 2 ? LinkType::SUCCESSOR : LinkType::PREDECESSOR);
+		if (link)
 		{
-			// Target road found and driving in same direction, create a target node.
-			pNode = CreateTargetNode(currentNode, nextRoad, lanePair);
+			CreateVertex(road, link, idx % 2 ? 1 : -1, vertex);
 		}
 		else
 		{
-			RoadLink *nextLink = GetNextLink(currentNode, nextRoad);
-			if (!nextLink)
+			vertex.road = road;
+			vertex.created = true;
+		}
+	}
+
+	return vertex;
+}
+
+bool RoadGraph::GetRefLinePoint(Road *road, double s, double &x, double &y)
+{
+	if (road->GetNumberOfGeometries() == 0)
+	{
+		return false;
+	}
+
+	int i = 0;
+	while (i < road->GetNumberOfGeometries() - 1 && road->GetGeometry(i + 1)->GetS() <= s)
+	{
+		i++;
+	}
+
+	Geometry *geom = road->GetGeometry(i);
+	double h = 0;
+	geom->EvaluateDS(CLAMP(s - geom->GetS(), 0.0, geom->GetLength()), &x, &y, &h);
+
+	return true;
+}
+
+void RoadGraph::GetRoadEnd(Road *road, RoadLink *link, double &x, double &y)
+{
+	int idx = 4 * roadIdx_[road] + (link->GetType() == LinkType::SUCCESSOR ? 2 : 0);
+	x = roadEnds_[idx];
+	y = roadEnds_[idx + 1];
+}
+
+void RoadGraph::Build()
+{
+	if (built_)
+	{
+		return;
+	}
+
+	size_t nRoads = roadIdx_.size();
+	bool geometryOK = true;
+	roadEnds_.resize(4 * nRoads);
+	maxSpeed_ = roadCalculations_.GetMaxRoadTypeSpeed();
+	for (size_t i = 0; i < nRoads; i++)
+	{
+		Road *road = odr_->GetRoadByIdx(static_cast<int>(i));
+		geometryOK &= GetRefLinePoint(road, 0.0, roadEnds_[4 * i], roadEnds_[4 * i + 1]);
+		geometryOK &= GetRefLinePoint(road, road->GetLength(), roadEnds_[4 * i + 2], roadEnds_[4 * i + 3]);
+		for (int j = 0; j < road->GetNumberOfRoadTypes(); j++)
+		{
+			maxSpeed_ = MAX(maxSpeed_, road->GetRoadType(j)->speed_);
+		}
+	}
+
+	reverseEdges_.assign(vertices_.size(), {});
+	roadEdges_.assign(nRoads, {});
+	distanceScale_ = geometryOK ? 1.0 : 0.0;
+	maxGap_ = 0.0;
+	for (int i = 0; i < static_cast<int>(vertices_.size()); i++)
+	{
+		const Vertex &vertex = GetVertex(i);
+		if (vertex.link == nullptr)
+		{
+			continue;
+		}
+
+		double x0 = 0;
+		double y0 = 0;
+		GetRoadEnd(vertex.road, vertex.link, x0, y0);
+		for (const Edge &edge : vertex.edges)
+		{
+			int nextRoadIdx = roadIdx_[edge.road];
+			roadEdges_[nextRoadIdx].push_back({i, &edge});
+
+			// Straight distance from this road end, via next road, to its other end must not exceed length of next road
+			const double *ends = &roadEnds_[4 * nextRoadIdx];
+			double gap = 0;
+			double chord = 0;
+			if (edge.link)
+			{
+				int entry = edge.link->GetType() == LinkType::SUCCESSOR ? 0 : 2;
+				gap = sqrt(pow(ends[entry] - x0, 2) + pow(ends[entry + 1] - y0, 2));
+				chord = sqrt(pow(ends[2] - ends[0], 2) + pow(ends[3] - ends[1], 2));
+				reverseEdges_[GetVertexIndex(edge.road, edge.link, edge.laneId)].push_back({i, &edge});
+			}
+			else
+			{
+				// dead end, entry is not known, assume the closest end
+				gap = MIN(sqrt(pow(ends[0] - x0, 2) + pow(ends[1] - y0, 2)), sqrt(pow(ends[2] - x0, 2) + pow(ends[3] - y0, 2)));
+			}
+			maxGap_ = MAX(maxGap_, gap);
+			if (gap + chord > SMALL_NUMBER)
 			{
-				// Dont add node if it does not have a link. (end of road)
-				continue;
+				distanceScale_ = MIN(distanceScale_, edge.road->GetLength() / (gap + chord));
 			}
-			// create next non target node
-			pNode = new Node;
-			pNode->link = nextLink;
-			pNode->road = nextRoad;
-			pNode->currentLaneId = lanePair.second;
-			pNode->fromLaneId = lanePair.first;
-			pNode->previous = currentNode;
-			double nextWeight = roadCalculations_.CalcWeight(currentNode, routeStrategy_, nextRoad->GetLength(), nextRoad);
-			pNode->weight = currentNode->weight + nextWeight;
 		}
-		if (pNode)
+	}
+
+	built_ = true;
+}
+
+void RoadGraph::CreateVertex(Road *road, RoadLink *link, int laneId, Vertex &vertex)
+{
+	Node linkNode; // weight calculations only look at the link of previous node
+	linkNode.link = link;
+	vertex.road = road;
+	vertex.link = link;
+
+	for (Road *nextRoad : GetNextRoads(link, road))
+	{
+		std::vector<std::pair<int, int>> connectingLaneIds = GetConnectingLanes(road, link, laneId, nextRoad);
+		if (connectingLaneIds.empty())
+		{
+			continue;
+		}
+
+		Edge edge;
+		edge.road = nextRoad;
+		edge.link = GetNextLink(road, link, nextRoad);
+		for (int i = 0; i < 3; i++)
+		{
+			edge.weight[i] = roadCalculations_.CalcWeight(&linkNode, static_cast<Position::RouteStrategy>(i), nextRoad->GetLength(), nextRoad);
+		}
+
+		for (std::pair<int, int> lanePair : connectingLaneIds)
 		{
-			nextNodes.push_back(pNode);
+			edge.fromLaneId = lanePair.first;
+			edge.laneId = lanePair.second;
+			vertex.edges.push_back(edge);
 		}
 	}
-	return nextNodes;
+	vertex.created = true;
 }
 
-std::vector<Road *> LaneIndependentRouter::GetNextRoads(RoadLink *link, Road *currentRoad)
+std::vector<Road *> RoadGraph::GetNextRoads(RoadLink *link, Road *currentRoad)
 {
 	std::vector<Road *> nextRoads;
 	Road *nextRoad;
 	if (link->GetElementType() == RoadLink::ElementType::ELEMENT_TYPE_ROAD)
 	{
-		nextRoad = odr_->GetRoadById(link->GetElementId());
+		nextRoad = GetRoadById(link->GetElementId());
 		if (nextRoad) // Dont push nullptr
 		{
 			nextRoads.push_back(nextRoad);
@@ -79,7 +223,7 @@ std::vector<Road *> LaneIndependentRouter::GetNextRoads(RoadLink *link, Road *cu
 		for (size_t j = 0; j < junction->GetNoConnectionsFromRoadId(currentRoad->GetId()); j++)
 		{
 			int roadId = junction->GetConnectingRoadIdFromIncomingRoadId(currentRoad->GetId(), (int)j);
-			nextRoad = odr_->GetRoadById(roadId);
+			nextRoad = GetRoadById(roadId);
 			if (nextRoad) // Dont push nullptr
 			{
 				nextRoads.push_back(nextRoad);
@@ -89,12 +233,12 @@ std::vector<Road *> LaneIndependentRouter::GetNextRoads(RoadLink *link, Road *cu
 	return nextRoads;
 }
 
-RoadLink *LaneIndependentRouter::GetNextLink(Node *currentNode, Road *nextRoad)
+RoadLink *RoadGraph::GetNextLink(Road *road, RoadLink *link, Road *nextRoad)
 {
-	if (currentNode->link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
+	if (link->GetElementType() == RoadLink::ELEMENT_TYPE_ROAD)
 	{
 		// node link is a road, find link in the other end of it
-		if (currentNode->link->GetContactPointType() == ContactPointType::CONTACT_POINT_END)
+		if (link->GetContactPointType() == ContactPointType::CONTACT_POINT_END)
 		{
 			return nextRoad->GetLink(LinkType::PREDECESSOR);
 		}
@@ -103,9 +247,9 @@ RoadLink *LaneIndependentRouter::GetNextLink(Node *currentNode, Road *nextRoad)
 			return nextRoad->GetLink(LinkType::SUCCESSOR);
 		}
 	}
-	else if (currentNode->link->GetElementType() == RoadLink::ElementType::ELEMENT_TYPE_JUNCTION)
+	else if (link->GetElementType() == RoadLink::ElementType::ELEMENT_TYPE_JUNCTION)
 	{
-		Junction *junction = Position::GetOpenDrive()->GetJunctionById(currentNode->link->GetElementId());
+		Junction *junction = odr_->GetJunctionById(link->GetElementId());
 		int elementId;
 		if (junction && junction->GetType() == Junction::JunctionType::DIRECT)
 		{
@@ -114,7 +258,7 @@ RoadLink *LaneIndependentRouter::GetNextLink(Node *currentNode, Road *nextRoad)
 		else
 		{
 			// Default junction
-			elementId = currentNode->road->GetId();
+			elementId = road->GetId();
 		}
 
 		if (nextRoad->GetLink(LinkType::SUCCESSOR) &&
@@ -132,17 +276,17 @@ RoadLink *LaneIndependentRouter::GetNextLink(Node *currentNode, Road *nextRoad)
 	return nullptr;
 }
 
-std::vector<std::pair<int, int>> LaneIndependentRouter::GetConnectingLanes(Node *currentNode, Road *nextRoad)
+std::vector<std::pair<int, int>> RoadGraph::GetConnectingLanes(Road *road, RoadLink *link, int laneId, Road *nextRoad)
 {
 	LaneSection *lanesection = nullptr;
-	if (currentNode->link->GetType() == LinkType::SUCCESSOR)
+	if (link->GetType() == LinkType::SUCCESSOR)
 	{
-		int nrOfLanesection = currentNode->road->GetNumberOfLaneSections();
-		lanesection = currentNode->road->GetLaneSectionByIdx(nrOfLanesection - 1);
+		int nrOfLanesection = road->GetNumberOfLaneSections();
+		lanesection = road->GetLaneSectionByIdx(nrOfLanesection - 1);
 	}
 	else
 	{
-		lanesection = currentNode->road->GetLaneSectionByIdx(0);
+		lanesection = road->GetLaneSectionByIdx(0);
 	}
 
 	std::vector<std::pair<int, int>> connectingLaneIds;
@@ -151,9 +295,9 @@ std::vector<std::pair<int, int>> LaneIndependentRouter::GetConnectingLanes(Node
 	{
 		Lane *lane = lanesection->GetLaneByIdx((int)i);
 		int currentlaneId = lane->GetId();
-		if (lane->IsDriving() && SIGN(currentlaneId) == SIGN(currentNode->currentLaneId) && lane->GetId() != 0)
+		if (lane->IsDriving() && SIGN(currentlaneId) == SIGN(laneId) && lane->GetId() != 0)
 		{
-			int nextLaneId = currentNode->road->GetConnectingLaneId(currentNode->link, currentlaneId, nextRoad->GetId());
+			int nextLaneId = road->GetConnectingLaneId(link, currentlaneId, nextRoad->GetId());
 			if (nextLaneId != 0)
 			{
 				connectingLaneIds.push_back({currentlaneId, nextLaneId});
@@ -164,15 +308,81 @@ std::vector<std::pair<int, int>> LaneIndependentRouter::GetConnectingLanes(Node
 	return connectingLaneIds;
 }
 
+bool RoadGraph::GetCachedPath(const PathKey &key, std::vector<Node> &path)
+{
+	auto it = cacheIndex_.find(key);
+	if (it == cacheIndex_.end())
+	{
+		return false;
+	}
+
+	// move to front, most recently used
+	cache_.splice(cache_.begin(), cache_, it->second);
+	path = it->second->second;
+	cacheHits_++;
+
+	return true;
+}
+
+void RoadGraph::AddCachedPath(const PathKey &key, const std::vector<Node> &path)
+{
+	if (cacheCapacity_ == 0)
+	{
+		return;
+	}
+
+	auto it = cacheIndex_.find(key);
+	if (it != cacheIndex_.end())
+	{
+		it->second->second = path;
+		cache_.splice(cache_.begin(), cache_, it->second);
+		return;
+	}
+
+	if (cache_.size() >= cacheCapacity_)
+	{
+		cacheIndex_.erase(cache_.back().first);
+		cache_.pop_back();
+	}
+
+	cache_.emplace_front(key, path);
+	cacheIndex_[key] = cache_.begin();
+}
+
+void RoadGraph::SetCacheCapacity(size_t capacity)
+{
+	cacheCapacity_ = capacity;
+	while (cache_.size() > cacheCapacity_)
+	{
+		cacheIndex_.erase(cache_.back().first);
+		cache_.pop_back();
+	}
+}
+
+LaneIndependentRouter::LaneIndependentRouter(OpenDrive *odr) : nodePoolUsed_(0), odr_(odr), graph_(odr->GetRoadGraph()),
+	roadCalculations_(RoadCalculations())
+{
+}
+
+Node *LaneIndependentRouter::NewNode()
+{
+	if (nodePoolUsed_ == nodePool_.size())
+	{
+		nodePool_.emplace_back();
+	}
+	return &nodePool_[nodePoolUsed_++];
+}
+
 Node *LaneIndependentRouter::CreateTargetNode(Node *currentNode, Road *nextRoad, std::pair<int, int> laneIds)
 {
 	// Create last node (targetnode)
-	Node *targetNode = new Node;
+	Node *targetNode = NewNode();
 	targetNode->previous = currentNode;
 	targetNode->road = nextRoad;
 	targetNode->currentLaneId = laneIds.second;
 	targetNode->fromLaneId = laneIds.first;
 	targetNode->link = nullptr;
+	targetNode->estimate = 0;
 	double nextWeight = roadCalculations_.CalcWeightWithPos(currentNode, targetWaypoint_, nextRoad, routeStrategy_);
 	targetNode->weight = currentNode->weight + nextWeight;
 	return targetNode;
@@ -180,20 +390,19 @@ Node *LaneIndependentRouter::CreateTargetNode(Node *currentNode, Road *nextRoad,
 
 bool LaneIndependentRouter::FindGoal()
 {
+	Road *targetRoad = graph_->GetRoadById(targetWaypoint_.GetTrackId());
+	int targetLaneId = targetWaypoint_.GetLaneId();
+
 	while (!unvisited_.empty())
 	{
 		Node *currentNode = unvisited_.top();
 		unvisited_.pop();
-		bool nodeIsVisited = std::find_if(visited_.begin(), visited_.end(), [currentNode](Node *n)
-										  { return *n == *currentNode; }) != visited_.end();
-		if (nodeIsVisited)
+		if (!visitedKeys_.insert({currentNode->road, currentNode->currentLaneId, currentNode->fromLaneId, currentNode->link}).second)
 		{
-			delete currentNode;
 			continue;
 		}
 		visited_.push_back(currentNode);
-		Road *targetRoad = odr_->GetRoadById(targetWaypoint_.GetTrackId());
-		int targetLaneId = targetWaypoint_.GetLaneId();
+		nodesExpanded_++;
 		if (currentNode->road == targetRoad && currentNode->currentLaneId == targetLaneId)
 		{
 			return true;
@@ -202,22 +411,199 @@ bool LaneIndependentRouter::FindGoal()
 		{
 			continue;
 		}
-		std::vector<Road *> nextRoads = GetNextRoads(currentNode->link,currentNode->road);
-		for (Road *nextRoad : nextRoads)
+		for (const RoadGraph::Edge &edge : graph_->GetEdges(currentNode->road, currentNode->link, currentNode->currentLaneId))
 		{
-			std::vector<Node *> nextNodes = GetNextNodes(nextRoad, targetRoad, currentNode);
-			for (Node *n : nextNodes)
+			Node *pNode = nullptr;
+			if (edge.road == targetRoad && edge.laneId == targetLaneId)
+			{
+				// Target road found and driving in same direction, create a target node.
+				pNode = CreateTargetNode(currentNode, edge.road, {edge.fromLaneId, edge.laneId});
+			}
+			else if (edge.link)
 			{
-				unvisited_.push(n);
+				if (!corridor_.empty() && !corridor_[graph_->GetVertexIndex(edge.road, edge.link, edge.laneId)])
+				{
+					continue;
+				}
+				// create next non target node. Dont add node if it does not have a link. (end of road)
+				pNode = NewNode();
+				pNode->link = edge.link;
+				pNode->road = edge.road;
+				pNode->currentLaneId = edge.laneId;
+				pNode->fromLaneId = edge.fromLaneId;
+				pNode->previous = currentNode;
+				pNode->weight = currentNode->weight + edge.weight[routeStrategy_];
+				pNode->estimate = Estimate(pNode);
+			}
+			if (pNode)
+			{
+				unvisited_.push(pNode);
 			}
 		}
 	}
 	return false;
 }
 
+bool LaneIndependentRouter::FindGoalBidirectional(Node *startNode)
+{
+	typedef std::pair<double, int> QueueItem; // weight, vertex index
+	typedef std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> VertexQueue;
+
+	graph_->Build();
+	Road *targetRoad = graph_->GetRoadById(targetWaypoint_.GetTrackId());
+	int targetLaneId = targetWaypoint_.GetLaneId();
+	auto isTargetEdge = [targetRoad, targetLaneId](const RoadGraph::Edge &edge)
+	{
+		// leads to target node, which can't be passed
+		return edge.road == targetRoad && edge.laneId == targetLaneId;
+	};
+
+	int nVertices = graph_->GetNumberOfVertices();
+	std::vector<double> weightFwd(nVertices, LARGE_NUMBER); // weight from start to end of vertex road
+	std::vector<double> weightBwd(nVertices, LARGE_NUMBER); // weight from end of vertex road to target
+	std::vector<char> doneFwd(nVertices, 0); // final weight known
+	std::vector<char> doneBwd(nVertices, 0);
+	VertexQueue queueFwd;
+	VertexQueue queueBwd;
+	double best = LARGE_NUMBER;
+	int meet = -1;
+
+	int startIdx = graph_->GetVertexIndex(startNode->road, startNode->link, startNode->currentLaneId);
+	weightFwd[startIdx] = startNode->weight;
+	queueFwd.push({startNode->weight, startIdx});
+
+	Node linkNode;
+	for (const RoadGraph::ReverseEdge &re : graph_->GetEdgesToRoad(targetRoad))
+	{
+		if (re.edge->laneId != targetLaneId)
+		{
+			continue;
+		}
+		linkNode.link = graph_->GetVertex(re.from).link;
+		double weight = roadCalculations_.CalcWeightWithPos(&linkNode, targetWaypoint_, targetRoad, routeStrategy_);
+		if (weight < weightBwd[re.from])
+		{
+			weightBwd[re.from] = weight;
+			queueBwd.push({weight, re.from});
+			if (re.from == startIdx && weightFwd[startIdx] + weight < best)
+			{
+				best = weightFwd[startIdx] + weight;
+				meet = startIdx;
+			}
+		}
+	}
+
+	// Expand the search with lowest weight, until no shorter path can be found
+	while (!queueFwd.empty() && !queueBwd.empty() && queueFwd.top().first + queueBwd.top().first < best)
+	{
+		if (queueFwd.top().first <= queueBwd.top().first)
+		{
+			QueueItem item = queueFwd.top();
+			queueFwd.pop();
+			if (item.first > weightFwd[item.second])
+			{
+				continue; // outdated
+			}
+			doneFwd[item.second] = 1;
+			nodesExpanded_++;
+			for (const RoadGraph::Edge &edge : graph_->GetVertex(item.second).edges)
+			{
+				if (!edge.link || isTargetEdge(edge))
+				{
+					continue;
+				}
+				int idx = graph_->GetVertexIndex(edge.road, edge.link, edge.laneId);
+				double weight = item.first + edge.weight[routeStrategy_];
+				if (weight < weightFwd[idx])
+				{
+					weightFwd[idx] = weight;
+					queueFwd.push({weight, idx});
+					if (weight + weightBwd[idx] < best)
+					{
+						best = weight + weightBwd[idx];
+						meet = idx;
+					}
+				}
+			}
+		}
+		else
+		{
+			QueueItem item = queueBwd.top();
+			queueBwd.pop();
+			if (item.first > weightBwd[item.second])
+			{
+				continue; // outdated
+			}
+			doneBwd[item.second] = 1;
+			nodesExpanded_++;
+			for (const RoadGraph::ReverseEdge &re : graph_->GetReverseEdges(item.second))
+			{
+				if (isTargetEdge(*re.edge))
+				{
+					continue;
+				}
+				double weight = item.first + re.edge->weight[routeStrategy_];
+				if (weight < weightBwd[re.from])
+				{
+					weightBwd[re.from] = weight;
+					queueBwd.push({weight, re.from});
+					if (weight + weightFwd[re.from] < best)
+					{
+						best = weight + weightFwd[re.from];
+						meet = re.from;
+					}
+				}
+			}
+		}
+	}
+
+	if (meet < 0)
+	{
+		return false;
+	}
+
+	// Weight is known, now find roads and lanes the same way as the single direction search. Restrict it to
+	// vertices that may be part of any path of that weight, so that ties are resolved as in the other modes.
+	// Weights of vertices not done are at least the lowest weight left in the queue.
+	double minFwd = queueFwd.empty() ? LARGE_NUMBER : queueFwd.top().first;
+	double minBwd = queueBwd.empty() ? LARGE_NUMBER : queueBwd.top().first;
+	double limit = best + SMALL_NUMBER * MAX(1.0, best);
+	corridor_.assign(nVertices, 0);
+	for (int idx = 0; idx < nVertices; idx++)
+	{
+		corridor_[idx] = (doneFwd[idx] ? weightFwd[idx] : minFwd) + (doneBwd[idx] ? weightBwd[idx] : minBwd) <= limit;
+	}
+	unvisited_.push(startNode);
+	bool found = FindGoal();
+	corridor_.clear();
+
+	return found;
+}
+
+double LaneIndependentRouter::Estimate(Node *node)
+{
+	if (!useEstimate_ || node->link == nullptr)
+	{
+		return 0.0;
+	}
+
+	double x = 0;
+	double y = 0;
+	graph_->GetRoadEnd(node->road, node->link, x, y);
+
+	// Roads are at least as long as the straight distance, compensating for any gaps between connected roads
+	double dist = MAX(0.0, graph_->GetDistanceScale() * sqrt(pow(targetX_ - x, 2) + pow(targetY_ - y, 2)) - graph_->GetMaxGap());
+	if (routeStrategy_ == Position::RouteStrategy::FASTEST)
+	{
+		return dist / graph_->GetMaxSpeed();
+	}
+
+	return dist;
+}
+
 bool LaneIndependentRouter::IsPositionValid(Position pos)
 {
-	Road *road = odr_->GetRoadById(pos.GetTrackId());
+	Road *road = graph_->GetRoadById(pos.GetTrackId());
 	if (!road)
 	{
 		return false;
@@ -237,12 +623,13 @@ bool LaneIndependentRouter::IsPositionValid(Position pos)
 
 Node *LaneIndependentRouter::CreateStartNode(RoadLink *link, Road *road, int laneId, ContactPointType contactPoint, Position pos)
 {
-	Node *startNode = new Node;
+	Node *startNode = NewNode();
 	startNode->link = link;
 	startNode->road = road;
 	startNode->currentLaneId = laneId;
 	startNode->fromLaneId = 0;
 	startNode->previous = 0;
+	startNode->estimate = 0;
 
 	double roadLength = 0;
 
@@ -275,8 +662,12 @@ Node *LaneIndependentRouter::CreateStartNode(RoadLink *link, Road *road, int lan
 
 std::vector<Node> LaneIndependentRouter::CalculatePath(Position start, Position target)
 {
-	clearQueue(unvisited_);
-	clearVector(visited_);
+	graph_ = odr_->GetRoadGraph(); // recreated if road network is reloaded
+	nodesExpanded_ = 0;
+	unvisited_ = InspectionPriorityQueue();
+	visited_.clear();
+	visitedKeys_.clear();
+	nodePoolUsed_ = 0;
 
 	if (!IsPositionValid(start))
 	{
@@ -289,11 +680,11 @@ std::vector<Node> LaneIndependentRouter::CalculatePath(Position start, Position
 		return {};
 	}
 
-	Road *startRoad = odr_->GetRoadById(start.GetTrackId());
+	Road *startRoad = graph_->GetRoadById(start.GetTrackId());
 	int startLaneId = start.GetLaneId();
 
 	targetWaypoint_ = target;
-	Road *targetRoad = odr_->GetRoadById(targetWaypoint_.GetTrackId());
+	Road *targetRoad = graph_->GetRoadById(targetWaypoint_.GetTrackId());
 	int targetLaneId = targetWaypoint_.GetLaneId();
 
 	//Get routestrategy from traget position
@@ -333,10 +724,44 @@ std::vector<Node> LaneIndependentRouter::CalculatePath(Position start, Position
 	}
 
 	Node *startNode = CreateStartNode(nextElement, startRoad, startLaneId, contactPoint, start);
-	unvisited_.push(startNode);
 
-	bool found = FindGoal();
+	// The path does not depend on where on the start road the search begins, only on the weight offset
+	RoadGraph::PathKey key = {startRoad->GetId(), startLaneId, isInForwardDirection, targetRoad->GetId(), targetLaneId, target.GetS(), routeStrategy_};
 	std::vector<Node> pathToGoal;
+	if (graph_->GetCachedPath(key, pathToGoal))
+	{
+		if (pathToGoal.empty())
+		{
+			LOG("(LaneIndependentRouter::CalculatePath) Warning: Path to target not found");
+		}
+		for (Node &n : pathToGoal)
+		{
+			n.weight += startNode->weight;
+		}
+		return pathToGoal;
+	}
+
+	// No useful estimate of number of intersections from distance
+	useEstimate_ = searchMode_ == SearchMode::ASTAR && routeStrategy_ != Position::RouteStrategy::MIN_INTERSECTIONS;
+	if (useEstimate_)
+	{
+		graph_->Build();
+		useEstimate_ = graph_->GetDistanceScale() > SMALL_NUMBER && graph_->GetMaxSpeed() > SMALL_NUMBER &&
+					   RoadGraph::GetRefLinePoint(targetRoad, target.GetS(), targetX_, targetY_);
+		startNode->estimate = Estimate(startNode);
+	}
+
+	bool found = false;
+	if (searchMode_ == SearchMode::BIDIRECTIONAL)
+	{
+		found = FindGoalBidirectional(startNode);
+	}
+	else
+	{
+		unvisited_.push(startNode);
+		found = FindGoal();
+	}
+
 	if (found)
 	{
 		Node *nodeIterator = visited_.back();
@@ -351,6 +776,19 @@ std::vector<Node> LaneIndependentRouter::CalculatePath(Position start, Position
 		LOG("(LaneIndependentRouter::CalculatePath) Warning: Path to target not found");
 	}
 	std::reverse(pathToGoal.begin(), pathToGoal.end());
+
+	// Nodes are reused by next calculation, so don't leave references to them
+	for (Node &n : pathToGoal)
+	{
+		n.previous = nullptr;
+		n.weight -= startNode->weight;
+	}
+	graph_->AddCachedPath(key, pathToGoal);
+	for (Node &n : pathToGoal)
+	{
+		n.weight += startNode->weight;
+	}
+
 	return pathToGoal;
 }
 
@@ -447,6 +885,16 @@ double RoadCalculations::CalcAverageSpeed(Road *road)
 	return totalSpeed / (double)roadTypeCount;
 }
 
+double RoadCalculations::GetMaxRoadTypeSpeed()
+{
+	double maxSpeed = 0;
+	for (auto &it : roadTypeToSpeed)
+	{
+		maxSpeed = MAX(maxSpeed, it.second);
+	}
+	return maxSpeed;
+}
+
 double RoadCalculations::CalcWeightWithPos(Node *previousNode, Position pos, Road *road, Position::RouteStrategy routeStrategy)
 {
 	double roadLength = 0;
@@ -2,10 +2,15 @@
 
 #include <string>
 #include <queue>
+#include <deque>
+#include <list>
 #include "pugixml.hpp"
 #include "CommonMini.hpp"
 #include "RoadManager.hpp"
 #include <unordered_map>
+#include <unordered_set>
+
+#define ROUTE_CACHE_SIZE 256  // max number of paths kept per road network
 
 namespace roadmanager
 {
@@ -21,6 +26,7 @@ namespace roadmanager
         double weight;
         RoadLink *link;
         Node *previous;
+        double estimate = 0; // heuristic estimate of remaining weight to target, only used by A* search
         void Print()
         {
             LOG("road=%d, cl=%d, fl=%d, w=%f", road->GetId(), currentLaneId, fromLaneId, weight);
@@ -44,20 +50,50 @@ namespace roadmanager
     public:
         bool operator()(Node *a, Node *b) // overloading both operators
         {
-            if (a->weight == b->weight) // sort after lanes if weight is same.
+            if (a->weight + a->estimate != b->weight + b->estimate)
             {
-                // Changes lane as soon as possible:
-                int aAbs = abs(a->currentLaneId - a->previous->currentLaneId);
-                int bAbs = abs(b->currentLaneId - b->previous->currentLaneId);
-                // Changes lane as late as possible:
-                // int aAbs = abs(a->currentLaneId);
-                // int bAbs = abs(b->currentLaneId);
-                return aAbs > bAbs;
+                return a->weight + a->estimate > b->weight + b->estimate;
             }
-            else
+            if (a->weight != b->weight)
             {
+                // Same estimated total, expand the node closest to start first as Dijkstra would
                 return a->weight > b->weight;
             }
+
+            // sort after lanes if weight is same.
+            // Changes lane as soon as possible:
+            int aAbs = abs(a->currentLaneId - a->previous->currentLaneId);
+            int bAbs = abs(b->currentLaneId - b->previous->currentLaneId);
+            // Changes lane as late as possible:
+            // int aAbs = abs(a->currentLaneId);
+            // int bAbs = abs(b->currentLaneId);
+            if (aAbs != bAbs)
+            {
+                return aAbs > bAbs;
+            }
+
+            // Remaining ties are decided by roads and lanes instead of by order of insertion,
+            // so that all search modes select the same one of equally good paths
+            int order = CompareKeys(a, b);
+            return order != 0 ? order > 0 : CompareKeys(a->previous, b->previous) > 0;
+        }
+
+        static int CompareKeys(Node *a, Node *b)
+        {
+            if (a == nullptr || b == nullptr)
+            {
+                return (a != nullptr) - (b != nullptr);
+            }
+            int keyA[] = {a->road->GetId(), a->currentLaneId, a->fromLaneId, a->link ? static_cast<int>(a->link->GetType()) : -1};
+            int keyB[] = {b->road->GetId(), b->currentLaneId, b->fromLaneId, b->link ? static_cast<int>(b->link->GetType()) : -1};
+            for (int i = 0; i < 4; i++)
+            {
+                if (keyA[i] != keyB[i])
+                {
+                    return keyA[i] < keyB[i] ? -1 : 1;
+                }
+            }
+            return 0;
         }
     };
     /**
@@ -95,6 +131,12 @@ namespace roadmanager
          * @return double ((m) or (s) or (nr of intersection) depending on routestrategy)
          */
         double CalcWeightWithPos(Node *previousNode, Position pos, Road *road, Position::RouteStrategy routeStrategy);
+        /**
+         * @brief Get the highest speed assumed for any road type without defined speed
+         *
+         * @return double (m/s)
+         */
+        double GetMaxRoadTypeSpeed();
 
     private:
         /**
@@ -111,6 +153,226 @@ namespace roadmanager
             {Road::RoadType::ROADTYPE_UNKNOWN, 19.444},
         };
     };
+    /**
+     * @brief Road connections for the lane independent pathfinder, shared by all routers on a road network.
+     *        A vertex is a road left via one of its ends (link), driving in lanes on one side of the reference line.
+     *        Its edges lead to each connecting lane of the next roads. Vertices are created on first use.
+     *        Also keeps the most recently calculated paths.
+     *
+     */
+    class RoadGraph
+    {
+    public:
+        typedef struct
+        {
+            Road *road;       // next road
+            RoadLink *link;   // link in the other end of next road, nullptr if none
+            int fromLaneId;   // lane on current road
+            int laneId;       // connecting lane on next road
+            double weight[3]; // cost of traveling along whole next road, per Position::RouteStrategy
+        } Edge;
+
+        typedef struct
+        {
+            bool created;
+            Road *road;
+            RoadLink *link;
+            std::vector<Edge> edges;
+        } Vertex;
+
+        typedef struct
+        {
+            int from;         // vertex index
+            const Edge *edge; // the edge from that vertex
+        } ReverseEdge;
+
+        typedef struct PathKey
+        {
+            int startRoadId;
+            int startLaneId;
+            bool forward;     // start driving along road direction
+            int targetRoadId;
+            int targetLaneId;
+            double targetS;
+            Position::RouteStrategy routeStrategy;
+            bool operator==(const PathKey &rhs) const
+            {
+                return startRoadId == rhs.startRoadId && startLaneId == rhs.startLaneId && forward == rhs.forward &&
+                       targetRoadId == rhs.targetRoadId && targetLaneId == rhs.targetLaneId && targetS == rhs.targetS &&
+                       routeStrategy == rhs.routeStrategy;
+            }
+        } PathKey;
+
+        /**
+         * @brief Construct a new Road Graph object
+         *
+         * @param odr the opendrive road network
+         */
+        RoadGraph(OpenDrive *odr);
+
+        /**
+         * @brief Get the edges from a road end
+         *
+         * @param road
+         * @param link road link of the end, i.e. successor or predecessor of road
+         * @param laneId any lane on the side of driving
+         * @return const std::vector<Edge>&, empty if no connections
+         */
+        const std::vector<Edge> &GetEdges(Road *road, RoadLink *link, int laneId);
+
+        /**
+         * @brief Get the index of a vertex, see GetVertex
+         *
+         * @param road
+         * @param link road link of the end, i.e. successor or predecessor of road
+         * @param laneId any lane on the side of driving
+         * @return int, -1 if not found
+         */
+        int GetVertexIndex(Road *road, RoadLink *link, int laneId);
+
+        /**
+         * @brief Get vertex by index, its edges are created if not already done
+         *
+         * @param idx
+         * @return const Vertex&
+         */
+        const Vertex &GetVertex(int idx);
+        int GetNumberOfVertices() { return static_cast<int>(vertices_.size()); }
+
+        /**
+         * @brief Create all vertices, reverse edges and the geometric bounds used by the A* heuristic.
+         *        Done once, on first need.
+         *
+         */
+        void Build();
+
+        /**
+         * @brief Get edges leading into a vertex, see Build
+         *
+         * @param idx vertex index
+         * @return const std::vector<ReverseEdge>&
+         */
+        const std::vector<ReverseEdge> &GetReverseEdges(int idx) { return reverseEdges_[idx]; }
+
+        /**
+         * @brief Get all edges leading into a road, see Build
+         *
+         * @param road
+         * @return const std::vector<ReverseEdge>&
+         */
+        const std::vector<ReverseEdge> &GetEdgesToRoad(Road *road) { return roadEdges_[roadIdx_[road]]; }
+
+        /**
+         * @brief Get reference line point at an end of a road, see Build
+         *
+         * @param road
+         * @param link road link of the end, i.e. successor or predecessor of road
+         * @param x
+         * @param y
+         */
+        void GetRoadEnd(Road *road, RoadLink *link, double &x, double &y);
+
+        /**
+         * @brief Factor by which straight distances are scaled to never exceed the length of roads along the way,
+         *        considering gaps between connected road ends. 1.0 for a perfectly connected network. See Build
+         *
+         * @return double
+         */
+        double GetDistanceScale() { return distanceScale_; }
+
+        /**
+         * @brief Largest gap between reference lines of connected roads (m), see Build
+         *
+         * @return double
+         */
+        double GetMaxGap() { return maxGap_; }
+
+        /**
+         * @brief Highest average speed of any road (m/s), see Build
+         *
+         * @return double
+         */
+        double GetMaxSpeed() { return maxSpeed_; }
+
+        /**
+         * @brief Get reference line point of a road
+         *
+         * @param road
+         * @param s
+         * @param x
+         * @param y
+         * @return true if road has any geometry
+         */
+        static bool GetRefLinePoint(Road *road, double s, double &x, double &y);
+
+        /**
+         * @brief Get road by id, constant time
+         *
+         * @param id
+         * @return Road*, nullptr if not found
+         */
+        Road *GetRoadById(int id);
+
+        /**
+         * @brief Look up a calculated path
+         *
+         * @param key
+         * @param path the path, weights relative start node, if found
+         * @return true if found
+         */
+        bool GetCachedPath(const PathKey &key, std::vector<Node> &path);
+
+        /**
+         * @brief Store a calculated path, replacing the least recently used one if the cache is full
+         *
+         * @param key
+         * @param path the path, weights relative start node. Empty if there is no path.
+         */
+        void AddCachedPath(const PathKey &key, const std::vector<Node> &path);
+
+        size_t GetNumberOfCachedPaths() { return cache_.size(); }
+        int GetCacheHits() { return cacheHits_; }
+        void SetCacheCapacity(size_t capacity);
+
+    private:
+        struct PathKeyHash
+        {
+            size_t operator()(const PathKey &k) const
+            {
+                size_t h = std::hash<int>()(k.startRoadId);
+                h = h * 31 + std::hash<int>()(k.startLaneId);
+                h = h * 31 + std::hash<int>()(k.targetRoadId);
+                h = h * 31 + std::hash<int>()(k.targetLaneId);
+                h = h * 31 + std::hash<double>()(k.targetS);
+                return h * 31 + static_cast<size_t>(k.routeStrategy) * 2 + (k.forward ? 1 : 0);
+            }
+        };
+
+        typedef std::list<std::pair<PathKey, std::vector<Node>>> PathList;
+
+        std::vector<Road *> GetNextRoads(RoadLink *link, Road *currentRoad);
+        RoadLink *GetNextLink(Road *road, RoadLink *link, Road *nextRoad);
+        std::vector<std::pair<int, int>> GetConnectingLanes(Road *road, RoadLink *link, int laneId, Road *nextRoad);
+        void CreateVertex(Road *road, RoadLink *link, int laneId, Vertex &vertex);
+
+        OpenDrive *odr_;
+        RoadCalculations roadCalculations_;
+        std::unordered_map<Road *, int> roadIdx_;
+        std::unordered_map<int, Road *> roadById_;
+        std::vector<Vertex> vertices_; // four per road: predecessor/successor end, right/left lanes
+        bool built_;
+        std::vector<std::vector<ReverseEdge>> reverseEdges_; // per vertex
+        std::vector<std::vector<ReverseEdge>> roadEdges_;    // per road
+        std::vector<double> roadEnds_;                       // x, y of start and end, per road
+        double distanceScale_;
+        double maxGap_;
+        double maxSpeed_;
+        PathList cache_;               // most recently used first
+        std::unordered_map<PathKey, PathList::iterator, PathKeyHash> cacheIndex_;
+        size_t cacheCapacity_;
+        int cacheHits_;
+    };
+
     /**
      * @brief The lane independent pathfinder
      *
@@ -118,6 +380,13 @@ namespace roadmanager
     class LaneIndependentRouter
     {
     public:
+        enum class SearchMode
+        {
+            DIJKSTRA,
+            ASTAR,        // goal directed, guided by straight distance to target
+            BIDIRECTIONAL // search from both start and target, then trace lanes along the found roads
+        };
+
         /**
          * @brief Construct a new Lane Independent Router object
          *
@@ -125,10 +394,10 @@ namespace roadmanager
          */
         LaneIndependentRouter(OpenDrive *odr);
 
-        ~LaneIndependentRouter();
-
         /**
          * @brief Calculates the path between two positions.
+         *        Results are cached per road network, see RoadGraph.
+         *        Node::previous is not set in the returned path, use the order of the list instead.
          *
          * @param start
          * @param target
@@ -145,23 +414,24 @@ namespace roadmanager
          */
         std::vector<Position> GetWaypoints(std::vector<Node> path, Position start, Position target);
 
-    private:
         /**
-         * @brief Get the Next Link between two roads
+         * @brief Set search algorithm. All modes find the same path, ties between equally good paths
+         *        are resolved by road and lane ids. Default is Dijkstra.
          *
-         * @param currentNode
-         * @param nextRoad
-         * @return RoadLink*, if no link exist returns nullptr
+         * @param mode
          */
-        RoadLink *GetNextLink(Node *currentNode, Road *nextRoad);
+        void SetSearchMode(SearchMode mode) { searchMode_ = mode; }
+        SearchMode GetSearchMode() { return searchMode_; }
+
         /**
-         * @brief Get the nextroads from a link
+         * @brief Get number of nodes expanded by latest path calculation, 0 if path was found in cache.
+         *        In bidirectional mode road ends expanded by both searches are included.
          *
-         * @param link roadlink
-         * @param currentRoad
-         * @return std::vector<Road *>, empty if no roads exists
+         * @return int
          */
-        std::vector<Road *> GetNextRoads(RoadLink *link, Road *currentRoad);
+        int GetNodesExpanded() { return nodesExpanded_; }
+
+    private:
         /**
          * @brief Creates a Target Node
          *
@@ -183,28 +453,26 @@ namespace roadmanager
          */
         Node *CreateStartNode(RoadLink *link, Road *road, int laneId, ContactPointType contactPoint, Position pos);
         /**
-         * @brief Get the next nodes (one for each lane) for the next road
+         * @brief The main loop of the lane independent pathfinder
          *
-         * @param nextRoad
-         * @param targetRoad
-         * @param currentNode currentNode
-         * @return std::vector<Node *>
+         * @return true if path is found
          */
-        std::vector<Node *> GetNextNodes(Road *nextRoad, Road *targetRoad, Node *currentNode);
+        bool FindGoal();
         /**
-         * @brief Get the Connecting Lanes between a node (road,lane) and the next road
+         * @brief Search roads from both start and target. Lanes are then found by FindGoal, limited to the roads
+         *        of the shortest path.
          *
-         * @param currentNode
-         * @param nextRoad
-         * @return std::vector<std::pair<int, int>>  <fromlaneId,currentLaneId>
+         * @param startNode
+         * @return true if path is found
          */
-        std::vector<std::pair<int, int>> GetConnectingLanes(Node *currentNode, Road *nextRoad);
+        bool FindGoalBidirectional(Node *startNode);
         /**
-         * @brief The main loop of the lane independent pathfinder
+         * @brief Estimate remaining weight from the end of a node to the target, never overestimating it
          *
-         * @return true if path is found
+         * @param node
+         * @return double
          */
-        bool FindGoal();
+        double Estimate(Node *node);
         /**
          * @brief Checks if a position is valid on the OpenDRIVE network.
          *
@@ -213,27 +481,36 @@ namespace roadmanager
          * @return false
          */
         bool IsPositionValid(Position pos);
-        template <class Q>
-        void clearQueue(Q &q)
+        /**
+         * @brief Get a node from the pool, valid until next path calculation
+         *
+         * @return Node*
+         */
+        Node *NewNode();
+
+        struct NodeKey
         {
-            while (!q.empty())
+            Road *road;
+            int currentLaneId;
+            int fromLaneId;
+            RoadLink *link;
+            bool operator==(const NodeKey &rhs) const
             {
-                auto p = q.top();
-                q.pop();
-                delete p;
+                return road == rhs.road && currentLaneId == rhs.currentLaneId && fromLaneId == rhs.fromLaneId && link == rhs.link;
             }
-            q = Q();
-        }
-        template <class V>
-        void clearVector(V &v)
+        };
+
+        struct NodeKeyHash
         {
-            for (auto p : v)
+            size_t operator()(const NodeKey &k) const
             {
-                delete p;
+                size_t h = std::hash<void *>()(k.road);
+                h = h * 31 + std::hash<int>()(k.currentLaneId);
+                h = h * 31 + std::hash<int>()(k.fromLaneId);
+                return h * 31 + std::hash<void *>()(k.link);
             }
-            v.clear();
-        }
-        
+        };
+
         struct InspectionPriorityQueue : public std::priority_queue<Node *, std::vector<Node *>, WeightCompare> {
             using BaseClass = std::priority_queue<Node *, std::vector<Node *>, WeightCompare>;
             using BaseClass::BaseClass;
@@ -246,10 +523,20 @@ namespace roadmanager
 
         InspectionPriorityQueue unvisited_;
         std::vector<Node *> visited_;
+        std::unordered_set<NodeKey, NodeKeyHash> visitedKeys_;
+        std::deque<Node> nodePool_; // stable addresses, reused between path calculations
+        size_t nodePoolUsed_;
         Position targetWaypoint_;
         OpenDrive *odr_;
+        RoadGraph *graph_;
         RoadCalculations roadCalculations_;
         Position::RouteStrategy routeStrategy_;
+        SearchMode searchMode_ = SearchMode::DIJKSTRA;
+        int nodesExpanded_ = 0;
+        bool useEstimate_ = false;
+        double targetX_ = 0;
+        double targetY_ = 0;
+        std::vector<char> corridor_; // per vertex, when not empty FindGoal only visits flagged vertices
     };
 
 }
\ No newline at end of file
@@ -54,6 +54,7 @@
 #include <sstream>
 
 #include "RoadManager.hpp"
+#include "LaneIndependentRouter.hpp"
 #include "odrSpiral.h"
 #include "pugixml.hpp"
 #include "CommonMini.hpp"
@@ -69,7 +70,10 @@ using namespace roadmanager;
 #define OSI_POINT_DIST_SCALE 0.025
 #define ROADMARK_WIDTH_STANDARD 0.15
 #define ROADMARK_WIDTH_BOLD 0.20
-#define NURBS_STEPLENGTH 1.0
+#define NURBS_STEPLENGTH 1.0  // initial distance between curve samples
+#define NURBS_TOLERANCE 0.01  // max deviation of polyline from curve
+#define NURBS_MAX_REFINE 5  // max number of times to halve the initial step where curve deviates from polyline
+#define NURBS_MAX_STEPS_PER_SEGMENT 8  // max number of initial steps represented by one polyline segment
 
 
 static int g_Lane_id;
@@ -2970,6 +2974,9 @@ void OpenDrive::Clear()
 {
 	InitGlobalLaneIds();
 
+	delete road_graph_;
+	road_graph_ = nullptr;
+
 	for (size_t i = 0; i < road_.size(); i++)
 	{
 		delete road_[i];
@@ -2991,6 +2998,12 @@ bool OpenDrive::LoadOpenDriveFile(const char *filename, bool replace)
 	{
 		Clear();
 	}
+	else
+	{
+		// Roads will be added, graph needs to be rebuilt
+		delete road_graph_;
+		road_graph_ = nullptr;
+	}
 
 	odr_filename_ = filename;
 
@@ -4882,6 +4895,16 @@ OpenDrive::~OpenDrive()
 	Clear();
 }
 
+RoadGraph* OpenDrive::GetRoadGraph()
+{
+	if (road_graph_ == nullptr)
+	{
+		road_graph_ = new RoadGraph(this);
+	}
+
+	return road_graph_;
+}
+
 int OpenDrive::GetTrackIdxById(int id)
 {
 	for (int i = 0; i<(int)road_.size(); i++)
@@ -9932,6 +9955,9 @@ TrajVertex* PolyLineBase::UpdateVertex(int i, double x, double y, double z)
 
 	v->s = length_;
 
+	// Segments on both sides of the vertex are affected
+	n_boxed_segments_ = MIN(n_boxed_segments_, MAX(0, i - 1));
+
 	return &vertex_[i];
 }
 
@@ -9946,6 +9972,39 @@ TrajVertex* PolyLineBase::UpdateVertex(int i, double x, double y, double z, doub
 	return &vertex_[i];
 }
 
+void PolyLineBase::RemoveFirstVertices(int n)
+{
+	if (n >= GetNumberOfVertices())
+	{
+		Reset();
+		return;
+	}
+	else if (n < 1)
+	{
+		return;
+	}
+
+	vertex_.erase(vertex_.begin(), vertex_.begin() + n);
+	current_index_ = MAX(0, current_index_ - n);
+	n_boxed_segments_ = 0;
+	revision_++;
+}
+
+void PolyLineBase::RemoveLastVertex()
+{
+	if (GetNumberOfVertices() < 2)
+	{
+		Reset();
+		return;
+	}
+
+	vertex_.pop_back();
+	length_ = vertex_.back().s;
+	current_index_ = MIN(current_index_, GetNumberOfVertices() - 1);
+	n_boxed_segments_ = MIN(n_boxed_segments_, GetNumberOfVertices() - 1);
+	revision_++;
+}
+
 int PolyLineBase::Evaluate(double s, TrajVertex& pos, double cornerRadius, int startAtIndex)
 {
 	double s_local = 0;
@@ -9963,13 +10022,9 @@ int PolyLineBase::Evaluate(double s, TrajVertex& pos, double cornerRadius, int s
 		s_local = 0;
 		i = GetNumberOfVertices() - 1;
 	}
-	else if (s >= vertex_[i].s)
-	{
-		for (; i < GetNumberOfVertices() - 1 && s >= vertex_[i + 1].s; i++);
-	}
-	else if (s < vertex_[i].s)
+	else
 	{
-		for (; i > 0 && s < vertex_[i].s; i--);
+		i = FindIndexByS(s, i);
 	}
 
 	double s0 = vertex_[i].s;
@@ -9996,56 +10051,219 @@ int PolyLineBase::Evaluate(double s, TrajVertex& pos)
 	return Evaluate(s, pos, 0.0, 0);
 }
 
+int PolyLineBase::FindIndexByS(double s, int startAtIndex)
+{
+	int i = CLAMP(startAtIndex, 0, GetNumberOfVertices() - 1);
+
+	// First look close to start index, typically the index of previous evaluation
+	if (s >= vertex_[i].s)
+	{
+		for (int j = 0; j < POLYLINE_SEARCH_WINDOW && i < GetNumberOfVertices() - 1 && s >= vertex_[i + 1].s; j++, i++);
+		if (i == GetNumberOfVertices() - 1 || s < vertex_[i + 1].s)
+		{
+			return i;
+		}
+	}
+	else
+	{
+		for (int j = 0; j < POLYLINE_SEARCH_WINDOW && i > 0 && s < vertex_[i].s; j++, i--);
+		if (i == 0 || s >= vertex_[i].s)
+		{
+			return i;
+		}
+	}
+
+	// s is increasing, so do a binary search
+	auto it = std::upper_bound(vertex_.begin(), vertex_.end(), s, [](double value, const TrajVertex& v) { return value < v.s; });
+
+	return MAX(0, static_cast<int>(it - vertex_.begin()) - 1);
+}
+
 int PolyLineBase::Time2S(double time, double& s)
 {
-	int step = 1;
-	if (GetNumberOfVertices() < 1 || time < vertex_[0].time)
+	int n = GetNumberOfVertices();
+	if (n < 1 || time < vertex_[0].time)
 	{
-		s = 0.0;
+		s = n < 1 ? 0.0 : vertex_[0].s;  // first vertex might have been removed, see RemoveFirstVertices
 		return 0;
 	}
 
 	// start looking from current index
-	int i = current_index_;
+	int i = CLAMP(current_index_, 0, MAX(0, n - 2));
+	int step = time < vertex_[i].time ? -1 : 1;
+	bool found = false;
 
-	if (time < vertex_[i].time)
+	for (int j = 0; j < POLYLINE_SEARCH_WINDOW && i >= 0 && i < n - 1; j++, i += step)
 	{
-		step = -1;  // Search backwards
+		if (vertex_[i].time <= time && vertex_[i + 1].time > time)
+		{
+			found = true;
+			break;
+		}
 	}
 
-	for (size_t j = 0; j < GetNumberOfVertices(); j++)
+	if (!found)
 	{
-		if (vertex_[i].time <= time && vertex_[i + 1].time > time)
+		// time is increasing, so do a binary search
+		auto it = std::upper_bound(vertex_.begin(), vertex_.end(), time, [](double value, const TrajVertex& v) { return value < v.time; });
+		i = static_cast<int>(it - vertex_.begin()) - 1;
+		found = i >= 0 && i < n - 1;
+	}
+
+	if (found)
+	{
+		double w = (time - vertex_[i].time) / (vertex_[i + 1].time - vertex_[i].time);
+		s = vertex_[i].s + w * (vertex_[i + 1].s - vertex_[i].s);
+		current_index_ = i;
+		current_s_ = s;
+		return 0;
+	}
+
+	// time out of range, grab last element
+	s = GetVertex(-1)->s;
+
+	return 0;
+}
+
+double PolyLineBase::SegmentDistance(int i, double x, double y, double& s_local)
+{
+	double px = 0.0;
+	double py = 0.0;
+
+	ProjectPointOnVector2D(x, y, vertex_[i].x, vertex_[i].y, vertex_[i + 1].x, vertex_[i + 1].y, px, py);
+	double dist = PointDistance2D(x, y, px, py);
+
+	bool inside = PointInBetweenVectorEndpoints(px, py, vertex_[i].x, vertex_[i].y, vertex_[i + 1].x, vertex_[i + 1].y, s_local);
+	if (!inside)
+	{
+		// Find combined longitudinal and lateral distance to line endpoint
+		// s_local represent now (outside line segment) distance to closest line segment end point
+		dist = sqrt(dist * dist + s_local * s_local);
+		if (s_local < 0)
 		{
-			double w = (time - vertex_[i].time) / (vertex_[i + 1].time - vertex_[i].time);
-			s = vertex_[i].s + w * (vertex_[i + 1].s - vertex_[i].s);
-			current_index_ = i;
-			current_s_ = s;
-			return 0;
+			s_local = 0;
+		}
+		else
+		{
+			s_local = vertex_[i + 1].s - vertex_[i].s;
 		}
+	}
+	else
+	{
+		// rescale normalized s
+		s_local *= (vertex_[i + 1].s - vertex_[i].s);
+	}
+
+	return dist;
+}
+
+void PolyLineBase::UpdateBoundingBoxes()
+{
+	int n_segments = MAX(0, GetNumberOfVertices() - 1);
+
+	if (n_boxed_segments_ > n_segments)
+	{
+		n_boxed_segments_ = 0;  // vertices removed
+	}
+
+	if (n_boxed_segments_ == n_segments)
+	{
+		return;
+	}
 
-		i += step;
-		if (i >= GetNumberOfVertices() - 1)
+	// Recalculate from the box of first changed segment
+	int first = n_boxed_segments_ / POLYLINE_BOX_SIZE;
+	boxes_[0].resize((n_segments + POLYLINE_BOX_SIZE - 1) / POLYLINE_BOX_SIZE);
+	for (int b = first; b < static_cast<int>(boxes_[0].size()); b++)
+	{
+		BoundingBox& box = boxes_[0][b];
+		box = {LARGE_NUMBER, LARGE_NUMBER, -LARGE_NUMBER, -LARGE_NUMBER};
+		for (int i = b * POLYLINE_BOX_SIZE; i <= MIN((b + 1) * POLYLINE_BOX_SIZE, n_segments); i++)
 		{
-			// Reached end of buffer, continue from start
-			i = 0;
+			box.x_min = MIN(box.x_min, vertex_[i].x);
+			box.y_min = MIN(box.y_min, vertex_[i].y);
+			box.x_max = MAX(box.x_max, vertex_[i].x);
+			box.y_max = MAX(box.y_max, vertex_[i].y);
 		}
-		else if (i < 0)
+	}
+
+	first /= POLYLINE_BOX_SIZE;
+	boxes_[1].resize((boxes_[0].size() + POLYLINE_BOX_SIZE - 1) / POLYLINE_BOX_SIZE);
+	for (int g = first; g < static_cast<int>(boxes_[1].size()); g++)
+	{
+		BoundingBox& box = boxes_[1][g];
+		box = {LARGE_NUMBER, LARGE_NUMBER, -LARGE_NUMBER, -LARGE_NUMBER};
+		for (int b = g * POLYLINE_BOX_SIZE; b < MIN((g + 1) * POLYLINE_BOX_SIZE, static_cast<int>(boxes_[0].size())); b++)
 		{
-			i = GetNumberOfVertices() - 1;
+			box.x_min = MIN(box.x_min, boxes_[0][b].x_min);
+			box.y_min = MIN(box.y_min, boxes_[0][b].y_min);
+			box.x_max = MAX(box.x_max, boxes_[0][b].x_max);
+			box.y_max = MAX(box.y_max, boxes_[0][b].y_max);
 		}
 	}
 
-	// s seems out of range, grab last element
-	s = GetVertex(-1)->s;
+	n_boxed_segments_ = n_segments;
+}
 
-	return 0;
+static double BoxDistance(double x_min, double y_min, double x_max, double y_max, double x, double y)
+{
+	double dx = MAX(0.0, MAX(x_min - x, x - x_max));
+	double dy = MAX(0.0, MAX(y_min - y, y - y_max));
+
+	return sqrt(dx * dx + dy * dy);
+}
+
+int PolyLineBase::FindClosestSegment(double x, double y, double& s_local, double& dist)
+{
+	UpdateBoundingBoxes();
+
+	// Visit groups in order of distance, skipping boxes further away than closest segment found so far
+	std::vector<std::pair<double, int>> groups(boxes_[1].size());
+	for (size_t g = 0; g < boxes_[1].size(); g++)
+	{
+		BoundingBox& box = boxes_[1][g];
+		groups[g] = {BoxDistance(box.x_min, box.y_min, box.x_max, box.y_max, x, y), static_cast<int>(g)};
+	}
+	std::sort(groups.begin(), groups.end());
+
+	int i_min = -1;
+	double s_local_tmp = 0.0;
+	dist = LARGE_NUMBER;
+	for (auto& group : groups)
+	{
+		// margin for rounding, so that of segments at equal distance the first one is always selected
+		if (group.first > dist + SMALL_NUMBER)
+		{
+			break;
+		}
+
+		for (int b = group.second * POLYLINE_BOX_SIZE; b < MIN((group.second + 1) * POLYLINE_BOX_SIZE, static_cast<int>(boxes_[0].size())); b++)
+		{
+			BoundingBox& box = boxes_[0][b];
+			if (BoxDistance(box.x_min, box.y_min, box.x_max, box.y_max, x, y) > dist + SMALL_NUMBER)
+			{
+				continue;
+			}
+
+			for (int i = b * POLYLINE_BOX_SIZE; i < MIN((b + 1) * POLYLINE_BOX_SIZE, n_boxed_segments_); i++)
+			{
+				double d = SegmentDistance(i, x, y, s_local_tmp);
+				if (d < dist || (d == dist && i < i_min))
+				{
+					i_min = i;
+					s_local = s_local_tmp;
+					dist = d;
+				}
+			}
+		}
+	}
+
+	return i_min;
 }
 
 int PolyLineBase::FindClosestPoint(double xin, double yin, TrajVertex& pos, int& index, int startAtIndex)
 {
 	// look along the line segments
-	TrajVertex tmpPos;
 	double sLocal = 0.0;
 	double sLocalMin = 0.0;
 	int iMin = startAtIndex;
@@ -10064,56 +10282,45 @@ int PolyLineBase::FindClosestPoint(double xin, double yin, TrajVertex& pos, int&
 		i = startAtIndex < 0 ? 0 : startAtIndex;
 	}
 
-	// Find closest line segment
-
-	while (i >= 0 && i < GetNumberOfVertices() - 1)
+	if (startAtIndex <= 0 && GetNumberOfVertices() - 1 > POLYLINE_BOX_SIZE)
 	{
-		ProjectPointOnVector2D(xin, yin, vertex_[i].x, vertex_[i].y, vertex_[i + 1].x, vertex_[i + 1].y, tmpPos.x, tmpPos.y);
-		double distTmp = PointDistance2D(xin, yin, tmpPos.x, tmpPos.y);
-
-		bool inside = PointInBetweenVectorEndpoints(tmpPos.x, tmpPos.y, vertex_[i].x, vertex_[i].y, vertex_[i + 1].x, vertex_[i + 1].y, sLocal);
-		if (!inside)
+		// Search whole polyline, use bounding boxes to skip segments far away
+		int iClosest = FindClosestSegment(xin, yin, sLocalMin, distMin);
+		if (iClosest >= 0)
 		{
-			// Find combined longitudinal and lateral distance to line endpoint
-			// sLocal represent now (outside line segment) distance to closest line segment end point
-			distTmp = sqrt(distTmp * distTmp + sLocal * sLocal);
-			if (sLocal < 0)
-			{
-				sLocal = 0;
-			}
-			else
-			{
-				sLocal = vertex_[i + 1].s - vertex_[i].s;
-			}
+			iMin = iClosest;
 		}
-		else
+	}
+	else
+	{
+		// Find closest line segment
+		while (i >= 0 && i < GetNumberOfVertices() - 1)
 		{
-			// rescale normalized s
-			sLocal *= (vertex_[i + 1].s - vertex_[i].s);
-		}
+			double distTmp = SegmentDistance(i, xin, yin, sLocal);
 
-		if (distTmp < distMin)
-		{
-			iMin = (int)i;
-			sLocalMin = sLocal;
-			distMin = distTmp;
-		}
-		else if (startAtIndex > 0)
-		{
-			// Look for a local minimum distance
-			// Distance is increasing
-			// After looking in forward direction, go backwards from the start index
-			if (step == 1)
+			if (distTmp < distMin)
 			{
-				i = startAtIndex;  // go back to start index
-				step = -1;  // and continue search in other direction
+				iMin = (int)i;
+				sLocalMin = sLocal;
+				distMin = distTmp;
 			}
-			else
+			else if (startAtIndex > 0)
 			{
-				break;  // Now give up
+				// Look for a local minimum distance
+				// Distance is increasing
+				// After looking in forward direction, go backwards from the start index
+				if (step == 1)
+				{
+					i = startAtIndex;  // go back to start index
+					step = -1;  // and continue search in other direction
+				}
+				else
+				{
+					break;  // Now give up
+				}
 			}
+			i += step;
 		}
-		i += step;
 	}
 
 	if (distMin < LARGE_NUMBER)
@@ -10186,9 +10393,13 @@ TrajVertex* PolyLineBase::GetVertex(int index)
 void PolyLineBase::Reset()
 {
 	vertex_.clear();
+	boxes_[0].clear();
+	boxes_[1].clear();
+	n_boxed_segments_ = 0;
 	current_index_ = 0;
 	current_s_ = 0.0;
 	length_ = 0;
+	revision_++;
 }
 
 void PolyLineShape::AddVertex(Position pos, double time, bool calculateHeading)
@@ -10297,6 +10508,84 @@ double NurbsShape::CoxDeBoor(double x, int i, int k, const std::vector<double>&
 	return eq1 + eq2;
 }
 
+int NurbsShape::FindSpan(double t)
+{
+	int n = static_cast<int>(ctrlPoint_.size());
+
+	if (order_ < 1 || static_cast<int>(knot_.size()) < n + order_)
+	{
+		return -1;
+	}
+
+	// Last knot not greater than t, i.e. skipping any empty spans of repeated knots
+	int span = static_cast<int>(std::upper_bound(knot_.begin(), knot_.end(), t) - knot_.begin()) - 1;
+
+	if (span < order_ - 1 || span > n - 1)
+	{
+		return -1;
+	}
+
+	return span;
+}
+
+void NurbsShape::UpdateSpanCache()
+{
+	int p = order_ - 1;
+	int n_spans = static_cast<int>(ctrlPoint_.size()) - p;
+	int n_coeffs = p * (p + 1) / 2;
+
+	span_inv_.assign(static_cast<size_t>(MAX(0, n_spans * n_coeffs)), 0.0);
+	left_.assign(static_cast<size_t>(order_), 0.0);
+	right_.assign(static_cast<size_t>(order_), 0.0);
+
+	for (int span = p; span < p + n_spans; span++)
+	{
+		double* inv = span_inv_.data() + (span - p) * n_coeffs;
+		for (int j = 1; j <= p; j++)
+		{
+			for (int r = 0; r < j; r++)
+			{
+				double den = knot_[span + r + 1] - knot_[span + 1 - j + r];
+				inv[j * (j - 1) / 2 + r] = den > SMALL_NUMBER ? 1.0 / den : 0.0;
+			}
+		}
+	}
+}
+
+void NurbsShape::EvaluateBasis(int span, double t)
+{
+	// Triangular scheme, see "The NURBS Book" by Piegl and Tiller, algorithm A2.2
+	// Resulting values are the basis functions of control points span - p .. span
+	int p = order_ - 1;
+	double* inv = span_inv_.data() + (span - p) * p * (p + 1) / 2;
+	double* N = &d_[span - p];
+
+	if (basis_span_ < 0)
+	{
+		std::fill(d_.begin(), d_.end(), 0.0);
+	}
+	else if (basis_span_ != span)
+	{
+		std::fill(d_.begin() + (basis_span_ - p), d_.begin() + basis_span_ + 1, 0.0);
+	}
+	basis_span_ = span;
+
+	N[0] = 1.0;
+	for (int j = 1; j <= p; j++)
+	{
+		left_[j] = t - knot_[span + 1 - j];
+		right_[j] = knot_[span + j] - t;
+		double saved = 0.0;
+		for (int r = 0; r < j; r++)
+		{
+			double tmp = N[r] * inv[j * (j - 1) / 2 + r];
+			N[r] = saved + right_[r + 1] * tmp;
+			saved = left_[j - r] * tmp;
+		}
+		N[j] = saved;
+	}
+}
+
 void NurbsShape::CalculatePolyLine()
 {
 	if (ctrlPoint_.size() < 1)
@@ -10328,7 +10617,7 @@ void NurbsShape::CalculatePolyLine()
 		throw std::runtime_error("Nurbs zero length - check controlpoints");
 	}
 
-	// Calculate arc length
+	// Sample curve at uniform parameter steps
 	double newLength = 0.0;
 	double t_max = knot_.back();
 	int nSteps = (int)(1 + length_ / steplen);
@@ -10336,15 +10625,68 @@ void NurbsShape::CalculatePolyLine()
 	TrajVertex pos = { 0, 0, 0, 0, 0, 0, 0, 0, false };
 	TrajVertex oldpos = { 0, 0, 0, 0, 0, 0, 0, 0, false };
 	TrajVertex tmppos = { 0, 0, 0, 0, 0, 0, 0, 0, false };
+	std::vector<TrajVertex> sample;
+	sample.reserve(static_cast<size_t>(nSteps + 1));
 
-	pline_.Reset();
 	for (int i = 0; i < nSteps + 1; i++)
 	{
 		double t = i * p_steplen;
 		EvaluateInternal(t, pos);
+		pos.p = t;
+
+		// Find max contributing controlpoint for time interpolation, only the ones of current knot span are non-zero.
+		// Contributions are taken just next to the sample, at the point used for heading calculation.
+		EvaluateInternal(i < nSteps ? MIN(t + MIN(0.001, p_steplen), t_max) : MAX(t - MIN(0.001, p_steplen), 0.0), tmppos);
+		int j0 = basis_span_ < 0 ? 0 : basis_span_ - order_ + 1;
+		int j1 = basis_span_ < 0 ? (int)(ctrlPoint_.size()) - 1 : basis_span_;
+		for (int j = j0; j <= j1; j++)
+		{
+			if (d_[j] > dPeakValue_[j])
+			{
+					dPeakValue_[j] = d_[j];
+					dPeakT_[j] = t;
+			}
+		}
+
+		if (i > 0)
+		{
+			// Add samples where curvature is high
+			SampleInterval(sample.back(), pos, 0, sample);
+		}
+		sample.push_back(pos);
+	}
+
+	// Then skip samples where curvature is low, as long as the polyline segment, interpolated by the curve
+	// parameter, deviates less than NURBS_TOLERANCE from the skipped samples
+	std::vector<size_t> keep;
+	keep.push_back(0);
+	for (size_t i = 1; i < sample.size() - 1; i++)
+	{
+		TrajVertex& v0 = sample[keep.back()];
+		TrajVertex& v1 = sample[i + 1];
+		bool skip = v1.p - v0.p < NURBS_MAX_STEPS_PER_SEGMENT * p_steplen + SMALL_NUMBER;
+		for (size_t j = keep.back() + 1; skip && j <= i; j++)
+		{
+			double w = (sample[j].p - v0.p) / (v1.p - v0.p);
+			skip = PointSquareDistance2D(v0.x + w * (v1.x - v0.x), v0.y + w * (v1.y - v0.y), sample[j].x, sample[j].y) <
+				NURBS_TOLERANCE * NURBS_TOLERANCE;
+		}
+
+		if (!skip)
+		{
+			keep.push_back(i);
+		}
+	}
+	keep.push_back(sample.size() - 1);
+
+	pline_.Reset();
+	for (size_t k = 0; k < keep.size(); k++)
+	{
+		double t = sample[keep[k]].p;
+		pos = sample[keep[k]];
 
 		// Calulate heading from line segment between this and previous vertices
-		if (i < nSteps)
+		if (k < keep.size() - 1)
 		{
 			EvaluateInternal(MIN(t + MIN(0.001, p_steplen), t_max), tmppos);
 		}
@@ -10360,7 +10702,7 @@ void NurbsShape::CalculatePolyLine()
 		}
 		else
 		{
-			if (i < nSteps)
+			if (k < keep.size() - 1)
 			{
 				pos.h = GetAngleInInterval2PI(atan2(tmppos.y - pos.y, tmppos.x - pos.x));
 			}
@@ -10370,38 +10712,29 @@ void NurbsShape::CalculatePolyLine()
 			}
 		}
 
-		if (i > 0)
+		if (k > 0)
 		{
 			newLength += PointDistance2D(pos.x, pos.y, oldpos.x, oldpos.y);
 		}
 		pos.s = newLength;
 
-		// Find max contributing controlpoint for time interpolation
-		for (int j = 0; j < ctrlPoint_.size(); j++)
-		{
-			if (d_[j] > dPeakValue_[j])
-			{
-					dPeakValue_[j] = d_[j];
-					dPeakT_[j] = t;
-			}
-		}
-
 		pline_.AddVertex(pos);
-		pline_.vertex_[i].p = i * p_steplen;
+		pline_.vertex_[k].p = t;
 		oldpos = pos;
 		// Resolve Z value - from road elevation
 		tmpRoadPos.SetInertiaPos(pos.x, pos.y, pos.h);
 		pos.z = tmpRoadPos.GetZ();
-		pline_.vertex_[i].z = pos.z;
+		pline_.vertex_[k].z = pos.z;
 	}
 
 	// Calculate time interpolations
 	int currentCtrlPoint = 0;
 	for (int i = 0; i < pline_.vertex_.size(); i++)
 	{
-		if (pline_.vertex_[i].p >= dPeakT_[currentCtrlPoint + 1])
+		// Vertices might be sparse, passing more than one peak
+		while (currentCtrlPoint < (int)(ctrlPoint_.size()) - 2 && pline_.vertex_[i].p >= dPeakT_[currentCtrlPoint + 1])
 		{
-			currentCtrlPoint = MIN(currentCtrlPoint + 1, (int)(ctrlPoint_.size()) - 2);
+			currentCtrlPoint++;
 		}
 		double w = (pline_.vertex_[i].p - dPeakT_[currentCtrlPoint]) / (dPeakT_[currentCtrlPoint + 1] - dPeakT_[currentCtrlPoint]);
 		pline_.vertex_[i].time = ctrlPoint_[currentCtrlPoint].time_ + w * (ctrlPoint_[currentCtrlPoint + 1].time_ - ctrlPoint_[currentCtrlPoint].time_);
@@ -10410,25 +10743,69 @@ void NurbsShape::CalculatePolyLine()
 	length_ = newLength;
 }
 
+void NurbsShape::SampleInterval(TrajVertex v0, TrajVertex v1, int depth, std::vector<TrajVertex>& samples)
+{
+	if (depth >= NURBS_MAX_REFINE)
+	{
+		return;
+	}
+
+	TrajVertex v = v0;
+	EvaluateInternal(0.5 * (v0.p + v1.p), v);
+	v.p = 0.5 * (v0.p + v1.p);
+
+	if (PointSquareDistance2D(0.5 * (v0.x + v1.x), 0.5 * (v0.y + v1.y), v.x, v.y) < NURBS_TOLERANCE * NURBS_TOLERANCE)
+	{
+		return;
+	}
+
+	SampleInterval(v0, v, depth + 1, samples);
+	samples.push_back(v);
+	SampleInterval(v, v1, depth + 1, samples);
+}
+
 int NurbsShape::EvaluateInternal(double t, TrajVertex& pos)
 {
 	pos.x = pos.y = 0.0;
 
-	// Find knot span
 	t = CLAMP(t, knot_[0], knot_.back() - SMALL_NUMBER);
 
 	double rationalWeight = 0.0;
+	size_t first = 0;
+	size_t last = ctrlPoint_.size();
 
-	for (size_t i = 0; i < ctrlPoint_.size(); i++)
+	int span = FindSpan(t);
+	if (span >= 0)
+	{
+		if (span_inv_.size() != (ctrlPoint_.size() - order_ + 1) * order_ * (order_ - 1) / 2 || left_.size() != static_cast<size_t>(order_))
+		{
+			UpdateSpanCache();
+		}
+
+		// Only control points span - p .. span affect this part of the curve
+		EvaluateBasis(span, t);
+		first = static_cast<size_t>(span - order_ + 1);
+		last = static_cast<size_t>(span + 1);
+	}
+	else
+	{
+		// Outside the clamped range of the knot vector, fall back to the general recursive definition
+		for (size_t i = 0; i < ctrlPoint_.size(); i++)
+		{
+			d_[i] = CoxDeBoor(t, (int)i, order_, knot_);
+		}
+		basis_span_ = -1;
+	}
+
+	for (size_t i = first; i < last; i++)
 	{
 		// calculate the effect of this point on the curve
-		d_[i] = CoxDeBoor(t, (int)i, order_, knot_);
 		rationalWeight += d_[i] * ctrlPoint_[i].weight_;
 	}
 
-	for (size_t i = 0; i < ctrlPoint_.size(); i++)
+	for (size_t i = first; i < last; i++)
 	{
-		if (d_[i] > SMALL_NUMBER)
+		if (d_[i] > 0.0)
 		{
 			// sum effect of CV on this part of the curve
 			pos.x += d_[i] * ctrlPoint_[i].pos_.GetX() * ctrlPoint_[i].weight_ / rationalWeight;
@@ -10446,6 +10823,8 @@ void NurbsShape::AddControlPoint(Position pos, double time, double weight, bool
 		LOG_ONCE("Info: Explicit orientation in Nurbs trajectory control points not supported yet");
 	}
 	ctrlPoint_.push_back(ControlPoint(pos, time, weight, true));
+	span_inv_.clear();
+	basis_span_ = -1;
 	d_.push_back(0);
 	dPeakT_.push_back(0);
 	dPeakValue_.push_back(0);
@@ -10454,6 +10833,7 @@ void NurbsShape::AddControlPoint(Position pos, double time, double weight, bool
 void NurbsShape::AddKnots(std::vector<double> knots)
 {
 	knot_ = knots;
+	span_inv_.clear();
 
 	if (knot_.back() < SMALL_NUMBER)
 	{
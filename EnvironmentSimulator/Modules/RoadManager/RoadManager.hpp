@@ -22,6 +22,8 @@
 #include "CommonMini.hpp"
 
 #define PARAMPOLY3_STEPS 100
+#define POLYLINE_SEARCH_WINDOW 4  // vertices to step from previous index before searching whole polyline
+#define POLYLINE_BOX_SIZE 16  // line segments per bounding box, and boxes per group of boxes
 
 namespace roadmanager
 {
@@ -1655,6 +1657,8 @@ namespace roadmanager
 		int towgs84_;
 	} GeoReference;
 
+	class RoadGraph;
+
 	class OpenDrive
 	{
 	public:
@@ -1760,6 +1764,12 @@ namespace roadmanager
 		int GetVersionMajor() { return versionMajor_; }
 		int GetVersionMinor() { return versionMinor_; }
 
+		/**
+			Get the graph of road connections used for route planning, see LaneIndependentRouter.hpp
+			Created on first call and kept until the road network is cleared or reloaded.
+		*/
+		RoadGraph* GetRoadGraph();
+
 		void Print();
 
 	private:
@@ -1773,6 +1783,7 @@ namespace roadmanager
 		SpeedUnit speed_unit_; // First specified speed unit. MS is default. Undefined if no speed entries.
 		int versionMajor_;
 		int versionMinor_;
+		RoadGraph* road_graph_ = nullptr;
 	};
 
 	typedef struct
@@ -2731,7 +2742,7 @@ namespace roadmanager
 	class PolyLineBase
 	{
 	public:
-		PolyLineBase() : length_(0), current_index_(0), current_s_(0.0), interpolateHeading_(false) {}
+		PolyLineBase() : length_(0), current_index_(0), current_s_(0.0), interpolateHeading_(false), revision_(0), n_boxed_segments_(0) {}
 		TrajVertex *AddVertex(TrajVertex p);
 		TrajVertex *AddVertex(double x, double y, double z, double h);
 		TrajVertex *AddVertex(double x, double y, double z);
@@ -2757,6 +2768,18 @@ namespace roadmanager
 		 */
 		TrajVertex *UpdateVertex(int i, double x, double y, double z);
 
+		/**
+		 * Remove vertices from the start, e.g. to bound a growing trail. Remaining vertices keep s and time.
+		 * NOTE: Indices of remaining vertices are reduced by n
+		 * @param n Number of vertices to remove
+		 */
+		void RemoveFirstVertices(int n);
+
+		/**
+		 * Remove the last vertex. Length of polyline is reduced accordingly.
+		 */
+		void RemoveLastVertex();
+
 		void reset() { length_ = 0.0; }
 		int Evaluate(double s, TrajVertex &pos, double cornerRadius, int startAtIndex);
 		int Evaluate(double s, TrajVertex &pos, double cornerRadius);
@@ -2786,6 +2809,12 @@ namespace roadmanager
 		int GetNumberOfVertices() { return (int)vertex_.size(); }
 		TrajVertex *GetVertex(int index);
 		void Reset();
+		/**
+		 * Find s at a point in time. Vertex time is assumed to be increasing.
+		 * @param time Time, same base as vertex time
+		 * @param s Returns s, s of last vertex if time is beyond the polyline
+		 * @return 0
+		 */
 		int Time2S(double time, double &s);
 
 		std::vector<TrajVertex> vertex_;
@@ -2793,9 +2822,53 @@ namespace roadmanager
 		double current_s_;
 		double length_;
 		bool interpolateHeading_;
+		int revision_;  // incremented whenever vertices are removed, telling copies (e.g. visualization) to resync
 
 	protected:
+		typedef struct
+		{
+			double x_min;
+			double y_min;
+			double x_max;
+			double y_max;
+		} BoundingBox;
+
 		int EvaluateSegmentByLocalS(int i, double local_s, double cornerRadius, TrajVertex &pos);
+
+		/**
+		 * Find the segment including s, i.e. last vertex with s less than or equal to given s
+		 * @param s Distance along the polyline
+		 * @param startAtIndex Look in the neighborhood of this vertex first
+		 * @return Vertex index, 0 if s is before first vertex
+		 */
+		int FindIndexByS(double s, int startAtIndex);
+
+		/**
+		 * Distance from a point to a line segment
+		 * @param i Index of first vertex of the line segment
+		 * @param x X coordinate of point
+		 * @param y Y coordinate of point
+		 * @param s_local Returns distance along the segment to closest point
+		 * @return Distance
+		 */
+		double SegmentDistance(int i, double x, double y, double &s_local);
+
+		/**
+		 * Find the line segment closest to a point, checking only those in bounding boxes close enough
+		 * @param x X coordinate of point
+		 * @param y Y coordinate of point
+		 * @param s_local Returns distance along the segment to closest point
+		 * @param dist Returns distance
+		 * @return Index of first vertex of the line segment, -1 if not found
+		 */
+		int FindClosestSegment(double x, double y, double &s_local, double &dist);
+
+		// Extend or refresh bounding boxes to cover all segments
+		void UpdateBoundingBoxes();
+
+		// Level 0: Boxes of POLYLINE_BOX_SIZE segments. Level 1: Boxes of POLYLINE_BOX_SIZE level 0 boxes
+		std::vector<BoundingBox> boxes_[2];
+		int n_boxed_segments_;  // number of segments covered by bounding boxes
 	};
 
 	// Trajectory stuff
@@ -2895,7 +2968,7 @@ namespace roadmanager
 		};
 
 	public:
-		NurbsShape(int order) : order_(order), Shape(ShapeType::NURBS), length_(0)
+		NurbsShape(int order) : order_(order), Shape(ShapeType::NURBS), length_(0), basis_span_(-1)
 		{
 			pline_.interpolateHeading_ = true;
 		}
@@ -2919,7 +2992,38 @@ namespace roadmanager
 
 	private:
 		double CoxDeBoor(double x, int i, int p, const std::vector<double> &t);
+
+		/**
+		Find knot span i, where knot_[i] <= t < knot_[i + 1], within the valid range order_ - 1 .. n_ctrl_points - 1
+		@param t Curve parameter
+		@return Knot span index, -1 if t is outside the valid range
+		*/
+		int FindSpan(double t);
+
+		/**
+		Calculate the non-zero basis functions of a knot span, storing them in d_
+		@param span Knot span, as from FindSpan
+		@param t Curve parameter
+		*/
+		void EvaluateBasis(int span, double t);
+
+		void UpdateSpanCache();
+
+		/**
+		Add samples between v0 and v1, excluding them, by halving the interval until the curve deviates less than
+		tolerance from the line segments
+		@param v0 Sample at start of interval, including curve parameter p
+		@param v1 Sample at end of interval
+		@param depth Number of times the interval has been halved
+		@param samples Resulting samples are appended here
+		*/
+		void SampleInterval(TrajVertex v0, TrajVertex v1, int depth, std::vector<TrajVertex> &samples);
+
 		double length_;
+		std::vector<double> span_inv_;  // per knot span, inverse of knot differences used by the basis function recursion
+		std::vector<double> left_;      // temporary storage for basis function evaluation
+		std::vector<double> right_;
+		int basis_span_;                // knot span of the non-zero values in d_, -1 if any value might be non-zero
 	};
 
 	class RMTrajectory
@@ -541,58 +541,66 @@ void TrigBySimulationTime::Log()
 		sim_time_, Rule2Str(rule_).c_str(), value_, Edge2Str().c_str());
 }
 
-bool TrigByParameter::CheckCondition(StoryBoard* storyBoard, double sim_time)
+// Compare parameter value to reference value, parsed into ref on first use or if parameter type changes
+static bool EvaluateParameterRule(OSCParameterDeclarations::ParameterStruct* pe, OSCParameterDeclarations::ParameterStruct& ref,
+	const std::string& value, Rule rule)
 {
-	bool result = false;
-	current_value_str_ = "";
-
-	OSCParameterDeclarations::ParameterStruct* pe = parameters_->getParameterEntry(name_);
-	if (pe == 0)
+	if (ref.type != pe->type)
 	{
-		if (state_ < ConditionState::EVALUATED)  // print only once
-		{
-			LOG("Parameter %s not found", name_.c_str());
-		}
-		return result;
+		ref.type = pe->type;
+		ref.value._int = strtoi(value);
+		ref.value._double = strtod(value);
+		ref.value._bool = value == "true" ? true : false;
 	}
 
-	current_value_str_ = std::to_string(pe->value._int).c_str();
 	if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_INTEGER)
 	{
-		result = EvaluateRule(pe->value._int, strtoi(value_), rule_);
-
+		return EvaluateRule(pe->value._int, ref.value._int, rule);
 	}
 	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_DOUBLE)
 	{
-		result = EvaluateRule(pe->value._double, strtod(value_), rule_);
+		return EvaluateRule(pe->value._double, ref.value._double, rule);
 	}
 	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_STRING)
 	{
-		result = EvaluateRule(pe->value._string, value_, rule_);
+		return EvaluateRule(pe->value._string, value, rule);
 	}
 	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_BOOL)
 	{
-		result = EvaluateRule(pe->value._bool, value_ == "true" ? true : false, rule_);
+		return EvaluateRule(pe->value._bool, ref.value._bool, rule);
 	}
 	else
 	{
 		LOG("Unexpected parameter type: %d", pe->type);
 	}
 
-	return result;
+	return false;
+}
+
+bool TrigByParameter::CheckCondition(StoryBoard* storyBoard, double sim_time)
+{
+	OSCParameterDeclarations::ParameterStruct* pe = parameters_->getParameterEntry(name_);
+	if (pe == 0)
+	{
+		if (state_ < ConditionState::EVALUATED)  // print only once
+		{
+			LOG("Parameter %s not found", name_.c_str());
+		}
+		return false;
+	}
+
+	return EvaluateParameterRule(pe, ref_, value_, rule_);
 }
 
 void TrigByParameter::Log()
 {
-	LOG("parameter %s %s %s %s edge: %s", name_.c_str(), current_value_str_.c_str(),
+	OSCParameterDeclarations::ParameterStruct* pe = parameters_->getParameterEntry(name_);
+	LOG("parameter %s %s %s %s edge: %s", name_.c_str(), pe ? std::to_string(pe->value._int).c_str() : "",
 			Rule2Str(rule_).c_str(), value_.c_str(), Edge2Str().c_str());
 }
 
 bool TrigByVariable::CheckCondition(StoryBoard* storyBoard, double sim_time)
 {
-	bool result = false;
-	current_value_str_ = "";
-
 	OSCParameterDeclarations::ParameterStruct* pe = variables_->getParameterEntry(name_);
 	if (pe == 0)
 	{
@@ -600,38 +608,16 @@ bool TrigByVariable::CheckCondition(StoryBoard* storyBoard, double sim_time)
 		{
 			LOG("Variable %s not found", name_.c_str());
 		}
-		return result;
-	}
-
-	current_value_str_ = std::to_string(pe->value._int).c_str();
-	if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_INTEGER)
-	{
-		result = EvaluateRule(pe->value._int, strtoi(value_), rule_);
-
-	}
-	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_DOUBLE)
-	{
-		result = EvaluateRule(pe->value._double, strtod(value_), rule_);
-	}
-	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_STRING)
-	{
-		result = EvaluateRule(pe->value._string, value_, rule_);
-	}
-	else if (pe->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_BOOL)
-	{
-		result = EvaluateRule(pe->value._bool, value_ == "true" ? true : false, rule_);
-	}
-	else
-	{
-		LOG("Unexpected variable type: %d", pe->type);
+		return false;
 	}
 
-	return result;
+	return EvaluateParameterRule(pe, ref_, value_, rule_);
 }
 
 void TrigByVariable::Log()
 {
-	LOG("variable %s %s %s %s edge: %s", name_.c_str(), current_value_str_.c_str(),
+	OSCParameterDeclarations::ParameterStruct* pe = variables_->getParameterEntry(name_);
+	LOG("variable %s %s %s %s edge: %s", name_.c_str(), pe ? std::to_string(pe->value._int).c_str() : "",
 			Rule2Str(rule_).c_str(), value_.c_str(), Edge2Str().c_str());
 }
 
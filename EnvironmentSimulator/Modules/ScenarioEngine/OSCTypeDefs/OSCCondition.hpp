@@ -429,7 +429,7 @@ namespace scenarioengine
 		std::string value_;
 		Rule rule_;
 		Parameters* parameters_;
-		std::string current_value_str_;
+		OSCParameterDeclarations::ParameterStruct ref_;  // value_ parsed into type of the parameter
 
 
 		bool CheckCondition(StoryBoard* storyBoard, double sim_time);
@@ -445,7 +445,7 @@ namespace scenarioengine
 		std::string value_;
 		Rule rule_;
 		Parameters* variables_;
-		std::string current_value_str_;
+		OSCParameterDeclarations::ParameterStruct ref_;  // value_ parsed into type of the parameter
 
 
 		bool CheckCondition(StoryBoard* storyBoard, double sim_time);
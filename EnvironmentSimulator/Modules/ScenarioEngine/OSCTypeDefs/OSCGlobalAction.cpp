@@ -37,8 +37,6 @@ using std::vector;
 #define VEHICLE_DISTANCE 12 // Min distance between two spawned vehicles
 #define SWARM_TIME_INTERVAL 0.1  // Sleep time between update steps
 #define SWARM_SPAWN_FREQUENCY 1.1  // Sleep time between spawns
-#define MAX_CARS 1000
-#define MAX_LANES 32
 
 int SwarmTrafficAction::counter_ = 0;
 
@@ -226,13 +224,7 @@ void SwarmTrafficAction::Start(double simTime, double dt)
     minSize_    = ceil(sqrt(pow(x1 - x0, 2) + pow(y1 - y0, 2)) * 100) / 100.0;
     if (minSize_ == 0) minSize_ = 1.0;
 
-    aabbTree::ptTree tree = std::make_shared<aabbTree::Tree>();
-    aabbTree::BBoxVec vec;
-    vec.clear();
-    createRoadSegments(vec);
-
-    tree->build(vec);
-    rTree = tree;
+    spawnIndex_.Build(odrManager_, minSize_);
 
 
     // Register model filesnames from first vehicle catalog
@@ -281,118 +273,22 @@ void SwarmTrafficAction::Step(double simTime, double dt)
     // Executes the step at each TIME_INTERVAL
     if (lastTime < 0 || abs(simTime - lastTime) > SWARM_TIME_INTERVAL)
     {
-        double SMjA = midSMjA;
-        double SMnA = midSMnA;
-
-        BBoxVec vec;
-        aabbTree::Candidates candidates;
-        std::vector<ptTriangle> triangle;
-        Solutions sols;
-        vec.clear(); candidates.clear(); triangle.clear(); sols.clear();
-
-        EllipseInfo info = {
-            SMjA,
-            SMnA,
-            centralObject_->pos_
-        };
-
-        createEllipseSegments(vec, SMjA, SMnA);
-        aabbTree::Tree eTree;
-        eTree.build(vec);
-        rTree->intersect(eTree, candidates);
-        aabbTree::processCandidates(candidates, triangle);
-        aabbTree::findPoints(triangle, info, sols);
-
-        spawn(sols, despawn(simTime), simTime);
-        lastTime = simTime;
-    }
-}
-
-void SwarmTrafficAction::createRoadSegments(BBoxVec &vec)
-{
-    for (int i = 0; i < odrManager_->GetNumOfRoads(); i++)
-    {
-        roadmanager::Road* road = odrManager_->GetRoadByIdx(i);
-
-        for (int j = 0; j < road->GetNumberOfGeometries(); j++)
-        {
-            roadmanager::Geometry *gm = road->GetGeometry(j);
-
-            switch (gm->GetType())
-            {
-                case roadmanager::Geometry::GeometryType::GEOMETRY_TYPE_UNKNOWN:
-                {
-                    break;
-                }
-                case roadmanager::Geometry::GeometryType::GEOMETRY_TYPE_LINE:
-                {
-                    auto const length = gm->GetLength();
-                    for (double dist = gm->GetS(); dist < length;)
-                    {
-                        double ds = dist + minSize_;
-                        if (ds > length)
-                            ds = length;
-                        double x0, y0, x1, y1, x2, y2, dummy, l;
-                        gm->EvaluateDS(dist, &x0, &y0, &dummy);
-                        gm->EvaluateDS(ds, &x1, &y1, &dummy);
-                        l = sqrt(pow(x1 - x0, 2) + pow(y1 - y0, 2));
-                        x2 = (x1 + x0)/2 + l / 4.0;
-                        y2 = (y1 + y0)/2 + l / 4.0;
-                        Point a(x0, y0), b(x1, y1), c(x2, y2);
-                        ptTriangle triangle = make_shared<Triangle>(gm);
-                        triangle->a = a;
-                        triangle->b = b;
-                        triangle->c = c;
-                        triangle->sI = dist;
-                        triangle->sF = ds;
-                        ptBBox bbox = make_shared<BBox>(triangle);
-                        vec.push_back(bbox);
-                        dist = ds;
-                    }
-                    break;
-                }
-                default:
-                {
-                    curve2triangles(gm, minSize_, M_PI/36, vec);
-                    break;
-                }
-            }
-        }
-    }
-}
+        roadmanager::Position& pos = centralObject_->pos_;
+        spawnIndex_.Query(pos.GetX(), pos.GetY(), pos.GetH(), midSMjA, midSMnA, spawnPoints_);
 
-void SwarmTrafficAction::createEllipseSegments(aabbTree::BBoxVec &vec, double SMjA, double SMnA)
-{
-    double alpha = -M_PI / 72.0;
-    double dAlpha = M_PI / 36.0;
-    auto pos = centralObject_->pos_;
-    double x0, y0, x1, y1, x2, y2;
-
-    while (alpha < (2 * M_PI - M_PI / 72.0))
-    {
-        double da = alpha + dAlpha;
-        if (da > 2 * M_PI - M_PI / 72.0)
+        updateOccupancy();
+        int nDespawned = despawn(simTime);
+        if (nDespawned > 0)
         {
-            da = 2 * M_PI - M_PI / 72.0;
+            updateOccupancy();  // index refers to vehicles by position in spawned list
         }
 
-        paramEllipse(alpha , pos.GetX(), pos.GetY(), SMjA, SMnA, pos.GetH(), x0, y0);
-        paramEllipse(da, pos.GetX(), pos.GetY(), SMjA, SMnA, pos.GetH(), x1, y1);
-
-        double theta0, theta1;
-        theta0 = angleTangentEllipse(SMjA, SMnA, alpha, pos.GetH());
-        theta1 = angleTangentEllipse(SMjA, SMnA, da, pos.GetH());
-
-        tangentIntersection(x0, y0, alpha, theta0, x1, y1, da, theta1, x2, y2);
-
-        ptBBox bbx = makeTriangleAndBbx(x0, y0, x1, y1, x2, y2);
-        vec.push_back(bbx);
-
-        alpha = da;
+        spawn(spawnPoints_, nDespawned, simTime);
+        lastTime = simTime;
     }
 }
 
-inline void SwarmTrafficAction::sampleRoads(int minN, int maxN, Solutions &sols, vector<SelectInfo> &info)
+inline void SwarmTrafficAction::sampleRoads(int minN, int maxN, std::vector<SpawnIndex::SpawnPoint> &points, vector<SelectInfo> &info)
 {
     //printf("Entered road selection\n");
     //printf("Min: %d, Max: %d\n", minN, maxN);
@@ -415,26 +311,20 @@ inline void SwarmTrafficAction::sampleRoads(int minN, int maxN, Solutions &sols,
     info.clear();
     // We have more points than number of vehicles to spawn.
     // We sample the selected number and each point will be assigned a lane
-    if (nCarsToSpawn <= sols.size() && nCarsToSpawn > 0)
+    if (nCarsToSpawn <= points.size() && nCarsToSpawn > 0)
     {
         // Shuffle and randomly select the points
-        // Solutions selected(nCarsToSpawn);
-        static Point selected[MAX_CARS];  // Remove macro when/if found a solution for dynamic array
-        std::random_shuffle(sols.begin(), sols.end());
-        sample(sols.begin(), sols.end(), selected, nCarsToSpawn, SE_Env::Inst().GetGenerator());
+        selected_.resize(nCarsToSpawn);
+        std::random_shuffle(points.begin(), points.end());
+        sample(points.begin(), points.end(), selected_.begin(), nCarsToSpawn, SE_Env::Inst().GetGenerator());
 
         for (int i = 0; i < nCarsToSpawn; i++)
         {
-            Point &pt = selected[i];
-            // Find road
-            roadmanager::Position pos(pt.x, pt.y, 0.0, pt.h, 0.0, 0.0);
-            if (pos.IsInJunction())
-            {
-                continue;  // avoid put vehicles in the middle of junctions
-            }
-            // pos.XYZH2TrackPos(pt.x, pt.y, 0, pt.h);
-            // Peek road
-            roadmanager::Road* road = odrManager_->GetRoadById(pos.GetTrackId());
+            SpawnIndex::SpawnPoint &pt = selected_[i];
+            // Road is known from the spawn slot, junctions are already excluded
+            roadmanager::Position pos;
+            pos.SetTrackPos(pt.road->GetId(), pt.s, 0.0);
+            roadmanager::Road* road = pt.road;
             if (road->GetNumberOfDrivingLanes(pos.GetS()) == 0) continue;
             // Since the number of points is equal to the number of vehicles to spaw,
             // only one lane is selected
@@ -452,13 +342,13 @@ inline void SwarmTrafficAction::sampleRoads(int minN, int maxN, Solutions &sols,
         // We use all the spawnable points and we ensure that each obtains
         // a lane at least. The remaining ones will be randomly distributed.
         // The algorithms does not ensure to saturate the selected number of vehicles.
-        int lanesLeft = nCarsToSpawn - static_cast<int>(sols.size());
-        for (Point pt : sols)
+        int lanesLeft = nCarsToSpawn - static_cast<int>(points.size());
+        for (SpawnIndex::SpawnPoint &pt : points)
         {
-            roadmanager::Position pos(pt.x, pt.y, 0.0, pt.h, 0.0, 0.0);
-            //pos.XYZH2TrackPos(pt.x, pt.y, 0, pt.h);
+            roadmanager::Position pos;
+            pos.SetTrackPos(pt.road->GetId(), pt.s, 0.0);
 
-            roadmanager::Road* road = odrManager_->GetRoadById(pos.GetTrackId());
+            roadmanager::Road* road = pt.road;
             int nDrivingLanes = road->GetNumberOfDrivingLanes(pos.GetS());
             if (nDrivingLanes == 0)
             {
@@ -485,29 +375,29 @@ inline void SwarmTrafficAction::sampleRoads(int minN, int maxN, Solutions &sols,
     }
 }
 
-void SwarmTrafficAction::spawn(Solutions sols, int replace, double simTime)
+void SwarmTrafficAction::spawn(std::vector<SpawnIndex::SpawnPoint> &points, int replace, double simTime)
 {
-    int maxCars = MIN(MAX_CARS, numberOfVehicles - (int)spawnedV.size());  // Remove MIN check when/if found a solution for dynamic array
+    int maxCars = static_cast<int>(numberOfVehicles) - static_cast<int>(spawnedV.size());
     if (maxCars <= 0)
     {
         return;
     }
 
-    vector<SelectInfo> info;
-    sampleRoads(replace, maxCars, sols, info);
-
-    for (SelectInfo inf : info) {
-        int lanesNo = MIN(MAX_LANES, inf.road->GetNumberOfDrivingLanes(inf.pos.GetS()));
-        static int elements[MAX_LANES];
-        std::iota(elements, elements + lanesNo, 0);
+    selectInfo_.clear();
+    sampleRoads(replace, maxCars, points, selectInfo_);
 
-        static int lanes[MAX_LANES];
+    for (SelectInfo& inf : selectInfo_) {
+        int lanesNo = inf.road->GetNumberOfDrivingLanes(inf.pos.GetS());
+        laneIdx_.resize(lanesNo);
+        std::iota(laneIdx_.begin(), laneIdx_.end(), 0);
 
-        sample(elements, elements + lanesNo, lanes, MIN(MAX_LANES, inf.nLanes), SE_Env::Inst().GetGenerator());
+        int nLanes = MIN(lanesNo, inf.nLanes);
+        laneSel_.resize(nLanes);
+        sample(laneIdx_.begin(), laneIdx_.end(), laneSel_.begin(), nLanes, SE_Env::Inst().GetGenerator());
 
-        for (int i = 0; i < MIN(MAX_LANES, inf.nLanes); i++)
+        for (int i = 0; i < nLanes; i++)
         {
-            auto Lane = inf.road->GetDrivingLaneByIdx(inf.pos.GetS(), lanes[i]);
+            auto Lane = inf.road->GetDrivingLaneByIdx(inf.pos.GetS(), laneSel_[i]);
             int laneID;
 
             if (!Lane)
@@ -522,40 +412,78 @@ void SwarmTrafficAction::spawn(Solutions sols, int replace, double simTime)
 
             if (!ensureDistance(inf.pos, laneID, MIN(MAX(40.0, velocity_ * 2.0), 0.7 * semiMajorAxis_))) continue;  // distance = speed * 2 seconds
 
-            Controller::InitArgs args;
-            args.name = "Swarm ACC controller";
-            args.type = ControllerACC::GetTypeNameStatic();
-            args.entities = entities_;
-            args.gateway = gateway_;
-            args.parameters = 0;
-            args.properties = 0;
+            // Pick random model from vehicle catalog
+            std::uniform_int_distribution<int> dist(0, (int)(vehicle_pool_.size() - 1));
+            int number = dist(SE_Env::Inst().GetGenerator());
+
+            Vehicle* vehicle = nullptr;
+            int nTrailers = 0;
+            for (Object* t = vehicle_pool_[number]->TrailerVehicle(); t; t = t->TrailerVehicle())
+            {
+                nTrailers++;
+            }
+            bool reuse = nTrailers < static_cast<int>(free_vehicles_.size()) && !free_vehicles_[nTrailers].empty();
+            int id = -1;
+
+            if (reuse)
+            {
+                // Reuse a despawned vehicle with same trailer setup
+                vehicle = free_vehicles_[nTrailers].back();
+                free_vehicles_[nTrailers].pop_back();
+                vehicle->Recycle(*vehicle_pool_[number]);
+            }
+            else
+            {
+                vehicle = new Vehicle(*vehicle_pool_[number]);
+            }
+
+            ControllerACC* acc = static_cast<ControllerACC*>(reader_->ReuseController(ControllerACC::GetTypeStatic()));
+            if (acc == nullptr)
+            {
+                Controller::InitArgs args;
+                args.name = "Swarm ACC controller";
+                args.type = ControllerACC::GetTypeNameStatic();
+                args.entities = entities_;
+                args.gateway = gateway_;
+                args.parameters = 0;
+                args.properties = 0;
 
 #if 0   // This is one way of setting the ACC setSpeed property
-            args.properties = new OSCProperties();
-            OSCProperties::Property property;
-            property.name_ = "setSpeed";
-            property.value_ = std::to_string(velocity_);
-            args.properties->property_.push_back(property);
+                args.properties = new OSCProperties();
+                OSCProperties::Property property;
+                property.name_ = "setSpeed";
+                property.value_ = std::to_string(velocity_);
+                args.properties->property_.push_back(property);
 #endif
-            Controller* acc = InstantiateControllerACC(&args);
+                acc = static_cast<ControllerACC*>(InstantiateControllerACC(&args));
+                reader_->AddController(acc);
+            }
+            vehicle->controller_ = acc;
 
 #if 1   // This is another way of setting the ACC setSpeed property
-            ((ControllerACC*)acc)->SetSetSpeed(velocity_);
+            acc->SetSetSpeed(velocity_);
 #endif
-            reader_->AddController(acc);
 
-            // Pick random model from vehicle catalog
-            std::uniform_int_distribution<int> dist(0, (int)(vehicle_pool_.size() - 1));
-            int number = dist(SE_Env::Inst().GetGenerator());
-
-            Vehicle* vehicle = new Vehicle(*vehicle_pool_[number]);
             vehicle->pos_.SetLanePos(inf.pos.GetTrackId(), laneID, inf.pos.GetS(), 0.0);
             vehicle->pos_.SetHeadingRelativeRoadDirection(laneID < 0 ? 0.0 : M_PI);
-            vehicle->controller_ = acc;
             vehicle->SetSpeed(velocity_);
             //vehicle->scaleMode_ = EntityScaleMode::BB_TO_MODEL;
             vehicle->name_ = "swarm_" + std::to_string(counter_++);
-            int id = entities_->addObject(vehicle, true);
+
+            if (!reuse)
+            {
+                id = entities_->addObject(vehicle, true);
+            }
+            else
+            {
+                // Trailers keep names from previous life, update them as addObject would do
+                for (Vehicle* v = vehicle; v->TrailerVehicle(); v = static_cast<Vehicle*>(v->TrailerVehicle()))
+                {
+                    v->TrailerVehicle()->name_ = v->GetName() + "+";
+                }
+                entities_->activateObject(vehicle);
+                id = vehicle->id_;
+            }
 
             // align trailers
             Vehicle* v = vehicle;
@@ -572,27 +500,51 @@ void SwarmTrafficAction::spawn(Solutions sols, int replace, double simTime)
                 0,                     // Useless detection counter
                 inf.pos.GetTrackId(),  // Road ID
                 laneID,                // Lane
-                simTime                // Simulation time
+                simTime,               // Simulation time
+                nTrailers,             // Number of trailers
+                vehicle                // Vehicle
             };
             spawnedV.push_back(sInfo);
+
+            roadmanager::Position& vPos = vehicle->pos_;
+            occupancy_.Insert(vPos.GetTrackId(), vPos.GetLaneId(), vPos.GetS(), vPos.GetX(), vPos.GetY(),
+                static_cast<int>(spawnedV.size() - 1));
         }
     }
 }
 
 inline bool SwarmTrafficAction::ensureDistance(roadmanager::Position pos, int lane, double dist)
 {
-    for (SpawnInfo info : spawnedV) {
-        Object* vehicle = entities_->GetObjectById(info.vehicleID);
+    const double minRadius = 20.0;
 
-        // First apply minimal radius filter to avoid vehicles appear too close, e.g. next to each other in neighbor lanes
-        if (PointDistance2D(pos.GetX(), pos.GetY(), vehicle->pos_.GetX(), vehicle->pos_.GetY()) < 20)
+    // First apply minimal radius filter to avoid vehicles appear too close, e.g. next to each other in neighbor lanes
+    occupancy_.FindNearby(pos.GetX(), pos.GetY(), MAX(minRadius, dist), nearby_);
+    for (STGeometry::LaneOccupancy::Item& item : nearby_)
+    {
+        if (PointDistance2D(pos.GetX(), pos.GetY(), item.x, item.y) < minRadius)
         {
             return false;
         }
+    }
+
+    // Same road, check lane interval
+    if (occupancy_.IsLaneOccupied(pos.GetTrackId(), lane, pos.GetS(), dist))
+    {
+        return false;
+    }
+
+    // Other roads, e.g. connected ones, need path search. Only vehicles within dist can be closer than dist along
+    // the road, so only nearby ones are checked.
+    pos.SetLaneId(lane);
+    for (STGeometry::LaneOccupancy::Item& item : nearby_)
+    {
+        if (item.roadId == pos.GetTrackId())
+        {
+            continue;
+        }
 
-        pos.SetLaneId(lane);
         roadmanager::PositionDiff posDiff;
-        if (pos.Delta(&vehicle->pos_, posDiff, true, 100.0))  // potentially expensive since trying to resolve path between vehicles...
+        if (pos.Delta(&spawnedV[item.ref].vehicle->pos_, posDiff, true, 100.0))
         {
             // If close and in same lane -> NOK
             if (posDiff.dLaneId == 0 && fabs(posDiff.ds) < dist)
@@ -605,26 +557,51 @@ inline bool SwarmTrafficAction::ensureDistance(roadmanager::Position pos, int la
     return true;
 }
 
+void SwarmTrafficAction::updateOccupancy()
+{
+    // Index current vehicles by lane, for quick distance checks of spawn candidates and despawn conditions
+    occupancy_.Clear();
+    for (size_t i = 0; i < spawnedV.size(); i++)
+    {
+        roadmanager::Position& vPos = spawnedV[i].vehicle->pos_;
+        occupancy_.Add(vPos.GetTrackId(), vPos.GetLaneId(), vPos.GetS(), vPos.GetX(), vPos.GetY(), static_cast<int>(i));
+    }
+    occupancy_.Sort();
+}
+
 int SwarmTrafficAction::despawn(double simTime)
 {
-    auto infoPtr               = spawnedV.begin();
-    bool increase              = true;
-    bool deleteVehicle         = false;
-    int count                  = 0;
+    int count     = 0;
+    size_t nKept  = 0;
+
+    roadmanager::Position& cPos = centralObject_->pos_;
 
-    roadmanager::Position cPos = centralObject_->pos_;
+    // Vehicles within the largest circle inside the middle ellipse are looked up in the occupancy index,
+    // no need to evaluate the ellipses for them
+    inside_.assign(spawnedV.size(), false);
+    occupancy_.FindNearby(cPos.GetX(), cPos.GetY(), MIN(midSMjA, midSMnA), nearby_);
+    for (STGeometry::LaneOccupancy::Item& item : nearby_)
+    {
+        inside_[static_cast<size_t>(item.ref)] = true;
+    }
 
-    while (infoPtr != spawnedV.end())
+    for (size_t i = 0; i < spawnedV.size(); i++)
     {
-        Object *vehicle = entities_->GetObjectById(infoPtr->vehicleID);
+        SpawnInfo& info = spawnedV[i];
+        Object *vehicle = info.vehicle;
+        bool deleteVehicle = false;
 
         if (vehicle->IsOffRoad() || vehicle->IsEndOfRoad())
         {
             deleteVehicle = true;
         }
+        else if (inside_[i])
+        {
+            info.outMidAreaCount = 0;
+        }
         else
         {
-            roadmanager::Position vPos = vehicle->pos_;
+            roadmanager::Position& vPos = vehicle->pos_;
             auto e0 = ellipse(cPos.GetX(), cPos.GetY(), cPos.GetH(), semiMajorAxis_, semiMinorAxis_, vPos.GetX(), vPos.GetY());
             auto e1 = ellipse(cPos.GetX(), cPos.GetY(), cPos.GetH(), midSMjA, midSMnA, vPos.GetX(), vPos.GetY());
 
@@ -634,71 +611,49 @@ int SwarmTrafficAction::despawn(double simTime)
             }
             else if (e1 > 0.001 || (0 <= e1 && e1 <= 0.001)) // outside middle ellipse or on the border
             {
-                infoPtr->outMidAreaCount++;
-                if (infoPtr->outMidAreaCount > USELESS_THRESHOLD)
+                info.outMidAreaCount++;
+                if (info.outMidAreaCount > USELESS_THRESHOLD)
                 {
                     deleteVehicle = true;
                 }
             }
             else
             {
-                infoPtr->outMidAreaCount = 0;
+                info.outMidAreaCount = 0;
             }
         }
 
         if (deleteVehicle)
         {
-            reader_->RemoveController(vehicle->controller_);
+            // Keep vehicle, trailers and controller for reuse instead of deleting them
+            vehicle->controller_->Deactivate();
+            reader_->ReleaseController(vehicle->controller_);
 
-            if (vehicle->type_ == Object::Type::VEHICLE)
+            for (Object* v = vehicle; v; v = v->TrailerVehicle())
             {
-                Vehicle* v = (Vehicle*)vehicle;
-                Vehicle* trailer = nullptr;
-                while (v)  // remove all linked trailers
-                {
-                    trailer = (Vehicle*)v->TrailerVehicle();
-
-                    gateway_->removeObject(v->name_);
-
-                    if (v->objectEvents_.size() > 0 || v->initActions_.size() > 0)
-                    {
-                        entities_->deactivateObject(v);
-                    }
-                    else
-                    {
-                        entities_->removeObject(v, false);
-                    }
-                    v = trailer;
-
-                    vehicle = nullptr;  // indicate vehicle removed
-                }
+                gateway_->removeObject(v->name_);
             }
+            entities_->deactivateObject(vehicle);  // including trailers
 
-            if (vehicle)
+            if (info.nTrailers >= static_cast<int>(free_vehicles_.size()))
             {
-                gateway_->removeObject(vehicle->name_);
-                if (vehicle->objectEvents_.size() > 0 || vehicle->initActions_.size() > 0)
-                {
-                    entities_->deactivateObject(vehicle);
-                }
-                else
-                {
-                    entities_->removeObject(vehicle, false);
-                }
+                free_vehicles_.resize(info.nTrailers + 1);
             }
+            free_vehicles_[info.nTrailers].push_back(static_cast<Vehicle*>(vehicle));
 
-            infoPtr = spawnedV.erase(infoPtr);
-            increase = deleteVehicle = false;
             count++;
         }
-
-        if (increase)
+        else
         {
-            ++infoPtr;
+            // Compact the list in place, keeping order of remaining vehicles
+            if (nKept != i)
+            {
+                spawnedV[nKept] = info;
+            }
+            nKept++;
         }
-
-        increase = true;
     }
+    spawnedV.resize(nKept);
 
     return count;
 }
\ No newline at end of file
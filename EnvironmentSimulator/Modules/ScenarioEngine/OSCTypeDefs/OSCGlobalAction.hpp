@@ -18,7 +18,7 @@
 #include "Parameters.hpp"
 #include "Entities.hpp"
 #include "ScenarioGateway.hpp"
-#include "OSCAABBTree.hpp"
+#include "OSCSwarmTrafficGeometry.hpp"
 #include <vector>
 #include "OSCUtils.hpp"
 #include "OSCPosition.hpp"
@@ -215,6 +215,8 @@ namespace scenarioengine
 			int roadID;
 			int lane;
 			double simTime;
+			int nTrailers;
+			Object* vehicle;
 		};
 
 		typedef struct {
@@ -259,20 +261,27 @@ namespace scenarioengine
 		ScenarioGateway* gateway_;
 		ScenarioReader* reader_;
 		Object* centralObject_;
-		aabbTree::ptTree rTree;
+		STGeometry::SpawnIndex spawnIndex_;
+		std::vector<STGeometry::SpawnIndex::SpawnPoint> spawnPoints_;  // reused between steps
+		std::vector<SelectInfo> selectInfo_;  // reused between steps
+		std::vector<STGeometry::SpawnIndex::SpawnPoint> selected_;  // reused between steps
+		std::vector<int> laneIdx_, laneSel_;  // reused between steps
+		STGeometry::LaneOccupancy occupancy_;  // spawned vehicles, updated each swarm step
+		std::vector<STGeometry::LaneOccupancy::Item> nearby_;  // reused between steps
+		std::vector<bool> inside_;  // per spawned vehicle, whether well within middle ellipse, reused between steps
 		unsigned long numberOfVehicles;
 		std::vector<SpawnInfo> spawnedV;
 		roadmanager::OpenDrive* odrManager_;
 		double innerRadius_, semiMajorAxis_, semiMinorAxis_, midSMjA, midSMnA, minSize_, lastTime;
 		std::vector<Vehicle*> vehicle_pool_;
+		std::vector<std::vector<Vehicle*>> free_vehicles_;  // despawned vehicles per number of trailers, inactive in entities pool
 		static int counter_;
 
+		void updateOccupancy();
 		int despawn(double simTime);
-		void createRoadSegments(aabbTree::BBoxVec &vec);
-		void spawn(Solutions sols, int replace, double simTime);
+		void spawn(std::vector<STGeometry::SpawnIndex::SpawnPoint> &points, int replace, double simTime);
 		inline bool ensureDistance(roadmanager::Position pos, int lane, double dist);
-		void createEllipseSegments(aabbTree::BBoxVec &vec, double SMjA, double SMnA);
-		inline void sampleRoads(int minN, int maxN, Solutions &sols, vector<SelectInfo> &info);
+		inline void sampleRoads(int minN, int maxN, std::vector<STGeometry::SpawnIndex::SpawnPoint> &points, vector<SelectInfo> &info);
 	};
 
 }
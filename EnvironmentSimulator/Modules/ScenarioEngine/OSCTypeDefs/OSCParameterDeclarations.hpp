@@ -46,6 +46,29 @@ namespace scenarioengine
 				bool _bool = false;
 			} value;
 			bool variable = false;
+			bool string_valid = true;  // false when typed value has been set but not yet value._string
+
+			// Value as string, formatted on demand from the typed value
+			const std::string& getString()
+			{
+				if (!string_valid)
+				{
+					if (type == ParameterType::PARAM_TYPE_INTEGER)
+					{
+						value._string = std::to_string(value._int);
+					}
+					else if (type == ParameterType::PARAM_TYPE_DOUBLE)
+					{
+						value._string = std::to_string(value._double);
+					}
+					else if (type == ParameterType::PARAM_TYPE_BOOL)
+					{
+						value._string = value._bool ? "true" : "false";
+					}
+					string_valid = true;
+				}
+				return value._string;
+			}
 		};
 
 		std::vector<ParameterStruct> Parameter;
@@ -11,7 +11,12 @@
  */
 
 #include <cmath>
+#include <algorithm>
 #include "OSCSwarmTrafficGeometry.hpp"
+#include "CommonMini.hpp"
+
+#define SPAWN_INDEX_CELL_SIZE 50.0  // m
+#define SPAWN_INDEX_MAX_CELLS 1000000  // cell size is increased for large road networks
 
 namespace STGeometry {
 
@@ -337,4 +342,222 @@ namespace STGeometry {
         return (sol.size() - pos) > 0;
     }
 
-}
\ No newline at end of file
+    void SpawnIndex::Build(roadmanager::OpenDrive* odr, double spacing)
+    {
+        slots_.clear();
+        cellStart_.clear();
+        cellSlots_.clear();
+        nx_ = ny_ = 0;
+        spacing_ = spacing;
+
+        roadmanager::Position pos;
+        double xmin = LARGE_NUMBER, ymin = LARGE_NUMBER, xmax = -LARGE_NUMBER, ymax = -LARGE_NUMBER;
+
+        for (int i = 0; i < odr->GetNumOfRoads(); i++)
+        {
+            roadmanager::Road* road = odr->GetRoadByIdx(i);
+            if (road->GetJunction() != -1 || road->GetLength() < SMALL_NUMBER)
+            {
+                continue;  // avoid put vehicles in the middle of junctions
+            }
+
+            // Evenly spread slots, first and last at road ends
+            int n = std::max(1, static_cast<int>(ceil(road->GetLength() / spacing)));
+            for (int j = 0; j <= n; j++)
+            {
+                double s = std::min(road->GetLength(), j * road->GetLength() / n);
+                pos.SetTrackPos(road->GetId(), s, 0.0);
+                Slot slot = { pos.GetX(), pos.GetY(), s, road, j == n };
+                slots_.push_back(slot);
+
+                xmin = std::min(xmin, slot.x);
+                ymin = std::min(ymin, slot.y);
+                xmax = std::max(xmax, slot.x);
+                ymax = std::max(ymax, slot.y);
+            }
+        }
+
+        if (slots_.empty())
+        {
+            return;
+        }
+
+        cellSize_ = std::max(SPAWN_INDEX_CELL_SIZE, spacing);
+        while (((xmax - xmin) / cellSize_ + 1) * ((ymax - ymin) / cellSize_ + 1) > SPAWN_INDEX_MAX_CELLS)
+        {
+            cellSize_ *= 2;
+        }
+        x0_ = xmin;
+        y0_ = ymin;
+        nx_ = static_cast<int>((xmax - xmin) / cellSize_) + 1;
+        ny_ = static_cast<int>((ymax - ymin) / cellSize_) + 1;
+
+        // Sort segments into cells by their start slot, counting first to get the cell ranges
+        auto cellOf = [this](const Slot& slot)
+        {
+            int i = std::min(nx_ - 1, static_cast<int>((slot.x - x0_) / cellSize_));
+            int j = std::min(ny_ - 1, static_cast<int>((slot.y - y0_) / cellSize_));
+            return j * nx_ + i;
+        };
+
+        cellStart_.assign(nx_ * ny_ + 1, 0);
+        for (size_t i = 0; i < slots_.size(); i++)
+        {
+            if (!slots_[i].last)
+            {
+                cellStart_[cellOf(slots_[i]) + 1]++;
+            }
+        }
+        for (size_t i = 1; i < cellStart_.size(); i++)
+        {
+            cellStart_[i] += cellStart_[i - 1];
+        }
+
+        std::vector<int> fill(cellStart_.begin(), cellStart_.end() - 1);
+        cellSlots_.resize(cellStart_.back());
+        for (size_t i = 0; i < slots_.size(); i++)
+        {
+            if (!slots_[i].last)
+            {
+                cellSlots_[fill[cellOf(slots_[i])]++] = static_cast<int>(i);
+            }
+        }
+    }
+
+    void SpawnIndex::Query(double h, double k, double A, double SMjA, double SMnA, std::vector<SpawnPoint>& points) const
+    {
+        points.clear();
+
+        if (cellSlots_.empty())
+        {
+            return;
+        }
+
+        // Bounding box of the rotated ellipse, extended by one segment since segments are indexed by start slot
+        double ex = sqrt(pow(SMjA * cos(A), 2) + pow(SMnA * sin(A), 2)) + spacing_;
+        double ey = sqrt(pow(SMjA * sin(A), 2) + pow(SMnA * cos(A), 2)) + spacing_;
+        int i0 = std::max(0, static_cast<int>(floor((h - ex - x0_) / cellSize_)));
+        int i1 = std::min(nx_ - 1, static_cast<int>(floor((h + ex - x0_) / cellSize_)));
+        int j0 = std::max(0, static_cast<int>(floor((k - ey - y0_) / cellSize_)));
+        int j1 = std::min(ny_ - 1, static_cast<int>(floor((k + ey - y0_) / cellSize_)));
+
+        // The normalized radius, sqrt(ellipse() + 1), changes at most 1 / min axis per meter
+        double minAxis = std::min(SMjA, SMnA);
+        double marginIn = spacing_ / minAxis;
+        double marginOut = (cellSize_ * sqrt(2.0) + spacing_) / minAxis;
+
+        for (int j = j0; j <= j1; j++)
+        {
+            for (int i = i0; i <= i1; i++)
+            {
+                int cell = j * nx_ + i;
+                if (cellStart_[cell] == cellStart_[cell + 1])
+                {
+                    continue;
+                }
+
+                // Skip cells with all segments inside or outside the ellipse. Max radius is found at a corner.
+                double rmin = LARGE_NUMBER, rmax = 0.0;
+                for (int c = 0; c < 4; c++)
+                {
+                    double r = sqrt(std::max(0.0, ellipse(h, k, A, SMjA, SMnA,
+                        x0_ + (i + (c & 1)) * cellSize_, y0_ + (j + (c >> 1)) * cellSize_) + 1.0));
+                    rmin = std::min(rmin, r);
+                    rmax = std::max(rmax, r);
+                }
+                if (rmax + marginIn < 1.0 || rmin - marginOut > 1.0)
+                {
+                    continue;
+                }
+
+                for (int n = cellStart_[cell]; n < cellStart_[cell + 1]; n++)
+                {
+                    const Slot& a = slots_[cellSlots_[n]];
+                    const Slot& b = slots_[cellSlots_[n] + 1];
+                    double f0 = ellipse(h, k, A, SMjA, SMnA, a.x, a.y);
+                    double f1 = ellipse(h, k, A, SMjA, SMnA, b.x, b.y);
+
+                    if ((f0 < 0.0) != (f1 < 0.0))
+                    {
+                        double t = f0 / (f0 - f1);
+                        SpawnPoint point = { a.road, a.s + t * (b.s - a.s), a.x + t * (b.x - a.x), a.y + t * (b.y - a.y) };
+                        points.push_back(point);
+                    }
+                }
+            }
+        }
+    }
+
+    static long long LaneKey(int roadId, int laneId)
+    {
+        return (static_cast<long long>(roadId) << 32) | static_cast<unsigned int>(laneId);
+    }
+
+    static bool ItemLessX(const LaneOccupancy::Item& a, const LaneOccupancy::Item& b)
+    {
+        return a.x < b.x;
+    }
+
+    void LaneOccupancy::Clear()
+    {
+        // Keep lane entries and their memory, lanes are typically reused next time
+        for (auto& lane : lanes_)
+        {
+            lane.second.clear();
+        }
+        items_.clear();
+    }
+
+    void LaneOccupancy::Add(int roadId, int laneId, double s, double x, double y, int ref)
+    {
+        lanes_[LaneKey(roadId, laneId)].push_back(s);
+        items_.push_back({ x, y, roadId, ref });
+    }
+
+    void LaneOccupancy::Sort()
+    {
+        for (auto& lane : lanes_)
+        {
+            std::sort(lane.second.begin(), lane.second.end());
+        }
+        std::sort(items_.begin(), items_.end(), ItemLessX);
+    }
+
+    void LaneOccupancy::Insert(int roadId, int laneId, double s, double x, double y, int ref)
+    {
+        std::vector<double>& lane = lanes_[LaneKey(roadId, laneId)];
+        lane.insert(std::upper_bound(lane.begin(), lane.end(), s), s);
+
+        Item item = { x, y, roadId, ref };
+        items_.insert(std::upper_bound(items_.begin(), items_.end(), item, ItemLessX), item);
+    }
+
+    bool LaneOccupancy::IsLaneOccupied(int roadId, int laneId, double s, double dist) const
+    {
+        auto lane = lanes_.find(LaneKey(roadId, laneId));
+        if (lane == lanes_.end())
+        {
+            return false;
+        }
+
+        // First value above lower limit, occupied if it's also below upper limit
+        auto it = std::upper_bound(lane->second.begin(), lane->second.end(), s - dist);
+        return it != lane->second.end() && *it < s + dist;
+    }
+
+    void LaneOccupancy::FindNearby(double x, double y, double radius, std::vector<Item>& items) const
+    {
+        items.clear();
+
+        Item lower = { x - radius, 0.0, 0, 0 };
+        for (auto it = std::lower_bound(items_.begin(), items_.end(), lower, ItemLessX);
+             it != items_.end() && it->x <= x + radius; ++it)
+        {
+            if ((it->x - x) * (it->x - x) + (it->y - y) * (it->y - y) < radius * radius)
+            {
+                items.push_back(*it);
+            }
+        }
+    }
+
+}
@@ -13,6 +13,7 @@
 #pragma once
 #include "OSCAABBTree.hpp"
 #include <functional>
+#include <unordered_map>
 
 namespace STGeometry {
 
@@ -171,4 +172,123 @@ namespace STGeometry {
      */
     bool geometryIntersect(Triangle& triangle, EllipseInfo& eInfo, Solutions& sol);
 
+    /**
+     * @brief Spawn slots sampled along the reference line of all roads outside junctions, indexed
+     * by a uniform grid. Built once, then queried at each swarm update for the points where the
+     * roads cross an ellipse around the central object. Only grid cells overlapping the border of
+     * the ellipse are visited. Slots and cells are stored in flat arrays and the query reuses the
+     * caller's result buffer, so no allocations are made once the buffer has grown.
+     */
+    class SpawnIndex
+    {
+    public:
+        typedef struct
+        {
+            roadmanager::Road* road;
+            double s;
+            double x;
+            double y;
+        } SpawnPoint;
+
+        SpawnIndex() : cellSize_(0), x0_(0), y0_(0), spacing_(0), nx_(0), ny_(0) {}
+
+        /**
+         * @brief Sample all roads and build the grid
+         *
+         * @param odr Road network
+         * @param spacing Max distance between slots along a road
+         */
+        void Build(roadmanager::OpenDrive* odr, double spacing);
+
+        /**
+         * @brief Find the points where roads cross the ellipse, interpolated between slots
+         *
+         * @param h x coordinate of the center
+         * @param k y coordinate of the center
+         * @param A Angle of rotation of the ellipse
+         * @param SMjA Semi major axes
+         * @param SMnA Semi minor axes
+         * @param points Found points, replacing any previous content
+         */
+        void Query(double h, double k, double A, double SMjA, double SMnA, std::vector<SpawnPoint>& points) const;
+
+        size_t GetNumberOfSlots() const { return slots_.size(); }
+
+    private:
+        typedef struct
+        {
+            double x;
+            double y;
+            double s;
+            roadmanager::Road* road;
+            bool last;  // last slot of the road, i.e. not start of a segment
+        } Slot;
+
+        std::vector<Slot> slots_;
+        std::vector<int> cellStart_;  // per cell first entry in cellSlots_, one extra entry marks the end
+        std::vector<int> cellSlots_;  // segment start slots, grouped by cell
+        double cellSize_, x0_, y0_, spacing_;
+        int nx_, ny_;
+    };
+
+    /**
+     * @brief Occupancy of lanes by vehicles, for checking free space at spawn positions
+     *
+     * Per road and lane the s values of the vehicles are kept sorted, so that a lane interval
+     * is checked by binary search. All vehicles are also sorted by x for radius queries.
+     */
+    class LaneOccupancy
+    {
+    public:
+        typedef struct
+        {
+            double x;
+            double y;
+            int roadId;
+            int ref;  // reference to vehicle, defined by user
+        } Item;
+
+        /**
+         * @brief Remove all vehicles, keeping allocated memory
+         */
+        void Clear();
+
+        /**
+         * @brief Add a vehicle. After adding a batch call Sort() before any query.
+         *
+         * @param roadId Road of the vehicle
+         * @param laneId Lane of the vehicle
+         * @param s Distance along the road
+         * @param x x coordinate
+         * @param y y coordinate
+         * @param ref Reference to vehicle, returned by FindNearby
+         */
+        void Add(int roadId, int laneId, double s, double x, double y, int ref);
+
+        void Sort();
+
+        /**
+         * @brief Add a vehicle, keeping the index sorted. For adding a few vehicles between queries.
+         */
+        void Insert(int roadId, int laneId, double s, double x, double y, int ref);
+
+        /**
+         * @brief Check whether any vehicle is in given lane closer than dist along the road
+         *
+         * @return true if the interval (s - dist, s + dist) is occupied
+         */
+        bool IsLaneOccupied(int roadId, int laneId, double s, double dist) const;
+
+        /**
+         * @brief Find vehicles within given radius
+         *
+         * @param items Found vehicles, replacing any previous content
+         */
+        void FindNearby(double x, double y, double radius, std::vector<Item>& items) const;
+
+    private:
+        std::unordered_map<long long, std::vector<double>> lanes_;  // sorted s values per road and lane
+        std::vector<Item> items_;  // sorted by x
+    };
+
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
  * https://sites.google.com/view/simulationscenarios
  */
 
+#include <sys/stat.h>
+#include <stdlib.h>
 #include "Catalogs.hpp"
 #include "pugixml.hpp"
 
@@ -53,10 +55,11 @@ CatalogType Entry::GetTypeByNodeName(pugi::xml_node node)
 	return CatalogType::CATALOG_UNDEFINED;
 }
 
-Entry::Entry(std::string name, pugi::xml_document root)
+Entry::Entry(std::string name, std::shared_ptr<pugi::xml_document> doc, pugi::xml_node node)
 {
 	name_ = name;
-	root_ = std::move(root);
+	doc_ = doc;
+	node_ = node;
 	type_ = GetTypeByNodeName(GetNode());
 }
 
@@ -121,3 +124,66 @@ std::string Entry::GetTypeAsStr_(CatalogType type)
 
 	return "";
 }
+
+CatalogCache& CatalogCache::Inst()
+{
+	static CatalogCache instance_;
+	return instance_;
+}
+
+std::shared_ptr<pugi::xml_document> CatalogCache::Load(std::string filename, pugi::xml_parse_result& result)
+{
+	struct stat info;
+	if (stat(filename.c_str(), &info) != 0 || info.st_mode & S_IFDIR)
+	{
+		result.status = pugi::status_file_not_found;
+		return nullptr;
+	}
+
+	// Resolve to canonical path, so that different relative paths to the same file share the entry
+	std::string key = filename;
+#ifdef _WIN32
+	char* path = _fullpath(nullptr, filename.c_str(), 0);
+#else
+	char* path = realpath(filename.c_str(), nullptr);
+#endif
+	if (path != nullptr)
+	{
+		key = path;
+		free(path);
+	}
+
+	mutex_.Lock();
+
+	std::map<std::string, CacheEntry>::iterator it = cache_.find(key);
+	if (it != cache_.end() && it->second.mtime == (long long)info.st_mtime && it->second.size == (long long)info.st_size)
+	{
+		std::shared_ptr<pugi::xml_document> doc = it->second.doc;
+		hits_++;
+		mutex_.Unlock();
+		result.status = pugi::status_ok;
+		return doc;
+	}
+
+	std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+	result = doc->load_file(key.c_str());
+	if (!result)
+	{
+		cache_.erase(key);
+		mutex_.Unlock();
+		return nullptr;
+	}
+
+	cache_[key] = { (long long)info.st_mtime, (long long)info.st_size, doc };
+	misses_++;
+	mutex_.Unlock();
+
+	return doc;
+}
+
+void CatalogCache::Clear()
+{
+	mutex_.Lock();
+	cache_.clear();
+	mutex_.Unlock();
+}
@@ -15,6 +15,8 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
 
 #include "CommonMini.hpp"
 #include "RoadManager.hpp"
@@ -43,11 +45,12 @@ namespace scenarioengine
 	public:
 
 		std::string name_;
-		pugi::xml_document root_;
+		std::shared_ptr<pugi::xml_document> doc_;  // catalog document, shared with the catalog cache
+		pugi::xml_node node_;
 		CatalogType type_;
 
-		Entry(std::string name, pugi::xml_document root);
-		pugi::xml_node GetNode() { return root_.first_child(); }
+		Entry(std::string name, std::shared_ptr<pugi::xml_document> doc, pugi::xml_node node);
+		pugi::xml_node GetNode() { return node_; }
 
 		static std::string GetTypeAsStr_(CatalogType type);
 		std::string GetTypeAsStr() { return GetTypeAsStr_(type_); }
@@ -107,12 +110,15 @@ namespace scenarioengine
 		std::vector<Catalog*> catalog_;
 
 		Catalogs() {}
-		~Catalogs()
+		~Catalogs() { Clear(); }
+		void Clear()
 		{
 			for (auto* entry : catalog_)
 			{
 				delete entry;
 			}
+			catalog_.clear();
+			catalog_dirs_.clear();
 		}
 
 		int RegisterCatalogDirectory(std::string type, std::string directory);
@@ -176,4 +182,43 @@ namespace scenarioengine
 
 	};
 
+
+	/*
+	 * Process-wide cache of parsed catalog files, keyed by canonical path. A file is parsed again only if
+	 * its modification time or size has changed, so repeated scenario loads using the same catalogs, e.g.
+	 * re-initializations via esminiLib or parameter distribution runs, share the parsed documents.
+	 * Documents are read-only once cached.
+	 */
+	class CatalogCache
+	{
+	public:
+		static CatalogCache& Inst();
+
+		/**
+			Get parsed catalog file, from cache if unchanged since last parsed
+			@param filename Path to catalog file
+			@param result Parse result, description on failure
+			@return Document, or nullptr if file does not exist or failed to parse
+		*/
+		std::shared_ptr<pugi::xml_document> Load(std::string filename, pugi::xml_parse_result& result);
+
+		// Release all cached documents. Documents still referenced by catalogs stay valid until released.
+		void Clear();
+
+		int GetNumberOfHits() { return hits_; }
+		int GetNumberOfMisses() { return misses_; }
+
+	private:
+		typedef struct
+		{
+			long long mtime;
+			long long size;
+			std::shared_ptr<pugi::xml_document> doc;
+		} CacheEntry;
+
+		std::map<std::string, CacheEntry> cache_;
+		SE_Mutex mutex_;
+		int hits_ = 0;
+		int misses_ = 0;
+	};
 }
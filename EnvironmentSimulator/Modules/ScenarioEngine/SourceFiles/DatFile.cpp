@@ -0,0 +1,421 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include <cstring>
+#include <cstdint>
+#include "DatFile.hpp"
+#include "CommonMini.hpp"
+
+using namespace scenarioengine;
+
+#define DAT_N_FIELDS static_cast<int>(DatField::N_FIELDS)
+
+// Map float to integer of same order, so that close values give small differences. Bijective, i.e. lossless.
+static long long FloatToOrdered(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(float));
+	if (bits & 0x80000000u)
+	{
+		return -1 - static_cast<long long>(bits & 0x7fffffffu);
+	}
+	return static_cast<long long>(bits);
+}
+
+static float OrderedToFloat(long long value)
+{
+	unsigned int bits = value < 0 ? static_cast<unsigned int>(-1 - value) | 0x80000000u : static_cast<unsigned int>(value);
+	float f;
+	memcpy(&f, &bits, sizeof(float));
+	return f;
+}
+
+static float* FloatField(ObjectStateStructDat& s, DatField field)
+{
+	switch (field)
+	{
+	case DatField::SPEED: return &s.info.speed;
+	case DatField::WHEEL_ANGLE: return &s.info.wheel_angle;
+	case DatField::WHEEL_ROT: return &s.info.wheel_rot;
+	case DatField::X: return &s.pos.x;
+	case DatField::Y: return &s.pos.y;
+	case DatField::Z: return &s.pos.z;
+	case DatField::H: return &s.pos.h;
+	case DatField::P: return &s.pos.p;
+	case DatField::R: return &s.pos.r;
+	case DatField::OFFSET: return &s.pos.offset;
+	case DatField::T: return &s.pos.t;
+	case DatField::S: return &s.pos.s;
+	default: return nullptr;
+	}
+}
+
+static long long GetFieldValue(const ObjectStateStructDat& s, DatField field)
+{
+	if (field == DatField::ROAD_ID)
+	{
+		return s.pos.roadId;
+	}
+	else if (field == DatField::LANE_ID)
+	{
+		return s.pos.laneId;
+	}
+	return FloatToOrdered(*FloatField(const_cast<ObjectStateStructDat&>(s), field));
+}
+
+static void SetFieldValue(ObjectStateStructDat& s, DatField field, long long value)
+{
+	if (field == DatField::ROAD_ID)
+	{
+		s.pos.roadId = static_cast<int>(value);
+	}
+	else if (field == DatField::LANE_ID)
+	{
+		s.pos.laneId = static_cast<int>(value);
+	}
+	else
+	{
+		*FloatField(s, field) = OrderedToFloat(value);
+	}
+}
+
+static bool StaticInfoEqual(const ObjectStateStructDat& a, const ObjectStateStructDat& b)
+{
+	return a.info.model_id == b.info.model_id &&
+		a.info.obj_type == b.info.obj_type &&
+		a.info.obj_category == b.info.obj_category &&
+		a.info.ctrl_type == b.info.ctrl_type &&
+		a.info.scaleMode == b.info.scaleMode &&
+		a.info.visibilityMask == b.info.visibilityMask &&
+		strncmp(a.info.name, b.info.name, NAME_LEN) == 0 &&
+		memcmp(&a.info.boundingbox, &b.info.boundingbox, sizeof(OSCBoundingBox)) == 0;
+}
+
+static void PutVarint(std::vector<char>& buf, unsigned long long value)
+{
+	while (value >= 0x80)
+	{
+		buf.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	buf.push_back(static_cast<char>(value));
+}
+
+static void PutSigned(std::vector<char>& buf, long long value)
+{
+	// zigzag encoding, small magnitudes give small varints regardless of sign
+	PutVarint(buf, (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63));
+}
+
+static void PutFloat(std::vector<char>& buf, float value)
+{
+	char bytes[sizeof(float)];
+	memcpy(bytes, &value, sizeof(float));
+	buf.insert(buf.end(), bytes, bytes + sizeof(float));
+}
+
+namespace
+{
+	class DatReader
+	{
+	public:
+		DatReader(const char* data, size_t size) : pos_(data), end_(data + size) {}
+
+		size_t Remaining() { return static_cast<size_t>(end_ - pos_); }
+
+		bool GetByte(unsigned char& value)
+		{
+			if (pos_ >= end_)
+			{
+				return false;
+			}
+			value = static_cast<unsigned char>(*pos_++);
+			return true;
+		}
+
+		bool GetVarint(unsigned long long& value)
+		{
+			value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				unsigned char byte;
+				if (!GetByte(byte))
+				{
+					return false;
+				}
+				value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+				if (!(byte & 0x80))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool GetSigned(long long& value)
+		{
+			unsigned long long u;
+			if (!GetVarint(u))
+			{
+				return false;
+			}
+			value = static_cast<long long>(u >> 1) ^ -static_cast<long long>(u & 1);
+			return true;
+		}
+
+		bool GetInt(int& value)
+		{
+			long long v;
+			if (!GetSigned(v))
+			{
+				return false;
+			}
+			value = static_cast<int>(v);
+			return true;
+		}
+
+		bool GetBytes(char* dst, size_t n)
+		{
+			if (static_cast<size_t>(end_ - pos_) < n)
+			{
+				return false;
+			}
+			memcpy(dst, pos_, n);
+			pos_ += n;
+			return true;
+		}
+
+		bool GetFloat(float& value)
+		{
+			return GetBytes(reinterpret_cast<char*>(&value), sizeof(float));
+		}
+
+	private:
+		const char* pos_;
+		const char* end_;
+	};
+}
+
+void DatEncoder::EncodeObjectInfo(const ObjectStateStructDat& state, std::vector<char>& buf)
+{
+	const ObjectInfoStructDat& info = state.info;
+	size_t name_len = strnlen(info.name, NAME_LEN);
+
+	buf.push_back(DAT_PACKET_OBJECT_INFO);
+	PutSigned(buf, info.id);
+	PutSigned(buf, info.model_id);
+	PutSigned(buf, info.obj_type);
+	PutSigned(buf, info.obj_category);
+	PutSigned(buf, info.ctrl_type);
+	PutSigned(buf, info.scaleMode);
+	PutSigned(buf, info.visibilityMask);
+	PutVarint(buf, name_len);
+	buf.insert(buf.end(), info.name, info.name + name_len);
+	PutFloat(buf, info.boundingbox.center_.x_);
+	PutFloat(buf, info.boundingbox.center_.y_);
+	PutFloat(buf, info.boundingbox.center_.z_);
+	PutFloat(buf, info.boundingbox.dimensions_.width_);
+	PutFloat(buf, info.boundingbox.dimensions_.length_);
+	PutFloat(buf, info.boundingbox.dimensions_.height_);
+}
+
+void DatEncoder::EncodeFrame(const ObjectStateStructDat* states, size_t n, std::vector<char>& buf)
+{
+	// First register any new or changed static info, referred to by the frame
+	for (size_t i = 0; i < n; i++)
+	{
+		auto it = objects_.find(states[i].info.id);
+		if (it == objects_.end() || !StaticInfoEqual(it->second.state, states[i]))
+		{
+			if (it == objects_.end())
+			{
+				DatObjectCache cache;
+				memset(&cache, 0, sizeof(cache));
+				it = objects_.emplace(states[i].info.id, cache).first;
+			}
+			it->second.state.info = states[i].info;
+			EncodeObjectInfo(states[i], buf);
+		}
+	}
+
+	buf.push_back(DAT_PACKET_FRAME);
+	PutFloat(buf, states[0].info.timeStamp);
+	PutVarint(buf, n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		DatObjectCache& cache = objects_[states[i].info.id];
+		long long delta[DAT_N_FIELDS];
+		unsigned int mask = 0;
+
+		for (int j = 0; j < DAT_N_FIELDS; j++)
+		{
+			long long value = GetFieldValue(states[i], static_cast<DatField>(j));
+			delta[j] = value - cache.value[j];
+			if (delta[j] != 0)
+			{
+				mask |= 1u << j;
+				cache.value[j] = value;
+			}
+		}
+
+		PutSigned(buf, states[i].info.id);
+		PutVarint(buf, mask);
+		for (int j = 0; j < DAT_N_FIELDS; j++)
+		{
+			if (mask & (1u << j))
+			{
+				PutSigned(buf, delta[j]);
+			}
+		}
+	}
+}
+
+void DatEncoder::Encode(const ObjectStateStructDat* states, size_t n, std::vector<char>& buf)
+{
+	size_t first = 0;
+
+	for (size_t i = 1; i <= n; i++)
+	{
+		if (i == n || states[i].info.timeStamp != states[first].info.timeStamp)
+		{
+			EncodeFrame(&states[first], i - first, buf);
+			first = i;
+		}
+	}
+}
+
+int DatDecoder::Decode(const char* data, size_t size, std::vector<ObjectStateStructDat>& states)
+{
+	size_t pos = 0;
+
+	return Decode(data, size, pos, states, SIZE_MAX);
+}
+
+int DatDecoder::Decode(const char* data, size_t size, size_t& pos, std::vector<ObjectStateStructDat>& states, size_t max_states)
+{
+	DatReader reader(data + pos, size - pos);
+	size_t n_start = states.size();
+	unsigned char type;
+
+	while (states.size() - n_start < max_states && reader.GetByte(type))
+	{
+		if (type == DAT_PACKET_OBJECT_INFO)
+		{
+			ObjectInfoStructDat info;
+			unsigned long long name_len;
+
+			memset(&info, 0, sizeof(info));
+			if (!(reader.GetInt(info.id) && reader.GetInt(info.model_id) && reader.GetInt(info.obj_type) &&
+				reader.GetInt(info.obj_category) && reader.GetInt(info.ctrl_type) && reader.GetInt(info.scaleMode) &&
+				reader.GetInt(info.visibilityMask) && reader.GetVarint(name_len)))
+			{
+				break;
+			}
+			if (name_len > NAME_LEN)
+			{
+				LOG("Corrupt dat file, object name length %llu", name_len);
+				return -1;
+			}
+			if (!(reader.GetBytes(info.name, name_len) &&
+				reader.GetFloat(info.boundingbox.center_.x_) && reader.GetFloat(info.boundingbox.center_.y_) &&
+				reader.GetFloat(info.boundingbox.center_.z_) && reader.GetFloat(info.boundingbox.dimensions_.width_) &&
+				reader.GetFloat(info.boundingbox.dimensions_.length_) && reader.GetFloat(info.boundingbox.dimensions_.height_)))
+			{
+				break;
+			}
+
+			auto it = objects_.find(info.id);
+			if (it == objects_.end())
+			{
+				DatObjectCache cache;
+				memset(&cache, 0, sizeof(cache));
+				it = objects_.emplace(info.id, cache).first;
+			}
+			it->second.state.info.id = info.id;
+			it->second.state.info.model_id = info.model_id;
+			it->second.state.info.obj_type = info.obj_type;
+			it->second.state.info.obj_category = info.obj_category;
+			it->second.state.info.ctrl_type = info.ctrl_type;
+			it->second.state.info.scaleMode = info.scaleMode;
+			it->second.state.info.visibilityMask = info.visibilityMask;
+			memcpy(it->second.state.info.name, info.name, NAME_LEN);
+			it->second.state.info.boundingbox = info.boundingbox;
+		}
+		else if (type == DAT_PACKET_FRAME)
+		{
+			float timestamp;
+			unsigned long long n;
+			size_t frame_start = states.size();
+			bool complete = reader.GetFloat(timestamp) && reader.GetVarint(n);
+
+			for (unsigned long long i = 0; complete && i < n; i++)
+			{
+				int id;
+				unsigned long long mask;
+
+				if (!(reader.GetInt(id) && reader.GetVarint(mask)))
+				{
+					complete = false;
+					break;
+				}
+
+				auto it = objects_.find(id);
+				if (it == objects_.end())
+				{
+					LOG("Corrupt dat file, state of object %d before its info", id);
+					return -1;
+				}
+
+				DatObjectCache& cache = it->second;
+				for (int j = 0; j < DAT_N_FIELDS; j++)
+				{
+					if (mask & (1ull << j))
+					{
+						long long delta;
+						if (!reader.GetSigned(delta))
+						{
+							complete = false;
+							break;
+						}
+						cache.value[j] += delta;
+						SetFieldValue(cache.state, static_cast<DatField>(j), cache.value[j]);
+					}
+				}
+				cache.state.info.timeStamp = timestamp;
+				states.push_back(cache.state);
+			}
+
+			if (!complete)
+			{
+				// Recording interrupted, skip the incomplete frame
+				states.resize(frame_start);
+				break;
+			}
+		}
+		else
+		{
+			LOG("Corrupt dat file, unknown packet type %d", type);
+			return -1;
+		}
+
+		pos = size - reader.Remaining();
+	}
+
+	if (pos < size && states.size() - n_start < max_states)
+	{
+		LOG("Skipped incomplete data at end of dat file");
+		pos = size;
+	}
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+/*
+ * Encoding and decoding of the compact .dat recording format (DAT_FILE_FORMAT_VERSION 3)
+ *
+ * The file starts with a DatHeader, followed by a sequence of packets. Each packet starts with a one byte type:
+ *
+ *   DAT_PACKET_OBJECT_INFO  static object info, written the first time an object appears and whenever it changes
+ *     id, model_id, obj_type, obj_category, ctrl_type, scaleMode, visibilityMask (varint)
+ *     name length (varint) + name characters
+ *     bounding box center x, y, z and dimension width, length, height (float32)
+ *
+ *   DAT_PACKET_FRAME  all object states sharing one timestamp
+ *     timestamp (float32), number of objects (varint), then per object:
+ *       id (varint), mask of changed fields (varint), delta of each changed quantized field (varint)
+ *
+ * Dynamic fields are stored as difference to the previously stored value of the same object. Float values
+ * are first mapped to integers of the same order, i.e. quantized to the float32 grid, so encoding is lossless
+ * and replay identical to version 2 files. Varints are little endian base-128, signed values zigzag encoded.
+ */
+
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "ScenarioGateway.hpp"
+
+#define DAT_PACKET_OBJECT_INFO 1
+#define DAT_PACKET_FRAME 2
+
+namespace scenarioengine
+{
+	// Dynamic fields of a record, bit index in the changed fields mask
+	enum class DatField
+	{
+		SPEED,
+		WHEEL_ANGLE,
+		WHEEL_ROT,
+		X,
+		Y,
+		Z,
+		H,
+		P,
+		R,
+		ROAD_ID,
+		LANE_ID,
+		OFFSET,
+		T,
+		S,
+		N_FIELDS
+	};
+
+	typedef struct
+	{
+		ObjectStateStructDat state;  // static info and last written values
+		long long value[static_cast<int>(DatField::N_FIELDS)];  // last written values, as ordered integers
+	} DatObjectCache;
+
+	class DatEncoder
+	{
+	public:
+		/**
+			Encode object states, appending packets to given buffer. Consecutive states with same timestamp
+			are grouped into one frame.
+			@param states Array of object states
+			@param n Number of states
+			@param buf Buffer to append encoded data to
+		*/
+		void Encode(const ObjectStateStructDat* states, size_t n, std::vector<char>& buf);
+
+		// Forget all objects, e.g. when starting a new file
+		void Reset() { objects_.clear(); }
+
+	private:
+		std::unordered_map<int, DatObjectCache> objects_;
+
+		void EncodeObjectInfo(const ObjectStateStructDat& state, std::vector<char>& buf);
+		void EncodeFrame(const ObjectStateStructDat* states, size_t n, std::vector<char>& buf);
+	};
+
+	class DatDecoder
+	{
+	public:
+		/**
+			Decode packets into full object states, appended to given vector.
+			An incomplete frame at the end of data, e.g. from an interrupted recording, is skipped.
+			@param data Encoded data, following the DatHeader
+			@param size Size of data in bytes
+			@param states Vector to append decoded states to
+			@return 0 on success, -1 if data is corrupt
+		*/
+		int Decode(const char* data, size_t size, std::vector<ObjectStateStructDat>& states);
+
+		/**
+			Decode packets in chunks, e.g. for streaming through large files
+			@param data Encoded data, following the DatHeader
+			@param size Size of data in bytes
+			@param pos Position in data to continue from, updated to first packet not yet decoded. Equals size when done.
+			@param states Vector to append decoded states to
+			@param max_states Stop after the frame completing this number of appended states
+			@return 0 on success, -1 if data is corrupt
+		*/
+		int Decode(const char* data, size_t size, size_t& pos, std::vector<ObjectStateStructDat>& states, size_t max_states);
+
+		void Reset() { objects_.clear(); }
+
+		/**
+			Decoding state, i.e. static info and last values of all objects seen so far. Saving the state at a
+			packet boundary makes it possible to resume decoding from that position later on.
+		*/
+		const std::unordered_map<int, DatObjectCache>& GetObjects() const { return objects_; }
+		void SetObjects(const std::unordered_map<int, DatObjectCache>& objects) { objects_ = objects; }
+
+	private:
+		std::unordered_map<int, DatObjectCache> objects_;
+	};
+
+}
@@ -25,7 +25,7 @@ Object::Object(Type type) : type_(type), id_(0), speed_(0), wheel_angle_(0), whe
 trail_follow_index_(0), odometer_(0), end_of_road_timestamp_(0.0), off_road_timestamp_(0.0), stand_still_timestamp_(0),
 dirty_(0), reset_(0), controller_(0), headstart_time_(0), ghost_(0), ghost_Ego_(0), visibilityMask_(0xff), isGhost_(false),
 junctionSelectorStrategy_(Junction::JunctionStrategyType::RANDOM), nextJunctionSelectorAngle_(0.0), scaleMode_(EntityScaleMode::NONE),
-is_active_(false)
+is_active_(false), lod_low_(false), lod_skip_(false), lod_dt_(0.0), lod_referenced_(false)
 {
 	sensor_pos_[0] = 0;
 	sensor_pos_[1] = 0;
@@ -1373,6 +1373,36 @@ int Vehicle::ConnectTrailer(Vehicle* trailer)
 	return -1;
 }
 
+void Vehicle::Recycle(const Vehicle& v)
+{
+	int id = id_;
+	Controller* controller = controller_;
+
+	// Draw random junction selector angle like the constructor does before it's overwritten by the copy,
+	// so that the random sequence is the same as if a new vehicle had been created
+	SetJunctionSelectorAngleRandom();
+
+	Object::operator=(v);  // trailer connections are not touched
+
+	id_ = id;
+	controller_ = controller;
+
+	if (trailer_hitch_ && v.trailer_hitch_)
+	{
+		trailer_hitch_->dx_ = v.trailer_hitch_->dx_;
+	}
+	if (trailer_coupler_ && v.trailer_coupler_)
+	{
+		trailer_coupler_->dx_ = v.trailer_coupler_->dx_;
+	}
+
+	Vehicle* trailer = static_cast<Vehicle*>(TrailerVehicle());
+	if (trailer && v.trailer_hitch_ && v.trailer_hitch_->trailer_vehicle_)
+	{
+		trailer->Recycle(*static_cast<Vehicle*>(v.trailer_hitch_->trailer_vehicle_));
+	}
+}
+
 void Vehicle::AlignTrailers()
 {
 	// Calculate neutral trailer position and orientation
@@ -128,6 +128,7 @@ namespace scenarioengine
 		roadmanager::Position pos_;
 		int model_id_;
 		roadmanager::PolyLineBase trail_;
+		std::vector<roadmanager::TrajVertex> trail_dropped_;  // samples dropped from trail since last vertex, see ScenarioEngine::SetGhostTrailBound
 		double odometer_;
 		OSCBoundingBox boundingbox_;
 		double end_of_road_timestamp_;
@@ -143,6 +144,10 @@ namespace scenarioengine
 		Controller* controller_; // reference to any assigned controller object
 		bool reset_;			 // indicate discreet movement, teleporting, no odometer update
 		bool isGhost_;
+		bool lod_low_;           // simulated at low level of detail, see ScenarioEngine::SetLOD()
+		bool lod_skip_;          // low level of detail and not updated this frame
+		double lod_dt_;          // time since last update, only maintained when level of detail is enabled
+		bool lod_referenced_;    // referenced by a condition, always kept at full level of detail
 
 		//Rel2abs Controller addition
 		std::vector<Event*> objectEvents_;				//Events that contains privateactions applied to this object
@@ -468,6 +473,14 @@ namespace scenarioengine
 		int ConnectTrailer(Vehicle* trailer);
 		void AlignTrailers();
 
+		/**
+			Reset state of this vehicle and any trailers to the ones of given vehicle, e.g. a catalog template.
+			Id, controller and trailer connections are kept, so the vehicle can be reused instead of deleted
+			and another one copied from the template.
+			@param v Vehicle to copy state from, with the same number of trailers
+		*/
+		void Recycle(const Vehicle& v);
+
 		std::shared_ptr<TrailerCoupler> trailer_coupler_;  // mounting point to any tow vehicle
 		std::shared_ptr<TrailerHitch> trailer_hitch_;   // mounting point to any tow vehicle
 	};
@@ -636,17 +649,23 @@ namespace scenarioengine
 	{
 	public:
 		Entities() : nextId_(0) {}
-		~Entities()
+		~Entities() { Clear(); }
+
+		// Delete all objects, including any in the pool
+		void Clear()
 		{
 			for (auto* entry : object_)
 			{
 				delete entry;
 			}
+			object_.clear();
 
 			for (auto* entry : object_pool_)
 			{
 				delete entry;
 			}
+			object_pool_.clear();
+			nextId_ = 0;
 		}
 
 		std::vector<Object*> object_;
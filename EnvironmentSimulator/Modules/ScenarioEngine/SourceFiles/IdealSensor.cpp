@@ -10,10 +10,92 @@
  * https://sites.google.com/view/simulationscenarios
  */
 
+#include <algorithm>
 #include "IdealSensor.hpp"
 
 using namespace scenarioengine;
 
+void SensorGrid::Update(Entities* entities)
+{
+	items_.clear();
+	cells_.clear();
+
+	for (size_t i = 0; i < entities->object_.size(); i++)
+	{
+		Object* obj = entities->object_[i];
+		if (obj->IsGhost() || !(obj->visibilityMask_ & Object::Visibility::SENSORS))
+		{
+			continue;
+		}
+
+		Item item;
+		item.obj = obj;
+		item.index = static_cast<int>(i);
+		item.x = obj->pos_.GetX();
+		item.y = obj->pos_.GetY();
+
+		double h = obj->pos_.GetH();
+		double cos_h = cos(h);
+		double sin_h = sin(h);
+		OSCBoundingBox& bb = obj->boundingbox_;
+		for (int j = 0; j < 4; j++)
+		{
+			double lx = bb.center_.x_ + (j == 0 || j == 3 ? 0.5 : -0.5) * bb.dimensions_.length_;
+			double ly = bb.center_.y_ + (j < 2 ? 0.5 : -0.5) * bb.dimensions_.width_;
+			item.corner[j][0] = item.x + lx * cos_h - ly * sin_h;
+			item.corner[j][1] = item.y + lx * sin_h + ly * cos_h;
+		}
+
+		cells_.push_back(std::make_pair(CellKey(static_cast<int>(floor(item.x / cell_size_)),
+			static_cast<int>(floor(item.y / cell_size_))), static_cast<int>(items_.size())));
+		items_.push_back(item);
+	}
+
+	std::sort(cells_.begin(), cells_.end());
+}
+
+void SensorGrid::FindNearby(double x, double y, double radius, std::vector<Item*>& items)
+{
+	items.clear();
+
+	int ix0 = static_cast<int>(floor((x - radius) / cell_size_));
+	int ix1 = static_cast<int>(floor((x + radius) / cell_size_));
+	int iy0 = static_cast<int>(floor((y - radius) / cell_size_));
+	int iy1 = static_cast<int>(floor((y + radius) / cell_size_));
+	double radius_sq = radius * radius;
+
+	if (static_cast<double>(ix1 - ix0 + 1) * (iy1 - iy0 + 1) > items_.size())
+	{
+		// More cells than items, faster to check all
+		for (size_t i = 0; i < items_.size(); i++)
+		{
+			if (PointSquareDistance2D(x, y, items_[i].x, items_[i].y) <= radius_sq)
+			{
+				items.push_back(&items_[i]);
+			}
+		}
+		return;
+	}
+
+	for (int ix = ix0; ix <= ix1; ix++)
+	{
+		for (int iy = iy0; iy <= iy1; iy++)
+		{
+			auto it = std::lower_bound(cells_.begin(), cells_.end(), std::make_pair(CellKey(ix, iy), 0));
+			for (; it != cells_.end() && it->first == CellKey(ix, iy); it++)
+			{
+				Item* item = &items_[it->second];
+				if (PointSquareDistance2D(x, y, item->x, item->y) <= radius_sq)
+				{
+					items.push_back(item);
+				}
+			}
+		}
+	}
+
+	std::sort(items.begin(), items.end(), [](const Item* a, const Item* b) { return a->index < b->index; });
+}
+
 BaseSensor::BaseSensor(BaseSensor::Type type, double pos_x, double pos_y, double pos_z, double heading)
 {
 	type_ = type;
@@ -41,6 +123,7 @@ ObjectSensor::ObjectSensor(
 	maxObj_ = maxObj;
 	host_ = refobj;
 	nObj_ = 0;
+	occlusion_ = false;
 	hitList_ = (ObjectHit*)malloc(maxObj * sizeof(ObjectHit));
 }
 
@@ -50,107 +133,235 @@ ObjectSensor::~ObjectSensor()
 }
 
 void ObjectSensor::Update()
+{
+	grid_.Update(entities_);
+	Update(&grid_);
+}
+
+void ObjectSensor::Update(SensorGrid* grid)
 {
 	nObj_ = 0;
 
-	for (size_t i = 0; i < entities_->object_.size(); i++)
+	// Sensor pose in global coordinates, same for all objects
+	double host_h = host_->pos_.GetH();
+	double sensor_h = GetAngleSum(host_h, pos_.h);
+	double sensor_pos_x, sensor_pos_y;
+	RotateVec2D(pos_.x, pos_.y, host_h, sensor_pos_x, sensor_pos_y);
+	pos_.x_global = host_->pos_.GetX() + sensor_pos_x;
+	pos_.y_global = host_->pos_.GetY() + sensor_pos_y;
+	pos_.z_global = host_->pos_.GetZ() + pos_.z;
+	double cos_h = cos(sensor_h);
+	double sin_h = sin(sensor_h);
+
+	// Field of view test without trigonometry: |y| < x * tan(fov/2) in sensor coordinates, or the opposite for wide angles
+	double half_fov = fovH_ / 2;
+	bool wide = half_fov > M_PI_2;
+	double tan_half_fov = tan(wide ? M_PI - half_fov : half_fov);
+
+	grid->FindNearby(pos_.x_global, pos_.y_global, far_, nearby_);
+
+	candidates_.clear();
+	for (size_t i = 0; i < nearby_.size(); i++)
 	{
-		Object *obj = entities_->object_[i];
-		if (obj == host_ || obj->IsGhost())
+		SensorGrid::Item* item = nearby_[i];
+		if (item->obj == host_)
+		{
+			continue;
+		}
+
+		double xo = item->x - pos_.x_global;
+		double yo = item->y - pos_.y_global;
+		double dist_sq = xo * xo + yo * yo;
+		if (dist_sq < near_sq_)
 		{
-			// skip own vehicle and any ghost vehicles
 			continue;
 		}
 
-		if (!(obj->visibilityMask_ & Object::Visibility::SENSORS))
+		Candidate c;
+		c.item = item;
+		c.dist_sq = dist_sq;
+		c.x = xo * cos_h + yo * sin_h;
+		c.y = -xo * sin_h + yo * cos_h;
+		if (half_fov >= M_PI)
+		{
+			c.in_fov = true;
+		}
+		else if (wide)
+		{
+			c.in_fov = !(c.x <= 0.0 && fabs(c.y) <= -c.x * tan_half_fov);
+		}
+		else
+		{
+			c.in_fov = c.x > 0.0 && fabs(c.y) < c.x * tan_half_fov;
+		}
+		c.visible = c.in_fov;
+
+		if (!occlusion_ && !c.in_fov)
 		{
-			// Object is not visible for sensors
 			continue;
 		}
 
-		// Check whether object is within field of view
+		candidates_.push_back(c);
+	}
+
+	if (occlusion_)
+	{
+		Occlude();
+	}
+
+	for (size_t i = 0; i < candidates_.size() && nObj_ < maxObj_; i++)
+	{
+		if (candidates_[i].visible)
+		{
+			AddHit(candidates_[i].item->obj, candidates_[i].x, candidates_[i].y, sensor_h);
+		}
+	}
+}
 
-		// find out angle between heading vector and line to object
-		double hx = 1.0;
-		double hy = 0.0;
-		double hx2, hy2;
-		RotateVec2D(hx, hy, host_->pos_.GetH(), hx2, hy2);
+void ObjectSensor::Occlude()
+{
+	by_distance_.clear();
+	for (size_t i = 0; i < candidates_.size(); i++)
+	{
+		by_distance_.push_back(&candidates_[i]);
+	}
+	std::sort(by_distance_.begin(), by_distance_.end(), [](const Candidate* a, const Candidate* b) { return a->dist_sq < b->dist_sq; });
 
-		double sensor_pos_x, sensor_pos_y;
-		RotateVec2D(pos_.x, pos_.y, host_->pos_.GetH(), sensor_pos_x, sensor_pos_y);
-		pos_.x_global = host_->pos_.GetX() + sensor_pos_x;
-		pos_.y_global = host_->pos_.GetY() + sensor_pos_y;
-		pos_.z_global = host_->pos_.GetZ() + pos_.z;
+	shadows_.clear();
+	for (size_t i = 0; i < by_distance_.size(); i++)
+	{
+		Candidate* c = by_distance_[i];
 
-		// Find vector from host to object
-		double xo = obj->pos_.GetX() - pos_.x_global;
-		double yo = obj->pos_.GetY() - pos_.y_global;
+		// Angular interval covered by the footprint, as seen from the sensor
+		double xo = c->item->x - pos_.x_global;
+		double yo = c->item->y - pos_.y_global;
+		double angle = atan2(c->y, c->x);
+		double lo = 0.0;
+		double hi = 0.0;
+		bool inside = false;
+		for (int j = 0; j < 4; j++)
+		{
+			double cx = c->item->corner[j][0] - pos_.x_global;
+			double cy = c->item->corner[j][1] - pos_.y_global;
+			double rel = atan2(GetCrossProduct2D(xo, yo, cx, cy), GetDotProduct2D(xo, yo, cx, cy));
+			if (fabs(rel) >= M_PI_2)
+			{
+				inside = true;  // sensor within or next to footprint, neither shadowing nor shadowed
+				break;
+			}
+			lo = MIN(lo, rel);
+			hi = MAX(hi, rel);
+		}
 
-		// First check distance
-		double dist_sq = (xo*xo + yo * yo);
-		if (dist_sq < near_sq_ || dist_sq > far_sq_)
+		if (inside)
 		{
-			// Not within near and far radius/distance
 			continue;
 		}
 
-		double xon, yon;
-		NormalizeVec2D(xo, yo, xon, yon);
-
-		// Find angle to object
-		double angle = acos(GetDotProduct2D(hx2, hy2, xon, yon));
-		double rel_angle = GetAbsAngleDifference(angle, pos_.h);
-		if (rel_angle < fovH_/2)
-		{
-			hitList_[nObj_].obj_ = obj;
-
-			// Calculate hit object position in sensor local coordinates
-			double xl, yl;
-			RotateVec2D(xo, yo, -GetAngleSum(host_->pos_.GetH(), pos_.h), xl, yl);
-
-			hitList_[nObj_].x_ = xl;
-			hitList_[nObj_].y_ = yl;
-			hitList_[nObj_].z_ = obj->pos_.GetZ() - pos_.z_global + 0.7;
-
-			// Calculate hit object velocity in sensor local coordinates
-			double xVelTarget = obj->pos_.GetVelX();
-			double yVelTarget = obj->pos_.GetVelY();
-			double xVelHost = host_->pos_.GetVelX();
-			double yVelHost = host_->pos_.GetVelY();
-			double angleHost = -GetAngleSum(host_->pos_.GetH(), pos_.h);
-			double targetVelXforHost, targetVelYforHost;
-			Global2LocalCoordinates(xVelTarget, yVelTarget,
-									xVelHost, yVelHost, angleHost,
-									targetVelXforHost, targetVelYforHost);
-			hitList_[nObj_].velX_ = targetVelXforHost;
-			hitList_[nObj_].velY_ = targetVelYforHost;
-
-			// Calculate hit object acceleration in sensor local coordinates
-			double xAccTarget = obj->pos_.GetAccX();
-			double yAccTarget = obj->pos_.GetAccY();
-			double xAccHost = host_->pos_.GetAccX();
-			double yAccHost = host_->pos_.GetAccY();
-			double targetAccXforHost, targetAccYforHost;
-			Global2LocalCoordinates(xAccTarget, yAccTarget,
-									xAccHost, yAccHost, angleHost,
-									targetAccXforHost, targetAccYforHost);
-			hitList_[nObj_].accX_ = targetAccXforHost;
-			hitList_[nObj_].accY_ = targetAccYforHost;
-
-			// Calculate hit object yaw, yaw rate and yaw acceleration in sensor local coordinates
-			double yawTarget = obj->pos_.GetH();
-			double yawHost = GetAngleSum(host_->pos_.GetH(), pos_.h);
-			hitList_[nObj_].yaw_ = GetAngleDifference(yawTarget, yawHost);
-
-			double yawRateTarget = obj->pos_.GetHRate();
-			double yawRateHost = host_->pos_.GetHRate();
-			hitList_[nObj_].yawRate_ = GetAngleDifference(yawRateTarget, yawRateHost);
-
-			double yawAccTarget = obj->pos_.GetHAcc();
-			double yawAccHost = host_->pos_.GetHAcc();
-			hitList_[nObj_].yawAcc_ = GetAngleDifference(yawAccTarget, yawAccHost);
-
-			nObj_++;
+		lo += angle;
+		hi += angle;
+
+		// Shadows are kept within [-pi, pi], split any interval wrapping around the rear direction
+		double piece[2][2] = {{lo, hi}, {0.0, 0.0}};
+		int n_pieces = 1;
+		if (hi > M_PI)
+		{
+			piece[0][1] = M_PI;
+			piece[1][0] = -M_PI;
+			piece[1][1] = hi - 2 * M_PI;
+			n_pieces = 2;
+		}
+		else if (lo < -M_PI)
+		{
+			piece[0][0] = -M_PI;
+			piece[1][0] = lo + 2 * M_PI;
+			piece[1][1] = M_PI;
+			n_pieces = 2;
+		}
+
+		// Hidden if completely within the shadow of nearer objects
+		bool hidden = true;
+		for (int k = 0; hidden && k < n_pieces; k++)
+		{
+			hidden = false;
+			for (size_t j = 0; !hidden && j < shadows_.size(); j++)
+			{
+				hidden = shadows_[j].first <= piece[k][0] && shadows_[j].second >= piece[k][1];
+			}
+		}
+		if (hidden)
+		{
+			c->visible = false;
+		}
+
+		// Add footprint to shadows, merging overlapping intervals
+		for (int k = 0; k < n_pieces; k++)
+		{
+			lo = piece[k][0];
+			hi = piece[k][1];
+			for (size_t j = 0; j < shadows_.size();)
+			{
+				if (shadows_[j].first <= hi && shadows_[j].second >= lo)
+				{
+					lo = MIN(lo, shadows_[j].first);
+					hi = MAX(hi, shadows_[j].second);
+					shadows_.erase(shadows_.begin() + static_cast<long>(j));
+				}
+				else
+				{
+					j++;
+				}
+			}
+			shadows_.push_back(std::make_pair(lo, hi));
 		}
 	}
-}
\ No newline at end of file
+}
+
+void ObjectSensor::AddHit(Object* obj, double x, double y, double sensor_h)
+{
+	hitList_[nObj_].obj_ = obj;
+
+	// Hit object position in sensor local coordinates
+	hitList_[nObj_].x_ = x;
+	hitList_[nObj_].y_ = y;
+	hitList_[nObj_].z_ = obj->pos_.GetZ() - pos_.z_global + 0.7;
+
+	// Calculate hit object velocity in sensor local coordinates
+	double xVelTarget = obj->pos_.GetVelX();
+	double yVelTarget = obj->pos_.GetVelY();
+	double xVelHost = host_->pos_.GetVelX();
+	double yVelHost = host_->pos_.GetVelY();
+	double angleHost = -sensor_h;
+	double targetVelXforHost, targetVelYforHost;
+	Global2LocalCoordinates(xVelTarget, yVelTarget,
+							xVelHost, yVelHost, angleHost,
+							targetVelXforHost, targetVelYforHost);
+	hitList_[nObj_].velX_ = targetVelXforHost;
+	hitList_[nObj_].velY_ = targetVelYforHost;
+
+	// Calculate hit object acceleration in sensor local coordinates
+	double xAccTarget = obj->pos_.GetAccX();
+	double yAccTarget = obj->pos_.GetAccY();
+	double xAccHost = host_->pos_.GetAccX();
+	double yAccHost = host_->pos_.GetAccY();
+	double targetAccXforHost, targetAccYforHost;
+	Global2LocalCoordinates(xAccTarget, yAccTarget,
+							xAccHost, yAccHost, angleHost,
+							targetAccXforHost, targetAccYforHost);
+	hitList_[nObj_].accX_ = targetAccXforHost;
+	hitList_[nObj_].accY_ = targetAccYforHost;
+
+	// Calculate hit object yaw, yaw rate and yaw acceleration in sensor local coordinates
+	double yawTarget = obj->pos_.GetH();
+	hitList_[nObj_].yaw_ = GetAngleDifference(yawTarget, sensor_h);
+
+	double yawRateTarget = obj->pos_.GetHRate();
+	double yawRateHost = host_->pos_.GetHRate();
+	hitList_[nObj_].yawRate_ = GetAngleDifference(yawRateTarget, yawRateHost);
+
+	double yawAccTarget = obj->pos_.GetHAcc();
+	double yawAccHost = host_->pos_.GetHAcc();
+	hitList_[nObj_].yawAcc_ = GetAngleDifference(yawAccTarget, yawAccHost);
+
+	nObj_++;
+}
@@ -12,10 +12,56 @@
 
 #pragma once
 
+#include <vector>
 #include "ScenarioEngine.hpp"
 
+#define SENSOR_GRID_CELL_SIZE 20.0  // m
+
 namespace scenarioengine
 {
+	/**
+		Spatial index of entities visible to sensors, updated once per frame and shared by all object sensors
+	*/
+	class SensorGrid
+	{
+	public:
+		typedef struct
+		{
+			Object* obj;
+			int index;               // index in entity list, for keeping order of detections
+			double x;                // reference point
+			double y;
+			double corner[4][2];     // bounding box footprint, global coordinates
+		} Item;
+
+		SensorGrid(double cellSize = SENSOR_GRID_CELL_SIZE) : cell_size_(cellSize) {}
+
+		/**
+			Rebuild from current entity states. Ghosts and objects not visible to sensors are excluded.
+			@param entities Entities of the scenario
+		*/
+		void Update(Entities* entities);
+
+		/**
+			Find items with reference point within given distance
+			@param x X coordinate of query point
+			@param y Y coordinate of query point
+			@param radius Max distance from query point
+			@param items Found items, sorted on entity index
+		*/
+		void FindNearby(double x, double y, double radius, std::vector<Item*>& items);
+
+	private:
+		double cell_size_;
+		std::vector<Item> items_;
+		std::vector<std::pair<unsigned long long, int>> cells_;  // cell key and item index, sorted on key
+
+		unsigned long long CellKey(int ix, int iy)
+		{
+			return (static_cast<unsigned long long>(static_cast<unsigned int>(ix)) << 32) | static_cast<unsigned int>(iy);
+		}
+	};
+
 	typedef struct
 	{
 		double x;
@@ -77,6 +123,7 @@ namespace scenarioengine
 		double fovH_;         // Horizontal field of view, in degrees
 		double fovV_;         // Vertical field of view, in degrees
 		int maxObj_;          // Maximum length of object list
+		bool occlusion_;      // Skip objects completely hidden behind nearer ones, 2D approximation
 		ObjectHit *hitList_;  // List of identified objects
 		Object *host_;        // Entity to which the sensor is attached
 		int nObj_;            // Size of object list, i.e. number of identified objects
@@ -84,11 +131,39 @@ namespace scenarioengine
 		ObjectSensor(Entities *entities, Object *refobj, double pos_x, double pos_y, double pos_z, double heading,
 			double nearClip, double farClip, double fovH, int maxObj);
 		~ObjectSensor();
+
+		/**
+			Detect objects, building a grid of this sensor only. For multiple sensors, use Update(SensorGrid*).
+		*/
 		void Update();
 
+		/**
+			Detect objects
+			@param grid Spatial index of entities, already updated for current frame
+		*/
+		void Update(SensorGrid* grid);
+		void SetOcclusion(bool enable) { occlusion_ = enable; }
+
 	private:
+		typedef struct
+		{
+			SensorGrid::Item* item;
+			double dist_sq;
+			double x;             // position in sensor local coordinates
+			double y;
+			bool in_fov;
+			bool visible;
+		} Candidate;
 
 		Entities *entities_;   // Reference to the global collection of objects within the scenario
+		SensorGrid grid_;      // Used when no shared grid is provided
+		std::vector<SensorGrid::Item*> nearby_;
+		std::vector<Candidate> candidates_;
+		std::vector<Candidate*> by_distance_;
+		std::vector<std::pair<double, double>> shadows_;  // merged angular intervals, sensor local coordinates
+
+		void Occlude();
+		void AddHit(Object* obj, double x, double y, double sensor_h);
 
 	};
 
@@ -22,17 +22,20 @@ namespace scenarioengine
 	class Init
 	{
 	public:
-		~Init()
+		~Init() { Clear(); }
+		void Clear()
 		{
 			for (auto* entry : private_action_)
 			{
 				delete entry;
 			}
-		
+			private_action_.clear();
+
 			for (auto* entry : global_action_)
 			{
 				delete entry;
 			}
+			global_action_.clear();
 		}
 
 		std::vector<OSCPrivateAction*> private_action_;
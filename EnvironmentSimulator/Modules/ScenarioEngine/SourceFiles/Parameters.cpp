@@ -11,6 +11,7 @@
  */
 
 #include "Parameters.hpp"
+#include <algorithm>
 #include "simple_expr.h"
 
 using namespace scenarioengine;
@@ -40,9 +41,21 @@ void Parameters::RestoreParameterDeclarations()
 {
 	if (!paramDeclarationsSize_.empty())
 	{
+		UpdateIndex();
+		int n_remove = (int)parameterDeclarations_.Parameter.size() - paramDeclarationsSize_.top();
+		for (int i = 0; i < n_remove; i++)
+		{
+			std::vector<int>& positions = index_[parameterDeclarations_.Parameter[i].name];
+			positions.pop_back();
+			if (positions.empty())
+			{
+				index_.erase(parameterDeclarations_.Parameter[i].name);
+			}
+		}
 		parameterDeclarations_.Parameter.erase(
 			parameterDeclarations_.Parameter.begin(),
-			parameterDeclarations_.Parameter.begin() + parameterDeclarations_.Parameter.size() - paramDeclarationsSize_.top());
+			parameterDeclarations_.Parameter.begin() + n_remove);
+		index_size_ = parameterDeclarations_.Parameter.size();
 		paramDeclarationsSize_.pop();
 		catalog_param_assignments.clear();
 	}
@@ -54,48 +67,78 @@ void Parameters::RestoreParameterDeclarations()
 
 int Parameters::setParameter(std::string name, std::string value)
 {
-	// If string already present in parameterDeclaration
-	for (size_t i = 0; i < parameterDeclarations_.Parameter.size(); i++)
+	OSCParameterDeclarations::ParameterStruct* ps = getParameterEntry(name);
+
+	if (!ps)
 	{
-		if (PARAMETER_PREFIX + parameterDeclarations_.Parameter[i].name == name || // parameter names should not include prefix
-			parameterDeclarations_.Parameter[i].name == name)  // But support also parameter name including prefix
-		{
-			parameterDeclarations_.Parameter[i].value._string = value;
-			return 0;
-		}
+		return -1;
 	}
 
-	return -1;
+	ps->value._string = value;
+	ps->string_valid = true;
+
+	return 0;
 }
 
 std::string Parameters::getParameter(OSCParameterDeclarations& parameterDeclaration, std::string name)
 {
+	if (&parameterDeclaration == &parameterDeclarations_)
+	{
+		OSCParameterDeclarations::ParameterStruct* ps = getParameterEntry(name);
+		if (ps)
+		{
+			return ps->getString();
+		}
+		LOG("Failed to resolve parameter %s", name.c_str());
+		throw std::runtime_error("Failed to resolve parameter");
+	}
+
 	// If string already present in parameterDeclaration
 	for (size_t i = 0; i < parameterDeclaration.Parameter.size(); i++)
 	{
 		if (PARAMETER_PREFIX + parameterDeclaration.Parameter[i].name == name || // parameter names should not include prefix
 			parameterDeclaration.Parameter[i].name == name)  // But support also parameter name including prefix
 		{
-			return parameterDeclaration.Parameter[i].value._string;
+			return parameterDeclaration.Parameter[i].getString();
 		}
 	}
 	LOG("Failed to resolve parameter %s", name.c_str());
 	throw std::runtime_error("Failed to resolve parameter");
 }
 
-OSCParameterDeclarations::ParameterStruct* Parameters::getParameterEntry(std::string name)
+void Parameters::UpdateIndex()
 {
-	// If string already present in parameterDeclaration
-	for (size_t i = 0; i < parameterDeclarations_.Parameter.size(); i++)
+	if (index_size_ == parameterDeclarations_.Parameter.size())
 	{
-		if (PARAMETER_PREFIX + parameterDeclarations_.Parameter[i].name == name || // parameter names should not include prefix
-			parameterDeclarations_.Parameter[i].name == name)  // But support also parameter name including prefix
-		{
-			return &parameterDeclarations_.Parameter[i];
-		}
+		return;
 	}
 
-	return 0;
+	// Rebuild from scratch, oldest declaration first
+	index_.clear();
+	for (int i = (int)parameterDeclarations_.Parameter.size() - 1; i >= 0; i--)
+	{
+		index_[parameterDeclarations_.Parameter[i].name].push_back((int)parameterDeclarations_.Parameter.size() - 1 - i);
+	}
+	index_size_ = parameterDeclarations_.Parameter.size();
+}
+
+OSCParameterDeclarations::ParameterStruct* Parameters::getParameterEntry(const std::string& name)
+{
+	UpdateIndex();
+
+	// Parameter names should not include prefix, but support also parameter name including prefix
+	auto it = index_.find(name);
+	if (it == index_.end() && name.size() > 1 && name[0] == PARAMETER_PREFIX)
+	{
+		it = index_.find(name.substr(1));
+	}
+
+	if (it == index_.end())
+	{
+		return 0;
+	}
+
+	return &parameterDeclarations_.Parameter[parameterDeclarations_.Parameter.size() - 1 - it->second.back()];
 }
 
 int Parameters::GetNumberOfParameters()
@@ -128,12 +171,12 @@ int Parameters::setParameterValue(std::string name, const void* value)
 	if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_INTEGER)
 	{
 		ps->value._int = *((int*)value);
-		ps->value._string = std::to_string(ps->value._int);
+		ps->string_valid = false;
 	}
 	else if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_DOUBLE)
 	{
 		ps->value._double = *((double*)value);
-		ps->value._string = std::to_string(ps->value._double);
+		ps->string_valid = false;
 	}
 	else if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_STRING)
 	{
@@ -142,7 +185,7 @@ int Parameters::setParameterValue(std::string name, const void* value)
 	else if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_BOOL)
 	{
 		ps->value._bool = *((bool*)value);
-		ps->value._string = ps->value._bool == true ? "true" : "false";
+		ps->string_valid = false;
 	}
 	else
 	{
@@ -285,6 +328,7 @@ int Parameters::setParameterValueByString(std::string name, std::string value)
 
 	// Always set string value
 	ps->value._string = value;
+	ps->string_valid = true;
 
 	if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_INTEGER)
 	{
@@ -317,7 +361,7 @@ int Parameters::setParameterValue(std::string name, int value)
 	}
 
 	ps->value._int = value;
-	ps->value._string = std::to_string(ps->value._int);
+	ps->string_valid = false;
 
 	return 0;
 }
@@ -332,7 +376,7 @@ int Parameters::setParameterValue(std::string name, double value)
 	}
 
 	ps->value._double = value;
-	ps->value._string = std::to_string(ps->value._double);
+	ps->string_valid = false;
 
 	return 0;
 }
@@ -361,7 +405,7 @@ int Parameters::setParameterValue(std::string name, bool value)
 	}
 
 	ps->value._bool = value;
-	ps->value._string = ps->value._bool == true ? "true" : "false";
+	ps->string_valid = false;
 
 	return 0;
 }
@@ -393,6 +437,92 @@ static void ReplaceStringInPlace(std::string& subject, const std::string& search
 	}
 }
 
+// Convert from OpenSCENARIO 1.1 operator names to expr op names
+static void ConvertOperators(std::string& expr)
+{
+	ReplaceStringInPlace(expr, "not ", "!");
+	ReplaceStringInPlace(expr, "not(", "!(");
+	ReplaceStringInPlace(expr, "and ", "&& ");
+	ReplaceStringInPlace(expr, "or ", "|| ");
+	ReplaceStringInPlace(expr, "true ", "1 ");
+	ReplaceStringInPlace(expr, "false ", "0 ");
+}
+
+double Parameters::EvaluateExpression(const std::string& expr)
+{
+	auto it = expressions_.find(expr);
+
+	if (it == expressions_.end())
+	{
+		// Replace each parameter reference by a variable @<n>, then parse
+		CompiledExpression ce;
+		std::string str = expr;
+		size_t found;
+		while ((found = str.find(PARAMETER_PREFIX)) != std::string::npos)
+		{
+			size_t found_end = str.find_first_of(" ({)}-+*/%^!|&<>=,", found);
+			std::string name = str.substr(found, found_end == std::string::npos ? std::string::npos : found_end - found);
+			size_t n = std::find(ce.param_names.begin(), ce.param_names.end(), name) - ce.param_names.begin();
+			if (n == ce.param_names.size())
+			{
+				ce.param_names.push_back(name);
+			}
+			str.replace(found, name.size(), "@" + std::to_string(n));
+		}
+		ConvertOperators(str);
+
+		compiled_expr* e = compile_expr(str.c_str());
+		if (e == nullptr)
+		{
+			return NAN;  // syntax error
+		}
+		ce.expr = std::shared_ptr<compiled_expr>(e, destroy_compiled_expr);
+		for (size_t i = 0; i < ce.param_names.size(); i++)
+		{
+			ce.param_values.push_back(compiled_expr_var(e, ("@" + std::to_string(i)).c_str()));
+		}
+		it = expressions_.insert(std::make_pair(expr, ce)).first;
+	}
+
+	CompiledExpression& ce = it->second;
+	for (size_t i = 0; i < ce.param_names.size(); i++)
+	{
+		OSCParameterDeclarations::ParameterStruct* ps = getParameterEntry(ce.param_names[i]);
+		if (ps == nullptr)
+		{
+			LOG("Failed to resolve parameter %s", ce.param_names[i].c_str());
+			throw std::runtime_error("Failed to resolve parameter");
+		}
+
+		if (ce.param_values[i] == nullptr)
+		{
+			continue;
+		}
+
+		if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_INTEGER)
+		{
+			*ce.param_values[i] = ps->value._int;
+		}
+		else if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_DOUBLE)
+		{
+			*ce.param_values[i] = ps->value._double;
+		}
+		else if (ps->type == OSCParameterDeclarations::ParameterType::PARAM_TYPE_BOOL)
+		{
+			*ce.param_values[i] = ps->value._bool ? 1.0 : 0.0;
+		}
+		else
+		{
+			// String value might hold any expression text, resolve by substitution as is
+			std::string str = ResolveParametersInString(expr);
+			ConvertOperators(str);
+			return eval_expr(str.c_str());
+		}
+	}
+
+	return eval_compiled_expr(ce.expr.get());
+}
+
 std::string Parameters::ReadAttribute(pugi::xml_node node, std::string attribute_name, bool required)
 {
 	if (!strcmp(attribute_name.c_str(), ""))
@@ -418,23 +548,14 @@ std::string Parameters::ReadAttribute(pugi::xml_node node, std::string attribute
 				if (found != std::string::npos)
 				{
 					expr = expr.substr(2, found - 2);  // trim to bare expression, exclude '{' and '}'
-					expr = ResolveParametersInString(expr);  // replace parameters by their values
 
-					// Convert from OpenSCENARIO 1.1 operator names to expr op names
-					ReplaceStringInPlace(expr, "not ", "!");
-					ReplaceStringInPlace(expr, "not(", "!(");
-					ReplaceStringInPlace(expr, "and ", "&& ");
-					ReplaceStringInPlace(expr, "or ", "|| ");
-					ReplaceStringInPlace(expr, "true ", "1 ");
-					ReplaceStringInPlace(expr, "false ", "0 ");
-
-					double value = eval_expr(expr.c_str());
+					double value = EvaluateExpression(expr);
 					if (isnan(value))
 					{
 						LOG_AND_QUIT("Failed to evaluate the expression : % s\n", attr.value());
 					}
 
-					LOG("Expr %s = %s = %.10lf", attr.value(), expr.c_str(), value);
+					LOG("Expr %s = %.10lf", attr.value(), value);
 					return std::to_string(value);
 				}
 				else
@@ -541,7 +662,16 @@ void Parameters::parseParameterDeclarations(pugi::xml_node declarationsNode, OSC
 		{
 			LOG_TRACE_AND_QUIT("Unexpected Type: %s", type_str.c_str());
 		}
+		if (pd == &parameterDeclarations_)
+		{
+			UpdateIndex();
+		}
 		pd->Parameter.insert(pd->Parameter.begin(), param);
+		if (pd == &parameterDeclarations_)
+		{
+			index_[param.name].push_back((int)pd->Parameter.size() - 1);
+			index_size_ = pd->Parameter.size();
+		}
 	}
 }
 
@@ -549,6 +679,8 @@ void Parameters::parseParameterDeclarations(pugi::xml_node declarationsNode, OSC
 void Parameters::Clear()
 {
 	parameterDeclarations_.Parameter.clear();
+	index_.clear();
+	index_size_ = 0;
 	while (!paramDeclarationsSize_.empty())
 	{
 		paramDeclarationsSize_.pop();
@@ -562,6 +694,6 @@ void Parameters::Print(std::string typestr)
 
 	for (size_t i = 0; i < parameterDeclarations_.Parameter.size(); i++)
 	{
-		LOG("   %s = %s", parameterDeclarations_.Parameter[i].name.c_str(), parameterDeclarations_.Parameter[i].value._string.c_str());
+		LOG("   %s = %s", parameterDeclarations_.Parameter[i].name.c_str(), parameterDeclarations_.Parameter[i].getString().c_str());
 	}
 }
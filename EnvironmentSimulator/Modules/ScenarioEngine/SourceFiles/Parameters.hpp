@@ -17,6 +17,9 @@
 #include "OSCParameterDeclarations.hpp"
 #include <vector>
 #include <stack>
+#include <memory>
+#include <unordered_map>
+#include "simple_expr.h"
 
 namespace scenarioengine
 {
@@ -35,7 +38,7 @@ namespace scenarioengine
 		void parseParameterDeclarations(pugi::xml_node xml_node, OSCParameterDeclarations* pd);
 		std::string getParameter(OSCParameterDeclarations& parameterDeclarations, std::string name);
 		std::string getParameter(std::string name) { return getParameter(parameterDeclarations_, name); }
-		OSCParameterDeclarations::ParameterStruct* getParameterEntry(std::string name);
+		OSCParameterDeclarations::ParameterStruct* getParameterEntry(const std::string& name);
 		int setParameter(std::string name, std::string value);
 		void addParameterDeclarations(pugi::xml_node xml_node);
 		void CreateRestorePoint();
@@ -66,5 +69,23 @@ namespace scenarioengine
 
 		// Log current set of parameter names and values
 		void Print(std::string type);
+
+	private:
+		// Expression parsed once, parameter references replaced by variables of the compiled expression
+		typedef struct
+		{
+			std::shared_ptr<compiled_expr> expr;
+			std::vector<std::string> param_names;
+			std::vector<double*> param_values;  // variables in the compiled expression, nullptr if unused
+		} CompiledExpression;
+
+		// Parameter name (without prefix) -> positions of its declarations, most recent last. Positions are
+		// counted from the end of parameterDeclarations_.Parameter, since new declarations are inserted first.
+		std::unordered_map<std::string, std::vector<int>> index_;
+		size_t index_size_ = 0;  // number of parameters indexed, to detect changes made directly to the vector
+		std::unordered_map<std::string, CompiledExpression> expressions_;  // expression text -> compiled
+
+		double EvaluateExpression(const std::string& expr);
+		void UpdateIndex();
 	};
 }
\ No newline at end of file
@@ -20,6 +20,10 @@
 
 #define WHEEL_RADIUS 0.35
 #define STAND_STILL_THRESHOLD 1e-3  // meter per second
+#define GHOST_TRAIL_TRIM_BATCH 16  // min number of vertices to remove at once, amortizing the cost of moving the rest
+#define GHOST_TRAIL_MAX_DROPPED 25  // max number of consecutive samples replaced by one trail segment
+#define GHOST_TRAIL_SPEED_TOLERANCE 0.1  // meter per second
+#define GHOST_TRAIL_HEADING_TOLERANCE 0.01  // rad
 
 using namespace scenarioengine;
 
@@ -113,8 +117,57 @@ int ScenarioEngine::InitScenario(const pugi::xml_document &xml_doc, bool disable
 	return parseScenario();
 }
 
+int ScenarioEngine::Reset()
+{
+	std::string oscFilename = scenarioReader->getScenarioFilename();
+	pugi::xml_document xml_doc;
+
+	if (oscFilename == "inline")
+	{
+		// Loaded from memory, keep a copy of the document
+		xml_doc.reset(*scenarioReader->GetDXMLDocument());
+	}
+
+	// Delete all scenario specific objects, in reverse order of creation
+	scenarioReader->UnloadControllers();
+	delete scenarioReader;
+	scenarioReader = 0;
+	storyBoard.Clear();
+	init.Clear();
+	entities_.Clear();
+	catalogs.Clear();
+	scenarioGateway.Clear();
+	collision_pair_.clear();
+	lod_focus_.clear();
+	ghost_trail_stats_ = {};
+	doOnce = true;
+
+	InitScenarioCommon(disable_controllers_);
+
+	if (oscFilename == "inline")
+	{
+		if (scenarioReader->loadOSCMem(xml_doc) != 0)
+		{
+			return init_status_ = -3;
+		}
+	}
+	else if (scenarioReader->loadOSCFile(oscFilename.c_str()) != 0)
+	{
+		LOG(("Failed to load OpenSCENARIO file " + oscFilename).c_str());
+		return init_status_ = -3;
+	}
+
+	return init_status_ = parseScenario(true);
+}
+
 ScenarioEngine::~ScenarioEngine()
 {
+	if (ghost_trail_margin_ > -SMALL_NUMBER)
+	{
+		const GhostTrailStats& stats = GetGhostTrailStats();
+		LOG("Ghost trails: %d vertices (%d bytes), max %d in one trail, %d decimated, %d trimmed",
+			stats.n_vertices, static_cast<int>(stats.bytes), stats.n_vertices_max, stats.n_decimated, stats.n_trimmed);
+	}
 	scenarioReader->UnloadControllers();
 	delete scenarioReader;
 	scenarioReader = 0;
@@ -513,10 +566,17 @@ int ScenarioEngine::step(double deltaSimTime)
 		trueTime_ = simulationTime_;
 	}
 
+	UpdateLOD(deltaSimTime);
+
 	for (size_t i = 0; i < entities_.object_.size(); i++)
 	{
 		Object* obj = entities_.object_[i];
 
+		if (obj->lod_skip_)
+		{
+			continue;  // far away, wait for next low level of detail update
+		}
+
 		// Fetch states from gateway (if available), indicated by dirty bits
 		ObjectState* o = scenarioGateway.getObjectStatePtrById(obj->id_);
 		if (o != nullptr)
@@ -542,7 +602,15 @@ int ScenarioEngine::step(double deltaSimTime)
 
 		// Do not move objects when speed is zero,
 		// and only ghosts allowed to execute during ghost (restart
-		if (!(obj->IsControllerActiveOnDomains(ControlDomains::DOMAIN_BOTH) && obj->GetControllerMode() == Controller::Mode::MODE_OVERRIDE) &&
+		if (obj->lod_low_ || obj->lod_dt_ > deltaSimTime + SMALL_NUMBER)
+		{
+			// Far away, or just entered focus region and need to catch up on time not simulated since last update
+			if (fabs(obj->speed_) > SMALL_NUMBER && !obj->TowVehicle())
+			{
+				lodController(obj, obj->lod_dt_);
+			}
+		}
+		else if (!(obj->IsControllerActiveOnDomains(ControlDomains::DOMAIN_BOTH) && obj->GetControllerMode() == Controller::Mode::MODE_OVERRIDE) &&
 			fabs(obj->speed_) > SMALL_NUMBER &&
 			// Skip update for non ghost objects during ghost restart
 			!(!obj->IsGhost() && ghost_mode_ == GhostMode::RESTARTING) &&
@@ -621,7 +689,8 @@ int ScenarioEngine::step(double deltaSimTime)
 	{
 		if (scenarioReader->controller_[i]->Active())
 		{
-			if (ghost_mode_ != GhostMode::RESTARTING)
+			Object* obj = scenarioReader->controller_[i]->GetRoadObject();
+			if (ghost_mode_ != GhostMode::RESTARTING && !(obj && obj->lod_low_))
 			{
 				scenarioReader->controller_[i]->Step(deltaSimTime);
 			}
@@ -635,7 +704,7 @@ int ScenarioEngine::step(double deltaSimTime)
 		Object* obj = entities_.object_[i];
 		Vehicle* trailer = (Vehicle*)obj->TrailerVehicle();
 
-		if (!obj->TowVehicle() && obj->TrailerVehicle())
+		if (!obj->TowVehicle() && obj->TrailerVehicle() && !obj->lod_skip_)
 		{
 			// Found a front tow vehicle, update trailers
 			Vehicle* tow_vehicle = (Vehicle*)obj;
@@ -665,6 +734,11 @@ int ScenarioEngine::step(double deltaSimTime)
 	{
 		Object* obj = entities_.object_[i];
 
+		if (obj->lod_low_)
+		{
+			continue;
+		}
+
 		// Off road?
 		if (obj->pos_.IsOffRoad())
 		{
@@ -719,7 +793,7 @@ ScenarioGateway *ScenarioEngine::getScenarioGateway()
 	return &scenarioGateway;
 }
 
-int ScenarioEngine::parseScenario()
+int ScenarioEngine::parseScenario(bool reuse_road_network)
 {
 	SetSimulationTime(0);
 	SetTrueTime(0);
@@ -774,7 +848,12 @@ int ScenarioEngine::parseScenario()
 			if (FileExists(file_name_candidates[i].c_str()))
 			{
 				located = true;
-				if (roadmanager::Position::LoadOpenDrive(file_name_candidates[i].c_str()) == true)
+				if (reuse_road_network && roadmanager::Position::GetOpenDrive()->GetOpenDriveFilename() == file_name_candidates[i])
+				{
+					LOG("Reusing OpenDRIVE: %s", file_name_candidates[i].c_str());
+					break;
+				}
+				else if (roadmanager::Position::LoadOpenDrive(file_name_candidates[i].c_str()) == true)
 				{
 					LOG("Loaded OpenDRIVE: %s", file_name_candidates[i].c_str());
 					break;
@@ -840,6 +919,30 @@ int ScenarioEngine::parseScenario()
 		}
 	}
 
+	// Entities referenced by conditions are kept at full level of detail
+	MarkLODReferencedObjects(storyBoard.stop_trigger_);
+	for (size_t i = 0; i < storyBoard.story_.size(); i++)
+	{
+		Story* story = storyBoard.story_[i];
+		for (size_t j = 0; j < story->act_.size(); j++)
+		{
+			Act* act = story->act_[j];
+			MarkLODReferencedObjects(act->start_trigger_);
+			MarkLODReferencedObjects(act->stop_trigger_);
+			for (size_t k = 0; k < act->maneuverGroup_.size(); k++)
+			{
+				for (size_t l = 0; l < act->maneuverGroup_[k]->maneuver_.size(); l++)
+				{
+					Maneuver* maneuver = act->maneuverGroup_[k]->maneuver_[l];
+					for (size_t m = 0; m < maneuver->event_.size(); m++)
+					{
+						MarkLODReferencedObjects(maneuver->event_[m]->start_trigger_);
+					}
+				}
+			}
+		}
+	}
+
 	// Align trailers
 	for (size_t i = 0; i < entities_.object_.size(); i++)
 	{
@@ -894,14 +997,358 @@ int ScenarioEngine::defaultController(Object* obj, double dt)
 	return retval == -1 ? -1 : 0;
 }
 
+void ScenarioEngine::SetLOD(double radius, int interval)
+{
+	lod_radius_ = MAX(0.0, radius);
+	lod_interval_ = MAX(1, interval);
+}
+
+void ScenarioEngine::SetGhostTrailBound(double margin, double tolerance)
+{
+	ghost_trail_margin_ = margin < 0.0 ? -1.0 : margin;
+	ghost_trail_tolerance_ = MAX(0.0, tolerance);
+}
+
+const GhostTrailStats& ScenarioEngine::GetGhostTrailStats()
+{
+	ghost_trail_stats_.n_vertices = 0;
+	ghost_trail_stats_.bytes = 0;
+
+	for (size_t i = 0; i < entities_.object_.size(); i++)
+	{
+		Object* obj = entities_.object_[i];
+		if (obj->IsGhost())
+		{
+			ghost_trail_stats_.n_vertices += obj->trail_.GetNumberOfVertices();
+			ghost_trail_stats_.bytes += (obj->trail_.vertex_.capacity() + obj->trail_dropped_.capacity()) * sizeof(roadmanager::TrajVertex);
+		}
+	}
+
+	return ghost_trail_stats_;
+}
+
+// Check whether a sample is represented by the trail segment v0 - v1, interpolating by time
+static bool TrailSegmentCoversSample(const roadmanager::TrajVertex& v0, const roadmanager::TrajVertex& v1,
+	const roadmanager::TrajVertex& sample, double tolerance)
+{
+	if (v1.time - v0.time < SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	double a = (sample.time - v0.time) / (v1.time - v0.time);
+	double x = v0.x + a * (v1.x - v0.x);
+	double y = v0.y + a * (v1.y - v0.y);
+	double z = v0.z + a * (v1.z - v0.z);
+	double h = v0.h + a * GetAngleDifference(v1.h, v0.h);
+	double speed = v0.speed + a * (v1.speed - v0.speed);
+
+	return PointSquareDistance2D(x, y, sample.x, sample.y) < tolerance * tolerance &&
+		fabs(z - sample.z) < tolerance &&
+		fabs(speed - sample.speed) < GHOST_TRAIL_SPEED_TOLERANCE &&
+		fabs(GetAngleDifference(h, sample.h)) < GHOST_TRAIL_HEADING_TOLERANCE;
+}
+
+void ScenarioEngine::AddTrailVertex(Object* obj)
+{
+	roadmanager::PolyLineBase& trail = obj->trail_;
+	roadmanager::TrajVertex v = { 0.0, obj->pos_.GetX(), obj->pos_.GetY(), obj->pos_.GetZ(), obj->pos_.GetH(), simulationTime_, obj->GetSpeed(), 0.0, false };
+
+	if (!obj->IsGhost() || ghost_trail_margin_ < -SMALL_NUMBER)
+	{
+		trail.AddVertex(v);
+		return;
+	}
+
+	if (trail.GetNumberOfVertices() == 0)
+	{
+		// Reserve for the time window, including vertices waiting to be trimmed
+		int n = static_cast<int>((obj->GetHeadstartTime() + ghost_trail_margin_) / GHOST_TRAIL_SAMPLE_TIME);
+		trail.vertex_.reserve(static_cast<size_t>(n + n / 2 + GHOST_TRAIL_TRIM_BATCH + 2));
+		obj->trail_dropped_.clear();
+	}
+
+	bool drop = false;
+	if (ghost_trail_tolerance_ > SMALL_NUMBER && trail.GetNumberOfVertices() > 1 && obj->trail_dropped_.size() < GHOST_TRAIL_MAX_DROPPED)
+	{
+		// Last vertex can be dropped if the segment from the one before to the new sample covers it,
+		// as well as all samples dropped since then
+		roadmanager::TrajVertex* anchor = trail.GetVertex(trail.GetNumberOfVertices() - 2);
+		roadmanager::TrajVertex* last = trail.GetVertex(-1);
+
+		drop = TrailSegmentCoversSample(*anchor, v, *last, ghost_trail_tolerance_);
+		for (size_t i = 0; drop && i < obj->trail_dropped_.size(); i++)
+		{
+			drop = TrailSegmentCoversSample(*anchor, v, obj->trail_dropped_[i], ghost_trail_tolerance_);
+		}
+	}
+
+	if (drop)
+	{
+		obj->trail_dropped_.push_back(*trail.GetVertex(-1));
+		trail.RemoveLastVertex();
+		ghost_trail_stats_.n_decimated++;
+
+		for (size_t i = 0; i < entities_.object_.size(); i++)
+		{
+			if (entities_.object_[i]->GetGhost() == obj)
+			{
+				entities_.object_[i]->trail_follow_index_ = MIN(entities_.object_[i]->trail_follow_index_, trail.GetNumberOfVertices() - 1);
+			}
+		}
+	}
+	else
+	{
+		obj->trail_dropped_.clear();
+	}
+
+	trail.AddVertex(v);
+	TrimGhostTrail(obj);
+
+	ghost_trail_stats_.n_vertices_max = MAX(ghost_trail_stats_.n_vertices_max, trail.GetNumberOfVertices());
+}
+
+void ScenarioEngine::TrimGhostTrail(Object* ghost)
+{
+	roadmanager::PolyLineBase& trail = ghost->trail_;
+	double time_min = trail.GetVertex(-1)->time - ghost->GetHeadstartTime() - ghost_trail_margin_;
+
+	// Keep the last vertex before the time window, needed for interpolation
+	auto it = std::upper_bound(trail.vertex_.begin(), trail.vertex_.end(), time_min,
+		[](double value, const roadmanager::TrajVertex& v) { return value < v.time; });
+	int n = static_cast<int>(it - trail.vertex_.begin()) - 1;
+
+	// Never remove segments still in use by any follower
+	for (size_t i = 0; i < entities_.object_.size(); i++)
+	{
+		if (entities_.object_[i]->GetGhost() == ghost)
+		{
+			n = MIN(n, entities_.object_[i]->trail_follow_index_);
+		}
+	}
+
+	if (n < MAX(GHOST_TRAIL_TRIM_BATCH, trail.GetNumberOfVertices() / 4))
+	{
+		return;
+	}
+
+	trail.RemoveFirstVertices(n);
+	ghost_trail_stats_.n_trimmed += n;
+
+	for (size_t i = 0; i < entities_.object_.size(); i++)
+	{
+		if (entities_.object_[i]->GetGhost() == ghost)
+		{
+			entities_.object_[i]->trail_follow_index_ -= n;
+		}
+	}
+}
+
+void ScenarioEngine::AddLODFocus(Object* obj)
+{
+	if (obj && std::find(lod_focus_.begin(), lod_focus_.end(), obj) == lod_focus_.end())
+	{
+		lod_focus_.push_back(obj);
+	}
+}
+
+bool ScenarioEngine::IsLODCandidate(Object* obj)
+{
+	if (obj->IsGhost() || obj->GetGhost() || !obj->objectEvents_.empty() || obj->lod_referenced_)
+	{
+		return false;
+	}
+
+	// Protect states reported externally or set by actions this frame
+	if (obj->CheckDirtyBits(Object::DirtyBit::LATERAL | Object::DirtyBit::LONGITUDINAL | Object::DirtyBit::SPEED))
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < obj->initActions_.size(); i++)
+	{
+		if (obj->initActions_[i]->IsActive())
+		{
+			return false;
+		}
+	}
+
+	// Simple driver models, like the one of swarm traffic, can be replaced by lane following
+	if (obj->controller_ && obj->controller_->Active() && obj->controller_->GetType() != Controller::Type::CONTROLLER_TYPE_ACC)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+// Return object a position is relative to, if any
+static Object* GetPositionObject(OSCPosition* position)
+{
+	if (position == nullptr)
+	{
+		return nullptr;
+	}
+
+	switch (position->type_)
+	{
+	case OSCPosition::PositionType::RELATIVE_OBJECT:
+		return ((OSCPositionRelativeObject*)position)->object_;
+	case OSCPosition::PositionType::RELATIVE_WORLD:
+		return ((OSCPositionRelativeWorld*)position)->object_;
+	case OSCPosition::PositionType::RELATIVE_LANE:
+		return ((OSCPositionRelativeLane*)position)->object_;
+	case OSCPosition::PositionType::RELATIVE_ROAD:
+		return ((OSCPositionRelativeRoad*)position)->object_;
+	default:
+		return nullptr;
+	}
+}
+
+void ScenarioEngine::MarkLODReferencedObjects(Trigger* trigger)
+{
+	if (trigger == nullptr)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < trigger->conditionGroup_.size(); i++)
+	{
+		for (size_t j = 0; j < trigger->conditionGroup_[i]->condition_.size(); j++)
+		{
+			OSCCondition* cond = trigger->conditionGroup_[i]->condition_[j];
+			if (cond->base_type_ != OSCCondition::ConditionType::BY_ENTITY)
+			{
+				continue;
+			}
+
+			TrigByEntity* trig = (TrigByEntity*)cond;
+			std::vector<Object*> refs;
+			for (size_t k = 0; k < trig->triggering_entities_.entity_.size(); k++)
+			{
+				refs.push_back(trig->triggering_entities_.entity_[k].object_);
+			}
+
+			// Entities the condition measures against, a simplified one would give imprecise results
+			switch (trig->type_)
+			{
+			case TrigByEntity::EntityConditionType::TIME_HEADWAY:
+				refs.push_back(((TrigByTimeHeadway*)trig)->object_);
+				break;
+			case TrigByEntity::EntityConditionType::TIME_TO_COLLISION:
+				refs.push_back(((TrigByTimeToCollision*)trig)->object_);
+				refs.push_back(GetPositionObject(((TrigByTimeToCollision*)trig)->position_.get()));
+				break;
+			case TrigByEntity::EntityConditionType::RELATIVE_DISTANCE:
+				refs.push_back(((TrigByRelativeDistance*)trig)->object_);
+				break;
+			case TrigByEntity::EntityConditionType::RELATIVE_SPEED:
+				refs.push_back(((TrigByRelativeSpeed*)trig)->object_);
+				break;
+			case TrigByEntity::EntityConditionType::COLLISION:
+				refs.push_back(((TrigByCollision*)trig)->object_);
+				break;
+			case TrigByEntity::EntityConditionType::REACH_POSITION:
+				refs.push_back(GetPositionObject(((TrigByReachPosition*)trig)->position_.get()));
+				break;
+			case TrigByEntity::EntityConditionType::DISTANCE:
+				refs.push_back(GetPositionObject(((TrigByDistance*)trig)->position_.get()));
+				break;
+			default:
+				break;
+			}
+
+			for (size_t k = 0; k < refs.size(); k++)
+			{
+				if (refs[k] != nullptr)
+				{
+					refs[k]->lod_referenced_ = true;
+				}
+			}
+		}
+	}
+}
+
+void ScenarioEngine::UpdateLOD(double dt)
+{
+	bool enabled = lod_radius_ > SMALL_NUMBER && frame_nr_ > 0 && ghost_mode_ == GhostMode::NORMAL;
+
+	if (!enabled)
+	{
+		for (size_t i = 0; i < entities_.object_.size(); i++)
+		{
+			Object* obj = entities_.object_[i];
+			obj->lod_low_ = false;
+			obj->lod_skip_ = false;
+			obj->lod_dt_ = 0.0;
+		}
+		return;
+	}
+
+	if (lod_focus_.empty() && !entities_.object_.empty())
+	{
+		lod_focus_.push_back(entities_.object_[0]);
+	}
+
+	for (size_t i = 0; i < entities_.object_.size(); i++)
+	{
+		Object* obj = entities_.object_[i];
+
+		// Trailers follow their tow vehicle
+		Object* head = obj;
+		while (head->TowVehicle())
+		{
+			head = head->TowVehicle();
+		}
+
+		bool low = std::find(lod_focus_.begin(), lod_focus_.end(), head) == lod_focus_.end() && IsLODCandidate(head);
+		for (size_t j = 0; low && j < lod_focus_.size(); j++)
+		{
+			if (lod_focus_[j]->IsActive() && PointSquareDistance2D(head->pos_.GetX(), head->pos_.GetY(),
+				lod_focus_[j]->pos_.GetX(), lod_focus_[j]->pos_.GetY()) < lod_radius_ * lod_radius_)
+			{
+				low = false;
+			}
+		}
+
+		if (!obj->lod_skip_)
+		{
+			obj->lod_dt_ = 0.0;
+		}
+		obj->lod_dt_ += dt;
+
+		obj->lod_low_ = low;
+
+		// Spread updates evenly over frames
+		obj->lod_skip_ = low && (frame_nr_ + static_cast<unsigned int>(head->GetId())) % static_cast<unsigned int>(lod_interval_) != 0;
+	}
+}
+
+int ScenarioEngine::lodController(Object* obj, double dt)
+{
+	if (obj->MoveAlongS(obj->speed_ * dt, true) == roadmanager::Position::ReturnCode::ERROR_GENERIC)
+	{
+		// Couldn't move vehicle forward. Stop.
+		obj->SetSpeed(0.0);
+	}
+	obj->SetDirtyBits(Object::DirtyBit::LONGITUDINAL | Object::DirtyBit::LATERAL | Object::DirtyBit::SPEED);
+
+	return 0;
+}
+
 void ScenarioEngine::prepareGroundTruth(double dt)
 {
 	for (size_t i = 0; i < entities_.object_.size(); i++)
 	{
 		// Fetch external states from gateway
 		Object* obj = entities_.object_[i];
-		ObjectState* o = scenarioGateway.getObjectStatePtrById(obj->id_);
 
+		if (obj->lod_skip_)
+		{
+			continue;  // not updated this frame, keep state
+		}
+
+		ObjectState* o = scenarioGateway.getObjectStatePtrById(obj->id_);
 
 		if (o == nullptr)
 		{
@@ -931,19 +1378,22 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 			}
 		}
 
+		// Time since last update, longer than dt for entities at low level of detail
+		double obj_dt = MAX(dt, obj->lod_dt_);
+
 		// Calculate resulting updated velocity, acceleration and heading rate (rad/s) NOTE: in global coordinate sys
 		double dx = obj->pos_.GetX() - obj->state_old.pos_x;
 		double dy = obj->pos_.GetY() - obj->state_old.pos_y;
 
 		if (frame_nr_ == 1 || obj->IsGhost() && ghost_mode_ != GhostMode::RESTART || !obj->IsGhost() && ghost_mode_ != GhostMode::RESTARTING)
 		{
-			if (dt > SMALL_NUMBER)
+			if (obj_dt > SMALL_NUMBER)
 			{
 				// If velocity has not been reported, calculate it based on movement
 				if (!obj->CheckDirtyBits(Object::DirtyBit::VELOCITY))
 				{
 					// If not already reported, calculate linear velocity
-					obj->SetVel(dx / dt, dy / dt, 0.0);
+					obj->SetVel(dx / obj_dt, dy / obj_dt, 0.0);
 				}
 
 				// If speed has not been reported or set by any controller, calculate it based on velocity
@@ -955,10 +1405,10 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 				if (!obj->CheckDirtyBits(Object::DirtyBit::ACCELERATION))
 				{
 					// If not already reported, calculate linear acceleration
-					obj->SetAcc((obj->pos_.GetVelX() - obj->state_old.vel_x) / dt, (obj->pos_.GetVelY() - obj->state_old.vel_y) / dt, 0.0);
+					obj->SetAcc((obj->pos_.GetVelX() - obj->state_old.vel_x) / obj_dt, (obj->pos_.GetVelY() - obj->state_old.vel_y) / obj_dt, 0.0);
 				}
 
-				double heading_rate_new = GetAngleDifference(obj->pos_.GetH(), obj->state_old.h) / dt;
+				double heading_rate_new = GetAngleDifference(obj->pos_.GetH(), obj->state_old.h) / obj_dt;
 				if (!obj->CheckDirtyBits(Object::DirtyBit::ANGULAR_RATE))
 				{
 					// If not already reported, calculate angular velocity/rate
@@ -968,7 +1418,7 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 				if (!obj->CheckDirtyBits(Object::DirtyBit::ANGULAR_ACC))
 				{
 					// If not already reported, calculate angular acceleration
-					obj->SetAngularAcc(GetAngleDifference(heading_rate_new, obj->state_old.h_rate) / dt, 0.0, 0.0);
+					obj->SetAngularAcc(GetAngleDifference(heading_rate_new, obj->state_old.h_rate) / obj_dt, 0.0, 0.0);
 				}
 
 				// Update wheel rotations of internal scenario objects
@@ -979,7 +1429,7 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 					double steeringAngleDiff = steeringAngleTarget - obj->wheel_angle_;
 
 					// Turn wheel gradually towards target
-					double steeringAngleStep = SIGN(steeringAngleDiff) * MIN(abs(steeringAngleDiff), 0.5 * dt);
+					double steeringAngleStep = SIGN(steeringAngleDiff) * MIN(abs(steeringAngleDiff), 0.5 * obj_dt);
 
 					obj->wheel_angle_ += steeringAngleStep;
 					obj->SetDirtyBits(Object::DirtyBit::WHEEL_ANGLE);
@@ -987,7 +1437,7 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 
 				if (!obj->CheckDirtyBits(Object::DirtyBit::WHEEL_ROTATION))
 				{
-					obj->wheel_rot_ = fmod(obj->wheel_rot_ + obj->speed_ * dt / WHEEL_RADIUS, 2 * M_PI);
+					obj->wheel_rot_ = fmod(obj->wheel_rot_ + obj->speed_ * obj_dt / WHEEL_RADIUS, 2 * M_PI);
 					obj->SetDirtyBits(Object::DirtyBit::WHEEL_ROTATION);
 				}
 			}
@@ -1031,7 +1481,7 @@ void ScenarioEngine::prepareGroundTruth(double dt)
 					// Only add trail vertex when speed is not stable at 0
 					if (obj->trail_.GetNumberOfVertices() == 0 || fabs(obj->trail_.GetVertex(-1)->speed) > SMALL_NUMBER || fabs(obj->GetSpeed()) > SMALL_NUMBER)
 					{
-						obj->trail_.AddVertex({ 0.0, obj->pos_.GetX(), obj->pos_.GetY(), obj->pos_.GetZ(), obj->pos_.GetH(), simulationTime_, obj->GetSpeed(), 0.0, false });
+						AddTrailVertex(obj);
 					}
 				}
 			}
@@ -1304,6 +1754,10 @@ int ScenarioEngine::DetectCollisions()
 		for (size_t j = i+1; j < entities_.object_.size(); j++)
 		{
 			Object* obj1 = entities_.object_[j];
+			if (obj0->lod_low_ && obj1->lod_low_)
+			{
+				continue;  // both far away, keep any collision state until one of them is back at full level of detail
+			}
 			if (obj0->Collision(obj1))
 			{
 				collision_pair_.push_back({ obj0, obj1 });
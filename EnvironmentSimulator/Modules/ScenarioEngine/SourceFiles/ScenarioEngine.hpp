@@ -44,6 +44,15 @@ namespace scenarioengine
 		Object* object1;
 	} CollisionPair;
 
+	typedef struct
+	{
+		int n_vertices;  // current number of vertices in all ghost trails
+		int n_vertices_max;  // max number of vertices in any ghost trail at any time
+		int n_decimated;  // number of vertices dropped by decimation
+		int n_trimmed;  // number of vertices removed from start of trails
+		size_t bytes;  // memory allocated for ghost trail vertices
+	} GhostTrailStats;
+
 	enum class GhostMode
 	{
 		NORMAL,
@@ -65,6 +74,13 @@ namespace scenarioengine
 		int InitScenario(std::string oscFilename, bool disable_controllers = false);
 		int InitScenario(const pugi::xml_document &xml_doc, bool disable_controllers = false);
 
+		/**
+			Re-initialize the scenario from its start, e.g. with parameter values of another permutation.
+			Storyboard, entities and controllers are recreated. An already loaded OpenDRIVE is kept.
+			@return 0 on success, else error code as from InitScenario
+		*/
+		int Reset();
+
 		int step(double deltaSimTime);
 		void printSimulationTime();
 		void prepareGroundTruth(double dt);
@@ -75,6 +91,38 @@ namespace scenarioengine
 		void ResetEvents();
 		int DetectCollisions();
 
+		/**
+			Simulate entities far from all focus objects at a reduced level of detail (LOD). Such entities are only
+			updated every n:th frame, moved along their lane at constant speed. Controllers, collision checks and
+			states like off road are skipped for them. They are brought back to full detail when entering the radius.
+			Only entities not subject to any action or external/interactive control are simplified. Entities referenced
+			by any condition, as triggering entity or as reference, are always simulated at full detail.
+			@param radius Distance (m) from focus objects beyond which entities are simplified, 0 = disabled
+			@param interval Number of frames between updates of simplified entities
+		*/
+		void SetLOD(double radius, int interval);
+		double GetLODRadius() { return lod_radius_; }
+		int GetLODInterval() { return lod_interval_; }
+
+		/**
+			Register an object, e.g. Ego, a sensor host or the camera target, around which entities are simulated
+			at full level of detail. If no focus objects are registered, the first object is used.
+		*/
+		void AddLODFocus(Object* obj);
+		void ClearLODFocus() { lod_focus_.clear(); }
+
+		/**
+			Bound the trail of ghosts to the headstart time window plus a margin. Older vertices are removed, except
+			the ones still in use by any object following the ghost. Optionally vertices on straight and steady
+			parts of the trail are dropped, as long as the trail deviates less than the tolerance from the samples.
+			@param margin Time (s) kept in addition to headstart time, < 0 = unbounded (default)
+			@param tolerance Max deviation (m) of decimated trail from sampled positions, 0 = no decimation
+		*/
+		void SetGhostTrailBound(double margin, double tolerance);
+		double GetGhostTrailMargin() { return ghost_trail_margin_; }
+		double GetGhostTrailTolerance() { return ghost_trail_tolerance_; }
+		const GhostTrailStats& GetGhostTrailStats();
+
 		std::string getScenarioFilename() { return scenarioReader->getScenarioFilename(); }
 		std::string getSceneGraphFilename() { return roadNetwork.sceneGraphFile.filepath; }
 		std::string getOdrFilename() { return roadNetwork.logicFile.filepath; }
@@ -123,7 +171,23 @@ namespace scenarioengine
 		unsigned int frame_nr_;
 		int init_status_;
 
-		int parseScenario();
+		// level of detail
+		double lod_radius_ = 0.0;
+		int lod_interval_ = 1;
+		std::vector<Object*> lod_focus_;
+
+		// ghost trail bounds
+		double ghost_trail_margin_ = -1.0;
+		double ghost_trail_tolerance_ = 0.0;
+		GhostTrailStats ghost_trail_stats_ = {};
+
+		int parseScenario(bool reuse_road_network = false);
+		bool IsLODCandidate(Object* obj);
+		void MarkLODReferencedObjects(Trigger* trigger);
+		void UpdateLOD(double dt);
+		int lodController(Object* obj, double dt);
+		void AddTrailVertex(Object* obj);
+		void TrimGhostTrail(Object* ghost);
 	};
 
 }
@@ -11,6 +11,7 @@
  */
 
 #include "ScenarioGateway.hpp"
+#include "DatFile.hpp"
 #include "CommonMini.hpp"
 
 #ifdef _WIN32
@@ -193,39 +194,76 @@ ScenarioGateway::ScenarioGateway()
 }
 
 ScenarioGateway::~ScenarioGateway()
+{
+	Clear();
+}
+
+void ScenarioGateway::Clear()
 {
 	objectState_.clear();
+	objectIndex_.clear();
 
-	data_file_.flush();
-	data_file_.close();
+	// Any buffered data is written before the file is closed
+	data_file_.Close();
+	dat_encoder_.reset();
 }
 
 ObjectState* ScenarioGateway::getObjectStatePtrById(int id)
 {
-	for (size_t i = 0; i < objectState_.size(); i++)
+	if (objectIndex_.size() != objectState_.size())
 	{
-		if (objectState_[i]->state_.info.id == id)
+		// Collection modified from outside, e.g. cleared
+		updateObjectIndex();
+	}
+
+	auto it = objectIndex_.find(id);
+	if (it == objectIndex_.end())
+	{
+		return 0;
+	}
+
+	if (it->second >= objectState_.size() || objectState_[it->second]->state_.info.id != id)
+	{
+		// Index outdated, rebuild and try again
+		updateObjectIndex();
+		it = objectIndex_.find(id);
+		if (it == objectIndex_.end())
 		{
-			return objectState_[i].get();
+			return 0;
 		}
 	}
 
-	return 0;
+	return objectState_[it->second].get();
 }
 
 int ScenarioGateway::getObjectStateById(int id, ObjectState& objectState)
 {
-	for (size_t i = 0; i < objectState_.size(); i++)
+	ObjectState* obj_state = getObjectStatePtrById(id);
+
+	if (obj_state == 0)
 	{
-		if (objectState_[i]->state_.info.id == id)
-		{
-			objectState = *objectState_[i];
-			return 0;
-		}
+		// Indicate not found by returning non zero
+		return -1;
 	}
 
-	// Indicate not found by returning non zero
-	return -1;
+	objectState = *obj_state;
+
+	return 0;
+}
+
+void ScenarioGateway::addObjectState(ObjectState* obj_state)
+{
+	objectIndex_[obj_state->state_.info.id] = objectState_.size();
+	objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+}
+
+void ScenarioGateway::updateObjectIndex()
+{
+	objectIndex_.clear();
+	for (size_t i = 0; i < objectState_.size(); i++)
+	{
+		objectIndex_[objectState_[i]->state_.info.id] = i;
+	}
 }
 
 int ScenarioGateway::updateObjectInfo(ObjectState* obj_state, double timestamp, int visibilityMask,
@@ -263,7 +301,7 @@ int ScenarioGateway::reportObject(int id, std::string name, int obj_type, int ob
 			scaleMode, visibilityMask, timestamp, speed, wheel_angle, wheel_rot, rear_axle_z_pos, pos);
 
 		// Add object to collection
-		objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+		addObjectState(obj_state);
 	}
 	else
 	{
@@ -293,7 +331,7 @@ int ScenarioGateway::reportObject(int id, std::string name, int obj_type, int ob
 			scaleMode, visibilityMask, timestamp, speed, wheel_angle, wheel_rot, rear_axle_z_pos, x, y, z, h, p, r);
 
 		// Add object to collection
-		objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+		addObjectState(obj_state);
 	}
 	else
 	{
@@ -323,7 +361,7 @@ int ScenarioGateway::reportObject(int id, std::string name, int obj_type, int ob
 			scaleMode, visibilityMask, timestamp, speed, wheel_angle, wheel_rot, rear_axle_z_pos, x, y, 0, h, 0, 0);
 
 		// Add object to collection
-		objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+		addObjectState(obj_state);
 	}
 	else
 	{
@@ -354,7 +392,7 @@ int ScenarioGateway::reportObject(int id, std::string name, int obj_type, int ob
 			laneId, laneOffset, s);
 
 		// Add object to collection
-		objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+		addObjectState(obj_state);
 	}
 	else
 	{
@@ -384,7 +422,7 @@ int ScenarioGateway::reportObject(int id, std::string name, int obj_type, int ob
 			visibilityMask, timestamp, speed, wheel_angle, wheel_rot, rear_axle_z_pos, roadId, lateralOffset, s);
 
 		// Add object to collection
-		objectState_.push_back(std::unique_ptr<ObjectState>{obj_state});
+		addObjectState(obj_state);
 	}
 	else
 	{
@@ -664,6 +702,7 @@ void ScenarioGateway::removeObject(int id)
 			++objectIt;
 		}
 	}
+	updateObjectIndex();
 }
 
 void ScenarioGateway::removeObject(std::string name)
@@ -677,16 +716,18 @@ void ScenarioGateway::removeObject(std::string name)
 			++objectIt;
 		}
 	}
+	updateObjectIndex();
 }
 
 void ScenarioGateway::WriteStatesToFile()
 {
-	if (data_file_.is_open())
+	if (data_file_.IsOpen())
 	{
 		// Write status to file - for later replay
+		dat_states_.resize(objectState_.size());
 		for (size_t i = 0; i < objectState_.size(); i++)
 		{
-			struct ObjectStateStructDat datState;
+			struct ObjectStateStructDat& datState = dat_states_[i];
 
 			datState.info.boundingbox = objectState_[i]->state_.info.boundingbox;
 			datState.info.ctrl_type = objectState_[i]->state_.info.ctrl_type;
@@ -714,8 +755,12 @@ void ScenarioGateway::WriteStatesToFile()
 			datState.pos.offset = (float)objectState_[i]->state_.pos.GetOffset();
 			datState.pos.t = (float)objectState_[i]->state_.pos.GetT();
 			datState.pos.s = (float)objectState_[i]->state_.pos.GetS();
-			data_file_.write((char*)(&datState), sizeof(datState));
 		}
+
+		// Encode into staging buffer, handed to the background writer
+		dat_buffer_.clear();
+		dat_encoder_->Encode(dat_states_.data(), dat_states_.size(), dat_buffer_);
+		data_file_.Write(dat_buffer_.data(), dat_buffer_.size());
 	}
 }
 
@@ -723,8 +768,7 @@ int ScenarioGateway::RecordToFile(std::string filename, std::string odr_filename
 {
 	if (!filename.empty())
 	{
-		data_file_.open(filename, std::ofstream::binary);
-		if (data_file_.fail())
+		if (data_file_.Open(filename) != 0)
 		{
 			LOG("Cannot open file: %s", filename.c_str());
 			return -1;
@@ -734,7 +778,9 @@ int ScenarioGateway::RecordToFile(std::string filename, std::string odr_filename
 		strncpy(header.odr_filename, odr_filename.c_str(), DAT_FILENAME_SIZE);
 		strncpy(header.model_filename, model_filename.c_str(), DAT_FILENAME_SIZE);
 
-		data_file_.write((char*)&header, sizeof(header));
+		data_file_.Write((char*)&header, sizeof(header));
+
+		dat_encoder_ = std::unique_ptr<DatEncoder>(new DatEncoder);
 	}
 
 	return 0;
@@ -11,11 +11,13 @@
  */
 
 #pragma once
+#include <unordered_map>
 #include "RoadManager.hpp"
 #include "OSCBoundingBox.hpp"
 #include "Entities.hpp"
 
-#define DAT_FILE_FORMAT_VERSION 2
+#define DAT_FILE_FORMAT_VERSION 3  // delta encoded, see DatFile.hpp
+#define DAT_FILE_FORMAT_VERSION_V2 2  // one full ObjectStateStructDat per object and frame, still readable
 #define DAT_FILENAME_SIZE 512
 
 
@@ -24,6 +26,8 @@ namespace scenarioengine
 
 #define NAME_LEN 32
 
+	class DatEncoder;
+
 	struct ObjectInfoStruct
 	{
 		int id;
@@ -129,6 +133,9 @@ namespace scenarioengine
 		ScenarioGateway();
 		~ScenarioGateway();
 
+		// Remove all object states and stop any recording
+		void Clear();
+
 		int reportObject(int id, std::string name, int obj_type, int obj_category, int model_id, int ctrl_type,
 			OSCBoundingBox boundingbox, int scaleMode, int visibilityMask, double timestamp, double speed,
 			double wheel_angle, double wheel_rot, double rear_axle_z_pos, roadmanager::Position *pos);
@@ -181,7 +188,13 @@ namespace scenarioengine
 
 	private:
 		int updateObjectInfo(ObjectState* obj_state, double timestamp, int visibilityMask, double speed, double wheel_angle, double wheel_rot);
-		std::ofstream data_file_;
+		void addObjectState(ObjectState* obj_state);
+		void updateObjectIndex();
+		std::unordered_map<int, size_t> objectIndex_;  // index in objectState_ per object id
+		SE_AsyncFileWriter data_file_;
+		std::unique_ptr<DatEncoder> dat_encoder_;
+		std::vector<ObjectStateStructDat> dat_states_;
+		std::vector<char> dat_buffer_;
 	};
 
 }
@@ -54,6 +54,12 @@ ScenarioReader::~ScenarioReader()
 		delete controller_[i];
 	}
 	controller_.clear();
+
+	for (size_t i = 0; i < released_controllers_.size(); i++)
+	{
+		delete released_controllers_[i];
+	}
+	released_controllers_.clear();
 }
 
 void ScenarioReader::LoadControllers()
@@ -95,6 +101,38 @@ int ScenarioReader::RemoveController(Controller* controller)
 	return -1;
 }
 
+int ScenarioReader::ReleaseController(Controller* controller)
+{
+	for (size_t i = 0; i < controller_.size(); i++)
+	{
+		if (controller_[i] == controller)
+		{
+			controller_.erase(controller_.begin() + i);
+			released_controllers_.push_back(controller);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+Controller* ScenarioReader::ReuseController(int type)
+{
+	// Search from the back, most recently released first
+	for (int i = static_cast<int>(released_controllers_.size()) - 1; i >= 0; i--)
+	{
+		if (released_controllers_[i]->GetType() == type)
+		{
+			Controller* controller = released_controllers_[i];
+			released_controllers_.erase(released_controllers_.begin() + i);
+			controller_.push_back(controller);
+			return controller;
+		}
+	}
+
+	return nullptr;
+}
+
 int ScenarioReader::loadOSCFile(const char *path)
 {
 	pugi::xml_parse_result result = doc_.load_file(path);
@@ -257,10 +295,10 @@ Catalog *ScenarioReader::LoadCatalog(std::string name)
 	}
 
 	// Not found, try to locate it in one the registered catalog directories
-	pugi::xml_document catalog_doc;
+	std::shared_ptr<pugi::xml_document> catalog_doc;
 	pugi::xml_parse_result result;
 	std::vector<std::string> file_name_candidates;
-	for (size_t i = 0; i < catalogs_->catalog_dirs_.size() && !result; i++)
+	for (size_t i = 0; i < catalogs_->catalog_dirs_.size() && !catalog_doc; i++)
 	{
 		file_name_candidates.clear();
 		// absolute path or relative to current directory
@@ -273,24 +311,21 @@ Catalog *ScenarioReader::LoadCatalog(std::string name)
 			file_name_candidates.push_back(CombineDirectoryPathAndFilepath(SE_Env::Inst().GetPaths()[j], catalogs_->catalog_dirs_[i].dir_name_ + "/" + name + ".xosc"));
 			file_name_candidates.push_back(CombineDirectoryPathAndFilepath(SE_Env::Inst().GetPaths()[j], name + ".xosc"));
 		}
-		for (size_t j = 0; j < file_name_candidates.size() && !result; j++)
+		for (size_t j = 0; j < file_name_candidates.size() && !catalog_doc; j++)
 		{
-			if (FileExists(file_name_candidates[j].c_str()))
-			{
-				// Load it
-				result = catalog_doc.load_file(file_name_candidates[j].c_str());
-			}
+			// Parsed documents are cached between scenario loads
+			catalog_doc = CatalogCache::Inst().Load(file_name_candidates[j], result);
 		}
 	}
-	if (!result)
+	if (!catalog_doc)
 	{
 		throw std::runtime_error(std::string("Couldn't locate catalog file: " + name + ". " + result.description()));
 	}
 
-	pugi::xml_node osc_node_ = catalog_doc.child("OpenSCENARIO");
+	pugi::xml_node osc_node_ = catalog_doc->child("OpenSCENARIO");
 	if (!osc_node_)
 	{
-		osc_node_ = catalog_doc.child("OpenScenario");
+		osc_node_ = catalog_doc->child("OpenScenario");
 		if (!osc_node_)
 		{
 			throw std::runtime_error("Couldn't find Catalog OpenSCENARIO or OpenScenario element - check XML!");
@@ -305,10 +340,7 @@ Catalog *ScenarioReader::LoadCatalog(std::string name)
 	{
 		std::string entry_name = parameters.ReadAttribute(entry_n, "name");
 
-		pugi::xml_document root;
-		root.append_copy(entry_n);
-
-		catalog->AddEntry(new Entry(entry_name, std::move(root)));
+		catalog->AddEntry(new Entry(entry_name, catalog_doc, entry_n));
 	}
 
 	// Get type by inspecting first entry
@@ -2541,7 +2573,7 @@ OSCPrivateAction *ScenarioReader::parseOSCPrivateAction(pugi::xml_node actionNod
 							// Find route in catalog
 							Entry *entry = ResolveCatalogReference(assignRouteChild);
 
-							if (entry == 0 || entry->root_ == 0)
+							if (entry == 0 || !entry->GetNode())
 							{
 								throw std::runtime_error("Failed to resolve catalog reference");
 							}
@@ -2612,7 +2644,7 @@ OSCPrivateAction *ScenarioReader::parseOSCPrivateAction(pugi::xml_node actionNod
 							// Find trajectory in catalog
 							Entry *entry = ResolveCatalogReference(followTrajectoryChild);
 
-							if (entry == 0 || entry->root_ == 0)
+							if (entry == 0 || !entry->GetNode())
 							{
 								throw std::runtime_error("Failed to resolve catalog reference");
 							}
@@ -3812,7 +3844,7 @@ int ScenarioReader::parseStoryBoard(StoryBoard &storyBoard)
 								parameters.CreateRestorePoint();
 								Entry *entry = ResolveCatalogReference(catalog_n);
 
-								if (entry == 0 || entry->root_ == 0)
+								if (entry == 0 || !entry->GetNode())
 								{
 									throw std::runtime_error("Failed to resolve catalog reference");
 								}
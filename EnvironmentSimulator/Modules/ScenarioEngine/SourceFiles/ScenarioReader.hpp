@@ -147,9 +147,24 @@ namespace scenarioengine
 
 		int RemoveController(Controller* controller);
 		void AddController(Controller* controller) { controller_.push_back(controller); }
+
+		/**
+			Move a controller, e.g. of a despawned object, from the controller list to a pool for later reuse
+			@param controller Controller to release, should be deactivated
+			@return 0 on success, -1 if controller was not found
+		*/
+		int ReleaseController(Controller* controller);
+
+		/**
+			Move a released controller of given type back to the controller list
+			@param type Controller type, e.g. ControllerACC::GetTypeStatic()
+			@return Controller or nullptr if no released one of the type exists
+		*/
+		Controller* ReuseController(int type);
 		pugi::xml_document* GetDXMLDocument() { return &doc_; }
 
 		std::vector<Controller*> controller_;
+		std::vector<Controller*> released_controllers_;  // released controllers, not stepped
 
 		static Parameters parameters;  // static to enable set via callback during creation of object
 		static Parameters variables;
@@ -0,0 +1,412 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include <string.h>
+#include <cstddef>
+#include "SharedMemoryExchange.hpp"
+
+using namespace scenarioengine;
+
+#define SHM_SPIN_TIME_NS 2000000  // time to poll without sleeping, keeping latency low when peer responds quickly
+#define SHM_POLL_PERIOD_NS 500000  // poll period after spin time, see SE_sleepUntilNs
+#define SHM_SEQLOCK_SPIN 1000  // read attempts between clock checks while a writer is busy
+#define SHM_SEQLOCK_TIMEOUT_NS 10000000  // max wait for a writer, which might have died while writing
+
+// Sequence lock, see https://en.wikipedia.org/wiki/Seqlock
+static void SeqLockWrite(std::atomic<unsigned int>& seq, void* dst, const void* src, size_t size)
+{
+	unsigned int s = seq.load(std::memory_order_relaxed);
+	seq.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(dst, src, size);
+	seq.store(s + 2, std::memory_order_release);
+}
+
+// Copy consistent data. Returns 0 and the sequence number of the copied data, or -1 if the writer did not finish in time.
+static int SeqLockRead(std::atomic<unsigned int>& seq, void* dst, const void* src, size_t size, unsigned int& seq_out)
+{
+	__int64 deadline = 0;
+
+	for (int i = 1; ; i++)
+	{
+		unsigned int s = seq.load(std::memory_order_acquire);
+		if (!(s & 1))  // else writer busy
+		{
+			memcpy(dst, src, size);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) == s)
+			{
+				seq_out = s;
+				return 0;
+			}
+		}
+
+		if (i % SHM_SEQLOCK_SPIN == 0)
+		{
+			__int64 now = SE_getMonotonicTimeNs();
+			if (deadline == 0)
+			{
+				deadline = now + SHM_SEQLOCK_TIMEOUT_NS;
+			}
+			else if (now > deadline)
+			{
+				return -1;
+			}
+		}
+	}
+}
+
+// Poll for condition to become true, first spinning then sleeping. Returns false on timeout (ms).
+template<class Condition>
+static bool WaitFor(Condition condition, int timeout)
+{
+	__int64 start_time = SE_getMonotonicTimeNs();
+	__int64 timeout_ns = static_cast<__int64>(timeout) * 1000000LL;
+
+	while (!condition())
+	{
+		__int64 now = SE_getMonotonicTimeNs();
+		if (now - start_time >= timeout_ns)
+		{
+			return false;
+		}
+		if (now - start_time >= SHM_SPIN_TIME_NS)
+		{
+			SE_sleepUntilNs(MIN(now + SHM_POLL_PERIOD_NS, start_time + timeout_ns));
+		}
+		else
+		{
+			SE_sleep(0);  // yield, letting the peer run
+		}
+	}
+
+	return true;
+}
+
+void scenarioengine::GetShmObjectState(ObjectState* obj_state, ShmObjectState* dst)
+{
+	ObjectStateStruct* state = &obj_state->state_;
+
+	dst->id = state->info.id;
+	dst->model_id = state->info.model_id;
+	dst->ctrl_type = state->info.ctrl_type;
+	dst->obj_type = state->info.obj_type;
+	dst->obj_category = state->info.obj_category;
+	dst->roadId = state->pos.GetTrackId();
+	dst->laneId = state->pos.GetLaneId();
+	dst->junctionId = state->pos.GetJunctionId();
+	dst->x = state->pos.GetX();
+	dst->y = state->pos.GetY();
+	dst->z = state->pos.GetZ();
+	dst->h = state->pos.GetH();
+	dst->p = state->pos.GetP();
+	dst->r = state->pos.GetR();
+	dst->speed = state->info.speed;
+	dst->wheel_angle = state->info.wheel_angle;
+	dst->wheel_rot = state->info.wheel_rot;
+	dst->s = state->pos.GetS();
+	dst->t = state->pos.GetT();
+	dst->laneOffset = state->pos.GetOffset();
+	dst->centerOffsetX = state->info.boundingbox.center_.x_;
+	dst->centerOffsetY = state->info.boundingbox.center_.y_;
+	dst->centerOffsetZ = state->info.boundingbox.center_.z_;
+	dst->width = state->info.boundingbox.dimensions_.width_;
+	dst->length = state->info.boundingbox.dimensions_.length_;
+	dst->height = state->info.boundingbox.dimensions_.height_;
+}
+
+int scenarioengine::ApplyShmInput(ScenarioGateway* gateway, const ShmInput& input)
+{
+	ObjectState* obj_state = gateway->getObjectStatePtrById(input.id);
+	if (obj_state == nullptr)
+	{
+		LOG_ONCE("Input for unknown object id %d", input.id);
+		return -1;
+	}
+
+	double timestamp = obj_state->state_.info.timeStamp;
+	gateway->updateObjectWorldPos(input.id, timestamp, input.x, input.y, input.z, input.h, input.p, input.r);
+	gateway->updateObjectSpeed(input.id, timestamp, input.speed);
+	gateway->updateObjectWheelAngle(input.id, timestamp, input.wheel_angle);
+
+	return 0;
+}
+
+SharedMemoryExchange::SharedMemoryExchange() : exchange_(nullptr), lockstep_timeout_(0), n_timeouts_(0)
+{
+	memset(input_seq_, 0, sizeof(input_seq_));
+}
+
+int SharedMemoryExchange::Create(std::string name, int lockstep_timeout)
+{
+	Close();
+
+	if (shm_.Create(name, sizeof(ShmExchange)) != 0)
+	{
+		LOG("Failed to create shared memory %s", name.c_str());
+		return -1;
+	}
+
+	// Region is zero initialized, which is a valid state for all atomics
+	exchange_ = reinterpret_cast<ShmExchange*>(shm_.GetData());
+	exchange_->magic = SHM_EXCHANGE_MAGIC;
+	exchange_->version = SHM_EXCHANGE_VERSION;
+	exchange_->size = static_cast<unsigned int>(sizeof(ShmExchange));
+	exchange_->max_objects = SHM_EXCHANGE_MAX_OBJECTS;
+	exchange_->max_inputs = SHM_EXCHANGE_MAX_INPUTS;
+	exchange_->max_clients = SHM_EXCHANGE_MAX_CLIENTS;
+	exchange_->frame.store(-1);
+	exchange_->lockstep.store(lockstep_timeout > 0 ? 1 : 0);
+	for (int i = 0; i < SHM_EXCHANGE_MAX_INPUTS; i++)
+	{
+		exchange_->input[i].input.id = -1;
+	}
+	for (int i = 0; i < SHM_EXCHANGE_MAX_CLIENTS; i++)
+	{
+		exchange_->client[i].done_frame.store(-1);
+	}
+
+	lockstep_timeout_ = lockstep_timeout;
+	n_timeouts_ = 0;
+	memset(input_seq_, 0, sizeof(input_seq_));
+
+	LOG("Shared memory %s created (%d bytes)%s", name.c_str(), static_cast<int>(sizeof(ShmExchange)),
+		lockstep_timeout > 0 ? ", lockstep mode" : "");
+
+	return 0;
+}
+
+void SharedMemoryExchange::Close()
+{
+	if (exchange_ != nullptr)
+	{
+		exchange_->closed.store(1);
+		if (n_timeouts_ > 0)
+		{
+			LOG("Shared memory: %d frames timed out waiting for client input", n_timeouts_);
+		}
+	}
+	exchange_ = nullptr;
+	shm_.Close();
+}
+
+void SharedMemoryExchange::Publish(ScenarioGateway* gateway, int frame, double time)
+{
+	if (exchange_ == nullptr)
+	{
+		return;
+	}
+
+	// Write to the buffer not most recently published, so readers of that one are not disturbed
+	unsigned int index = (exchange_->latest.load(std::memory_order_relaxed) + 1) % 2;
+	ShmFrameBuffer* buffer = &exchange_->buffer[index];
+	ShmFrame* shm_frame = &buffer->frame;
+	int n = MIN(gateway->getNumberOfObjects(), SHM_EXCHANGE_MAX_OBJECTS);
+
+	if (gateway->getNumberOfObjects() > SHM_EXCHANGE_MAX_OBJECTS)
+	{
+		LOG_ONCE("Shared memory: Number of objects exceeds %d, skipping the rest", SHM_EXCHANGE_MAX_OBJECTS);
+	}
+
+	unsigned int s = buffer->seq.load(std::memory_order_relaxed);
+	buffer->seq.store(s + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	shm_frame->frame = frame;
+	shm_frame->n_objects = n;
+	shm_frame->time = time;
+	for (int i = 0; i < n; i++)
+	{
+		GetShmObjectState(gateway->getObjectStatePtrByIdx(i), &shm_frame->objects[i]);
+	}
+
+	buffer->seq.store(s + 2, std::memory_order_release);
+
+	exchange_->latest.store(index, std::memory_order_release);
+	exchange_->frame.store(frame, std::memory_order_release);
+}
+
+int SharedMemoryExchange::ApplyInputs(ScenarioGateway* gateway)
+{
+	if (exchange_ == nullptr)
+	{
+		return 0;
+	}
+
+	if (lockstep_timeout_ > 0 && exchange_->frame.load() >= 0)
+	{
+		// Clients tag their signal with the frame number, so a late signal for an older frame never counts
+		ShmExchange* exchange = exchange_;
+		int frame = exchange_->frame.load();
+		auto all_clients_done = [exchange, frame]()
+		{
+			for (int i = 0; i < SHM_EXCHANGE_MAX_CLIENTS; i++)
+			{
+				if (exchange->client[i].attached.load() != 0 && exchange->client[i].done_frame.load() < frame)
+				{
+					return false;
+				}
+			}
+			return true;  // also when no client is attached, then there is nobody to wait for
+		};
+
+		if (!WaitFor(all_clients_done, lockstep_timeout_))
+		{
+			if (n_timeouts_++ == 0)
+			{
+				LOG("Shared memory: Timeout waiting for client input on frame %d", exchange_->frame.load());
+			}
+		}
+	}
+
+	int counter = 0;
+	for (int i = 0; i < SHM_EXCHANGE_MAX_INPUTS; i++)
+	{
+		ShmInputSlot* slot = &exchange_->input[i];
+
+		if (slot->seq.load(std::memory_order_acquire) == input_seq_[i])
+		{
+			continue;  // nothing new
+		}
+
+		ShmInput input;
+		if (SeqLockRead(slot->seq, &input, &slot->input, sizeof(ShmInput), input_seq_[i]) != 0)
+		{
+			// Writing client probably died, the slot is checked again next frame
+			LOG_ONCE("Shared memory: Input slot %d locked by client, skipped", i);
+			continue;
+		}
+
+		if (input.id >= 0 && ApplyShmInput(gateway, input) == 0)
+		{
+			counter++;
+		}
+	}
+
+	return counter;
+}
+
+int SharedMemoryClient::Open(std::string name)
+{
+	Close();
+
+	if (shm_.Open(name) != 0)
+	{
+		return -1;
+	}
+
+	ShmExchange* exchange = reinterpret_cast<ShmExchange*>(shm_.GetData());
+	if (shm_.GetSize() < sizeof(ShmExchange) || exchange->magic != SHM_EXCHANGE_MAGIC ||
+		exchange->version != SHM_EXCHANGE_VERSION || exchange->size != sizeof(ShmExchange))
+	{
+		LOG("Shared memory %s: Incompatible layout or version", name.c_str());
+		shm_.Close();
+		return -1;
+	}
+
+	// Claim a free client slot. Free slots always have done_frame -1, see Close().
+	for (int i = 0; i < SHM_EXCHANGE_MAX_CLIENTS; i++)
+	{
+		int expected = 0;
+		if (exchange->client[i].attached.compare_exchange_strong(expected, 1))
+		{
+			exchange_ = exchange;
+			slot_ = i;
+			return 0;
+		}
+	}
+
+	LOG("Shared memory %s: All %d client slots in use", name.c_str(), SHM_EXCHANGE_MAX_CLIENTS);
+	shm_.Close();
+
+	return -1;
+}
+
+void SharedMemoryClient::Close()
+{
+	if (exchange_ != nullptr && slot_ >= 0)
+	{
+		exchange_->client[slot_].done_frame.store(-1);
+		exchange_->client[slot_].attached.store(0);
+	}
+	exchange_ = nullptr;
+	slot_ = -1;
+	shm_.Close();
+}
+
+int SharedMemoryClient::WaitForFrame(int frame, int timeout)
+{
+	if (exchange_ == nullptr)
+	{
+		return -1;
+	}
+
+	ShmExchange* exchange = exchange_;
+	if (!WaitFor([exchange, frame]() { return exchange->frame.load() > frame || exchange->closed.load() != 0; }, timeout) ||
+		exchange_->closed.load() != 0)
+	{
+		return -1;
+	}
+
+	return exchange_->frame.load();
+}
+
+int SharedMemoryClient::ReadFrame(ShmFrame& frame)
+{
+	if (exchange_ == nullptr || exchange_->frame.load() < 0)
+	{
+		return -1;
+	}
+
+	for (;;)
+	{
+		ShmFrameBuffer* buffer = &exchange_->buffer[exchange_->latest.load(std::memory_order_acquire)];
+		unsigned int s = buffer->seq.load(std::memory_order_acquire);
+
+		if (s & 1)
+		{
+			continue;
+		}
+
+		// Copy fixed fields, then only the valid part of the object array
+		memcpy(&frame, &buffer->frame, offsetof(ShmFrame, objects));
+		int n = MAX(0, MIN(frame.n_objects, SHM_EXCHANGE_MAX_OBJECTS));
+		memcpy(frame.objects, buffer->frame.objects, n * sizeof(ShmObjectState));
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (buffer->seq.load(std::memory_order_relaxed) == s)
+		{
+			frame.n_objects = n;
+			return 0;
+		}
+	}
+}
+
+int SharedMemoryClient::WriteInput(int slot, const ShmInput& input)
+{
+	if (exchange_ == nullptr || slot < 0 || slot >= SHM_EXCHANGE_MAX_INPUTS)
+	{
+		return -1;
+	}
+
+	SeqLockWrite(exchange_->input[slot].seq, &exchange_->input[slot].input, &input, sizeof(ShmInput));
+
+	return 0;
+}
+
+void SharedMemoryClient::InputDone(int frame)
+{
+	if (exchange_ != nullptr)
+	{
+		exchange_->client[slot_].done_frame.store(frame);
+	}
+}
@@ -0,0 +1,246 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+/*
+ * Exchange of object states with external processes via shared memory, e.g. driver models in co-simulation
+ *
+ * esmini creates the region and publishes the state of all objects every frame. States are written
+ * alternately to two frame buffers, each protected by a sequence lock: the sequence number is odd while
+ * the buffer is being written. Readers copy the latest buffer and retry if the sequence number changed
+ * meanwhile. So no side ever blocks the other.
+ *
+ * External processes write states of the objects they control into input slots, also sequence locked.
+ * esmini applies new input at the start of each frame, same as SE_ReportObjectPos + SE_ReportObjectSpeed.
+ *
+ * Each client attaches by claiming a client slot. When its input for a frame has been written it stores the
+ * frame number in the slot. Each client writes only its own slot, so no read-modify-write is needed across
+ * processes. In lockstep mode esmini waits before each frame until all attached clients have signaled input
+ * for the last published frame, or timeout. Without any attached client esmini does not wait.
+ *
+ * Layout is fixed and consists of plain 32 bit integers and 64 bit floats, see scripts/shm_driver.py
+ * for an example client in Python.
+ */
+
+#pragma once
+
+#include <atomic>
+#include "CommonMini.hpp"
+#include "ScenarioGateway.hpp"
+
+#define SHM_EXCHANGE_MAGIC 0x494d5345  // "ESMI"
+#define SHM_EXCHANGE_VERSION 2
+#define SHM_EXCHANGE_MAX_OBJECTS 256
+#define SHM_EXCHANGE_MAX_INPUTS 64
+#define SHM_EXCHANGE_MAX_CLIENTS 16
+#define SHM_EXCHANGE_DEFAULT_NAME "esmini"
+#define SHM_EXCHANGE_DEFAULT_TIMEOUT 1000  // ms
+
+namespace scenarioengine
+{
+	typedef struct
+	{
+		int id;
+		int model_id;
+		int ctrl_type;
+		int obj_type;
+		int obj_category;
+		int roadId;
+		int laneId;
+		int junctionId;
+		double x;
+		double y;
+		double z;
+		double h;
+		double p;
+		double r;
+		double speed;
+		double wheel_angle;
+		double wheel_rot;
+		double s;
+		double t;
+		double laneOffset;
+		double centerOffsetX;
+		double centerOffsetY;
+		double centerOffsetZ;
+		double width;
+		double length;
+		double height;
+	} ShmObjectState;
+
+	typedef struct
+	{
+		int frame;  // frame number, starting at 0 for the initial state
+		int n_objects;
+		double time;  // simulation time
+		ShmObjectState objects[SHM_EXCHANGE_MAX_OBJECTS];
+	} ShmFrame;
+
+	typedef struct
+	{
+		int id;  // object id, -1 = slot not in use
+		int frame;  // number of the frame this input is based on
+		double x;
+		double y;
+		double z;
+		double h;
+		double p;
+		double r;
+		double speed;
+		double wheel_angle;
+	} ShmInput;
+
+	typedef struct
+	{
+		std::atomic<unsigned int> seq;  // odd while being written
+		unsigned int pad;
+		ShmFrame frame;
+	} ShmFrameBuffer;
+
+	typedef struct
+	{
+		std::atomic<unsigned int> seq;  // odd while being written
+		unsigned int pad;
+		ShmInput input;
+	} ShmInputSlot;
+
+	typedef struct
+	{
+		std::atomic<int> attached;  // 1 = slot in use by a client
+		std::atomic<int> done_frame;  // number of latest frame the client has completed input for, -1 = none
+	} ShmClientSlot;
+
+	typedef struct
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int size;  // of the complete ShmExchange struct
+		unsigned int max_objects;
+		unsigned int max_inputs;
+		unsigned int max_clients;
+		std::atomic<unsigned int> closed;  // set when esmini quits
+		std::atomic<unsigned int> latest;  // index of frame buffer most recently written
+		std::atomic<int> frame;  // number of frame most recently published, -1 = none
+		std::atomic<unsigned int> lockstep;  // 1 = esmini waits for all clients to complete input before each frame
+		ShmFrameBuffer buffer[2];
+		ShmInputSlot input[SHM_EXCHANGE_MAX_INPUTS];
+		ShmClientSlot client[SHM_EXCHANGE_MAX_CLIENTS];
+	} ShmExchange;
+
+	/**
+		Copy state of an object into exchange format
+		@param obj_state Object state in gateway
+		@param dst State to fill in
+	*/
+	void GetShmObjectState(ObjectState* obj_state, ShmObjectState* dst);
+
+	/**
+		Report input of an external participant to the gateway
+		@param gateway Scenario gateway to report state to
+		@param input Object state
+		@return 0 on success, -1 if object id is unknown
+	*/
+	int ApplyShmInput(ScenarioGateway* gateway, const ShmInput& input);
+
+	class SharedMemoryExchange
+	{
+	public:
+		SharedMemoryExchange();
+		~SharedMemoryExchange() { Close(); }
+
+		/**
+			Create shared memory region
+			@param name Name of the region
+			@param lockstep_timeout Max time (ms) to wait for client input each frame, 0 = no lockstep
+			@return 0 on success, -1 on failure
+		*/
+		int Create(std::string name, int lockstep_timeout);
+		void Close();
+		bool IsOpen() { return exchange_ != nullptr; }
+
+		/**
+			Publish state of all objects
+			@param gateway Scenario gateway holding the states
+			@param frame Frame number
+			@param time Simulation time
+		*/
+		void Publish(ScenarioGateway* gateway, int frame, double time);
+
+		/**
+			Report any new input from clients to the gateway. In lockstep mode, first wait for client input.
+			@param gateway Scenario gateway to report states to
+			@return Number of objects reported
+		*/
+		int ApplyInputs(ScenarioGateway* gateway);
+
+		int GetNumberOfTimeouts() { return n_timeouts_; }
+
+	private:
+		SE_SharedMemory shm_;
+		ShmExchange* exchange_;
+		int lockstep_timeout_;
+		int n_timeouts_;
+		unsigned int input_seq_[SHM_EXCHANGE_MAX_INPUTS];  // sequence number of last applied input per slot
+	};
+
+	class SharedMemoryClient
+	{
+	public:
+		SharedMemoryClient() : exchange_(nullptr), slot_(-1) {}
+		~SharedMemoryClient() { Close(); }
+
+		/**
+			Attach to the shared memory region of a running esmini
+			@param name Name of the region
+			@return 0 on success, -1 if not existing, incompatible or no free client slot
+		*/
+		int Open(std::string name);
+		void Close();
+		bool IsOpen() { return exchange_ != nullptr; }
+		bool IsClosedByServer() { return exchange_ == nullptr || exchange_->closed.load() != 0; }
+
+		/**
+			Wait for a frame newer than given one to be published
+			@param frame Number of last frame seen, -1 for any
+			@param timeout Max time to wait (ms)
+			@return Number of latest published frame, -1 on timeout or if esmini has quit
+		*/
+		int WaitForFrame(int frame, int timeout);
+
+		/**
+			Copy latest published frame
+			@param frame Frame to fill in, only the first n_objects entries of objects are copied
+			@return 0 on success, -1 if nothing published yet
+		*/
+		int ReadFrame(ShmFrame& frame);
+
+		/**
+			Write input for an externally controlled object
+			@param slot Input slot, 0 .. SHM_EXCHANGE_MAX_INPUTS - 1. Each object should use its own slot.
+			@param input State of the object
+			@return 0 on success, -1 on failure
+		*/
+		int WriteInput(int slot, const ShmInput& input);
+
+		/**
+			Signal that all input based on given frame has been written, releasing esmini in lockstep mode.
+			Signals for frames older than the latest published one are ignored by esmini.
+			@param frame Frame number
+		*/
+		void InputDone(int frame);
+
+	private:
+		SE_SharedMemory shm_;
+		ShmExchange* exchange_;
+		int slot_;  // claimed client slot
+	};
+
+}
@@ -128,13 +128,16 @@ namespace scenarioengine
 	{
 	public:
 		StoryBoard() : stop_trigger_(0) {}
-		~StoryBoard() 
-		{ 
-			for (auto* entry : story_) 
-			{ 
+		~StoryBoard() { Clear(); }
+		void Clear()
+		{
+			for (auto* entry : story_)
+			{
 				delete entry;
 			}
+			story_.clear();
 			delete stop_trigger_;
+			stop_trigger_ = 0;
 		}
 		Act* FindActByName(std::string name);
 		ManeuverGroup* FindManeuverGroupByName(std::string name);
@@ -0,0 +1,419 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+#include <string.h>
+#include "UDPLockstepExchange.hpp"
+
+using namespace scenarioengine;
+
+static void InitHeader(UDPLockstepHeader* header, UDPLockstepMsgType type, int frame, int n)
+{
+	header->magic = UDP_LOCKSTEP_MAGIC;
+	header->version = UDP_LOCKSTEP_VERSION;
+	header->type = static_cast<unsigned int>(type);
+	header->frame = frame;
+	header->n = n;
+	header->pad = 0;
+}
+
+static bool IsValidHeader(const char* buf, int size)
+{
+	const UDPLockstepHeader* header = reinterpret_cast<const UDPLockstepHeader*>(buf);
+
+	return size >= static_cast<int>(sizeof(UDPLockstepHeader)) && header->magic == UDP_LOCKSTEP_MAGIC &&
+		header->version == UDP_LOCKSTEP_VERSION && header->n >= 0;
+}
+
+static bool IsSameAddress(const struct sockaddr_in& a, const struct sockaddr_in& b)
+{
+	return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+}
+
+UDPLockstepExchange::UDPLockstepExchange() : udpServer_(nullptr), timeout_(0), frame_(-1)
+{
+	memset(&stats_, 0, sizeof(stats_));
+}
+
+int UDPLockstepExchange::Create(unsigned short port, int timeout)
+{
+	Close();
+
+	udpServer_ = new UDPServer(port, 0);
+	timeout_ = timeout;
+	frame_ = -1;
+	participants_.clear();
+	frame_msgs_.clear();
+	buf_.resize(UDP_LOCKSTEP_MAX_MSG_SIZE);
+	memset(&stats_, 0, sizeof(stats_));
+
+	LOG("UDP lockstep listening on port %d, timeout %d ms", port, timeout);
+
+	return 0;
+}
+
+void UDPLockstepExchange::Close()
+{
+	if (udpServer_ == nullptr)
+	{
+		return;
+	}
+
+	UDPLockstepHeader header;
+	InitHeader(&header, UDPLockstepMsgType::QUIT, frame_, 0);
+	for (auto& participant : participants_)
+	{
+		udpServer_->SendTo(reinterpret_cast<const char*>(&header), sizeof(header), participant.addr);
+	}
+
+	if (stats_.frames > 0)
+	{
+		LOG("UDP lockstep: %d frames, %d timeouts, %d late inputs discarded, %d invalid messages", stats_.frames,
+			stats_.timeouts, stats_.late, stats_.invalid);
+	}
+	if (stats_.rtt_samples > 0)
+	{
+		LOG("UDP lockstep: round trip min %.3f avg %.3f max %.3f ms", stats_.rtt_min, stats_.rtt_sum / stats_.rtt_samples,
+			stats_.rtt_max);
+	}
+
+	delete udpServer_;
+	udpServer_ = nullptr;
+	participants_.clear();
+}
+
+void UDPLockstepExchange::Publish(ScenarioGateway* gateway, int frame, double time)
+{
+	if (udpServer_ == nullptr)
+	{
+		return;
+	}
+
+	int n_total = gateway->getNumberOfObjects();
+	int n_per_msg = static_cast<int>(UDP_LOCKSTEP_MAX_OBJECTS_PER_MSG);
+	int n_msgs = MAX(1, (n_total + n_per_msg - 1) / n_per_msg);
+
+	frame_msgs_.resize(static_cast<size_t>(n_msgs));
+	for (int i = 0; i < n_msgs; i++)
+	{
+		int first = i * n_per_msg;
+		int n = MIN(n_total - first, n_per_msg);
+		std::vector<char>& msg = frame_msgs_[i];
+
+		msg.resize(sizeof(UDPLockstepStateHeader) + n * sizeof(ShmObjectState));
+		UDPLockstepStateHeader* header = reinterpret_cast<UDPLockstepStateHeader*>(msg.data());
+		InitHeader(&header->header, UDPLockstepMsgType::STATE, frame, n);
+		header->first = first;
+		header->n_total = n_total;
+		header->time = time;
+
+		ShmObjectState* states = reinterpret_cast<ShmObjectState*>(msg.data() + sizeof(UDPLockstepStateHeader));
+		for (int j = 0; j < n; j++)
+		{
+			GetShmObjectState(gateway->getObjectStatePtrByIdx(first + j), &states[j]);
+		}
+	}
+
+	frame_ = frame;
+
+	for (auto& participant : participants_)
+	{
+		participant.send_time = std::chrono::steady_clock::now();
+		for (auto& msg : frame_msgs_)
+		{
+			udpServer_->SendTo(msg.data(), static_cast<unsigned int>(msg.size()), participant.addr);
+		}
+	}
+}
+
+int UDPLockstepExchange::ApplyInputs(ScenarioGateway* gateway)
+{
+	if (udpServer_ == nullptr)
+	{
+		return 0;
+	}
+
+	int counter = 0;
+	struct sockaddr_in addr;
+	int size;
+
+	// First handle anything already queued, e.g. registrations
+	while ((size = udpServer_->ReceiveFrom(buf_.data(), static_cast<unsigned int>(buf_.size()), addr, 0)) > 0)
+	{
+		counter += HandleMessage(gateway, size, addr);
+	}
+
+	if (frame_ < 0 || participants_.empty())
+	{
+		return counter;  // nobody to wait for
+	}
+
+	stats_.frames++;
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_);
+
+	while (!AllReplied())
+	{
+		long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+		if (remaining <= 0)
+		{
+			if (stats_.timeouts++ == 0)
+			{
+				LOG("UDP lockstep: Timeout waiting for participant input on frame %d", frame_);
+			}
+			break;
+		}
+
+		size = udpServer_->ReceiveFrom(buf_.data(), static_cast<unsigned int>(buf_.size()), addr, static_cast<unsigned int>(remaining));
+		if (size > 0)
+		{
+			counter += HandleMessage(gateway, size, addr);
+		}
+	}
+
+	return counter;
+}
+
+int UDPLockstepExchange::FindParticipant(const struct sockaddr_in& addr)
+{
+	for (size_t i = 0; i < participants_.size(); i++)
+	{
+		if (IsSameAddress(participants_[i].addr, addr))
+		{
+			return static_cast<int>(i);
+		}
+	}
+
+	return -1;
+}
+
+bool UDPLockstepExchange::AllReplied()
+{
+	for (auto& participant : participants_)
+	{
+		if (participant.replied_frame < frame_)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int UDPLockstepExchange::HandleMessage(ScenarioGateway* gateway, int size, const struct sockaddr_in& addr)
+{
+	if (!IsValidHeader(buf_.data(), size))
+	{
+		stats_.invalid++;
+		return 0;
+	}
+
+	const UDPLockstepHeader* header = reinterpret_cast<const UDPLockstepHeader*>(buf_.data());
+	int index = FindParticipant(addr);
+
+	if (header->type == static_cast<unsigned int>(UDPLockstepMsgType::REGISTER))
+	{
+		if (index < 0)
+		{
+			Participant participant;
+			participant.addr = addr;
+			participant.replied_frame = frame_ - 1;
+			participants_.push_back(participant);
+			index = static_cast<int>(participants_.size()) - 1;
+			LOG("UDP lockstep: Participant %d registered from port %d", index, ntohs(addr.sin_port));
+		}
+
+		// Send latest frame to new participant, or again to any participant that missed it
+		participants_[index].send_time = std::chrono::steady_clock::now();
+		for (auto& msg : frame_msgs_)
+		{
+			udpServer_->SendTo(msg.data(), static_cast<unsigned int>(msg.size()), addr);
+		}
+	}
+	else if (header->type == static_cast<unsigned int>(UDPLockstepMsgType::UNREGISTER))
+	{
+		if (index >= 0)
+		{
+			participants_.erase(participants_.begin() + index);
+			LOG("UDP lockstep: Participant from port %d unregistered", ntohs(addr.sin_port));
+		}
+	}
+	else if (header->type == static_cast<unsigned int>(UDPLockstepMsgType::INPUT))
+	{
+		if (index < 0 || header->frame > frame_ || header->n > static_cast<int>(UDP_LOCKSTEP_MAX_INPUTS_PER_MSG) ||
+			size < static_cast<int>(sizeof(UDPLockstepHeader) + header->n * sizeof(ShmInput)))
+		{
+			stats_.invalid++;
+			return 0;
+		}
+
+		if (header->frame < frame_)
+		{
+			// Reply to a previous frame, most likely one that timed out. Applying it would mean stale input.
+			stats_.late++;
+			return 0;
+		}
+
+		Participant& participant = participants_[index];
+		if (participant.replied_frame < frame_)
+		{
+			double rtt = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - participant.send_time).count();
+			stats_.rtt_min = stats_.rtt_samples == 0 ? rtt : MIN(stats_.rtt_min, rtt);
+			stats_.rtt_max = MAX(stats_.rtt_max, rtt);
+			stats_.rtt_sum += rtt;
+			stats_.rtt_samples++;
+			participant.replied_frame = frame_;
+		}
+
+		const ShmInput* inputs = reinterpret_cast<const ShmInput*>(buf_.data() + sizeof(UDPLockstepHeader));
+		int counter = 0;
+		for (int i = 0; i < header->n; i++)
+		{
+			if (ApplyShmInput(gateway, inputs[i]) == 0)
+			{
+				counter++;
+			}
+		}
+
+		return counter;
+	}
+	else
+	{
+		stats_.invalid++;
+	}
+
+	return 0;
+}
+
+int UDPLockstepClient::Open(unsigned short port, std::string server_ip, unsigned short server_port)
+{
+	Close();
+
+	memset(&server_addr_, 0, sizeof(server_addr_));
+	server_addr_.sin_family = AF_INET;
+	server_addr_.sin_port = htons(server_port);
+	if (inet_pton(AF_INET, server_ip.c_str(), &server_addr_.sin_addr.s_addr) != 1)
+	{
+		LOG("UDP lockstep: Invalid server address %s", server_ip.c_str());
+		return -1;
+	}
+
+	udpServer_ = new UDPServer(port, 0);
+	buf_.resize(UDP_LOCKSTEP_MAX_MSG_SIZE);
+	quit_ = false;
+
+	return SendHeader(UDPLockstepMsgType::REGISTER, -1);
+}
+
+void UDPLockstepClient::Close()
+{
+	if (udpServer_ != nullptr)
+	{
+		if (!quit_)
+		{
+			SendHeader(UDPLockstepMsgType::UNREGISTER, -1);
+		}
+		delete udpServer_;
+		udpServer_ = nullptr;
+	}
+}
+
+int UDPLockstepClient::ReceiveFrame(ShmFrame& frame, int timeout)
+{
+	if (udpServer_ == nullptr || quit_)
+	{
+		return -1;
+	}
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	int n_received = 0;
+	frame.frame = -1;
+
+	for (;;)
+	{
+		long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+		struct sockaddr_in addr;
+		int size = udpServer_->ReceiveFrom(buf_.data(), static_cast<unsigned int>(buf_.size()), addr,
+			static_cast<unsigned int>(MAX(0, remaining)));
+
+		if (size <= 0)
+		{
+			if (remaining <= 0)
+			{
+				return -1;
+			}
+			continue;
+		}
+
+		if (!IsValidHeader(buf_.data(), size))
+		{
+			continue;
+		}
+
+		const UDPLockstepStateHeader* header = reinterpret_cast<const UDPLockstepStateHeader*>(buf_.data());
+		if (header->header.type == static_cast<unsigned int>(UDPLockstepMsgType::QUIT))
+		{
+			quit_ = true;
+			return -1;
+		}
+
+		if (header->header.type != static_cast<unsigned int>(UDPLockstepMsgType::STATE) ||
+			size < static_cast<int>(sizeof(UDPLockstepStateHeader) + header->header.n * sizeof(ShmObjectState)))
+		{
+			continue;
+		}
+
+		if (header->header.frame != frame.frame)
+		{
+			// Start of a new frame, drop any incomplete one
+			frame.frame = header->header.frame;
+			frame.time = header->time;
+			frame.n_objects = MIN(header->n_total, SHM_EXCHANGE_MAX_OBJECTS);
+			n_received = 0;
+		}
+
+		const ShmObjectState* states = reinterpret_cast<const ShmObjectState*>(buf_.data() + sizeof(UDPLockstepStateHeader));
+		for (int i = 0; i < header->header.n; i++)
+		{
+			if (header->first + i < SHM_EXCHANGE_MAX_OBJECTS)
+			{
+				frame.objects[header->first + i] = states[i];
+			}
+		}
+		n_received += header->header.n;
+
+		if (n_received >= header->n_total)
+		{
+			return frame.frame;
+		}
+	}
+}
+
+int UDPLockstepClient::SendInput(int frame, const ShmInput* inputs, int n)
+{
+	if (udpServer_ == nullptr || n < 0 || n > static_cast<int>(UDP_LOCKSTEP_MAX_INPUTS_PER_MSG))
+	{
+		return -1;
+	}
+
+	InitHeader(reinterpret_cast<UDPLockstepHeader*>(buf_.data()), UDPLockstepMsgType::INPUT, frame, n);
+	memcpy(buf_.data() + sizeof(UDPLockstepHeader), inputs, n * sizeof(ShmInput));
+
+	unsigned int size = static_cast<unsigned int>(sizeof(UDPLockstepHeader) + n * sizeof(ShmInput));
+	return udpServer_->SendTo(buf_.data(), size, server_addr_) == static_cast<int>(size) ? 0 : -1;
+}
+
+int UDPLockstepClient::SendHeader(UDPLockstepMsgType type, int frame)
+{
+	UDPLockstepHeader header;
+	InitHeader(&header, type, frame, 0);
+
+	return udpServer_->SendTo(reinterpret_cast<const char*>(&header), sizeof(header), server_addr_) == sizeof(header) ? 0 : -1;
+}
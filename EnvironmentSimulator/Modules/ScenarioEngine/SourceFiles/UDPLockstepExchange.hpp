@@ -0,0 +1,189 @@
+/*
+ * esmini - Environment Simulator Minimalistic
+ * https://github.com/esmini/esmini
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * Copyright (c) partners of Simulation Scenarios
+ * https://sites.google.com/view/simulationscenarios
+ */
+
+/*
+ * Lockstep co-simulation with external participants over UDP, e.g. driver models on another host
+ *
+ * Participants register by sending a REGISTER message to the esmini lockstep port. For each frame N esmini
+ * sends the state of all objects, tagged with N, to every registered participant and then waits until each of
+ * them has replied with an INPUT message tagged with N, or timeout. Without registered participants esmini
+ * does not wait. Inputs are applied before the next frame is calculated, so the simulation can run faster
+ * than real time without dropped or stale inputs.
+ *
+ * Input tagged with an older frame number is late, e.g. a reply to a frame that already timed out. It is
+ * discarded and counted, never applied. Round trip times, from sending the state until the input arrives,
+ * are measured per frame and participant.
+ *
+ * States are split into multiple STATE messages, each fitting into a single datagram within a typical MTU, so
+ * that no message relies on IP fragmentation. All messages start with a UDPLockstepHeader. Object states and
+ * inputs have the same layout as in the shared memory exchange, see SharedMemoryExchange.hpp. For an example
+ * participant in Python, see scripts/udp_driver/udp_lockstep_driver.py.
+ */
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include "CommonMini.hpp"
+#include "UDP.hpp"
+#include "ScenarioGateway.hpp"
+#include "SharedMemoryExchange.hpp"
+
+#define UDP_LOCKSTEP_MAGIC 0x4c534d45  // "EMSL"
+#define UDP_LOCKSTEP_VERSION 1
+#define UDP_LOCKSTEP_DEFAULT_PORT 48200
+#define UDP_LOCKSTEP_DEFAULT_TIMEOUT 1000  // ms
+#define UDP_LOCKSTEP_MAX_MSG_SIZE 1200  // bytes, below IPv6 minimum MTU 1280 also with tunnel overhead
+#define UDP_LOCKSTEP_MAX_OBJECTS_PER_MSG ((UDP_LOCKSTEP_MAX_MSG_SIZE - sizeof(UDPLockstepStateHeader)) / sizeof(ShmObjectState))
+#define UDP_LOCKSTEP_MAX_INPUTS_PER_MSG ((UDP_LOCKSTEP_MAX_MSG_SIZE - sizeof(UDPLockstepHeader)) / sizeof(ShmInput))
+
+namespace scenarioengine
+{
+	enum class UDPLockstepMsgType
+	{
+		REGISTER = 1,  // participant -> esmini
+		UNREGISTER = 2,  // participant -> esmini
+		STATE = 3,  // esmini -> participant, UDPLockstepStateHeader followed by ShmObjectState array
+		INPUT = 4,  // participant -> esmini, header followed by n ShmInput, completes reply to the frame
+		QUIT = 5  // esmini -> participant, sent when esmini quits
+	};
+
+	typedef struct
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int type;  // UDPLockstepMsgType
+		int frame;  // frame number, or -1 when not applicable
+		int n;  // number of elements (objects or inputs) following
+		int pad;
+	} UDPLockstepHeader;
+
+	typedef struct
+	{
+		UDPLockstepHeader header;
+		int first;  // index of first object in this message
+		int n_total;  // total number of objects in the frame
+		double time;  // simulation time
+	} UDPLockstepStateHeader;
+
+	typedef struct
+	{
+		int frames;  // number of frames waited for
+		int timeouts;  // number of frames where at least one participant did not reply in time
+		int late;  // number of late inputs discarded
+		int invalid;  // number of messages not understood or from unknown senders
+		int rtt_samples;
+		double rtt_min;  // round trip time, ms
+		double rtt_max;
+		double rtt_sum;
+	} UDPLockstepStats;
+
+	class UDPLockstepExchange
+	{
+	public:
+		UDPLockstepExchange();
+		~UDPLockstepExchange() { Close(); }
+
+		/**
+			Start listening for participants
+			@param port UDP port to listen on
+			@param timeout Max time (ms) to wait for participant input each frame
+			@return 0 on success, -1 on failure
+		*/
+		int Create(unsigned short port, int timeout);
+		void Close();
+		bool IsOpen() { return udpServer_ != nullptr; }
+
+		/**
+			Send state of all objects to registered participants
+			@param gateway Scenario gateway holding the states
+			@param frame Frame number
+			@param time Simulation time
+		*/
+		void Publish(ScenarioGateway* gateway, int frame, double time);
+
+		/**
+			Wait for all registered participants to reply to the last published frame, applying inputs as they
+			arrive. Returns without waiting if no participant is registered.
+			@param gateway Scenario gateway to report states to
+			@return Number of objects reported
+		*/
+		int ApplyInputs(ScenarioGateway* gateway);
+
+		int GetNumberOfParticipants() { return static_cast<int>(participants_.size()); }
+		const UDPLockstepStats& GetStats() { return stats_; }
+
+	private:
+		typedef struct
+		{
+			struct sockaddr_in addr;
+			int replied_frame;  // latest frame the participant has replied to
+			std::chrono::steady_clock::time_point send_time;  // when latest frame was sent to the participant
+		} Participant;
+
+		UDPServer* udpServer_;
+		int timeout_;
+		int frame_;  // latest published frame, -1 = none
+		std::vector<Participant> participants_;
+		std::vector<std::vector<char>> frame_msgs_;  // messages of latest published frame, resent to late joiners
+		std::vector<char> buf_;
+		UDPLockstepStats stats_;
+
+		int FindParticipant(const struct sockaddr_in& addr);
+		bool AllReplied();
+		int HandleMessage(ScenarioGateway* gateway, int size, const struct sockaddr_in& addr);
+	};
+
+	class UDPLockstepClient
+	{
+	public:
+		UDPLockstepClient() : udpServer_(nullptr), quit_(false) {}
+		~UDPLockstepClient() { Close(); }
+
+		/**
+			Register as participant to a running esmini
+			@param port Local port to receive states on
+			@param server_ip IP address of host running esmini
+			@param server_port Lockstep port of esmini
+			@return 0 on success, -1 on failure
+		*/
+		int Open(unsigned short port, std::string server_ip, unsigned short server_port);
+		void Close();
+		bool IsClosedByServer() { return quit_; }
+
+		/**
+			Receive next complete frame
+			@param frame Frame to fill in, objects beyond SHM_EXCHANGE_MAX_OBJECTS are skipped
+			@param timeout Max time to wait (ms)
+			@return Frame number, -1 on timeout or if esmini has quit
+		*/
+		int ReceiveFrame(ShmFrame& frame, int timeout);
+
+		/**
+			Send input for externally controlled objects, completing the reply to a frame
+			@param frame Number of the frame the input is based on
+			@param inputs Object states
+			@param n Number of inputs, max UDP_LOCKSTEP_MAX_INPUTS_PER_MSG
+			@return 0 on success, -1 on failure
+		*/
+		int SendInput(int frame, const ShmInput* inputs, int n);
+
+	private:
+		UDPServer* udpServer_;
+		struct sockaddr_in server_addr_;
+		bool quit_;
+		std::vector<char> buf_;
+
+		int SendHeader(UDPLockstepMsgType type, int frame);
+	};
+
+}
@@ -13,6 +13,7 @@
 // expression implementation is based on https://github.com/zserge/expr
 
 #include "expr.h"
+#include "simple_expr.h"
 
 // Custom function that returns the floor of its argument
 static double round_(struct expr_func* f, vec_expr_t* args, void* c) {
@@ -136,6 +137,53 @@ double eval_expr(const char* str)
     return retval;
 }
 
+struct compiled_expr
+{
+    struct expr* e;
+    struct expr_var_list vars;
+};
+
+compiled_expr* compile_expr(const char* str)
+{
+    compiled_expr* ce = (compiled_expr*)calloc(1, sizeof(compiled_expr));
+    ce->e = expr_create(str, strlen(str), &ce->vars, user_funcs);
+    if (ce->e == 0)
+    {
+        expr_destroy(0, &ce->vars);
+        free(ce);
+        return 0;
+    }
+
+    return ce;
+}
+
+double* compiled_expr_var(compiled_expr* e, const char* name)
+{
+    for (struct expr_var* v = e->vars.head; v; v = v->next)
+    {
+        if (strcmp(v->name, name) == 0)
+        {
+            return &v->value;
+        }
+    }
+
+    return 0;
+}
+
+double eval_compiled_expr(compiled_expr* e)
+{
+    return expr_eval(e->e);
+}
+
+void destroy_compiled_expr(compiled_expr* e)
+{
+    if (e)
+    {
+        expr_destroy(e->e, &e->vars);
+        free(e);
+    }
+}
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -23,6 +23,32 @@ extern "C" {
 */
 double eval_expr(const char* str);
 
+typedef struct compiled_expr compiled_expr;
+
+/**
+* Parse expression once, for repeated evaluation with different variable values
+* @param str Expression, any identifier not being a function is a variable
+* @return compiled expression, or 0 on syntax error
+*/
+compiled_expr* compile_expr(const char* str);
+
+/**
+* Get pointer to value of named variable in compiled expression, to set before evaluation
+* @param e Compiled expression
+* @param name Variable name
+* @return pointer to value, or 0 if the variable is not used in the expression
+*/
+double* compiled_expr_var(compiled_expr* e, const char* name);
+
+/**
+* Evaluate compiled expression using current variable values
+* @param e Compiled expression
+* @return evaluated resulting value as float
+*/
+double eval_compiled_expr(compiled_expr* e);
+
+void destroy_compiled_expr(compiled_expr* e);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
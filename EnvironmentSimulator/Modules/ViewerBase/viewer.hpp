@@ -302,6 +302,7 @@ namespace viewer
 		void SetTransparency(double factor);
 
 		std::unique_ptr<PolyLine> trail_;
+		int trail_revision_;  // revision of the source trail when last synced, see roadmanager::PolyLineBase
 		std::unique_ptr<RouteWayPoints> routewaypoints_;
 		osgViewer::Viewer* viewer_;
 		OnScreenText on_screen_info_;
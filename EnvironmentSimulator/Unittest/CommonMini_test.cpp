@@ -79,6 +79,377 @@ TEST(VectorOperations, TestIsPointWithinSectorBetweenTwoLines)
     EXPECT_NEAR(factor, 0.354, 1E-3);
 }
 
+TEST(FileOperations, TestAsyncFileWriter)
+{
+    // Write more than a couple of chunks, in pieces of varying size, then verify file content
+    std::vector<char> data;
+    SE_AsyncFileWriter writer;
+    ASSERT_EQ(writer.Open("async_writer_test.bin"), 0);
+
+    for (int i = 0; data.size() < 3 * SE_ASYNC_FILE_WRITER_CHUNK_SIZE; i++)
+    {
+        std::vector<char> piece(static_cast<size_t>(1 + (i * 37) % 1000), static_cast<char>(i));
+        writer.Write(piece.data(), piece.size());
+        data.insert(data.end(), piece.begin(), piece.end());
+    }
+    writer.Close();
+    EXPECT_EQ(writer.IsOpen(), false);
+
+    std::ifstream file("async_writer_test.bin", std::ifstream::binary);
+    ASSERT_EQ(file.fail(), false);
+    std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content.size(), data.size());
+    EXPECT_EQ(content == data, true);
+    file.close();
+    std::remove("async_writer_test.bin");
+}
+
+TEST(FileOperations, TestCSVLoggerTextFormat)
+{
+    // Text mode formats numbers without snprintf, output should still match printf "%f"
+    double values[] = { 0.0, -0.0, 1.0, -1.5, 0.1234565, 0.0000005, -0.0000004, 123456.7890125, 1e-12, 3.14159265358979,
+        -2.7182818284, 9.9999995, 1e20, -1e16, 0.5e-6 + 1e-15 };
+    int n_values = static_cast<int>(sizeof(values) / sizeof(double));
+    int collision_ids[] = { 2, 13 };
+    CSV_VehicleData data = {};
+    data.name = "Target";
+    data.id = 1;
+    data.collision_ids = collision_ids;
+    data.n_collisions = 2;
+
+    CSV_Logger::Inst().Open("test.xosc", 2, "csv_logger_test.csv");
+    for (int i = 0; i < n_values; i++)
+    {
+        data.speed = values[i];
+        data.curvature = -values[i];
+        CSV_Logger::Inst().LogVehicleData(true, 0.0, data);
+    }
+    CSV_Logger::Inst().Close();
+
+    std::ifstream file("csv_logger_test.csv");
+    ASSERT_EQ(file.fail(), false);
+    std::string line;
+    for (int i = 0; i < 7; i++)
+    {
+        std::getline(file, line);  // skip header
+    }
+    for (int i = 0; i < n_values; i++)
+    {
+        char expected[1024];
+        snprintf(expected, sizeof(expected), "Target, 1, %f, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, "
+            "0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, "
+            "0.000000, %f, 2 13 , ", values[i], -values[i]);
+        std::getline(file, line);
+        EXPECT_EQ(line, expected);
+    }
+    file.close();
+    std::remove("csv_logger_test.csv");
+}
+
+static void SetCSVTestValues(CSV_VehicleData& data, int row)
+{
+    // Unique value per row and column, to catch any mixup in the columnar layout
+    double v[CSV_N_VALUES];
+    for (int i = 0; i < CSV_N_VALUES; i++)
+    {
+        v[i] = row * 100.0 + i + 0.25;
+    }
+    data.speed = v[0];
+    data.wheel_angle = v[1];
+    data.wheel_rot = v[2];
+    data.x = v[3];
+    data.y = v[4];
+    data.z = v[5];
+    data.vel_x = v[6];
+    data.vel_y = v[7];
+    data.vel_z = v[8];
+    data.acc_x = v[9];
+    data.acc_y = v[10];
+    data.acc_z = v[11];
+    data.s = v[12];
+    data.t = v[13];
+    data.h = v[14];
+    data.h_rate = v[15];
+    data.h_relative = v[16];
+    data.h_relative_drive_direction = v[17];
+    data.p = v[18];
+    data.curvature = v[19];
+}
+
+TEST(FileOperations, TestCSVLoggerBinaryRoundTrip)
+{
+    // Two entities per frame, more rows than fit in one block. The second entity is renamed on the way.
+    const int n_frames = 700;
+    int collision_ids[] = { 0 };
+    CSV_VehicleData data = {};
+
+    CSV_Logger::Inst().Open("test.xosc", 2, "csv_logger_test.csvb", true);
+    for (int frame = 0; frame < n_frames; frame++)
+    {
+        for (int id = 0; id < 2; id++)
+        {
+            data.name = id == 0 ? "Ego" : (frame < 600 ? "Target" : "Target2");
+            data.id = id;
+            data.collision_ids = collision_ids;
+            data.n_collisions = (id == 1 && frame % 2 == 0) ? 1 : 0;
+            SetCSVTestValues(data, 2 * frame + id);
+            CSV_Logger::Inst().LogVehicleData(id == 1, 0.05 * frame, data);
+        }
+    }
+    CSV_Logger::Inst().Close();
+
+    std::ifstream file("csv_logger_test.csvb", std::ifstream::binary);
+    ASSERT_EQ(file.fail(), false);
+    std::vector<char> buf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove("csv_logger_test.csvb");
+
+    size_t pos = 0;
+    auto read = [&buf, &pos](void* dst, size_t size)
+    {
+        if (pos + size > buf.size())
+        {
+            return false;
+        }
+        memcpy(dst, &buf[pos], size);
+        pos += size;
+        return true;
+    };
+
+    // Header, info lines and column schema
+    CSV_BinaryHeader header;
+    ASSERT_TRUE(read(&header, sizeof(header)));
+    EXPECT_EQ(header.magic, static_cast<unsigned int>(CSV_BINARY_MAGIC));
+    EXPECT_EQ(header.version, CSV_BINARY_VERSION);
+    ASSERT_EQ(header.n_info_lines, 6);
+    ASSERT_EQ(header.n_columns, 4 + CSV_N_VALUES);
+    std::vector<std::string> strings;
+    for (int i = 0; i < header.n_info_lines + header.n_columns; i++)
+    {
+        int type = CSV_BINARY_INT32;
+        int length = 0;
+        if (i >= header.n_info_lines)
+        {
+            ASSERT_TRUE(read(&type, sizeof(int)));
+            EXPECT_TRUE(type == CSV_BINARY_INT32 || type == CSV_BINARY_FLOAT64);
+        }
+        ASSERT_TRUE(read(&length, sizeof(int)));
+        ASSERT_LE(pos + length, buf.size());
+        strings.push_back(std::string(&buf[pos], length));
+        pos += length;
+    }
+    EXPECT_EQ(strings[4], "Scenario File Name: test.xosc");
+    EXPECT_EQ(strings[5], "Number of Vehicles: 2");
+    EXPECT_EQ(strings[6], "Index [-]");
+    EXPECT_EQ(strings.back(), "Number_Of_Collisions [-]");
+
+    // Blocks, rows are checked in order
+    std::map<int, std::string> names;
+    int row = 0;
+    int n_data_blocks = 0;
+    int last_block_rows = 0;
+    CSV_BinaryBlockHeader block;
+    while (pos < buf.size())
+    {
+        ASSERT_TRUE(read(&block, sizeof(block)));
+        ASSERT_LE(pos + block.size, buf.size());
+        size_t end = pos + block.size;
+
+        if (block.type == CSV_BINARY_BLOCK_NAME)
+        {
+            int id;
+            ASSERT_TRUE(read(&id, sizeof(int)));
+            names[id] = std::string(&buf[pos], end - pos);
+            pos = end;
+            continue;
+        }
+        ASSERT_EQ(block.type, CSV_BINARY_BLOCK_DATA);
+
+        int n;
+        ASSERT_TRUE(read(&n, sizeof(int)));
+        ASSERT_GT(n, 0);
+        ASSERT_LE(n, CSV_BINARY_CHUNK_ROWS);
+        std::vector<int> index(n), id(n), n_collisions(n);
+        std::vector<double> time(n), values(static_cast<size_t>(n) * CSV_N_VALUES);
+        ASSERT_TRUE(read(index.data(), n * sizeof(int)));
+        ASSERT_TRUE(read(time.data(), n * sizeof(double)));
+        ASSERT_TRUE(read(id.data(), n * sizeof(int)));
+        ASSERT_TRUE(read(values.data(), values.size() * sizeof(double)));
+        ASSERT_TRUE(read(n_collisions.data(), n * sizeof(int)));
+
+        for (int j = 0; j < n; j++, row++)
+        {
+            int frame = row / 2;
+            EXPECT_EQ(index[j], frame);
+            EXPECT_EQ(time[j], 0.05 * frame);
+            EXPECT_EQ(id[j], row % 2);
+            EXPECT_EQ(names[id[j]], id[j] == 0 ? "Ego" : (frame < 600 ? "Target" : "Target2"));
+            for (int k = 0; k < CSV_N_VALUES; k++)
+            {
+                EXPECT_EQ(values[k * n + j], row * 100.0 + k + 0.25);
+            }
+            ASSERT_EQ(n_collisions[j], (id[j] == 1 && frame % 2 == 0) ? 1 : 0);
+            if (n_collisions[j] > 0)
+            {
+                int collision_id;
+                ASSERT_TRUE(read(&collision_id, sizeof(int)));
+                EXPECT_EQ(collision_id, 0);
+            }
+        }
+        EXPECT_EQ(pos, end);
+        pos = end;
+        n_data_blocks++;
+        last_block_rows = n;
+    }
+
+    // Final partial block is written on close
+    EXPECT_EQ(row, 2 * n_frames);
+    EXPECT_GE(n_data_blocks, 2);
+    EXPECT_LT(last_block_rows, CSV_BINARY_CHUNK_ROWS);
+}
+
+TEST(TimeOperations, TestFrameScheduler)
+{
+    // Frames follow absolute deadlines, so total time is given by the number of periods passed
+    SE_FrameScheduler scheduler;
+    EXPECT_EQ(scheduler.IsActive(), false);
+    scheduler.Start(0.002);
+    EXPECT_EQ(scheduler.IsActive(), true);
+
+    scheduler.WaitForNextFrame();
+    __int64 start_time = SE_getMonotonicTimeNs();
+    for (int i = 0; i < 50; i++)
+    {
+        scheduler.WaitForNextFrame();
+    }
+    double elapsed = 1e-9 * (SE_getMonotonicTimeNs() - start_time);
+    EXPECT_EQ(scheduler.GetStats().frames, 51);
+    // Allow for the test process being preempted, which will show as overruns and skipped frames
+    EXPECT_GE(elapsed, 0.1 - 1e-4);
+    EXPECT_LT(elapsed, 0.002 * (50 + scheduler.GetStats().skipped + 1) + 0.05);
+
+    // A long frame is an overrun, and deadlines missed completely are skipped
+    long long overruns = scheduler.GetStats().overruns;
+    long long skipped = scheduler.GetStats().skipped;
+    SE_sleepUntilNs(SE_getMonotonicTimeNs() + 5000000);
+    scheduler.WaitForNextFrame();
+    EXPECT_EQ(scheduler.GetStats().overruns, overruns + 1);
+    EXPECT_GE(scheduler.GetStats().skipped, skipped + 1);
+    EXPECT_GT(scheduler.GetStats().jitter_max_us, 0.0);
+
+    // After restart the next frame is due immediately, a pause before it is not an overrun
+    SE_sleepUntilNs(SE_getMonotonicTimeNs() + 5000000);
+    scheduler.Restart();
+    EXPECT_EQ(scheduler.GetStats().frames, 0);
+    scheduler.WaitForNextFrame();
+    EXPECT_EQ(scheduler.GetStats().frames, 1);
+    EXPECT_EQ(scheduler.GetStats().overruns, 0);
+    EXPECT_EQ(scheduler.GetStats().skipped, 0);
+}
+
+static std::vector<std::string> log_lines;
+
+static void LogCallback(const char* str)
+{
+    log_lines.push_back(str);
+}
+
+TEST(LogOperations, TestAsyncLogger)
+{
+    log_lines.clear();
+    Logger::Inst().SetCallback(LogCallback);
+    Logger::Inst().SetAsync(true);
+    EXPECT_EQ(Logger::Inst().IsAsync(), true);
+
+    // Repeated messages exceeding the rate limit are suppressed, others keep their order
+    for (int i = 0; i < 100; i++)
+    {
+        LOG("message %d", i);
+        LOG("repeated %d", 0);
+    }
+    LOG("other %d", 0);
+    Logger::Inst().Flush();
+    ASSERT_EQ(log_lines.size(), 100 + LOG_RATE_LIMIT + 1);
+    for (int i = 0; i < LOG_RATE_LIMIT; i++)
+    {
+        EXPECT_EQ(log_lines[2 * i], "message " + std::to_string(i));
+        EXPECT_EQ(log_lines[2 * i + 1], "repeated 0");
+    }
+    for (int i = LOG_RATE_LIMIT; i < 100; i++)
+    {
+        EXPECT_EQ(log_lines[LOG_RATE_LIMIT + i], "message " + std::to_string(i));
+    }
+    EXPECT_EQ(log_lines.back(), "other 0");
+
+    // Debug messages are dropped at default level
+    LOG_DEBUG("debug %d", 0);
+    Logger::Inst().SetLevel(LogLevel::LEVEL_DEBUG);
+    LOG_DEBUG("debug %d", 1);
+    Logger::Inst().SetLevel(LogLevel::LEVEL_INFO);
+    Logger::Inst().Flush();
+    EXPECT_EQ(log_lines.back(), "debug 1");
+
+    // Summary of suppressed messages is written when the window ends, without waiting for more messages
+    SE_sleep(1300);
+    Logger::Inst().Flush();
+    EXPECT_EQ(log_lines.back(), "(80 repeated messages suppressed: repeated 0)");
+
+    // Remaining summaries are written when leaving async mode
+    for (int i = 0; i < LOG_RATE_LIMIT + 5; i++)
+    {
+        LOG("repeated %d", 1);
+    }
+    Logger::Inst().SetAsync(false);
+    EXPECT_EQ(Logger::Inst().IsAsync(), false);
+    EXPECT_EQ(log_lines.back(), "(5 repeated messages suppressed: repeated 1)");
+
+    LOG("sync %d", 0);
+    EXPECT_EQ(log_lines.back(), "sync 0");
+
+    Logger::Inst().SetCallback(0);
+}
+
+static void LogAgainCallback(const char* str)
+{
+    log_lines.push_back(str);
+    // Logging from the callback must not block, even when the queue is full
+    LOG("again %d", 0);
+}
+
+static void LogWorker(void* args)
+{
+    (void)args;
+    for (int i = 0; i < 1000; i++)
+    {
+        LOG("worker %d", i);
+    }
+}
+
+TEST(LogOperations, TestAsyncLoggerReentrantAndShutdown)
+{
+    log_lines.clear();
+    Logger::Inst().SetCallback(LogAgainCallback);
+    Logger::Inst().SetAsync(true);
+    for (int i = 0; i < 2 * LOG_QUEUE_SIZE; i++)
+    {
+        LOG("entry %d", i);
+    }
+    Logger::Inst().SetAsync(false);
+    Logger::Inst().SetCallback(0);
+    EXPECT_GT(log_lines.size(), 0u);
+
+    // Leaving async mode while other threads are logging
+    log_lines.clear();
+    Logger::Inst().SetCallback(LogCallback);
+    Logger::Inst().SetAsync(true);
+    SE_Thread worker;
+    worker.Start(LogWorker, nullptr);
+    Logger::Inst().SetAsync(false);
+    worker.Wait();
+    Logger::Inst().SetCallback(0);
+    EXPECT_EQ(Logger::Inst().IsAsync(), false);
+}
+
 INSTANTIATE_TEST_SUITE_P(CommonMini, Local2Global,
     ::testing::Values(std::make_tuple(Coordinate2D{0, 1}, Coordinate2D{1, 1},
                                       -M_PI / 2, Coordinate2D{2, 1}),
@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include <vector>
 #include <chrono>
+#include <random>
 
 #include "pugixml.hpp"
 #include "simple_expr.h"
@@ -121,6 +122,47 @@ TEST_F(FollowRouteTestSmall, FindPathSmall1)
     ASSERT_EQ(path.back().road->GetId(), 5);
 }
 
+TEST_F(FollowRouteTestSmall, FindPathCached)
+{
+    ASSERT_NE(Position::GetOpenDrive(), nullptr);
+    RoadGraph *graph = Position::GetOpenDrive()->GetRoadGraph();
+    ASSERT_NE(graph, nullptr);
+
+    Position start(0, -1, 10, 0);
+    start.SetHeadingRelativeRoadDirection(0);
+    Position target(5, -2, 20, 0);
+
+    LaneIndependentRouter router(Position::GetOpenDrive());
+    std::vector<Node> path = router.CalculatePath(start, target);
+    ASSERT_FALSE(path.empty());
+    int hits = graph->GetCacheHits();
+
+    // Same start road and lane, further along. Expect same path from cache, with weights of new start.
+    Position start2(0, -1, 30, 0);
+    start2.SetHeadingRelativeRoadDirection(0);
+    LaneIndependentRouter router2(Position::GetOpenDrive());
+    std::vector<Node> path2 = router2.CalculatePath(start2, target);
+    EXPECT_EQ(graph->GetCacheHits(), hits + 1);
+    ASSERT_EQ(path2.size(), path.size());
+    for (size_t i = 0; i < path.size(); i++)
+    {
+        EXPECT_EQ(path2[i].road, path[i].road);
+        EXPECT_EQ(path2[i].currentLaneId, path[i].currentLaneId);
+        EXPECT_EQ(path2[i].fromLaneId, path[i].fromLaneId);
+        EXPECT_EQ(path2[i].previous, nullptr);
+        EXPECT_NEAR(path[i].weight - path2[i].weight, 20.0, 1e-6);
+    }
+
+    // Least recently used path is dropped when cache is full
+    graph->SetCacheCapacity(1);
+    Position target2(5, -3, 20, 0);
+    ASSERT_FALSE(router.CalculatePath(start, target2).empty());
+    EXPECT_EQ(graph->GetNumberOfCachedPaths(), 1);
+    router.CalculatePath(start, target);
+    EXPECT_EQ(graph->GetCacheHits(), hits + 1);
+    graph->SetCacheCapacity(ROUTE_CACHE_SIZE);
+}
+
 TEST_F(FollowRouteTestSmall, FindPathSmall2)
 {
     ASSERT_NE(Position::GetOpenDrive(), nullptr);
@@ -585,7 +627,7 @@ TEST_F(FollowRouteTestMediumChangedSpeeds, LogWaypointMedium)
     }
 
     std::ofstream ofs;
-    ofs.open("../../../follow_route_log.csv", std::ofstream::trunc);
+    ofs.open("follow_route_log.csv", std::ofstream::trunc);
 
     LaneIndependentRouter router(Position::GetOpenDrive());
 
@@ -777,6 +819,158 @@ TEST(FollowRouteTest, CalcAverageSpeedForTwoRoadTypes)
     ASSERT_NEAR(averageSpeed, expectedSpeed, 0.01);
 }
 
+static const char* searchModeMaps[] = {"crest-curve.xodr", "curve_r100.xodr", "curves.xodr", "curves_elevation.xodr",
+    "e6mini-lht.xodr", "e6mini.xodr", "fabriksgatan.xodr", "jolengatan.xodr", "multi_intersections.xodr", "soderleden.xodr",
+    "straight_500m.xodr"};
+static const LaneIndependentRouter::SearchMode searchModes[] = {LaneIndependentRouter::SearchMode::DIJKSTRA,
+    LaneIndependentRouter::SearchMode::ASTAR, LaneIndependentRouter::SearchMode::BIDIRECTIONAL};
+
+// Middle of every driving lane in the road network, heading in driving direction
+static std::vector<Position> GetDrivingLanePositions(OpenDrive* odr)
+{
+    std::vector<Position> positions;
+    for (int i = 0; i < odr->GetNumOfRoads(); i++)
+    {
+        Road* road = odr->GetRoadByIdx(i);
+        LaneSection* ls = road->GetLaneSectionByS(road->GetLength() / 2);
+        for (int j = 0; j < ls->GetNumberOfLanes(); j++)
+        {
+            Lane* lane = ls->GetLaneByIdx(j);
+            if (lane->GetId() != 0 && lane->IsDriving())
+            {
+                positions.push_back(Position(road->GetId(), lane->GetId(), road->GetLength() / 2, 0));
+                positions.back().SetHeadingRelativeRoadDirection(lane->GetId() < 0 ? 0.0 : M_PI);
+            }
+        }
+    }
+    return positions;
+}
+
+TEST(FollowRouteTest, SearchModesFindSamePaths)
+{
+    // Random routes on each road network, all strategies. All search modes must find the same paths.
+    const int nQueries = 100;
+    std::mt19937 rng(12345);
+
+    SE_Env::Inst().AddPath("../../../resources/traffic_signals");
+    for (const char* map : searchModeMaps)
+    {
+        ASSERT_TRUE(Position::LoadOpenDrive((std::string("../../../resources/xodr/") + map).c_str()));
+        OpenDrive* odr = Position::GetOpenDrive();
+        odr->GetRoadGraph()->SetCacheCapacity(0);
+
+        std::vector<Position> positions = GetDrivingLanePositions(odr);
+        ASSERT_FALSE(positions.empty());
+
+        int nodes[3] = {0, 0, 0};
+        int nFound = 0;
+        int nSame[3] = {0, 0, 0};
+        LaneIndependentRouter router(odr);
+        std::uniform_int_distribution<size_t> pick(0, positions.size() - 1);
+        for (int q = 0; q < nQueries; q++)
+        {
+            Position start = positions[pick(rng)];
+            Position target = positions[pick(rng)];
+            target.SetRouteStrategy(static_cast<Position::RouteStrategy>(q % 3));
+
+            std::vector<Node> paths[3];
+            for (int m = 0; m < 3; m++)
+            {
+                router.SetSearchMode(searchModes[m]);
+                paths[m] = router.CalculatePath(start, target);
+                nodes[m] += router.GetNodesExpanded();
+            }
+
+            // All modes find the same path, also when there are several ones with same weight
+            nFound += paths[0].empty() ? 0 : 1;
+            for (int m = 0; m < 3; m++)
+            {
+                ASSERT_EQ(paths[m].empty(), paths[0].empty());
+                if (paths[0].empty())
+                {
+                    continue;
+                }
+                EXPECT_NEAR(paths[m].back().weight, paths[0].back().weight, 1e-6);
+                bool same = paths[m].size() == paths[0].size();
+                for (size_t i = 0; same && i < paths[0].size(); i++)
+                {
+                    same = paths[m][i].road == paths[0][i].road && paths[m][i].currentLaneId == paths[0][i].currentLaneId &&
+                           paths[m][i].fromLaneId == paths[0][i].fromLaneId;
+                }
+                nSame[m] += same ? 1 : 0;
+            }
+        }
+
+        for (int m = 0; m < 3; m++)
+        {
+            EXPECT_EQ(nSame[m], nFound) << map << " search mode " << m;
+        }
+        EXPECT_LE(nodes[1], nodes[0]) << map;
+    }
+}
+
+// Benchmark, run with --gtest_also_run_disabled_tests --gtest_filter=*SearchModeBenchmark*
+// Nodes expanded and time per query is reported for each map, search mode and route strategy, printed and
+// recorded as test properties (see --gtest_output=xml)
+TEST(FollowRouteTest, DISABLED_SearchModeBenchmark)
+{
+    const char* modeNames[] = {"Dijkstra", "A*", "Bidirectional"};
+    const char* strategyNames[] = {"Shortest", "Fastest", "MinIntersections"};
+    const int nQueries = 200;
+    const int nRepeats = 5;  // per query and search mode, to get measurable times on small road networks
+    std::mt19937 rng(12345);
+
+    SE_Env::Inst().AddPath("../../../resources/traffic_signals");
+    for (const char* map : searchModeMaps)
+    {
+        ASSERT_TRUE(Position::LoadOpenDrive((std::string("../../../resources/xodr/") + map).c_str()));
+        OpenDrive* odr = Position::GetOpenDrive();
+        odr->GetRoadGraph()->SetCacheCapacity(0);
+
+        std::vector<Position> positions = GetDrivingLanePositions(odr);
+        ASSERT_FALSE(positions.empty());
+
+        LaneIndependentRouter router(odr);
+        std::uniform_int_distribution<size_t> pick(0, positions.size() - 1);
+        for (int strategy = 0; strategy < 3; strategy++)
+        {
+            long long nodes[3] = {0, 0, 0};
+            __int64 time_ns[3] = {0, 0, 0};
+            int nFound = 0;
+            for (int q = 0; q < nQueries; q++)
+            {
+                Position start = positions[pick(rng)];
+                Position target = positions[pick(rng)];
+                target.SetRouteStrategy(static_cast<Position::RouteStrategy>(strategy));
+
+                for (int m = 0; m < 3; m++)
+                {
+                    router.SetSearchMode(searchModes[m]);
+                    bool found = false;
+                    __int64 t0 = SE_getMonotonicTimeNs();
+                    for (int r = 0; r < nRepeats; r++)
+                    {
+                        found = !router.CalculatePath(start, target).empty();
+                    }
+                    time_ns[m] += SE_getMonotonicTimeNs() - t0;
+                    nodes[m] += router.GetNodesExpanded();
+                    nFound += (m == 0 && found) ? 1 : 0;
+                }
+            }
+
+            for (int m = 0; m < 3; m++)
+            {
+                char value[128];
+                snprintf(value, sizeof(value), "%3d/%d paths, %7.1f nodes expanded, %8.2f us per query", nFound, nQueries,
+                    static_cast<double>(nodes[m]) / nQueries, 1e-3 * static_cast<double>(time_ns[m]) / (nQueries * nRepeats));
+                std::string key = std::string(map) + " " + modeNames[m] + " " + strategyNames[strategy];
+                RecordProperty(key, value);
+                printf("%-26s %-13s %-16s %s\n", map, modeNames[m], strategyNames[strategy], value);
+            }
+        }
+    }
+}
+
 // Uncomment to print log output to console
 //#define LOG_TO_CONSOLE
 
@@ -3,6 +3,7 @@
 #include <gmock/gmock.h>
 #include <vector>
 #include <stdexcept>
+#include <random>
 
 #include "RoadManager.hpp"
 
@@ -1599,6 +1600,95 @@ TEST(TrajectoryTest, PolyLineBase_YawInterpolation)
     EXPECT_NEAR(v.h, 0.958407, 1e-5);
 }
 
+TEST(TrajectoryTest, PolyLineBase_SearchLongTrail)
+{
+    // Winding trail crossing itself, one vertex per 0.05 s
+    PolyLineBase pline;
+    for (int i = 0; i < 2000; i++)
+    {
+        double a = 0.01 * i;
+        TrajVertex* v = pline.AddVertex(100.0 * sin(a) + 3.0 * sin(7 * a), 50.0 * sin(2 * a), 0.0);
+        v->time = 0.05 * i;
+    }
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> coord(-120.0, 120.0);
+    std::uniform_int_distribution<int> index(0, pline.GetNumberOfVertices() - 1);
+    TrajVertex pos;
+    TrajVertex pos_ref;
+    int idx = 0;
+
+    for (int k = 0; k < 200; k++)
+    {
+        // Closest point over whole trail, compare with plain scan of all segments
+        double x = coord(gen);
+        double y = coord(gen);
+        double dist_ref = LARGE_NUMBER;
+        for (int i = 0; i < pline.GetNumberOfVertices() - 1; i++)
+        {
+            TrajVertex* v0 = pline.GetVertex(i);
+            TrajVertex* v1 = pline.GetVertex(i + 1);
+            double len2 = pow(v1->x - v0->x, 2) + pow(v1->y - v0->y, 2);
+            double a = CLAMP(((x - v0->x) * (v1->x - v0->x) + (y - v0->y) * (v1->y - v0->y)) / len2, 0.0, 1.0);
+            dist_ref = MIN(dist_ref, PointDistance2D(x, y, v0->x + a * (v1->x - v0->x), v0->y + a * (v1->y - v0->y)));
+        }
+        ASSERT_EQ(pline.FindClosestPoint(x, y, pos, idx, 0), 0);
+        EXPECT_NEAR(PointDistance2D(x, y, pos.x, pos.y), dist_ref, 1e-6);
+
+        // Evaluate gives same result wherever search starts
+        double s = pline.length_ * k / 200.0;
+        int i0 = pline.Evaluate(s, pos_ref, 0);
+        EXPECT_EQ(pline.Evaluate(s, pos, index(gen)), i0);
+        EXPECT_DOUBLE_EQ(pos.x, pos_ref.x);
+        EXPECT_DOUBLE_EQ(pos.y, pos_ref.y);
+
+        // Time maps to s by interpolation within segment
+        double time = 99.9 * (k % 37) / 36.0;
+        int i = static_cast<int>(time / 0.05);
+        double w = (time - pline.GetVertex(i)->time) / (pline.GetVertex(i + 1)->time - pline.GetVertex(i)->time);
+        ASSERT_EQ(pline.Time2S(time, s), 0);
+        EXPECT_NEAR(s, pline.GetVertex(i)->s + w * (pline.GetVertex(i + 1)->s - pline.GetVertex(i)->s), 1e-6);
+    }
+
+    // Moving a vertex is reflected in closest point search
+    pline.UpdateVertex(1000, 500.0, 500.0, 0.0);
+    ASSERT_EQ(pline.FindClosestPoint(490.0, 495.0, pos, idx, 0), 0);
+    EXPECT_TRUE(idx == 999 || idx == 1000);
+    EXPECT_NEAR(pos.x, 500.0, 10.0);
+}
+
+TEST(TrajectoryTest, PolyLineBase_RemoveVertices)
+{
+    // Straight line along x axis, one vertex per meter
+    PolyLineBase pline;
+    for (int i = 0; i < 20; i++)
+    {
+        pline.AddVertex(static_cast<double>(i), 0.0, 0.0);
+    }
+    TrajVertex pos;
+    int idx = 0;
+
+    // Adding vertices keeps the revision, removal from start or end is signaled by the revision counter
+    int revision = pline.revision_;
+    pline.AddVertex(20.0, 0.0, 0.0);
+    EXPECT_EQ(pline.revision_, revision);
+    pline.RemoveFirstVertices(10);
+    EXPECT_EQ(pline.GetNumberOfVertices(), 11);
+    EXPECT_EQ(pline.revision_, revision + 1);
+    EXPECT_DOUBLE_EQ(pline.GetVertex(0)->x, 10.0);
+    pline.RemoveLastVertex();
+    EXPECT_EQ(pline.GetNumberOfVertices(), 10);
+    EXPECT_EQ(pline.revision_, revision + 2);
+    EXPECT_DOUBLE_EQ(pline.GetVertex(-1)->x, 19.0);
+
+    // Search only considers remaining vertices
+    ASSERT_EQ(pline.FindClosestPoint(2.0, 1.0, pos, idx, 0), 0);
+    EXPECT_EQ(idx, 0);
+    EXPECT_NEAR(pos.x, 10.0, 1e-6);
+    ASSERT_EQ(pline.FindClosestPoint(25.0, 1.0, pos, idx, 0), 0);
+    EXPECT_NEAR(pos.x, 19.0, 1e-6);
+}
+
 TEST(DistanceTest, CalcDistanceLong)
 {
     double dist = 0.0;
@@ -1739,9 +1829,107 @@ TEST(NurbsTest, TestNurbsPosition)
     EXPECT_NEAR(v.y, 4.0, 1e-3);
 
     n.Evaluate(0.40045 * n.GetLength(), Shape::TrajectoryParamType::TRAJ_PARAM_TYPE_S, v);
-    EXPECT_NEAR(v.x, -1.248623, 1e-5);
-    EXPECT_NEAR(v.y, -0.087722, 1e-5);
-    EXPECT_NEAR(v.p, 0.360046, 1e-5);
+    EXPECT_NEAR(v.x, -1.248933, 1e-5);
+    EXPECT_NEAR(v.y, -0.087789, 1e-5);
+    EXPECT_NEAR(v.p, 0.360010, 1e-5);
+}
+
+// Reference implementation, the recursive definition of the basis functions
+static double NurbsBasisReference(double x, int i, int k, const std::vector<double>& t)
+{
+    if (k == 1)
+    {
+        return t[i] <= x && x < t[i + 1] ? 1.0 : 0.0;
+    }
+
+    double value = 0.0;
+    if (t[i + k - 1] - t[i] > 0)
+    {
+        value += (x - t[i]) / (t[i + k - 1] - t[i]) * NurbsBasisReference(x, i, k - 1, t);
+    }
+    if (t[i + k] - t[i + 1] > 0)
+    {
+        value += (t[i + k] - x) / (t[i + k] - t[i + 1]) * NurbsBasisReference(x, i + 1, k - 1, t);
+    }
+
+    return value;
+}
+
+TEST(NurbsTest, TestNurbsEvaluationRegression)
+{
+    // Long curve with straight parts, varying weights and a repeated interior knot
+    double ctrl[][3] = { {0, 0, 1}, {40, 0, 1}, {80, 0, 1}, {120, 0, 1}, {160, 0, 1}, {180, 10, 2}, {190, 40, 0.5}, {190, 80, 1},
+        {190, 120, 1}, {160, 150, 3}, {120, 150, 1} };
+    int n = sizeof(ctrl) / sizeof(ctrl[0]);
+
+    for (int order = 2; order < 6; order++)
+    {
+        NurbsShape nurbs(order);
+        for (int i = 0; i < n; i++)
+        {
+            nurbs.AddControlPoint(Position(ctrl[i][0], ctrl[i][1], 0.0, 0.0, 0.0, 0.0), i * 2.0, ctrl[i][2], true);
+        }
+
+        std::vector<double> knots;
+        for (int i = 0; i < n + order; i++)
+        {
+            knots.push_back(CLAMP(i - order + 1, 0, n - order + 1));
+        }
+        if (order > 2)
+        {
+            knots[order + 1] = knots[order];  // repeated knot
+        }
+        nurbs.AddKnots(knots);
+        nurbs.CalculatePolyLine();
+
+        // Curve points equal the ones of the recursive definition
+        for (int k = 0; k < 100 * knots.back(); k++)
+        {
+            double t = 0.01 * k;
+            double x = 0.0;
+            double y = 0.0;
+            double w = 0.0;
+            for (int i = 0; i < n; i++)
+            {
+                double b = NurbsBasisReference(t, i, order, knots) * ctrl[i][2];
+                x += b * ctrl[i][0];
+                y += b * ctrl[i][1];
+                w += b;
+            }
+
+            TrajVertex v;
+            nurbs.EvaluateInternal(t, v);
+            EXPECT_NEAR(v.x, x / w, 1e-8);
+            EXPECT_NEAR(v.y, y / w, 1e-8);
+        }
+
+        // Polyline follows the curve within tolerance
+        TrajVertex v;
+        TrajVertex vc;
+        for (double s = 0.0; s < nurbs.GetLength(); s += 0.5)
+        {
+            nurbs.pline_.Evaluate(s, v);
+            nurbs.EvaluateInternal(v.p, vc);
+            EXPECT_NEAR(v.x, vc.x, 0.02);
+            EXPECT_NEAR(v.y, vc.y, 0.02);
+        }
+        EXPECT_NEAR(nurbs.pline_.GetVertex(-1)->time, 20.0, 1e-5);
+
+        // Fewer vertices than the uniform sampling, 1 m along the control polygon, especially along the first straight part
+        double polygon_length = 0.0;
+        for (int i = 1; i < n; i++)
+        {
+            polygon_length += PointDistance2D(ctrl[i - 1][0], ctrl[i - 1][1], ctrl[i][0], ctrl[i][1]);
+        }
+        EXPECT_LT(nurbs.pline_.GetNumberOfVertices(), 0.75 * polygon_length);
+
+        int n_straight = 0;
+        for (int i = 0; i < nurbs.pline_.GetNumberOfVertices() && nurbs.pline_.GetVertex(i)->x < 100.0; i++)
+        {
+            n_straight++;
+        }
+        EXPECT_LT(n_straight, 50);
+    }
 }
 
 TEST(Route, TestAssignRoute)
@@ -11,6 +11,7 @@
 #include <vector>
 #include <stdexcept>
 #include <fstream>
+#include <cstdio>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -2299,6 +2300,52 @@ TEST(GatewayTest, TestReportToGatewayInCallback)
 	SE_Close();
 }
 
+TEST(GatewayTest, TestBulkGetAndReportStates)
+{
+	std::string scenario_file = "../../../resources/xosc/cut-in.xosc";
+	SE_ScenarioObjectState states[3];
+	SE_ScenarioObjectState state;
+
+	EXPECT_EQ(SE_GetAllObjectStates(states, 3), -1);
+	ASSERT_EQ(SE_Init(scenario_file.c_str(), 0, 0, 0, 0), 0);
+	SE_StepDT(0.1f);
+
+	ASSERT_EQ(SE_GetAllObjectStates(states, 3), 2);
+	for (int i = 0; i < 2; i++)
+	{
+		ASSERT_EQ(SE_GetObjectState(SE_GetId(i), &state), 0);
+		EXPECT_EQ(states[i].id, state.id);
+		EXPECT_FLOAT_EQ(states[i].x, state.x);
+		EXPECT_FLOAT_EQ(states[i].y, state.y);
+		EXPECT_FLOAT_EQ(states[i].speed, state.speed);
+		EXPECT_EQ(states[i].laneId, state.laneId);
+	}
+
+	// Capacity less than number of objects, only first state filled in
+	states[1].id = -1;
+	EXPECT_EQ(SE_GetAllObjectStates(states, 1), 2);
+	EXPECT_EQ(states[1].id, -1);
+	states[1].id = SE_GetId(1);
+
+	// Move both objects in one call, including a state for an unknown object which is skipped
+	states[0].x += 10.0f;
+	states[0].speed = 5.0f;
+	states[1].y += 2.0f;
+	states[1].wheel_angle = 0.1f;
+	states[2] = states[1];
+	states[2].id = 100;
+	EXPECT_EQ(SE_ReportObjectStatesBatch(states, 3), 2);
+
+	SE_GetObjectState(states[0].id, &state);
+	EXPECT_FLOAT_EQ(state.x, states[0].x);
+	EXPECT_FLOAT_EQ(state.speed, 5.0f);
+	SE_GetObjectState(states[1].id, &state);
+	EXPECT_FLOAT_EQ(state.y, states[1].y);
+	EXPECT_FLOAT_EQ(state.wheel_angle, 0.1f);
+
+	SE_Close();
+}
+
 static void ghostParamDeclCB(void* user_arg)
 {
 	bool ghostMode = *((bool*)user_arg);
@@ -2858,28 +2905,14 @@ TEST(DirectJunctionTest, TestVariousRoutes)
 	SE_RegisterParameterDeclarationCallback(0, 0);
 }
 
-static void ReadDat(std::string filename, std::vector<scenarioengine::ReplayEntry>& entries)
+static void ReadDat(std::string filename, std::vector<scenarioengine::ObjectStateStructDat>& entries)
 {
-	std::ifstream file;
-	scenarioengine::DatHeader header;
-
-	file.open(filename, std::ofstream::binary);
-	ASSERT_EQ(file.fail(), false);
-
-	file.read((char*)&header, sizeof(header));
+	scenarioengine::Replay replay(filename, false);
 
-	scenarioengine::ReplayEntry entry;
-
-	while (!file.eof())
+	for (size_t i = 0; i < replay.GetNumberOfEntries(); i++)
 	{
-		file.read((char*)&entry.state, sizeof(entry.state));
-
-		if (!file.eof())
-		{
-			entries.push_back(entry);
-		}
+		entries.push_back(*replay.GetStateByIndex(i));
 	}
-	file.close();
 }
 
 TEST(ExternalControlTest, TestTimings)
@@ -2945,240 +2978,240 @@ TEST(ExternalControlTest, TestTimings)
 		SE_Close();
 
 		// Check .dat file
-		std::vector<scenarioengine::ReplayEntry> entries;
+		std::vector<scenarioengine::ObjectStateStructDat> entries;
 		ReadDat("sim.dat", entries);
 
 		// Check first timestep (-3.0)
 		int i = 0;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -3.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -3.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -3.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Target");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -3.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Target");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -3.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -3.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 		// Check timestep before 0.0
-		while (i < entries.size() - 1 && entries[i].state.info.timeStamp < -SMALL_NUMBER) i++;
+		while (i < entries.size() - 1 && entries[i].info.timeStamp < -SMALL_NUMBER) i++;
 		i -= 3;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -0.05, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -0.05, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -0.05, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Target");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -0.05, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Target");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, -0.05, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-		EXPECT_NEAR(entries[i].state.pos.x, 39.5, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, -0.05, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+		EXPECT_NEAR(entries[i].pos.x, 39.5, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 		// Check timestep 0.0
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, 0.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Target");
-		EXPECT_NEAR(entries[i].state.pos.x, 10.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, 0.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Target");
+		EXPECT_NEAR(entries[i].pos.x, 10.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-		EXPECT_NEAR(entries[i].state.pos.x, 40.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, 0.0, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+		EXPECT_NEAR(entries[i].pos.x, 40.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 		// Check timestep after 0.0
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, dt, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego");
-		EXPECT_NEAR(entries[i].state.pos.x, 111.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, dt, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego");
+		EXPECT_NEAR(entries[i].pos.x, 111.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, dt, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Target");
-		EXPECT_NEAR(entries[i].state.pos.x, 12.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, dt, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Target");
+		EXPECT_NEAR(entries[i].pos.x, 12.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 		i++;
-		EXPECT_NEAR(entries[i].state.info.timeStamp, dt, 1E-3);
-		EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-		EXPECT_NEAR(entries[i].state.pos.x, 41.0, 1E-3);
-		EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+		EXPECT_NEAR(entries[i].info.timeStamp, dt, 1E-3);
+		EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+		EXPECT_NEAR(entries[i].pos.x, 41.0, 1E-3);
+		EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 		if (j == 1)  // additional restart tests
 		{
 			// Check first restart
 			i = 243;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 131.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 131.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 52.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 52.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 61.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 61.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.75, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 132.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.75, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 132.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.75, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 54.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.75, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 54.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.75, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 131.502, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.75, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 131.502, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.70, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 132.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.70, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 132.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.70, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 54.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.70, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 54.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, -0.70, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 132.005, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, -0.70, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 132.005, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i = 423;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 132.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 132.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 54.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 54.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 169.124, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 169.124, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 232.008, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 232.008, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 56.0, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 56.0, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 2.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 170.624, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 2.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 170.624, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i = 600;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 312.624, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 312.624, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 172.000, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 172.000, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 257.624, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 257.624, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 5.25, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 314.124, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 5.25, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 314.124, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 5.25, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 174.000, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 5.25, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 174.000, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 5.25, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 313.376, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 5.25, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 313.376, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i = 774;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 314.124, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 314.124, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 174.000, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 174.000, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.1, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 363.748, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.1, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 363.748, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i = 780;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 314.124, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 314.124, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 174.000, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 174.000, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.2, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 365.748, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.2, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 365.748, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego");
-			EXPECT_NEAR(entries[i].state.pos.x, 414.133, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego");
+			EXPECT_NEAR(entries[i].pos.x, 414.133, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Target");
-			EXPECT_NEAR(entries[i].state.pos.x, 176.000, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -4.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Target");
+			EXPECT_NEAR(entries[i].pos.x, 176.000, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -4.5, 1E-3);
 			i++;
-			EXPECT_NEAR(entries[i].state.info.timeStamp, 8.3, 1E-3);
-			EXPECT_STREQ(entries[i].state.info.name, "Ego_ghost");
-			EXPECT_NEAR(entries[i].state.pos.x, 367.748, 1E-3);
-			EXPECT_NEAR(entries[i].state.pos.y, -1.5, 1E-3);
+			EXPECT_NEAR(entries[i].info.timeStamp, 8.3, 1E-3);
+			EXPECT_STREQ(entries[i].info.name, "Ego_ghost");
+			EXPECT_NEAR(entries[i].pos.x, 367.748, 1E-3);
+			EXPECT_NEAR(entries[i].pos.y, -1.5, 1E-3);
 
 			// Also check a few entries in the csv log file, focus on scenario controlled entity "Target"
 			std::vector<std::vector<std::string>> csv;
@@ -3357,53 +3390,156 @@ TEST(ReplayTest, TestMultiReplayDifferentTimeSteps)
 		scenarioengine::Replay* replay = new scenarioengine::Replay(".", "multirep_test", "");
 		EXPECT_EQ(replay->GetNumberOfScenarios(), 2);
 
-		EXPECT_NEAR(replay->data_[0].state.info.timeStamp, -2.5, 1E-3);
-		EXPECT_STREQ(replay->data_[0].state.info.name, "Ego");
-		EXPECT_STREQ(replay->data_[1].state.info.name, "Ego_ghost");
-		EXPECT_STREQ(replay->data_[2].state.info.name, "Ego");
-		EXPECT_NEAR(replay->data_[2].state.info.timeStamp, -2.45, 1E-3);
-		EXPECT_NEAR(replay->data_[4].state.info.timeStamp, -2.40, 1E-3);
-		EXPECT_NEAR(replay->data_[100].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_NEAR(replay->data_[100].state.info.id, 0, 1E-3);
-		EXPECT_NEAR(replay->data_[101].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_NEAR(replay->data_[101].state.info.id, 1, 1E-3);
-		EXPECT_NEAR(replay->data_[102].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_NEAR(replay->data_[102].state.info.id, 100, 1E-3);
-		EXPECT_NEAR(replay->data_[103].state.info.timeStamp, 0.0, 1E-3);
-		EXPECT_NEAR(replay->data_[103].state.info.id, 101, 1E-3);
-		EXPECT_NEAR(replay->data_[104].state.info.timeStamp, 0.01, 1E-3);
-		EXPECT_NEAR(replay->data_[104].state.info.id, 0, 1E-3);
-		EXPECT_NEAR(replay->data_[108].state.info.timeStamp, 0.02, 1E-3);
-		EXPECT_NEAR(replay->data_[108].state.info.id, 0, 1E-3);
-		EXPECT_NEAR(replay->data_[139].state.info.timeStamp, 0.09, 1E-3);
-		EXPECT_NEAR(replay->data_[139].state.info.id, 101, 1E-3);
-		EXPECT_NEAR(replay->data_[140].state.info.timeStamp, 0.1, 1E-3);
-		EXPECT_NEAR(replay->data_[140].state.info.id, 0, 1E-3);
-
-		EXPECT_NEAR(replay->data_[2012].state.info.timeStamp, 4.78, 1E-3);
-		EXPECT_NEAR(replay->data_[2012].state.info.id, 0, 1E-3);
-		EXPECT_NEAR(replay->data_[2015].state.info.timeStamp, 4.78, 1E-3);
-		EXPECT_NEAR(replay->data_[2015].state.info.id, 101, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(0)->info.timeStamp, -2.5, 1E-3);
+		EXPECT_STREQ(replay->GetStateByIndex(0)->info.name, "Ego");
+		EXPECT_STREQ(replay->GetStateByIndex(1)->info.name, "Ego_ghost");
+		EXPECT_STREQ(replay->GetStateByIndex(2)->info.name, "Ego");
+		EXPECT_NEAR(replay->GetStateByIndex(2)->info.timeStamp, -2.45, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(4)->info.timeStamp, -2.40, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(100)->info.timeStamp, 0.0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(100)->info.id, 0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(101)->info.timeStamp, 0.0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(101)->info.id, 1, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(102)->info.timeStamp, 0.0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(102)->info.id, 100, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(103)->info.timeStamp, 0.0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(103)->info.id, 101, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(104)->info.timeStamp, 0.01, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(104)->info.id, 0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(108)->info.timeStamp, 0.02, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(108)->info.id, 0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(139)->info.timeStamp, 0.09, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(139)->info.id, 101, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(140)->info.timeStamp, 0.1, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(140)->info.id, 0, 1E-3);
+
+		EXPECT_NEAR(replay->GetStateByIndex(2012)->info.timeStamp, 4.78, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(2012)->info.id, 0, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(2015)->info.timeStamp, 4.78, 1E-3);
+		EXPECT_NEAR(replay->GetStateByIndex(2015)->info.id, 101, 1E-3);
 
 		if (k == 0)
 		{
-			EXPECT_NEAR(replay->data_[2012].state.pos.y, 130.995, 1E-3);
-			EXPECT_NEAR(replay->data_[2015].state.pos.y, 207.385, 1E-3);
-			EXPECT_NEAR(replay->data_[6009].state.info.timeStamp, 19.53, 1E-3);
-			EXPECT_NEAR(replay->data_[6009].state.info.id, 1, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(2012)->pos.y, 130.995, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(2015)->pos.y, 207.385, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(6009)->info.timeStamp, 19.53, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(6009)->info.id, 1, 1E-3);
 		}
 		else
 		{
-			EXPECT_NEAR(replay->data_[2012].state.pos.y, 130.924, 1E-3);
-			EXPECT_NEAR(replay->data_[2015].state.pos.y, 210.728, 1E-3);
-			EXPECT_NEAR(replay->data_[4213].state.info.timeStamp, 19.8, 1E-3);
-			EXPECT_NEAR(replay->data_[4213].state.info.id, 1, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(2012)->pos.y, 130.924, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(2015)->pos.y, 210.728, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(4213)->info.timeStamp, 19.8, 1E-3);
+			EXPECT_NEAR(replay->GetStateByIndex(4213)->info.id, 1, 1E-3);
 		}
 
 		delete replay;
 	}
 }
 
+static void WriteDatV3(std::string filename, int n_frames, int n_objects)
+{
+	scenarioengine::DatHeader header;
+	memset(&header, 0, sizeof(header));
+	header.version = DAT_FILE_FORMAT_VERSION;
+
+	std::vector<scenarioengine::ObjectStateStructDat> states;
+	scenarioengine::ObjectStateStructDat state;
+	for (int i = 0; i < n_frames; i++)
+	{
+		for (int j = 0; j < n_objects; j++)
+		{
+			memset(&state, 0, sizeof(state));
+			state.info.id = j;
+			state.info.timeStamp = static_cast<float>(0.05 * i);
+			snprintf(state.info.name, NAME_LEN, "obj%d", j);
+			state.info.speed = static_cast<float>(10.0 + j);
+			state.pos.x = static_cast<float>(i * 0.5 + j * 10.0);
+			state.pos.laneId = -1 - j;
+			states.push_back(state);
+		}
+	}
+
+	std::vector<char> buf;
+	scenarioengine::DatEncoder encoder;
+	encoder.Encode(states.data(), states.size(), buf);
+
+	std::ofstream file(filename, std::ofstream::binary);
+	file.write(reinterpret_cast<char*>(&header), sizeof(header));
+	file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+}
+
+TEST(ReplayTest, TestIndexFile)
+{
+	std::string dat_filename = "index_test.dat";
+	std::string idx_filename = dat_filename + REPLAY_INDEX_FILE_EXT;
+
+	// Enough records for the delta encoded recording to be decoded in several chunks
+	WriteDatV3(dat_filename, 2000, 3);
+	std::remove(idx_filename.c_str());
+
+	scenarioengine::Replay* replay = new scenarioengine::Replay(dat_filename, true, scenarioengine::Replay::IndexFile::READ_OR_CREATE);
+	ASSERT_EQ(replay->GetNumberOfEntries(), 6000);
+	ASSERT_EQ(replay->GetNumberOfFrames(), 2000);
+	delete replay;
+
+	std::ifstream idx_file(idx_filename, std::ifstream::binary | std::ifstream::ate);
+	ASSERT_TRUE(idx_file.is_open());
+	std::streamoff idx_size = idx_file.tellg();
+	idx_file.close();
+
+	// Index is loaded, compare with a replay building its own frame index. Access backwards to switch chunks.
+	replay = new scenarioengine::Replay(dat_filename, true, scenarioengine::Replay::IndexFile::READ_OR_CREATE);
+	scenarioengine::Replay reference(dat_filename, true);
+	ASSERT_EQ(replay->GetNumberOfEntries(), reference.GetNumberOfEntries());
+	ASSERT_EQ(replay->GetNumberOfFrames(), reference.GetNumberOfFrames());
+	for (size_t i = 0; i < replay->GetNumberOfFrames(); i++)
+	{
+		EXPECT_EQ(replay->GetFrame(i)->first, reference.GetFrame(i)->first);
+		EXPECT_EQ(replay->GetFrame(i)->n_entries, reference.GetFrame(i)->n_entries);
+		EXPECT_EQ(replay->GetFrame(i)->timestamp, reference.GetFrame(i)->timestamp);
+	}
+	for (size_t i = replay->GetNumberOfEntries(); i > 0; i--)
+	{
+		scenarioengine::ObjectStateStructDat* state = replay->GetStateByIndex(i - 1);
+		EXPECT_EQ(state->info.id, static_cast<int>((i - 1) % 3));
+		EXPECT_EQ(state->info.timeStamp, static_cast<float>(0.05 * ((i - 1) / 3)));
+		EXPECT_EQ(state->pos.x, reference.GetStateByIndex(i - 1)->pos.x);
+		EXPECT_STREQ(state->info.name, reference.GetStateByIndex(i - 1)->info.name);
+	}
+	delete replay;
+
+	// Recording replaced, outdated index must be ignored and recreated
+	WriteDatV3(dat_filename, 3000, 3);
+	replay = new scenarioengine::Replay(dat_filename, true, scenarioengine::Replay::IndexFile::READ_OR_CREATE);
+	EXPECT_EQ(replay->GetNumberOfEntries(), 9000);
+	EXPECT_EQ(replay->GetNumberOfFrames(), 3000);
+	EXPECT_EQ(replay->GetFrame(2999)->first, 8997);
+	delete replay;
+
+	idx_file.open(idx_filename, std::ifstream::binary | std::ifstream::ate);
+	ASSERT_TRUE(idx_file.is_open());
+	EXPECT_GT(idx_file.tellg(), idx_size);
+	idx_file.seekg(0);
+	std::vector<char> idx_data((std::istreambuf_iterator<char>(idx_file)), std::istreambuf_iterator<char>());
+	idx_file.close();
+
+	// Corrupt index, last frame pointing beyond the entries. Must be ignored.
+	scenarioengine::ReplayFrame* last_frame = reinterpret_cast<scenarioengine::ReplayFrame*>(idx_data.data() + idx_data.size() - sizeof(scenarioengine::ReplayFrame));
+	last_frame->first = 100000;
+	std::ofstream corrupt_file(idx_filename, std::ofstream::binary);
+	corrupt_file.write(idx_data.data(), static_cast<std::streamsize>(idx_data.size()));
+	corrupt_file.close();
+
+	replay = new scenarioengine::Replay(dat_filename, true, scenarioengine::Replay::IndexFile::READ_OR_CREATE);
+	EXPECT_EQ(replay->GetNumberOfFrames(), 3000);
+	EXPECT_EQ(replay->GetFrame(2999)->first, 8997);
+	delete replay;
+
+	std::remove(dat_filename.c_str());
+	std::remove(idx_filename.c_str());
+}
+
 void ConditionCallbackInstance1(const char* element_name, double timestamp)
 {
 	EXPECT_STREQ(element_name, "act_start");
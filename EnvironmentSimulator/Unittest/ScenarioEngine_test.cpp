@@ -4,6 +4,8 @@
 #include <vector>
 #include <stdexcept>
 #include <array>
+#include <map>
+#include <set>
 
 #include "ScenarioEngine.hpp"
 #include "ScenarioReader.hpp"
@@ -12,6 +14,10 @@
 #include "OSCParameterDistribution.hpp"
 #include "pugixml.hpp"
 #include "simple_expr.h"
+#include "DatFile.hpp"
+#include "SharedMemoryExchange.hpp"
+#include "UDPLockstepExchange.hpp"
+#include "IdealSensor.hpp"
 
 using namespace roadmanager;
 using namespace scenarioengine;
@@ -368,6 +374,30 @@ TEST(TrajectoryTest, PolyLineContinuosSpeed)
     delete se;
 }
 
+TEST(CatalogTest, CatalogCache)
+{
+    // Second load of same scenario should reuse the parsed catalog
+    ScenarioEngine* se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/brake_by_trajectory_100-0.xosc");
+    ASSERT_NE(se, nullptr);
+    double length = se->entities_.object_[0]->boundingbox_.dimensions_.length_;
+    delete se;
+
+    int hits = CatalogCache::Inst().GetNumberOfHits();
+    int misses = CatalogCache::Inst().GetNumberOfMisses();
+    se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/brake_by_trajectory_100-0.xosc");
+    ASSERT_NE(se, nullptr);
+    EXPECT_GE(CatalogCache::Inst().GetNumberOfHits(), hits + 1);
+    EXPECT_EQ(CatalogCache::Inst().GetNumberOfMisses(), misses);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[0]->boundingbox_.dimensions_.length_, length);
+    delete se;
+
+    // Documents stay valid for catalogs in use when cache is cleared
+    se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/brake_by_trajectory_100-0.xosc");
+    CatalogCache::Inst().Clear();
+    EXPECT_EQ(se->scenarioReader->LoadCatalog("VehicleCatalog")->FindEntryByName("car_red")->GetNode().name(), std::string("Vehicle"));
+    delete se;
+}
+
 TEST(ExpressionTest, EnsureResult)
 {
     ASSERT_DOUBLE_EQ(eval_expr("1 + 1"), 2.0);
@@ -427,6 +457,56 @@ TEST(ExpressionTest, EnsureResult)
     EXPECT_NEAR(eval_expr("abs(-2.9)"), 2.9, 1e-5);
 }
 
+TEST(ExpressionTest, ParametersInExpression)
+{
+    pugi::xml_document doc;
+    ASSERT_EQ(doc.load_string(
+        "<Root>"
+        "  <ParameterDeclarations>"
+        "    <ParameterDeclaration name=\"Speed\" parameterType=\"double\" value=\"10.5\"/>"
+        "    <ParameterDeclaration name=\"Lanes\" parameterType=\"integer\" value=\"3\"/>"
+        "    <ParameterDeclaration name=\"Active\" parameterType=\"boolean\" value=\"true\"/>"
+        "  </ParameterDeclarations>"
+        "  <Local>"
+        "    <ParameterDeclaration name=\"Lanes\" parameterType=\"integer\" value=\"5\"/>"
+        "  </Local>"
+        "  <Attr a=\"${$Speed * 2 + $Lanes}\" b=\"${$Active and $Lanes > 2}\" c=\"$Lanes\" d=\"${not $Active}\"/>"
+        "</Root>").status, pugi::status_ok);
+
+    Parameters params;
+    pugi::xml_node root = doc.child("Root");
+    pugi::xml_node attr = root.child("Attr");
+    params.parseGlobalParameterDeclarations(root.child("ParameterDeclarations"));
+
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "a")), 24.0);
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "b")), 1.0);
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "d")), 0.0);
+    EXPECT_EQ(params.ReadAttribute(attr, "c"), "3");
+
+    // Compiled expressions pick up new values
+    EXPECT_EQ(params.setParameterValue("Speed", 1.0), 0);
+    EXPECT_EQ(params.setParameterValue("Active", false), 0);
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "a")), 5.0);
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "b")), 0.0);
+    EXPECT_EQ(params.getParameterValueAsString("Active"), "false");
+
+    // Local declaration shadows global one until restored
+    params.CreateRestorePoint();
+    params.addParameterDeclarations(root.child("Local"));
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "a")), 7.0);
+    EXPECT_EQ(params.ReadAttribute(attr, "c"), "5");
+    params.RestoreParameterDeclarations();
+    params.RestoreParameterDeclarations();
+    EXPECT_DOUBLE_EQ(strtod(params.ReadAttribute(attr, "a")), 5.0);
+    EXPECT_EQ(params.getParameter("$Lanes"), "3");
+    EXPECT_EQ(params.GetNumberOfParameters(), 3);
+
+    // Typed values are formatted to string only when needed
+    EXPECT_EQ(params.setParameterValue("Lanes", 4), 0);
+    EXPECT_EQ(params.getParameter("Lanes"), "4");
+    EXPECT_EQ(params.getParameterEntry("Unknown"), nullptr);
+}
+
 TEST(OptionsTest, TestOptionHandling)
 {
     SE_Options opt;
@@ -871,6 +951,96 @@ TEST(ControllerTest, UDPDriverModelTestSynchronous)
     delete udpClient2;
 }
 
+TEST(ControllerTest, UDPDriverModelTestSharedPort)
+{
+    double dt = 0.01;
+
+    ScenarioEngine* se = new ScenarioEngine("../../../scripts/udp_driver/two_cars_in_open_space.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->entities_.object_.size(), 2);
+
+    // Replace controllers, both receiving on the same port
+    for (int i = 0; i < 2; i++)
+    {
+        scenarioengine::Controller::InitArgs args;
+        args.name = "UDPDriverModel Controller";
+        args.type = ControllerUDPDriver::GetTypeNameStatic();
+        args.parameters = 0;
+        args.gateway = se->getScenarioGateway();
+        args.properties = new OSCProperties();
+        OSCProperties::Property property;
+        property.name_ = "execMode";
+        property.value_ = "synchronous";
+        args.properties->property_.push_back(property);
+        property.name_ = "sharedPort";
+        property.value_ = std::to_string(61920);
+        args.properties->property_.push_back(property);
+        property.name_ = "inputMode";
+        property.value_ = "vehicleStateXYZHPR";
+        args.properties->property_.push_back(property);
+        ControllerUDPDriver* controller = (ControllerUDPDriver*)InstantiateControllerUDPDriver(&args);
+
+        delete se->entities_.object_[i]->controller_;
+        delete args.properties;
+
+        controller->Assign(se->entities_.object_[i]);
+        se->scenarioReader->controller_[i] = controller;
+        se->entities_.object_[i]->controller_ = controller;
+    }
+
+    // assign controllers
+    se->step(dt);
+
+    UDPClient* udpClient = new UDPClient(61920, "127.0.0.1");
+
+    ControllerUDPDriver::DMMessage msg;
+
+    msg.header.frameNumber = 0;
+    msg.header.version = 1;
+    msg.header.inputMode = static_cast<int>(ControllerUDPDriver::InputMode::VEHICLE_STATE_XYZHPR);
+    msg.message.stateXYZHPR.h = 0.3;
+    msg.message.stateXYZHPR.deadReckon = 0;
+
+    // Messages for both vehicles plus an unknown one on the same port
+    msg.header.objectId = 0;
+    msg.message.stateXYZHPR.x = 20.0;
+    msg.message.stateXYZHPR.y = 30.0;
+    udpClient->Send((char*)&msg, sizeof(msg));
+
+    msg.header.objectId = 1;
+    msg.message.stateXYZHPR.x = 90.0;
+    msg.message.stateXYZHPR.y = -10.0;
+    udpClient->Send((char*)&msg, sizeof(msg));
+
+    msg.header.objectId = 5;
+    msg.message.stateXYZHPR.x = 0.0;
+    udpClient->Send((char*)&msg, sizeof(msg));
+
+    // synchronous mode, each controller waits for a message of its own
+    se->step(dt);
+    se->step(dt);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[0]->pos_.GetX(), 20.0);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[0]->pos_.GetY(), 30.0);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[1]->pos_.GetX(), 90.0);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[1]->pos_.GetY(), -10.0);
+
+    // Only the latest of queued messages is kept per object
+    msg.header.objectId = 0;
+    msg.message.stateXYZHPR.x = 100.0;
+    udpClient->Send((char*)&msg, sizeof(msg));
+    msg.message.stateXYZHPR.x = 150.0;
+    udpClient->Send((char*)&msg, sizeof(msg));
+    SE_sleep(50);
+
+    se->step(dt);
+    se->step(dt);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[0]->pos_.GetX(), 150.0);
+    EXPECT_DOUBLE_EQ(se->entities_.object_[1]->pos_.GetX(), 90.0);
+
+    delete se;
+    delete udpClient;
+}
+
 TEST(RoadOrientationTest, TestElevationPitchRoll)
 {
     double dt = 0.1;
@@ -1747,6 +1917,59 @@ TEST(DistributionTest, TestDeterministicDistribution)
     EXPECT_NEAR(std::atof(dist.GetParamValue(3).c_str()), 1.3, 1e-3);
 }
 
+TEST(DistributionTest, TestResetScenario)
+{
+    OSCParameterDistribution& dist = OSCParameterDistribution::Inst();
+    double dt = 0.1;
+    double value = 0.0;
+
+    EXPECT_EQ(dist.Load("../../../resources/xosc/cut-in_parameter_set.xosc"), 0);
+
+    // Reference: permutation 3 initialized from scratch
+    EXPECT_EQ(dist.SetIndex(3), 0);
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/cut-in.xosc");
+    ASSERT_EQ(se->GetInitStatus(), 0);
+    for (int i = 0; i < 20; i++)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+    }
+    double x_ref = se->entities_.object_[1]->pos_.GetX();
+    double speed_ref = se->entities_.object_[1]->GetSpeed();
+    delete se;
+
+    EXPECT_EQ(dist.SetIndex(0), 0);
+    se = new ScenarioEngine("../../../resources/xosc/cut-in.xosc");
+    ASSERT_EQ(se->GetInitStatus(), 0);
+    EXPECT_EQ(se->scenarioReader->parameters.getParameterValueDouble("EgoSpeed", value), 0);
+    EXPECT_NEAR(value, 70.0, 1e-5);
+    for (int i = 0; i < 50; i++)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+    }
+    int n_roads = se->getRoadManager()->GetNumOfRoads();
+
+    // Restart with permutation 3, expect same result as when initialized from scratch
+    EXPECT_EQ(dist.SetIndex(3), 0);
+    ASSERT_EQ(se->Reset(), 0);
+    EXPECT_NEAR(se->getSimulationTime(), 0.0, 1e-5);
+    EXPECT_EQ(se->getRoadManager()->GetNumOfRoads(), n_roads);
+    EXPECT_EQ(se->entities_.object_.size(), 2);
+    EXPECT_EQ(se->scenarioReader->parameters.getParameterValueDouble("EgoSpeed", value), 0);
+    EXPECT_NEAR(value, 110.0, 1e-5);
+    for (int i = 0; i < 20; i++)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+    }
+    EXPECT_NEAR(se->entities_.object_[1]->pos_.GetX(), x_ref, 1e-5);
+    EXPECT_NEAR(se->entities_.object_[1]->GetSpeed(), speed_ref, 1e-5);
+
+    delete se;
+    dist.Reset();
+}
+
 TEST_F(StraightRoadTest, TestObjectOverlap)
 {
     Object ego(Object::Type::VEHICLE);
@@ -1833,6 +2056,585 @@ TEST(SpeedTest, TestAbsoluteSpeed)
     delete se;
 }
 
+TEST(DatFileTest, TestEncodeDecode)
+{
+    std::vector<ObjectStateStructDat> states;
+    ObjectStateStructDat state;
+
+    // Two objects over a few frames, second one changing name (static info) halfway
+    for (int i = 0; i < 10; i++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            memset(&state, 0, sizeof(state));
+            state.info.id = j;
+            state.info.timeStamp = static_cast<float>(0.05 * i - 1.0);
+            snprintf(state.info.name, NAME_LEN, "%s", j == 1 && i > 4 ? "Target_renamed" : (j == 0 ? "Ego" : "Target"));
+            state.info.boundingbox.dimensions_.length_ = 4.5f;
+            state.info.speed = static_cast<float>(10.0 + i * 0.1);
+            state.pos.x = static_cast<float>(1000.0 + j * 3.5 + i * 0.5);
+            state.pos.y = -1.5f;
+            state.pos.h = static_cast<float>(6.2 + i * 0.01);
+            state.pos.roadId = 1;
+            state.pos.laneId = -1 - j;
+            state.pos.s = static_cast<float>(i * 0.5);
+            states.push_back(state);
+        }
+    }
+
+    std::vector<char> buf;
+    DatEncoder encoder;
+    encoder.Encode(states.data(), 9, buf);  // split in two calls, mid frame
+    encoder.Encode(states.data() + 9, states.size() - 9, buf);
+    EXPECT_LT(buf.size(), states.size() * sizeof(ObjectStateStructDat) / 4);
+
+    std::vector<ObjectStateStructDat> decoded;
+    DatDecoder decoder;
+    ASSERT_EQ(decoder.Decode(buf.data(), buf.size(), decoded), 0);
+    ASSERT_EQ(decoded.size(), states.size());
+
+    for (size_t i = 0; i < states.size(); i++)
+    {
+        EXPECT_EQ(decoded[i].info.id, states[i].info.id);
+        EXPECT_STREQ(decoded[i].info.name, states[i].info.name);
+        EXPECT_EQ(decoded[i].info.timeStamp, states[i].info.timeStamp);
+        EXPECT_EQ(decoded[i].info.boundingbox.dimensions_.length_, 4.5f);
+        EXPECT_EQ(decoded[i].info.speed, states[i].info.speed);
+        EXPECT_EQ(decoded[i].pos.x, states[i].pos.x);
+        EXPECT_EQ(decoded[i].pos.y, states[i].pos.y);
+        EXPECT_EQ(decoded[i].pos.h, states[i].pos.h);
+        EXPECT_EQ(decoded[i].pos.s, states[i].pos.s);
+        EXPECT_EQ(decoded[i].pos.roadId, states[i].pos.roadId);
+        EXPECT_EQ(decoded[i].pos.laneId, states[i].pos.laneId);
+    }
+
+    // Truncated data, e.g. interrupted recording, skip incomplete last frame
+    decoded.clear();
+    decoder.Reset();
+    ASSERT_EQ(decoder.Decode(buf.data(), buf.size() - 1, decoded), 0);
+    EXPECT_EQ(decoded.size(), states.size() - 2);
+}
+
+TEST(SharedMemoryTest, TestExchange)
+{
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/cut-in.xosc");
+    se->step(0.0);
+    se->prepareGroundTruth(0.0);
+    ScenarioGateway* gw = se->getScenarioGateway();
+    ASSERT_EQ(gw->getNumberOfObjects(), 2);
+
+    SharedMemoryExchange server;
+    SharedMemoryClient client;
+    std::unique_ptr<ShmFrame> frame(new ShmFrame);
+
+    EXPECT_EQ(client.Open("esmini_unittest"), -1);
+    ASSERT_EQ(server.Create("esmini_unittest", 10), 0);
+    server.Publish(gw, 0, se->getSimulationTime());
+
+    // Lockstep, no client attached so nothing to wait for
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 0);
+
+    ASSERT_EQ(client.Open("esmini_unittest"), 0);
+    EXPECT_EQ(client.WaitForFrame(-1, 100), 0);
+    ASSERT_EQ(client.ReadFrame(*frame), 0);
+    ASSERT_EQ(frame->n_objects, 2);
+    for (int i = 0; i < 2; i++)
+    {
+        ObjectStateStruct* state = &gw->getObjectStatePtrByIdx(i)->state_;
+        EXPECT_EQ(frame->objects[i].id, state->info.id);
+        EXPECT_DOUBLE_EQ(frame->objects[i].x, state->pos.GetX());
+        EXPECT_DOUBLE_EQ(frame->objects[i].y, state->pos.GetY());
+        EXPECT_DOUBLE_EQ(frame->objects[i].speed, state->info.speed);
+        EXPECT_EQ(frame->objects[i].laneId, state->pos.GetLaneId());
+    }
+
+    // Lockstep, client attached but no input signaled
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 1);
+
+    ShmInput input = { frame->objects[0].id, 0, frame->objects[0].x + 10.0, frame->objects[0].y, frame->objects[0].z,
+        frame->objects[0].h, 0.0, 0.0, 5.0, 0.1 };
+    ASSERT_EQ(client.WriteInput(0, input), 0);
+    client.InputDone(0);
+    EXPECT_EQ(server.ApplyInputs(gw), 1);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 1);
+    ObjectStateStruct* state = &gw->getObjectStatePtrById(input.id)->state_;
+    EXPECT_NEAR(state->pos.GetX(), input.x, 1e-5);
+    EXPECT_DOUBLE_EQ(state->info.speed, 5.0);
+    EXPECT_DOUBLE_EQ(state->info.wheel_angle, 0.1);
+
+    // Input is applied once only
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+
+    server.Publish(gw, 1, se->getSimulationTime());
+    EXPECT_EQ(client.WaitForFrame(0, 100), 1);
+    EXPECT_EQ(client.WaitForFrame(1, 10), -1);
+
+    // Late signal for previous frame does not release the new one
+    client.InputDone(0);
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 2);
+    client.InputDone(1);
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 2);
+
+    // Each client claims its own slot
+    SharedMemoryClient client2;
+    ASSERT_EQ(client2.Open("esmini_unittest"), 0);
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfTimeouts(), 3);
+    client2.Close();
+
+    // Writer died in the middle of writing an input, the slot is skipped instead of blocking the server
+    SE_SharedMemory raw;
+    ASSERT_EQ(raw.Open("esmini_unittest"), 0);
+    ShmExchange* exchange = reinterpret_cast<ShmExchange*>(raw.GetData());
+    exchange->input[1].seq.fetch_add(1);
+    client.InputDone(1);
+    __int64 start_time = SE_getMonotonicTimeNs();
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_LT(SE_getMonotonicTimeNs() - start_time, 1000000000LL);
+    exchange->input[1].seq.fetch_add(1);
+    raw.Close();
+
+    server.Close();
+    EXPECT_TRUE(client.IsClosedByServer());
+    EXPECT_EQ(client.WaitForFrame(1, 100), -1);
+    client.Close();
+
+    delete se;
+}
+
+TEST(UDPLockstepTest, TestExchange)
+{
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/cut-in.xosc");
+    se->step(0.0);
+    se->prepareGroundTruth(0.0);
+    ScenarioGateway* gw = se->getScenarioGateway();
+    ASSERT_EQ(gw->getNumberOfObjects(), 2);
+
+    UDPLockstepExchange server;
+    UDPLockstepClient client;
+    std::unique_ptr<ShmFrame> frame(new ShmFrame);
+
+    ASSERT_EQ(server.Create(61930, 10), 0);
+    server.Publish(gw, 0, se->getSimulationTime());
+
+    // No participant registered, so nothing to wait for
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetStats().frames, 0);
+    EXPECT_EQ(server.GetStats().timeouts, 0);
+
+    ASSERT_EQ(client.Open(61931, "127.0.0.1", 61930), 0);
+
+    // Registration is handled, then timeout since participant has not responded yet
+    EXPECT_EQ(server.ApplyInputs(gw), 0);
+    EXPECT_EQ(server.GetNumberOfParticipants(), 1);
+    EXPECT_EQ(server.GetStats().timeouts, 1);
+
+    // Latest frame is sent on registration
+    ASSERT_EQ(client.ReceiveFrame(*frame, 100), 0);
+    ASSERT_EQ(frame->n_objects, 2);
+    for (int i = 0; i < 2; i++)
+    {
+        ObjectStateStruct* state = &gw->getObjectStatePtrByIdx(i)->state_;
+        EXPECT_EQ(frame->objects[i].id, state->info.id);
+        EXPECT_DOUBLE_EQ(frame->objects[i].x, state->pos.GetX());
+        EXPECT_DOUBLE_EQ(frame->objects[i].speed, state->info.speed);
+    }
+
+    ShmInput input = { frame->objects[0].id, 0, frame->objects[0].x + 10.0, frame->objects[0].y, frame->objects[0].z,
+        frame->objects[0].h, 0.0, 0.0, 5.0, 0.1 };
+    ASSERT_EQ(client.SendInput(0, &input, 1), 0);
+    EXPECT_EQ(server.ApplyInputs(gw), 1);
+    EXPECT_EQ(server.GetStats().timeouts, 1);
+    EXPECT_EQ(server.GetStats().rtt_samples, 1);
+    ObjectStateStruct* state = &gw->getObjectStatePtrById(input.id)->state_;
+    EXPECT_NEAR(state->pos.GetX(), input.x, 1e-5);
+    EXPECT_DOUBLE_EQ(state->info.speed, 5.0);
+
+    // Reply to an old frame is discarded, only input matching latest frame is applied
+    server.Publish(gw, 1, se->getSimulationTime());
+    ASSERT_EQ(client.ReceiveFrame(*frame, 100), 1);
+    input.x += 10.0;
+    ASSERT_EQ(client.SendInput(0, &input, 1), 0);
+    input.x += 10.0;
+    ASSERT_EQ(client.SendInput(1, &input, 1), 0);
+    EXPECT_EQ(server.ApplyInputs(gw), 1);
+    EXPECT_EQ(server.GetStats().late, 1);
+    EXPECT_EQ(server.GetStats().timeouts, 1);
+    EXPECT_NEAR(state->pos.GetX(), input.x, 1e-5);
+
+    server.Close();
+    EXPECT_EQ(client.ReceiveFrame(*frame, 100), -1);
+    EXPECT_TRUE(client.IsClosedByServer());
+    client.Close();
+
+    delete se;
+}
+
+TEST(UDPLockstepTest, TestSplitState)
+{
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/synchronize.xosc");
+    se->step(0.0);
+    se->prepareGroundTruth(0.0);
+    ScenarioGateway* gw = se->getScenarioGateway();
+    ASSERT_GT(gw->getNumberOfObjects(), static_cast<int>(UDP_LOCKSTEP_MAX_OBJECTS_PER_MSG));
+
+    UDPLockstepExchange server;
+    UDPLockstepClient client;
+    std::unique_ptr<ShmFrame> frame(new ShmFrame);
+
+    ASSERT_EQ(server.Create(61932, 10), 0);
+    ASSERT_EQ(client.Open(61933, "127.0.0.1", 61932), 0);
+    server.ApplyInputs(gw);
+    ASSERT_EQ(server.GetNumberOfParticipants(), 1);
+
+    // State messages each fit into one datagram, the client assembles the complete frame
+    server.Publish(gw, 0, se->getSimulationTime());
+    ASSERT_EQ(client.ReceiveFrame(*frame, 100), 0);
+    ASSERT_EQ(frame->n_objects, gw->getNumberOfObjects());
+    for (int i = 0; i < frame->n_objects; i++)
+    {
+        EXPECT_EQ(frame->objects[i].id, gw->getObjectStatePtrByIdx(i)->state_.info.id);
+        EXPECT_DOUBLE_EQ(frame->objects[i].x, gw->getObjectStatePtrByIdx(i)->state_.pos.GetX());
+    }
+    EXPECT_LE(sizeof(UDPLockstepStateHeader) + UDP_LOCKSTEP_MAX_OBJECTS_PER_MSG * sizeof(ShmObjectState),
+        static_cast<size_t>(UDP_LOCKSTEP_MAX_MSG_SIZE));
+
+    client.Close();
+    server.Close();
+    delete se;
+}
+
+TEST(SwarmTest, TestLaneOccupancy)
+{
+    STGeometry::LaneOccupancy occupancy;
+    std::vector<STGeometry::LaneOccupancy::Item> items;
+
+    occupancy.Add(1, -1, 100.0, 100.0, 0.0, 0);
+    occupancy.Add(1, -1, 20.0, 20.0, 0.0, 1);
+    occupancy.Add(1, 1, 50.0, 50.0, 3.0, 2);
+    occupancy.Add(2, -1, 10.0, 0.0, 60.0, 3);
+    occupancy.Sort();
+
+    EXPECT_TRUE(occupancy.IsLaneOccupied(1, -1, 60.0, 41.0));
+    EXPECT_FALSE(occupancy.IsLaneOccupied(1, -1, 60.0, 39.0));
+    EXPECT_FALSE(occupancy.IsLaneOccupied(1, -2, 60.0, 100.0));
+    EXPECT_FALSE(occupancy.IsLaneOccupied(3, -1, 60.0, 100.0));
+    EXPECT_TRUE(occupancy.IsLaneOccupied(1, 1, 60.0, 11.0));
+    EXPECT_FALSE(occupancy.IsLaneOccupied(1, 1, 60.0, 10.0));
+
+    occupancy.Insert(1, -1, 70.0, 70.0, 0.0, 4);
+    EXPECT_TRUE(occupancy.IsLaneOccupied(1, -1, 60.0, 11.0));
+
+    occupancy.FindNearby(50.0, 0.0, 31.0, items);
+    ASSERT_EQ(items.size(), 3);
+    EXPECT_EQ(items[0].ref, 1);
+    EXPECT_EQ(items[1].ref, 2);
+    EXPECT_EQ(items[2].ref, 4);
+
+    occupancy.FindNearby(0.0, 50.0, 11.0, items);
+    ASSERT_EQ(items.size(), 1);
+    EXPECT_EQ(items[0].roadId, 2);
+
+    occupancy.Clear();
+    EXPECT_FALSE(occupancy.IsLaneOccupied(1, -1, 60.0, 100.0));
+    occupancy.FindNearby(50.0, 0.0, 100.0, items);
+    EXPECT_EQ(items.size(), 0);
+}
+
+TEST(SwarmTest, TestChurnReusesVehicles)
+{
+    double dt = 0.05;
+    SE_Env::Inst().SetSeed(12345);
+    ScenarioEngine* se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/swarm_churn.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->GetInitStatus(), 0);
+
+    std::set<std::string> names;
+    std::set<int> ids;
+    size_t max_active = 0;
+
+    while (se->getSimulationTime() < 30.0 - SMALL_NUMBER)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+        for (size_t i = 0; i < se->entities_.object_.size(); i++)
+        {
+            names.insert(se->entities_.object_[i]->GetName());
+            ids.insert(se->entities_.object_[i]->GetId());
+        }
+        max_active = MAX(max_active, se->entities_.object_.size());
+    }
+
+    // Despawned vehicles are kept and reused under new names, keeping their id. So the number of allocated
+    // objects and controllers follows the number of simultaneously active ones, not the number spawned over time
+    size_t n_allocated = se->entities_.object_.size() + se->entities_.object_pool_.size();
+    EXPECT_EQ(ids.size(), n_allocated);
+    EXPECT_LT(3 * ids.size(), 2 * names.size());
+    ScenarioReader* reader = se->GetScenarioReader();
+    EXPECT_LT(reader->controller_.size() + reader->released_controllers_.size(), n_allocated);
+
+    delete se;
+}
+
+TEST(SwarmTest, TestMoreThanThousandVehicles)
+{
+    double dt = 0.1;
+    SE_Env::Inst().SetSeed(12345);
+    ScenarioEngine* se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/swarm_dense.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->GetInitStatus(), 0);
+
+    size_t max_active = 0;
+    int n_too_close = 0;
+
+    while (se->getSimulationTime() < 40.0 - SMALL_NUMBER)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+        max_active = MAX(max_active, se->entities_.object_.size());
+    }
+
+    // Vehicles sharing a lane keep their distance, also when spawned into dense traffic
+    std::map<std::pair<int, int>, std::vector<double>> lanes;
+    for (size_t i = 0; i < se->entities_.object_.size(); i++)
+    {
+        Object* obj = se->entities_.object_[i];
+        lanes[std::make_pair(obj->pos_.GetTrackId(), obj->pos_.GetLaneId())].push_back(obj->pos_.GetS());
+    }
+    for (auto& lane : lanes)
+    {
+        std::sort(lane.second.begin(), lane.second.end());
+        for (size_t i = 1; i < lane.second.size(); i++)
+        {
+            if (lane.second[i] - lane.second[i - 1] < 2.0)
+            {
+                n_too_close++;
+            }
+        }
+    }
+
+    EXPECT_GT(max_active, 1000);
+    EXPECT_EQ(n_too_close, 0);
+
+    delete se;
+}
+
+TEST(LODTest, TestFarEntitiesSimplified)
+{
+    double dt = 0.05;
+    double radius = 150.0;
+    int interval = 4;
+    SE_Env::Inst().SetSeed(12345);
+    ScenarioEngine* se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/swarm_churn.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->GetInitStatus(), 0);
+    se->SetLOD(radius, interval);
+
+    ScenarioGateway* gw = se->getScenarioGateway();
+    Object* ego = se->entities_.object_[0];
+    std::map<int, double> old_x;
+    int n_low = 0;
+    int n_low_updated = 0;
+
+    while (se->getSimulationTime() < 10.0 - SMALL_NUMBER)
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+
+        for (size_t i = 0; i < se->entities_.object_.size(); i++)
+        {
+            Object* obj = se->entities_.object_[i];
+            double dist = sqrt(PointSquareDistance2D(obj->pos_.GetX(), obj->pos_.GetY(), ego->pos_.GetX(), ego->pos_.GetY()));
+
+            // allow for movement since classification
+            if (dist < radius - 5.0)
+            {
+                EXPECT_FALSE(obj->lod_low_);
+            }
+            else if (dist > radius + 5.0 && obj->lod_low_)
+            {
+                n_low++;
+                if (obj->lod_skip_)
+                {
+                    // state is kept until next update
+                    ASSERT_NE(old_x.find(obj->GetId()), old_x.end());
+                    EXPECT_DOUBLE_EQ(gw->getObjectStatePtrById(obj->GetId())->state_.pos.GetX(), old_x[obj->GetId()]);
+                }
+                else
+                {
+                    n_low_updated++;
+                    // velocity derived from movement over the full time since last update
+                    EXPECT_NEAR(GetLengthOfVector2D(obj->pos_.GetVelX(), obj->pos_.GetVelY()), fabs(obj->GetSpeed()), 0.5);
+                }
+            }
+            old_x[obj->GetId()] = gw->getObjectStatePtrById(obj->GetId())->state_.pos.GetX();
+        }
+    }
+
+    EXPECT_FALSE(ego->lod_low_);
+    EXPECT_GT(n_low, 1000);
+    EXPECT_NEAR(static_cast<double>(n_low_updated) / n_low, 1.0 / interval, 0.05);
+
+    delete se;
+}
+
+TEST(LODTest, TestConditionEntitiesKept)
+{
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/cut-in.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->entities_.object_.size(), 2);
+    se->SetLOD(1.0, 4);
+
+    // Ego is triggering entity, OverTaker is reference of time headway conditions
+    Object* overtaker = se->entities_.object_[1];
+    EXPECT_TRUE(se->entities_.object_[0]->lod_referenced_);
+    EXPECT_TRUE(overtaker->lod_referenced_);
+
+    while (se->getSimulationTime() < 5.0 - SMALL_NUMBER)
+    {
+        se->step(0.05);
+        se->prepareGroundTruth(0.05);
+        EXPECT_FALSE(overtaker->lod_low_);
+    }
+
+    delete se;
+
+    // Swarm vehicles are not referenced by any condition
+    se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/swarm_churn.xosc");
+    ASSERT_NE(se, nullptr);
+    se->step(0.05);
+    int n_swarm = 0;
+    for (size_t i = 0; i < se->entities_.object_.size(); i++)
+    {
+        if (se->entities_.object_[i]->GetName().rfind("swarm_", 0) == 0)
+        {
+            EXPECT_FALSE(se->entities_.object_[i]->lod_referenced_);
+            n_swarm++;
+        }
+    }
+    EXPECT_GT(n_swarm, 0);
+
+    delete se;
+}
+
+TEST(SensorTest, TestObjectSensorGridAndOcclusion)
+{
+    ScenarioEngine* se = new ScenarioEngine("../../../EnvironmentSimulator/Unittest/xosc/multi_lane_changes.xosc");
+    ASSERT_NE(se, nullptr);
+    ASSERT_EQ(se->entities_.object_.size(), 4);
+
+    // Host at origin, one object straight ahead, one hidden behind it and one to the left
+    std::vector<Object*>& obj = se->entities_.object_;
+    obj[0]->pos_.SetInertiaPos(0.0, 0.0, 0.0, false);
+    obj[1]->pos_.SetInertiaPos(20.0, 0.0, 0.0, false);
+    obj[2]->pos_.SetInertiaPos(40.0, 0.0, 0.0, false);
+    obj[3]->pos_.SetInertiaPos(30.0, 10.0, 0.0, false);
+
+    SensorGrid grid(5.0);
+    grid.Update(&se->entities_);
+
+    ObjectSensor front(&se->entities_, obj[0], 0.0, 0.0, 0.0, 0.0, 1.0, 100.0, M_PI_2, 10);
+    front.Update(&grid);
+    ASSERT_EQ(front.nObj_, 3);
+    EXPECT_EQ(front.hitList_[0].obj_, obj[1]);
+    EXPECT_EQ(front.hitList_[1].obj_, obj[2]);
+    EXPECT_EQ(front.hitList_[2].obj_, obj[3]);
+    EXPECT_NEAR(front.hitList_[2].x_, 30.0, 1e-5);
+    EXPECT_NEAR(front.hitList_[2].y_, 10.0, 1e-5);
+
+    // Same result without shared grid
+    front.Update();
+    EXPECT_EQ(front.nObj_, 3);
+
+    front.SetOcclusion(true);
+    front.Update(&grid);
+    ASSERT_EQ(front.nObj_, 2);
+    EXPECT_EQ(front.hitList_[0].obj_, obj[1]);
+    EXPECT_EQ(front.hitList_[1].obj_, obj[3]);
+
+    // Object list is limited
+    ObjectSensor limited(&se->entities_, obj[0], 0.0, 0.0, 0.0, 0.0, 1.0, 100.0, M_PI_2, 1);
+    limited.Update(&grid);
+    EXPECT_EQ(limited.nObj_, 1);
+
+    // Sensor looking to the right, mounted on the right side, does not see objects to the left
+    obj[3]->pos_.SetInertiaPos(0.0, -20.0, 0.0, false);
+    obj[2]->pos_.SetInertiaPos(0.0, 20.0, 0.0, false);
+    grid.Update(&se->entities_);
+    ObjectSensor right(&se->entities_, obj[0], 1.0, -1.0, 0.0, -M_PI_2, 1.0, 50.0, M_PI_2, 10);
+    right.Update(&grid);
+    ASSERT_EQ(right.nObj_, 1);
+    EXPECT_EQ(right.hitList_[0].obj_, obj[3]);
+    EXPECT_NEAR(right.hitList_[0].x_, 19.0, 1e-5);
+    EXPECT_NEAR(right.hitList_[0].y_, -1.0, 1e-5);
+
+    // All around sensor, shadow straight behind the host wraps around +-pi
+    obj[1]->pos_.SetInertiaPos(-20.0, 0.0, 0.0, false);
+    obj[2]->pos_.SetInertiaPos(-40.0, -0.5, 0.0, false);
+    obj[3]->pos_.SetInertiaPos(-30.0, -10.0, 0.0, false);
+    grid.Update(&se->entities_);
+    ObjectSensor around(&se->entities_, obj[0], 0.0, 0.0, 0.0, 0.0, 1.0, 100.0, 2 * M_PI, 10);
+    around.SetOcclusion(true);
+    around.Update(&grid);
+    ASSERT_EQ(around.nObj_, 2);
+    EXPECT_EQ(around.hitList_[0].obj_, obj[1]);
+    EXPECT_EQ(around.hitList_[1].obj_, obj[3]);
+
+    delete se;
+}
+
+static std::vector<std::pair<double, double>> RunFollowGhost(double margin, double tolerance, GhostTrailStats& stats, int& n_unbounded)
+{
+    std::vector<std::pair<double, double>> ego_pos;
+    double dt = 0.05;
+    ScenarioEngine* se = new ScenarioEngine("../../../resources/xosc/follow_ghost.xosc");
+    se->SetGhostTrailBound(margin, tolerance);
+    Object* ego = se->entities_.object_[0];
+    n_unbounded = 0;
+
+    while (se->getSimulationTime() < 30.0 - SMALL_NUMBER && !se->GetQuitFlag())
+    {
+        se->step(dt);
+        se->prepareGroundTruth(dt);
+        ego_pos.push_back(std::make_pair(ego->pos_.GetX(), ego->pos_.GetY()));
+        n_unbounded = MAX(n_unbounded, ego->GetGhost()->trail_.GetNumberOfVertices());
+    }
+    stats = se->GetGhostTrailStats();
+
+    delete se;
+
+    return ego_pos;
+}
+
+TEST(GhostTest, TestBoundedTrail)
+{
+    GhostTrailStats stats;
+    int n_unbounded = 0;
+    int n_bounded = 0;
+
+    std::vector<std::pair<double, double>> ref = RunFollowGhost(-1.0, 0.0, stats, n_unbounded);
+    std::vector<std::pair<double, double>> bounded = RunFollowGhost(1.0, 0.05, stats, n_bounded);
+
+    ASSERT_EQ(ref.size(), bounded.size());
+    ASSERT_GT(ref.size(), 100);
+    EXPECT_GT(stats.n_trimmed, 0);
+    EXPECT_GT(stats.n_decimated, 0);
+    EXPECT_EQ(stats.n_vertices_max, n_bounded);
+    EXPECT_LT(n_bounded, n_unbounded / 2);
+
+    // Follower should drive along the same path
+    double max_dev = 0.0;
+    for (size_t i = 0; i < ref.size(); i++)
+    {
+        max_dev = MAX(max_dev, sqrt(PointSquareDistance2D(ref[i].first, ref[i].second, bounded[i].first, bounded[i].second)));
+    }
+    EXPECT_LT(max_dev, 0.1);
+}
+
 // Uncomment to print log output to console
 //#define LOG_TO_CONSOLE
 
@@ -118,6 +118,35 @@ TEST(CustomCameraTest, TestCustomCameraVariants)
 
 #endif // _USE_OSG
 
+TEST(PacingTest, TestResetRestartsFrameSchedule)
+{
+    const char* args[] =
+    {
+        "esmini", "--osc", "../../../resources/xosc/cut-in.xosc", "--headless", "--fixed_timestep", "0.01", "--pace_realtime", "--disable_stdout"
+    };
+    int argc = sizeof(args) / sizeof(char*);
+    ScenarioPlayer* player = new ScenarioPlayer(argc, (char**)args);
+
+    ASSERT_NE(player, nullptr);
+    ASSERT_EQ(player->Init(), 0);
+    ASSERT_EQ(player->frameScheduler.IsActive(), true);
+
+    for (int i = 0; i < 5; i++)
+    {
+        player->Frame();
+    }
+    EXPECT_GT(player->frameScheduler.GetStats().frames, 0);
+
+    // Time passed before restart, e.g. evaluating the previous run, does not count as missed frames
+    SE_sleepUntilNs(SE_getMonotonicTimeNs() + 50000000);
+    ASSERT_EQ(player->Reset(), 0);
+    EXPECT_EQ(player->frameScheduler.GetStats().frames, 1);
+    EXPECT_EQ(player->frameScheduler.GetStats().overruns, 0);
+    EXPECT_EQ(player->frameScheduler.GetStats().skipped, 0);
+
+    delete player;
+}
+
 int main(int argc, char** argv)
 {
     //testing::GTEST_FLAG(filter) = "*TestCustomCameraVariants*";
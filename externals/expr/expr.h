@@ -303,6 +303,7 @@ static struct expr_var *expr_var(struct expr_var_list *vars, const char *s,
   }
   v->next = vars->head;
   v->value = 0;
+  v->name = (char *)(v + 1); /* name is stored right after the struct */
   strncpy(v->name, s, len);
   v->name[len] = '\0';
   vars->head = v;
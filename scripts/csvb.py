@@ -0,0 +1,127 @@
+import argparse
+import os
+import struct
+
+# Columnar binary csv_logger format, see CSV_Logger in EnvironmentSimulator/Modules/CommonMini/CommonMini.hpp
+MAGIC = 0x42565343
+VERSION = 1
+INT32 = 1
+FLOAT64 = 2
+BLOCK_NAME = 1
+BLOCK_DATA = 2
+
+TYPE_CODES = {INT32: 'i', FLOAT64: 'd'}
+
+
+class CSVBFile():
+    def __init__(self, filename):
+        if not os.path.isfile(filename):
+            print('ERROR: csv binary file not found: {}'.format(filename))
+            exit(-1)
+
+        with open(filename, 'rb') as f:
+            buffer = f.read()
+
+        self.filename = filename
+        magic, self.version, n_info_lines, n_columns = struct.unpack_from('Iiii', buffer, 0)
+        if magic != MAGIC or self.version != VERSION:
+            print('ERROR: {} is not a csv binary file of version {}'.format(filename, VERSION))
+            exit(-1)
+        pos = 16
+
+        self.info = []
+        for i in range(n_info_lines):
+            length = struct.unpack_from('i', buffer, pos)[0]
+            self.info.append(buffer[pos + 4:pos + 4 + length].decode('utf-8'))
+            pos += 4 + length
+
+        self.columns = []  # list of (name, type)
+        for i in range(n_columns):
+            type, length = struct.unpack_from('ii', buffer, pos)
+            self.columns.append((buffer[pos + 8:pos + 8 + length].decode('utf-8'), type))
+            pos += 8 + length
+
+        # Read blocks into one list of values per column, plus entity name and collision ids per row
+        self.data = [[] for c in self.columns]
+        self.names = []
+        self.collisions = []
+        names = {}
+        while pos + 8 <= len(buffer):
+            type, size = struct.unpack_from('ii', buffer, pos)
+            pos += 8
+            if pos + size > len(buffer):
+                break  # recording interrupted, skip incomplete block
+            if type == BLOCK_NAME:
+                id = struct.unpack_from('i', buffer, pos)[0]
+                names[id] = buffer[pos + 4:pos + size].decode('utf-8')
+            elif type == BLOCK_DATA:
+                n = struct.unpack_from('i', buffer, pos)[0]
+                p = pos + 4
+                for i, (name, col_type) in enumerate(self.columns):
+                    code = TYPE_CODES[col_type]
+                    self.data[i].extend(struct.unpack_from('{}{}'.format(n, code), buffer, p))
+                    p += n * struct.calcsize(code)
+                n_collisions = self.data[-1][-n:] if n > 0 else []
+                for count in n_collisions:
+                    self.collisions.append(struct.unpack_from('{}i'.format(count), buffer, p))
+                    p += 4 * count
+                self.names.extend(names[id] for id in self.data[2][-n:])
+            pos += size
+
+    def get_column(self, name):
+        for i, (col_name, col_type) in enumerate(self.columns):
+            if col_name == name:
+                return self.data[i]
+        return None
+
+    def get_n_rows(self):
+        return len(self.names)
+
+    def save_csv(self, filename=None):
+        # Write text csv, same format as csv_logger in text mode
+        if filename is None:
+            filename = os.path.splitext(self.filename)[0] + '.csv'
+
+        n_vehicles = 0
+        for line in self.info:
+            if line.startswith('Number of Vehicles:'):
+                n_vehicles = int(line.split(':')[1])
+
+        labels = [col[0] for col in self.columns[3:-1]]
+        with open(filename, 'w') as f:
+            for line in self.info:
+                f.write(line + '\n')
+            header = 'Index [-] , TimeStamp [s] , '
+            for i in range(1, n_vehicles + 1):
+                header += '#{0} Entitity_Name [-] , #{0} Entitity_ID [-] , '.format(i)
+                header += ''.join('#{} {} , '.format(i, label) for label in labels)
+                header += '#{} collision_ids , '.format(i)
+            f.write(header + '\n')
+
+            index = self.data[0]
+            for row in range(self.get_n_rows()):
+                id = self.data[2][row]
+                entry = ''
+                if id == 0:
+                    entry += '{}, {:f}, '.format(index[row], self.data[1][row])
+                entry += '{}, {}, '.format(self.names[row], id)
+                entry += ''.join('{:f}, '.format(self.data[i][row]) for i in range(3, len(self.columns) - 1))
+                entry += ''.join('{} '.format(c) for c in self.collisions[row]) + ', '
+                if row + 1 == self.get_n_rows() or index[row + 1] != index[row]:
+                    entry += '\n'
+                f.write(entry)
+
+        return filename
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Print summary of csv binary file')
+    parser.add_argument('filename', help='csv binary filename')
+    args = parser.parse_args()
+
+    csvb = CSVBFile(args.filename)
+    for line in csvb.info:
+        print(line)
+    print('{} rows, {} columns:'.format(csvb.get_n_rows(), len(csvb.columns)))
+    for name, type in csvb.columns:
+        print('  {} ({})'.format(name, 'int32' if type == INT32 else 'float64'))
@@ -0,0 +1,15 @@
+from csvb import *
+
+if __name__ == "__main__":
+    # Create the parser
+    parser = argparse.ArgumentParser(description='Convert csv binary file, from esmini --csv_logger with --csv_binary, to text csv')
+
+    # Add the arguments
+    parser.add_argument('filename', help='csv binary filename')
+    parser.add_argument('--output', '-o', default=None, help='csv filename (default: same as input with .csv extension)')
+
+    # Execute the parse_args() method
+    args = parser.parse_args()
+
+    csvb = CSVBFile(args.filename)
+    print('Created ' + csvb.save_csv(args.output))
@@ -1,8 +1,10 @@
 import argparse
 import ctypes
 import os
+import struct
 
-VERSION = 2
+VERSION = 3  # delta encoded, see EnvironmentSimulator/Modules/ScenarioEngine/SourceFiles/DatFile.hpp
+VERSION_V2 = 2  # one full ObjectStateStructDat per object and frame
 REPLAY_FILENAME_SIZE = 512
 NAME_LEN = 32
 
@@ -45,6 +47,35 @@ class ObjectStateStructDat(ctypes.Structure):
     ]
 
 
+# Delta encoded format (version 3) constants
+PACKET_OBJECT_INFO = 1
+PACKET_FRAME = 2
+
+# Dynamic fields in order of bit index in the changed fields mask, and whether float (else int)
+DELTA_FIELDS = [
+    ("speed", True),
+    ("wheel_angle", True),
+    ("wheel_rot", True),
+    ("x", True),
+    ("y", True),
+    ("z", True),
+    ("h", True),
+    ("p", True),
+    ("r", True),
+    ("roadId", False),
+    ("laneId", False),
+    ("offset", True),
+    ("t", True),
+    ("s", True),
+]
+
+
+def ordered_to_float(value):
+    # inverse of the float to ordered integer mapping used for delta encoding
+    bits = ((-1 - value) | 0x80000000) if value < 0 else value
+    return struct.unpack('f', struct.pack('I', bits))[0]
+
+
 class DATHeader(ctypes.Structure):
     _fields_ = [
         ('version', ctypes.c_int),
@@ -71,18 +102,84 @@ class DATFile():
         self.labels = [field[0] for field in ObjectStateStructDat._fields_]
         self.data = []
 
-        if (self.version != VERSION):
-            print('Version mismatch. {} is version {} while supported version is: {}'.format(
-                filename, self.version, VERSION)
+        if self.version == VERSION:
+            self.decode(self.file.read())
+        elif self.version == VERSION_V2:
+            # Read all rows of data
+            while (True):
+                buffer = self.file.read(ctypes.sizeof(ObjectStateStructDat))
+                if len(buffer) < ctypes.sizeof(ObjectStateStructDat):
+                    break
+                self.data.append(ObjectStateStructDat.from_buffer_copy(buffer))
+        else:
+            print('Version mismatch. {} is version {} while supported versions are: {} and {}'.format(
+                filename, self.version, VERSION_V2, VERSION)
             )
             exit(-1)
 
-        # Read and print all rows of data
-        while (True):
-            buffer = self.file.read(ctypes.sizeof(ObjectStateStructDat))
-            if len(buffer) < ctypes.sizeof(ObjectStateStructDat):
-                break
-            self.data.append(ObjectStateStructDat.from_buffer_copy(buffer))
+    def decode(self, buffer):
+        # Expand delta encoded packets into full states, see DatFile.hpp for format description
+        buffer = bytearray(buffer)
+        objects = {}  # per object id: [state, quantized values]
+        pos = [0]  # list, for closures to update it also in Python 2
+
+        def varint():
+            value = 0
+            shift = 0
+            while True:
+                byte = buffer[pos[0]]
+                pos[0] += 1
+                value |= (byte & 0x7f) << shift
+                if not byte & 0x80:
+                    return value
+                shift += 7
+
+        def signed():
+            value = varint()
+            return (value >> 1) ^ -(value & 1)
+
+        try:
+            while pos[0] < len(buffer):
+                packet_type = buffer[pos[0]]
+                pos[0] += 1
+                if packet_type == PACKET_OBJECT_INFO:
+                    id = signed()
+                    if id not in objects:
+                        objects[id] = [ObjectStateStructDat(), [0] * len(DELTA_FIELDS)]
+                    state = objects[id][0]
+                    state.id = id
+                    state.model_id = signed()
+                    state.obj_type = signed()
+                    state.obj_category = signed()
+                    state.ctrl_type = signed()
+                    state.scaleMode = signed()
+                    state.visibilityMask = signed()
+                    name_len = varint()
+                    state.name = bytes(buffer[pos[0]:pos[0] + name_len])
+                    pos[0] += name_len
+                    (state.centerOffsetX, state.centerOffsetY, state.centerOffsetZ,
+                        state.width, state.length, state.height) = struct.unpack_from('6f', buffer, pos[0])
+                    pos[0] += 24
+                elif packet_type == PACKET_FRAME:
+                    time = struct.unpack_from('f', buffer, pos[0])[0]
+                    pos[0] += 4
+                    frame = []
+                    for i in range(varint()):
+                        state, values = objects[signed()]
+                        mask = varint()
+                        for j, (field, is_float) in enumerate(DELTA_FIELDS):
+                            if mask & (1 << j):
+                                values[j] += signed()
+                                setattr(state, field, ordered_to_float(values[j]) if is_float else values[j])
+                        state.time = time
+                        frame.append(ObjectStateStructDat.from_buffer_copy(state))
+                    self.data.extend(frame)
+                else:
+                    print('Corrupt dat file, unknown packet type {}'.format(packet_type))
+                    exit(-1)
+        except (IndexError, struct.error):
+            # Recording interrupted, skip the incomplete frame
+            pass
 
     def get_header_line(self):
         return 'Version: {}, OpenDRIVE: {}, 3DModel: {}'.format(
@@ -244,7 +341,10 @@ class DATFile():
             print('ERROR: Could not open file {} for writing'.format(filename))
             raise
 
-        fdat.write(self.header)
+        # Saved in version 2 format, i.e. full records
+        header = DATHeader.from_buffer_copy(self.header)
+        header.version = VERSION_V2
+        fdat.write(header)
 
         for d in self.data:
             fdat.write(d)
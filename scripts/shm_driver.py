@@ -0,0 +1,145 @@
+'''
+   This script shows how to exchange object states with esmini via shared memory, as a faster alternative
+   to the UDP based interfaces. It reads the state of all objects each frame and drives the first object
+   (typically Ego) along its heading with a varying speed, writing its new state back to esmini.
+
+   For layout and protocol, see esmini/EnvironmentSimulator/Modules/ScenarioEngine/SourceFiles/SharedMemoryExchange.hpp
+
+   Prerequisites:
+      Python 3
+
+   To run it:
+   1. Open two terminals
+   2. From terminal 1, run: ./bin/esmini --window 60 60 800 400 --osc ./resources/xosc/cut-in.xosc --shm --shm_lockstep --fixed_timestep 0.05
+   3. From terminal 2, run: python3 ./scripts/shm_driver.py
+   Skip --shm_lockstep to let esmini run without waiting for the driver, any input is then applied when available.
+   In lockstep mode esmini only waits while a client is attached, until then it runs freely.
+   Optional arguments: name of the shared memory region and client slot, e.g. python3 ./scripts/shm_driver.py esmini 15
+'''
+
+import ctypes
+import math
+import mmap
+import os
+import sys
+import time
+
+MAGIC = 0x494d5345
+VERSION = 2
+MAX_OBJECTS = 256
+MAX_INPUTS = 64
+MAX_CLIENTS = 16
+
+class ObjectState(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int) for name in
+                ['id', 'model_id', 'ctrl_type', 'obj_type', 'obj_category', 'roadId', 'laneId', 'junctionId']] + \
+               [(name, ctypes.c_double) for name in
+                ['x', 'y', 'z', 'h', 'p', 'r', 'speed', 'wheel_angle', 'wheel_rot', 's', 't', 'laneOffset',
+                 'centerOffsetX', 'centerOffsetY', 'centerOffsetZ', 'width', 'length', 'height']]
+
+class Frame(ctypes.Structure):
+    _fields_ = [('frame', ctypes.c_int), ('n_objects', ctypes.c_int), ('time', ctypes.c_double),
+                ('objects', ObjectState * MAX_OBJECTS)]
+
+class Input(ctypes.Structure):
+    _fields_ = [('id', ctypes.c_int), ('frame', ctypes.c_int)] + \
+               [(name, ctypes.c_double) for name in ['x', 'y', 'z', 'h', 'p', 'r', 'speed', 'wheel_angle']]
+
+class FrameBuffer(ctypes.Structure):
+    _fields_ = [('seq', ctypes.c_uint), ('pad', ctypes.c_uint), ('frame', Frame)]
+
+class InputSlot(ctypes.Structure):
+    _fields_ = [('seq', ctypes.c_uint), ('pad', ctypes.c_uint), ('input', Input)]
+
+class ClientSlot(ctypes.Structure):
+    _fields_ = [('attached', ctypes.c_int), ('done_frame', ctypes.c_int)]
+
+class Exchange(ctypes.Structure):
+    _fields_ = [('magic', ctypes.c_uint), ('version', ctypes.c_uint), ('size', ctypes.c_uint),
+                ('max_objects', ctypes.c_uint), ('max_inputs', ctypes.c_uint), ('max_clients', ctypes.c_uint),
+                ('closed', ctypes.c_uint), ('latest', ctypes.c_uint), ('frame', ctypes.c_int),
+                ('lockstep', ctypes.c_uint), ('buffer', FrameBuffer * 2), ('input', InputSlot * MAX_INPUTS),
+                ('client', ClientSlot * MAX_CLIENTS)]
+
+class SharedMemoryClient():
+    def __init__(self, name='esmini', slot=MAX_CLIENTS - 1):
+        # Python lacks atomic read-modify-write on shared memory, so the client slot is given explicitly
+        # instead of claimed like the C++ client does. Each Python client must use its own slot.
+        size = ctypes.sizeof(Exchange)
+        if sys.platform == 'win32':
+            self.mm = mmap.mmap(-1, size, tagname=name)
+        else:
+            fd = os.open('/dev/shm/' + name, os.O_RDWR)
+            self.mm = mmap.mmap(fd, size)
+            os.close(fd)
+        self.exchange = Exchange.from_buffer(self.mm)
+        if self.exchange.magic != MAGIC or self.exchange.version != VERSION or self.exchange.size != size:
+            raise Exception('Incompatible shared memory layout or version')
+        self.client = self.exchange.client[slot]
+        if self.client.attached:
+            raise Exception('Client slot {} already in use'.format(slot))
+        self.client.done_frame = -1
+        self.client.attached = 1
+
+    def close(self):
+        # Free slots always have done_frame -1
+        self.client.done_frame = -1
+        self.client.attached = 0
+        del self.client
+        del self.exchange
+        self.mm.close()
+
+    def wait_for_frame(self, frame, timeout=5.0):
+        # Returns number of a frame newer than given one, or -1 on timeout or if esmini has quit
+        start = time.time()
+        while self.exchange.frame <= frame and not self.exchange.closed:
+            if time.time() - start > timeout:
+                return -1
+            time.sleep(0)
+        return -1 if self.exchange.closed else self.exchange.frame
+
+    def read_frame(self):
+        while True:
+            buffer = self.exchange.buffer[self.exchange.latest]
+            seq = buffer.seq
+            if seq & 1:
+                continue
+            frame = Frame.from_buffer_copy(buffer.frame)
+            if buffer.seq == seq:
+                return frame
+
+    def write_input(self, slot, input):
+        s = self.exchange.input[slot]
+        s.seq += 1  # odd while writing
+        s.input = input
+        s.seq += 1
+
+    def input_done(self, frame):
+        # Tagged with frame number, a late signal for an older frame is ignored by esmini
+        self.client.done_frame = frame
+
+if __name__ == "__main__":
+
+    client = SharedMemoryClient(sys.argv[1] if len(sys.argv) > 1 else 'esmini',
+                                int(sys.argv[2]) if len(sys.argv) > 2 else MAX_CLIENTS - 1)
+    frame_nr = -1
+
+    while True:
+        frame_nr = client.wait_for_frame(frame_nr)
+        if frame_nr < 0:
+            break
+
+        frame = client.read_frame()
+        obj = frame.objects[0]
+        dt = 0.05  # assumed step size, adjust to esmini --fixed_timestep
+        speed = 15.0 + 5.0 * math.sin(0.2 * frame.time)
+
+        client.write_input(0, Input(id=obj.id, frame=frame.frame, x=obj.x + speed * dt * math.cos(obj.h),
+            y=obj.y + speed * dt * math.sin(obj.h), z=obj.z, h=obj.h, p=obj.p, r=obj.r, speed=speed, wheel_angle=0.0))
+        client.input_done(frame.frame)
+
+        if frame.frame % 20 == 0:
+            print('frame {} time {:.2f} objects {} obj {} x {:.2f} y {:.2f} speed {:.2f}'.format(
+                frame.frame, frame.time, frame.n_objects, obj.id, obj.x, obj.y, obj.speed))
+
+    client.close()
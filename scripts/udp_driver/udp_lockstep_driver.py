@@ -0,0 +1,117 @@
+'''
+   This script shows how to run an external driver model in lockstep with esmini over UDP. Each frame it
+   receives the state of all objects and drives the first object (typically Ego) along its heading with a
+   varying speed, replying with the new state tagged with the received frame number. esmini waits for the
+   reply before calculating the next frame.
+
+   For protocol and message layout, see esmini/EnvironmentSimulator/Modules/ScenarioEngine/SourceFiles/UDPLockstepExchange.hpp
+
+   Prerequisites:
+      Python 3
+
+   To run it:
+   1. Open two terminals
+   2. From terminal 1, run: ./bin/esmini --window 60 60 800 400 --osc ./resources/xosc/cut-in.xosc --udp_lockstep --fixed_timestep 0.05
+   3. From terminal 2, run: python3 ./scripts/udp_driver/udp_lockstep_driver.py
+   If esmini is running on another host, add argument --ip <ip address of host running esmini>
+   esmini waits for input only while a participant is registered, until then it runs freely.
+'''
+
+import argparse
+import ctypes
+import math
+import socket
+
+MAGIC = 0x4c534d45
+VERSION = 1
+REGISTER, UNREGISTER, STATE, INPUT, QUIT = 1, 2, 3, 4, 5
+MAX_MSG_SIZE = 1200  # datagram size limit, states of a frame are split into multiple messages
+
+class Header(ctypes.Structure):
+    _fields_ = [('magic', ctypes.c_uint), ('version', ctypes.c_uint), ('type', ctypes.c_uint),
+                ('frame', ctypes.c_int), ('n', ctypes.c_int), ('pad', ctypes.c_int)]
+
+class StateHeader(ctypes.Structure):
+    _fields_ = [('header', Header), ('first', ctypes.c_int), ('n_total', ctypes.c_int), ('time', ctypes.c_double)]
+
+class ObjectState(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_int) for name in
+                ['id', 'model_id', 'ctrl_type', 'obj_type', 'obj_category', 'roadId', 'laneId', 'junctionId']] + \
+               [(name, ctypes.c_double) for name in
+                ['x', 'y', 'z', 'h', 'p', 'r', 'speed', 'wheel_angle', 'wheel_rot', 's', 't', 'laneOffset',
+                 'centerOffsetX', 'centerOffsetY', 'centerOffsetZ', 'width', 'length', 'height']]
+
+class Input(ctypes.Structure):
+    _fields_ = [('id', ctypes.c_int), ('frame', ctypes.c_int)] + \
+               [(name, ctypes.c_double) for name in ['x', 'y', 'z', 'h', 'p', 'r', 'speed', 'wheel_angle']]
+
+class LockstepParticipant():
+    def __init__(self, ip='127.0.0.1', port=48200):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.addr = (ip, port)
+        self.sock.sendto(bytes(Header(MAGIC, VERSION, REGISTER, -1, 0, 0)), self.addr)
+
+    def close(self):
+        self.sock.sendto(bytes(Header(MAGIC, VERSION, UNREGISTER, -1, 0, 0)), self.addr)
+        self.sock.close()
+
+    def receive_frame(self, timeout=5.0):
+        # Returns (frame number, time, list of object states), frame number -1 on timeout or if esmini has quit
+        self.sock.settimeout(timeout)
+        frame_nr, objects = -1, {}
+        while True:
+            try:
+                msg = self.sock.recv(65536)
+            except socket.timeout:
+                return -1, 0.0, []
+            header = Header.from_buffer_copy(msg)
+            if header.magic != MAGIC or header.version != VERSION:
+                continue
+            if header.type == QUIT:
+                return -1, 0.0, []
+            if header.type != STATE:
+                continue
+            state_header = StateHeader.from_buffer_copy(msg)
+            if header.frame != frame_nr:
+                frame_nr, objects = header.frame, {}
+            for i in range(header.n):
+                offset = ctypes.sizeof(StateHeader) + i * ctypes.sizeof(ObjectState)
+                objects[state_header.first + i] = ObjectState.from_buffer_copy(msg, offset)
+            if len(objects) >= state_header.n_total:
+                return frame_nr, state_header.time, [objects[i] for i in sorted(objects)]
+
+    def send_input(self, frame, inputs):
+        if ctypes.sizeof(Header) + len(inputs) * ctypes.sizeof(Input) > MAX_MSG_SIZE:
+            raise Exception('Too many inputs for one message')
+        header = Header(MAGIC, VERSION, INPUT, frame, len(inputs), 0)
+        self.sock.sendto(bytes(header) + b''.join(bytes(i) for i in inputs), self.addr)
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description='Drive first object in lockstep with esmini')
+    parser.add_argument('--ip', default='127.0.0.1', help='IP address of host running esmini')
+    parser.add_argument('--port', type=int, default=48200, help='esmini lockstep port')
+    parser.add_argument('--dt', type=float, default=0.05, help='assumed step size, adjust to esmini --fixed_timestep')
+    args = parser.parse_args()
+
+    participant = LockstepParticipant(args.ip, args.port)
+
+    while True:
+        frame_nr, time, objects = participant.receive_frame()
+        if frame_nr < 0:
+            break
+
+        if len(objects) == 0:
+            participant.send_input(frame_nr, [])  # initial frame is published before objects are added
+            continue
+
+        obj = objects[0]
+        speed = 15.0 + 5.0 * math.sin(0.2 * time)
+        participant.send_input(frame_nr, [Input(id=obj.id, frame=frame_nr, x=obj.x + speed * args.dt * math.cos(obj.h),
+            y=obj.y + speed * args.dt * math.sin(obj.h), z=obj.z, h=obj.h, p=obj.p, r=obj.r, speed=speed, wheel_angle=0.0)])
+
+        if frame_nr % 20 == 0:
+            print('frame {} time {:.2f} objects {} obj {} x {:.2f} y {:.2f} speed {:.2f}'.format(
+                frame_nr, time, len(objects), obj.id, obj.x, obj.y, obj.speed))
+
+    participant.close()
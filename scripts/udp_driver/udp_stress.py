@@ -0,0 +1,72 @@
+'''
+   Load generator for the esmini UDPDriverController shared port mode. It sends vehicleStateXYH messages
+   for a number of objects at a given rate to one single port, moving each object along a circle.
+
+   Prerequisites:
+      Python 3
+
+   To run it:
+   1. In the scenario, assign UDPDriverController to the objects with parameter SharedPort set, e.g. 54000
+   2. From terminal 1, run esmini with that scenario
+   3. From terminal 2, run: python3 ./scripts/udp_driver/udp_stress.py --port 54000 --n_objects 2 --rate 1000
+   It can also run alone, just to measure send throughput on loopback.
+'''
+
+import argparse
+import math
+import socket
+import struct
+import time
+
+INPUT_MODE_STATE_XYH = 3
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description='Send vehicle states for many objects to one UDP port')
+    parser.add_argument('--ip', default='127.0.0.1', help='IP address of host running esmini')
+    parser.add_argument('--port', type=int, default=54000, help='shared port of the UDPDriverControllers')
+    parser.add_argument('--n_objects', type=int, default=2, help='number of objects, ids 0 .. n_objects-1')
+    parser.add_argument('--rate', type=float, default=100.0, help='messages per second and object, 0 = max')
+    parser.add_argument('--duration', type=float, default=10.0, help='seconds to run')
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    addr = (args.ip, args.port)
+    period = 1.0 / args.rate if args.rate > 0 else 0.0
+    n_sent = 0
+    frame = 0
+    start_time = time.perf_counter()
+    next_time = start_time
+
+    while time.perf_counter() - start_time < args.duration:
+        t = frame * period if period > 0 else time.perf_counter() - start_time
+        for i in range(args.n_objects):
+            # one circle per object, 10 m apart
+            angle = 0.1 * t
+            radius = 50.0 + 10.0 * i
+            message = struct.pack('iiiidddddB',
+                1,  # version
+                INPUT_MODE_STATE_XYH,
+                i,  # object ID
+                frame,
+                radius * math.cos(angle),  # x
+                radius * math.sin(angle),  # y
+                angle + math.pi / 2,  # h
+                radius * 0.1,  # speed
+                0.0,  # wheel angle
+                0  # dead reckoning
+            )
+            sock.sendto(message, addr)
+            n_sent += 1
+        frame += 1
+
+        if period > 0:
+            next_time += period
+            delay = next_time - time.perf_counter()
+            if delay > 0:
+                time.sleep(delay)
+
+    elapsed = time.perf_counter() - start_time
+    print('Sent {} messages for {} objects in {:.2f} s ({:.0f} messages/s)'.format(
+        n_sent, args.n_objects, elapsed, n_sent / elapsed))
+    sock.close()
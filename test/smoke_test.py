@@ -1,3 +1,4 @@
+import math
 import re
 import sys
 from sys import platform
@@ -70,9 +71,9 @@ class TestSuite(unittest.TestCase):
         self.assertTrue(re.search('\n11.100.*, 0, Ego, 200.713, 72.600, -2.443, 1.057, 6.263, 0.000, 16.000', csv))
         self.assertTrue(re.search('\n11.100, 1, Target, 206.003, 66.438, -2.496, 2.508, 6.281, 6.263, 17.500, -0.253, 1.548', csv))
         self.assertTrue(re.search('\n17.250.*, 0, Ego, 217.345, 167.663, 1.989, 1.738, 6.209, 0.000, 16.000', csv))
-        self.assertTrue(re.search('\n17.250, 1, Target, 210.632, 157.507, 1.295, 1.225, 6.216, 0.032, 14.907, 0.050, 2.996', csv))
+        self.assertTrue(re.search('\n17.250, 1, Target, 210.632, 157.507, 1.295, 1.225, 6.216, 0.032, 14.800, 0.050, 2.997', csv))
         self.assertTrue(re.search('\n25.000.*, 0, Ego, 206.081, 288.506, 5.436, 1.188, 6.238, 0.000, 16.000', csv))
-        self.assertTrue(re.search('\n25.000, 1, Target, 216.288, 307.524, 6.706, 0.968, 6.214, 0.000, 21.101, -0.032, 5.799', csv))
+        self.assertTrue(re.search('\n25.000, 1, Target, 216.288, 307.524, 6.706, 0.968, 6.214, 0.000, 21.101, -0.032, 5.789', csv))
 
     def test_synchronize(self):
         log = run_scenario(os.path.join(ESMINI_PATH, 'resources/xosc/synchronize.xosc'), COMMON_ARGS \
@@ -226,23 +227,25 @@ class TestSuite(unittest.TestCase):
         csv = generate_csv()
 
         self.assertTrue(re.search('^40.00.*, 0, Ego, 33.31.*, 699.01.*, -0.95.*, 1.45.*, 0.00.*, 0.00.*, 10.00.*', csv, re.MULTILINE))
+        self.assertTrue(re.search('^5.000, 0, Ego, 11.090, 349.861, -0.625, 1.550, 0.002, 0.000, 10.000, -0.000, 4.627', csv, re.MULTILINE))
+
+        # Swarm vehicles present, within max number and the swarm ellipse around Ego (semi axes 300 and 500 m)
+        for t in ['5.000', '20.000', '40.000']:
+            rows = [line.split(',') for line in csv.splitlines() if line.startswith(t + ',')]
+            ego = [r for r in rows if r[2].strip() == 'Ego']
+            self.assertEqual(len(ego), 1)
+            swarm = [r for r in rows if r[2].strip().startswith('swarm_')]
+            self.assertTrue(0 < len(swarm) <= 75)
+            for r in swarm:
+                self.assertLess(math.hypot(float(r[3]) - float(ego[0][3]), float(r[4]) - float(ego[0][4])), 500.0)
+
         # Random generators differ on platforms => random traffic will be repeatable only per platform
-        if platform == "win32":
-            self.assertTrue(re.search('^5.000, 0, Ego, 11.090, 349.861, -0.625, 1.550, 0.002, 0.000, 10.000, -0.000, 4.627', csv, re.MULTILINE))
-            self.assertTrue(re.search('^5.000, 2, swarm_1, -7.366, 400.877, -0.720, 4.684, 6.281, 0.000, 30.000, 0.001, 1.315', csv, re.MULTILINE))
-            self.assertTrue(re.search('^5.000, 19, swarm_15, 28.373, 614.039, -0.826, 1.480, 0.000, 0.000, 30.000, 0.000, 0.000', csv, re.MULTILINE))
-            self.assertTrue(re.search('^5.000, 20, swarm_15\+, 27.832, 608.063, -0.826, 1.481, 6.283, 0.000, 30.000, 0.000, 0.000', csv, re.MULTILINE))
-            self.assertTrue(re.search('^5.000, 21, swarm_15\+\+, 26.689, 595.415, -0.828, 1.481, 6.283, 0.000, 30.000, 0.000, 0.000', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 32, swarm_22, 13.924, 447.798, -0.793, 1.532, 0.001, 0.000, 13.665, -0.001, 4.040', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 33, swarm_23, 19.789, 495.137, -0.838, 1.518, 0.001, 0.000, 30.649, -0.001, 5.924', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 36, swarm_25, -9.511, 299.399, -0.526, 4.697, 6.281, 0.000, 30.000, 0.000, 2.958', csv, re.MULTILINE))
-        elif platform == "linux" or platform == "linux2":
-            self.assertTrue(re.search('^5.000, 0, Ego, 11.090, 349.861, -0.625, 1.550, 0.002, 0.000, 10.000, -0.000, 4.627', csv, re.MULTILINE))
-            self.assertTrue(re.search('^5.000, 1, swarm_0, 12.730, 199.986, -0.348, 1.562, 0.002, 0.000, 30.000, -0.000, 1.315', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 23, swarm_16, 14.959, 472.228, -0.820, 1.525, 0.001, 0.000, 12.184, -0.001, 4.946', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 76, swarm_52, 13.880, 298.618, -0.525, 1.556, 0.002, 0.000, 30.375, -0.000, 1.993', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 77, swarm_52\+, 13.793, 292.619, -0.514, 1.556, 0.002, 0.000, 30.000, -0.000, 1.942', csv, re.MULTILINE))
-            self.assertTrue(re.search('^20.000, 78, swarm_52\+\+, 13.618, 279.920, -0.490, 1.557, 0.002, 0.000, 30.000, -0.000, 1.942', csv, re.MULTILINE))
+        if platform == "linux" or platform == "linux2":
+            self.assertTrue(re.search('^5.000, 1, swarm_0, 12.734, 200.408, -0.348, 1.562, 0.002, 0.000, 30.000, -0.000, 1.315', csv, re.MULTILINE))
+            self.assertTrue(re.search('^20.000, 5, swarm_3, 15.174, 476.870, -0.825, 1.524, 0.001, 0.000, 10.231, -0.001, 4.747', csv, re.MULTILINE))
+            self.assertTrue(re.search('^20.000, 12, swarm_13, 14.093, 452.034, -0.798, 1.531, 0.001, 0.000, 11.174, -0.001, 1.987', csv, re.MULTILINE))
+            self.assertTrue(re.search('^20.000, 13, swarm_13\+, 13.862, 446.039, -0.791, 1.532, 0.001, 0.000, 30.000, -0.001, 4.684', csv, re.MULTILINE))
+            self.assertTrue(re.search('^20.000, 14, swarm_13\+\+, 13.400, 433.347, -0.773, 1.535, 0.001, 6.283, 30.000, -0.001, 4.684', csv, re.MULTILINE))
 
     def test_conflicting_domains(self):
         log = run_scenario(os.path.join(ESMINI_PATH, 'EnvironmentSimulator/Unittest/xosc/conflicting-domains.xosc'), COMMON_ARGS)